@@ -41,6 +41,11 @@ using namespace hal;
 static void printSequence(ostream &outStream, const Sequence *sequence, const set<const Genome *> &targetSet, hal_size_t start,
                           hal_size_t length, hal_size_t step, bool countDupes, bool noAncestors);
 
+/** Print the alignment depth wiggle values for every position of a
+ * subrange of a given sequence */
+static void printBlocks(ostream &outStream, const Sequence *sequence, const set<const Genome *> &targetSet, hal_size_t start,
+                        hal_size_t last, bool countDupes, bool noAncestors);
+
 /** If given genome-relative coordinates, map them to a series of
  * sequence subranges */
 static void printGenome(ostream &outStream, const Genome *genome, const Sequence *sequence,
@@ -234,6 +239,17 @@ void printSequence(ostream &outStream, const Sequence *sequence, const set<const
     string sequenceName = sequence->getName();
     string genomeName = genome->getName();
 
+    // note wig coordinates are 1-based for some reason so we shift to right
+    outStream << "fixedStep chrom=" << sequenceName << " start=" << start + 1 << " step=" << step << "\n";
+
+    if (step == 1) {
+        /** With a step of one, every column is printed.  The depth is the
+         * same for all the columns of a gapless block, so we iterate over
+         * blocks rather than columns */
+        printBlocks(outStream, sequence, targetSet, start, last - 1, countDupes, noAncestors);
+        return;
+    }
+
     /** The ColumnIterator is fundamental structure used in this example to
      * traverse the alignment.  It essientially generates the multiple alignment
      * on the fly according to the given reference (in this case the target
@@ -243,8 +259,6 @@ void printSequence(ostream &outStream, const Sequence *sequence, const set<const
      * duplications out of the desired range while we are iterating. */
     hal_size_t pos = start;
     ColumnIteratorPtr colIt = sequence->getColumnIterator(&targetSet, 0, pos, last - 1, false, noAncestors);
-    // note wig coordinates are 1-based for some reason so we shift to right
-    outStream << "fixedStep chrom=" << sequenceName << " start=" << start + 1 << " step=" << step << "\n";
 
     /** Since the column iterator stores coordinates in Genome coordinates
      * internally, we have to switch back to genome coordinates.  */
@@ -288,22 +302,38 @@ void printSequence(ostream &outStream, const Sequence *sequence, const set<const
         }
 
         pos += step;
-        if (step == 1) {
-            /** Move the iterator one position to the right */
-            colIt->toRight();
-
-            /** This is some tuning code that will probably be hidden from
-             * the interface at some point.  It is a good idea to use for now
-             * though */
-            // erase empty entries from the column.  helps when there are
-            // millions of sequences (ie from fastas with lots of scaffolds)
-            if (pos % 1000 == 0) {
-                colIt->defragment();
+        /** Reset the iterator to a non-contiguous position */
+        colIt->toSite(pos, last);
+    }
+}
+
+/** Print the alignment depth of each column from start to last (inclusive,
+ * sequence-relative), a gapless block of columns at a time */
+void printBlocks(ostream &outStream, const Sequence *sequence, const set<const Genome *> &targetSet, hal_size_t start,
+                 hal_size_t last, bool countDupes, bool noAncestors) {
+    ColumnBlockIterator blockIt(sequence, &targetSet, start, last, false, noAncestors);
+    // keep track of unique genomes
+    set<const Genome *> genomeSet;
+    while (true) {
+        const ColumnBlockIterator::Rows &rows = blockIt.getRows();
+        hal_size_t count = rows.size();
+        if (countDupes == false) {
+            genomeSet.clear();
+            for (const ColumnBlockIterator::Row &row : rows) {
+                genomeSet.insert(row._sequence->getGenome());
             }
-        } else {
-            /** Reset the iterator to a non-contiguous position */
-            colIt->toSite(pos, last);
+            count = genomeSet.size();
+        }
+        // don't want to include reference base in output
+        --count;
+
+        for (hal_size_t i = 0; i < blockIt.getLength(); ++i) {
+            outStream << count << '\n';
+        }
+        if (blockIt.lastBlock() == true) {
+            break;
         }
+        blockIt.toRight();
     }
 }
 
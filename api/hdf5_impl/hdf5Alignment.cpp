@@ -48,6 +48,7 @@ const hsize_t Hdf5Alignment::DefaultCacheRDCElems = 521;
 const hsize_t Hdf5Alignment::DefaultCacheRDCBytes = 1048576;
 const double Hdf5Alignment::DefaultCacheW0 = 0.75;
 const bool Hdf5Alignment::DefaultInMemory = false;
+const hsize_t Hdf5Alignment::DefaultArrayCacheBytes = 0;
 
 /* check if first bit of file has HDF5 header */
 bool hal::Hdf5Alignment::isHdf5File(const std::string &initialBytes) {
@@ -70,7 +71,7 @@ Hdf5Alignment::Hdf5Alignment(const string &alignmentPath, unsigned mode, const H
                              const H5::FileAccPropList &fileAccessProps, const H5::DSetCreatPropList &datasetCreateProps,
                              bool inMemory)
     : _alignmentPath(alignmentPath), _mode(halDefaultAccessMode(mode)), _file(NULL), _flags(hdf5DefaultFlags(_mode)),
-      _inMemory(inMemory), _metaData(NULL), _tree(NULL), _dirty(false) {
+      _inMemory(inMemory), _metaData(NULL), _tree(NULL), _dirty(false), _chunkCache(NULL), _printCacheStats(false) {
     _cprops.copy(fileCreateProps);
     _aprops.copy(fileAccessProps);
     _dcprops.copy(datasetCreateProps);
@@ -86,7 +87,7 @@ Hdf5Alignment::Hdf5Alignment(const string &alignmentPath, unsigned mode, const H
 
 Hdf5Alignment::Hdf5Alignment(const std::string &alignmentPath, unsigned mode, const CLParser *parser)
     : _alignmentPath(alignmentPath), _mode(halDefaultAccessMode(mode)), _file(NULL), _flags(hdf5DefaultFlags(_mode)),
-      _inMemory(false), _metaData(NULL), _tree(NULL), _dirty(false) {
+      _inMemory(false), _metaData(NULL), _tree(NULL), _dirty(false), _chunkCache(NULL), _printCacheStats(false) {
     initializeFromOptions(parser);
     if (_inMemory) {
         setInMemory();
@@ -124,6 +125,12 @@ void Hdf5Alignment::defineOptions(CLParser *parser, unsigned mode) {
     parser->addOption("hdf5CacheW0", "w0 parameter for hdf5 cache", DefaultCacheW0);
     parser->addOption("cacheW0", "obsolete name for --hdf5CacheW0", DefaultCacheW0);
 
+    parser->addOption("hdf5ArrayCacheBytes",
+                      "size in bytes of a cache of array chunks shared by all open genomes, in addition to the hdf5 cache"
+                      " (0 to disable)",
+                      DefaultArrayCacheBytes);
+    parser->addOptionFlag("hdf5CacheStats", "print hit rates of the array chunk cache to stderr on close", false);
+
     parser->addOptionFlag("hdf5InMemory", "load all data in memory (and disable hdf5 cache)", DefaultInMemory);
     parser->addOptionFlag("inMemory", "obsolete name for --hdf5InMemory", DefaultInMemory);
 }
@@ -143,6 +150,11 @@ void Hdf5Alignment::initializeFromOptions(const CLParser *parser) {
     _aprops.setCache(
         parser->getOptionAlt<hsize_t>("hdf5CacheMDC", "cacheMDC"), parser->getOptionAlt<hsize_t>("hdf5CacheRDC", "cacheRDC"),
         parser->getOptionAlt<hsize_t>("hdf5CacheBytes", "cacheBytes"), parser->getOptionAlt<double>("hdf5CacheW0", "cacheW0"));
+    hsize_t arrayCacheBytes = parser->getOption<hsize_t>("hdf5ArrayCacheBytes");
+    if ((arrayCacheBytes > 0) and not _inMemory) {
+        _chunkCache = new Hdf5ChunkCache(arrayCacheBytes);
+        _printCacheStats = parser->getFlag("hdf5CacheStats");
+    }
 }
 
 /* set properties for in-memory access */
@@ -171,6 +183,9 @@ void Hdf5Alignment::create() {
 }
 
 void Hdf5Alignment::open() {
+    if (_mode & CONCURRENT_READ_ACCESS) {
+        throw hal_exception(_alignmentPath + ": concurrent read access is only supported for mmap HAL files");
+    }
 #ifdef ENABLE_UDC
     // check for url rather than UDC cache, since default UDC cache directory could be used.
     if (((_mode & WRITE_ACCESS) == 0) and isUrl(_alignmentPath)) {
@@ -222,6 +237,13 @@ void Hdf5Alignment::close() {
             delete genome;
         }
         _openGenomes.clear();
+        if (_chunkCache != NULL) {
+            if (_printCacheStats) {
+                _chunkCache->printStats(cerr);
+            }
+            delete _chunkCache;
+            _chunkCache = NULL;
+        }
         if (not isReadOnly()) {
             _file->flush(H5F_SCOPE_LOCAL);
         }
@@ -10,6 +10,7 @@
 
 #include "halAlignmentInstance.h"
 #include "hdf5Alignment.h"
+#include "hdf5ChunkCache.h"
 #include "hdf5Genome.h"
 #include "hdf5MetaData.h"
 #include <H5Cpp.h>
@@ -81,6 +82,12 @@ namespace hal {
 
         bool isReadOnly() const;
 
+        /* cache of array chunks shared by all genomes, or NULL if not
+         * enabled */
+        Hdf5ChunkCache *getChunkCache() const {
+            return _chunkCache;
+        }
+
         void replaceNewickTree(const std::string &newNewickString);
 
       private:
@@ -109,6 +116,7 @@ namespace hal {
         static const hsize_t DefaultCacheRDCBytes;
         static const double DefaultCacheW0;
         static const bool DefaultInMemory;
+        static const hsize_t DefaultArrayCacheBytes;
 
         static const H5std_string MetaGroupName;
         static const H5std_string TreeGroupName;
@@ -130,6 +138,8 @@ namespace hal {
         mutable std::map<std::string, stTree *> _nodeMap;
         bool _dirty;
         mutable std::map<std::string, Hdf5Genome *> _openGenomes;
+        Hdf5ChunkCache *_chunkCache;
+        bool _printCacheStats;
     };
 }
 #endif
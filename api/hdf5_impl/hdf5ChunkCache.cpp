@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#include "hdf5ChunkCache.h"
+#include <cstring>
+#include <iomanip>
+#include <iterator>
+
+using namespace hal;
+using namespace std;
+
+Hdf5ChunkCache::Hdf5ChunkCache(size_t maxBytes) : _maxBytes(maxBytes), _usedBytes(0) {
+}
+
+Hdf5ChunkCache::ArrayStats *Hdf5ChunkCache::getArrayStats(const string &arrayName) {
+    return &_arrayStats[arrayName];
+}
+
+bool Hdf5ChunkCache::fetch(const Hdf5ExternalArray *array, hsize_t start, char *buf, size_t numBytes) {
+    map<ChunkKey, ChunkList::iterator>::iterator indexIt = _chunkIndex.find(ChunkKey(array, start));
+    if ((indexIt == _chunkIndex.end()) or (indexIt->second->_data.size() != numBytes)) {
+        return false;
+    }
+    _chunks.splice(_chunks.begin(), _chunks, indexIt->second);
+    memcpy(buf, indexIt->second->_data.data(), numBytes);
+    return true;
+}
+
+void Hdf5ChunkCache::eraseChunk(ChunkList::iterator chunkIt) {
+    _usedBytes -= chunkIt->_data.size();
+    _chunkIndex.erase(chunkIt->_key);
+    _chunks.erase(chunkIt);
+}
+
+void Hdf5ChunkCache::store(const Hdf5ExternalArray *array, hsize_t start, const char *buf, size_t numBytes) {
+    ChunkKey key(array, start);
+    map<ChunkKey, ChunkList::iterator>::iterator indexIt = _chunkIndex.find(key);
+    if (indexIt != _chunkIndex.end()) {
+        eraseChunk(indexIt->second);
+    }
+    if (numBytes > _maxBytes) {
+        return;
+    }
+    while (_usedBytes + numBytes > _maxBytes) {
+        eraseChunk(std::prev(_chunks.end()));
+    }
+    _chunks.push_front(Chunk());
+    _chunks.front()._key = key;
+    _chunks.front()._data.assign(buf, buf + numBytes);
+    _chunkIndex[key] = _chunks.begin();
+    _usedBytes += numBytes;
+}
+
+void Hdf5ChunkCache::dropArray(const Hdf5ExternalArray *array) {
+    map<ChunkKey, ChunkList::iterator>::iterator indexIt = _chunkIndex.lower_bound(ChunkKey(array, 0));
+    while ((indexIt != _chunkIndex.end()) and (indexIt->first.first == array)) {
+        ChunkList::iterator chunkIt = indexIt->second;
+        ++indexIt;
+        eraseChunk(chunkIt);
+    }
+}
+
+static void printStatsLine(ostream &out, const string &name, size_t hits, size_t misses) {
+    size_t total = hits + misses;
+    out << setw(40) << left << name << right << setw(14) << hits << setw(14) << misses << setw(10) << fixed
+        << setprecision(1) << ((total > 0) ? (100.0 * hits) / total : 0.0) << endl;
+}
+
+void Hdf5ChunkCache::printStats(ostream &out) const {
+    out << "hdf5 array chunk cache: " << _usedBytes << " of " << _maxBytes << " bytes used" << endl;
+    out << setw(40) << left << "array" << right << setw(14) << "hits" << setw(14) << "misses" << setw(10) << "hit%"
+        << endl;
+    size_t totalHits = 0, totalMisses = 0;
+    for (const pair<const string, ArrayStats> &arrayStats : _arrayStats) {
+        if (arrayStats.second._hits + arrayStats.second._misses == 0) {
+            continue; // not accessed
+        }
+        printStatsLine(out, arrayStats.first, arrayStats.second._hits, arrayStats.second._misses);
+        totalHits += arrayStats.second._hits;
+        totalMisses += arrayStats.second._misses;
+    }
+    printStatsLine(out, "total", totalHits, totalMisses);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#ifndef _HDF5CHUNKCACHE_H
+#define _HDF5CHUNKCACHE_H
+
+#include <H5Cpp.h>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hal {
+    class Hdf5ExternalArray;
+
+    /**
+     * Cache of chunks read by Hdf5ExternalArray objects, shared by all
+     * arrays of an alignment.  Each array only buffers the chunk being
+     * accessed; when it pages to another chunk, the chunk is copied from
+     * this cache if present, avoiding the HDF5 read and decompression.
+     * A single memory budget is divided between all open arrays of all
+     * genomes by evicting the least recently used chunk, so the chunks in
+     * use stay cached no matter how many genomes are open.
+     *
+     * Hits and misses are counted for each array by name and kept after
+     * the array is closed, so they can be reported when the alignment is
+     * closed.
+     */
+    class Hdf5ChunkCache {
+      public:
+        /* hit statistics for an array */
+        struct ArrayStats {
+            ArrayStats() : _hits(0), _misses(0) {
+            }
+            size_t _hits;
+            size_t _misses;
+        };
+
+        Hdf5ChunkCache(size_t maxBytes);
+
+        /* get the statistics object for an array, which is created if
+         * needed and is valid for the life of the cache */
+        ArrayStats *getArrayStats(const std::string &arrayName);
+
+        /* Copy a chunk of an array into buf if it is cached, making it the
+         * most recently used.  Hit statistics are not updated. */
+        bool fetch(const Hdf5ExternalArray *array, hsize_t start, char *buf, size_t numBytes);
+
+        /* add or replace a chunk of an array, evicting least recently used
+         * chunks to stay within the budget */
+        void store(const Hdf5ExternalArray *array, hsize_t start, const char *buf, size_t numBytes);
+
+        /* drop all chunks of an array */
+        void dropArray(const Hdf5ExternalArray *array);
+
+        size_t getMaxBytes() const {
+            return _maxBytes;
+        }
+        size_t getUsedBytes() const {
+            return _usedBytes;
+        }
+
+        /* print hit rates of all arrays and the total */
+        void printStats(std::ostream &out) const;
+
+      private:
+        typedef std::pair<const Hdf5ExternalArray *, hsize_t> ChunkKey;
+        struct Chunk {
+            ChunkKey _key;
+            std::vector<char> _data;
+        };
+        typedef std::list<Chunk> ChunkList;
+
+        void eraseChunk(ChunkList::iterator chunkIt);
+
+        size_t _maxBytes;
+        size_t _usedBytes;
+        ChunkList _chunks; // most recently used first
+        std::map<ChunkKey, ChunkList::iterator> _chunkIndex;
+        std::map<std::string, ArrayStats> _arrayStats;
+
+      private:
+        Hdf5ChunkCache(const Hdf5ChunkCache &);
+        Hdf5ChunkCache &operator=(const Hdf5ChunkCache &);
+    };
+}
+#endif
+// Local Variables:
+// mode: c++
+// End:
@@ -15,14 +15,23 @@ using namespace std;
 
 /** Constructor */
 Hdf5ExternalArray::Hdf5ExternalArray()
-    : _file(NULL), _size(0), _chunkSize(0), _bufStart(0), _bufEnd(0), _bufSize(0), _buf(NULL), _dirty(false) {
+    : _file(NULL), _size(0), _chunkSize(0), _bufStart(0), _bufEnd(0), _bufSize(0), _buf(NULL), _dirty(false),
+      _cache(NULL), _cacheStats(NULL) {
 }
 
 /** Destructor */
 Hdf5ExternalArray::~Hdf5ExternalArray() {
+    if (_cache != NULL) {
+        _cache->dropArray(this);
+    }
     delete[] _buf;
 }
 
+void Hdf5ExternalArray::setCache(Hdf5ChunkCache *cache, const std::string &arrayName) {
+    _cache = cache;
+    _cacheStats = (cache != NULL) ? cache->getArrayStats(arrayName) : NULL;
+}
+
 /* initialize the internal data buffer */
 void Hdf5ExternalArray::initBuf() {
     _bufSize = _chunkSize > 1 ? _chunkSize : _size;
@@ -35,6 +44,10 @@ void Hdf5ExternalArray::initBuf() {
 // Create a new dataset in specifed location
 void Hdf5ExternalArray::create(PortableH5Location *file, const H5std_string &path, const DataType &dataType,
                                hsize_t numElements, const DSetCreatPropList *inCparms, hsize_t chunksInBuffer) {
+    // chunks of a previous dataset are no longer valid
+    if (_cache != NULL) {
+        _cache->dropArray(this);
+    }
     // copy in parameters
     _file = file;
     _path = path;
@@ -78,6 +91,9 @@ void Hdf5ExternalArray::create(PortableH5Location *file, const H5std_string &pat
 
 // Load an existing dataset into memory
 void Hdf5ExternalArray::load(PortableH5Location *file, const H5std_string &path, hsize_t chunksInBuffer) {
+    if (_cache != NULL) {
+        _cache->dropArray(this);
+    }
     // load up the parameters
     _file = file;
     _path = path;
@@ -117,6 +133,9 @@ void Hdf5ExternalArray::write() {
         _dataSpace.selectHyperslab(H5S_SELECT_SET, &_bufSize, &_bufStart);
         _dataSet.write(_buf, _dataType, _chunkSpace, _dataSpace);
         _dirty = false;
+        if (useCache()) {
+            _cache->store(this, _bufStart, _buf, _bufSize * _dataSize);
+        }
     }
 }
 
@@ -134,8 +153,16 @@ void Hdf5ExternalArray::page(hsize_t i) {
         _chunkSpace = DataSpace(1, &_bufSize);
     }
 
-    _dataSpace.selectHyperslab(H5S_SELECT_SET, &_bufSize, &_bufStart);
-    _dataSet.read(_buf, _dataType, _chunkSpace, _dataSpace);
+    if (useCache() and _cache->fetch(this, _bufStart, _buf, _bufSize * _dataSize)) {
+        _cacheStats->_hits++;
+    } else {
+        _dataSpace.selectHyperslab(H5S_SELECT_SET, &_bufSize, &_bufStart);
+        _dataSet.read(_buf, _dataType, _chunkSpace, _dataSpace);
+        if (useCache()) {
+            _cacheStats->_misses++;
+            _cache->store(this, _bufStart, _buf, _bufSize * _dataSize);
+        }
+    }
     _dirty = false;
     assert(_bufSize > 0 || _size == 0);
 }
@@ -9,6 +9,7 @@
 #define _HDF5EXTERNALARRAY_H
 
 #include "halDefs.h"
+#include "hdf5ChunkCache.h"
 #include <H5Cpp.h>
 #include <cassert>
 
@@ -67,6 +68,11 @@ namespace hal {
           */
         void load(H5::PortableH5Location *file, const H5std_string &path, hsize_t chunksInBuffer = 1);
 
+        /** Share chunks through a cache.  Must be called before create or load.
+         * @param cache Cache of the alignment, or NULL for no cache
+         * @param arrayName Name under which hits are counted */
+        void setCache(Hdf5ChunkCache *cache, const std::string &arrayName);
+
         /** Write the memory buffer back to the file */
         void write();
 
@@ -133,6 +139,9 @@ namespace hal {
 
       private:
         void initBuf();
+        bool useCache() const {
+            return (_cache != NULL) and (_chunkSize > 0);
+        }
 
         /** Pointer to file that owns this dataset */
         H5::PortableH5Location *_file;
@@ -163,6 +172,9 @@ namespace hal {
         /** Flag saying we should write to disk on write
          * or page-out calls (set by getUpdate()) */
         bool _dirty;
+        /** Cache shared with other arrays, or NULL */
+        Hdf5ChunkCache *_cache;
+        Hdf5ChunkCache::ArrayStats *_cacheStats;
 
       private:
         Hdf5ExternalArray(const Hdf5ExternalArray &);
@@ -43,6 +43,12 @@ Hdf5Genome::Hdf5Genome(const string &name, Hdf5Alignment *alignment, PortableH5L
     _dcprops.copy(dcProps);
     assert(!name.empty());
     assert(alignment != NULL && h5Parent != NULL);
+    Hdf5ChunkCache *chunkCache = alignment->getChunkCache();
+    _dnaArray.setCache(chunkCache, name + "/" + dnaArrayName);
+    _topArray.setCache(chunkCache, name + "/" + topArrayName);
+    _bottomArray.setCache(chunkCache, name + "/" + bottomArrayName);
+    _sequenceIdxArray.setCache(chunkCache, name + "/" + sequenceIdxArrayName);
+    _sequenceNameArray.setCache(chunkCache, name + "/" + sequenceNameArrayName);
 
     try {
         HDF5DisableExceptionPrinting prDisable;
@@ -525,6 +531,14 @@ void Hdf5Genome::getSubString(string &outString, hal_size_t start, hal_size_t le
     dnaIt->readString(outString, length);
 }
 
+void Hdf5Genome::getSubString(char *outBuffer, hal_size_t start, hal_size_t length, bool reversed) const {
+    if (length > 0) {
+        DnaIteratorPtr dnaIt(getDnaIterator(reversed ? start + length - 1 : start));
+        dnaIt->setReversed(reversed);
+        dnaIt->readBases(outBuffer, length);
+    }
+}
+
 void Hdf5Genome::setSubString(const string &inString, hal_size_t start, hal_size_t length) {
     if (length != inString.length()) {
         throw hal_exception(string("setString: input string has different") + "length from target string in genome");
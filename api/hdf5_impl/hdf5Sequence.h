@@ -74,6 +74,7 @@ namespace hal {
         void setString(const std::string &inString);
 
         void getSubString(std::string &outString, hal_size_t start, hal_size_t length) const;
+        void getSubString(char *outBuffer, hal_size_t start, hal_size_t length, bool reversed = false) const;
 
         void setSubString(const std::string &intString, hal_size_t start, hal_size_t length);
 
@@ -69,8 +69,10 @@ Alignment *hal::hdf5AlignmentInstance(const std::string &alignmentPath, unsigned
     return new Hdf5Alignment(alignmentPath, mode, fileCreateProps, fileAccessProps, datasetCreateProps, inMemory);
 }
 
-Alignment *hal::mmapAlignmentInstance(const std::string &alignmentPath, unsigned mode, size_t fileSize) {
-    return new MMapAlignment(alignmentPath, mode, fileSize);
+Alignment *hal::mmapAlignmentInstance(const std::string &alignmentPath, unsigned mode, size_t fileSize,
+                                      MMapSegmentLayout segmentLayout, MMapDnaLayout dnaLayout,
+                                      const MMapAccessOptions &accessOptions) {
+    return new MMapAlignment(alignmentPath, mode, fileSize, segmentLayout, dnaLayout, accessOptions);
 }
 
 static const int DETECT_INITIAL_NUM_BYTES = 64;
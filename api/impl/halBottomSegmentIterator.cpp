@@ -38,16 +38,37 @@ void BottomSegmentIterator::print(ostream &os) const {
 // BOTTOM SEGMENT ITERATOR INTERFACE
 //////////////////////////////////////////////////////////////////////////////
 void BottomSegmentIterator::toParent(const TopSegmentIteratorPtr &topSegIt) {
-    _bottomSegment->setArrayIndex(topSegIt->getGenome()->getParent(), topSegIt->tseg()->getParentIndex());
+    Genome *genome = topSegIt->getGenome();
+    hal_index_t parentIndex;
+    bool parentReversed;
+    ProjectionCache *projectionCache = genome->getParentProjectionCache();
+    if (projectionCache != NULL) {
+        projectionCache->get(topSegIt->getArrayIndex(), parentIndex, parentReversed);
+    } else {
+        parentIndex = topSegIt->tseg()->getParentIndex();
+        parentReversed = topSegIt->tseg()->getParentReversed();
+    }
+    _bottomSegment->setArrayIndex(genome->getParent(), parentIndex);
     _startOffset = topSegIt->getStartOffset();
     _endOffset = topSegIt->getEndOffset();
     _reversed = topSegIt->getReversed();
-    if (topSegIt->tseg()->getParentReversed() == true) {
+    if (parentReversed == true) {
         toReverse();
     }
     assert(inRange() == true);
 }
 
+bool BottomSegmentIterator::hasChild(hal_size_t child) const {
+    ProjectionCache *projectionCache = getGenome()->getChildProjectionCache(child);
+    if (projectionCache == NULL) {
+        return bseg()->hasChild(child);
+    }
+    hal_index_t childIndex;
+    bool childReversed;
+    projectionCache->get(getArrayIndex(), childIndex, childReversed);
+    return childIndex != NULL_INDEX;
+}
+
 void BottomSegmentIterator::toParseDown(const TopSegmentIteratorPtr &topSegIt) {
     Genome *genome = topSegIt->getGenome();
     hal_index_t index = topSegIt->tseg()->getBottomParseIndex();
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halColumnBlockIterator.h"
+#include "halSequence.h"
+#include <cassert>
+
+using namespace std;
+using namespace hal;
+
+ColumnBlockIterator::ColumnBlockIterator(const Sequence *sequence, const set<const Genome *> *targets, hal_index_t position,
+                                         hal_index_t lastPosition, bool noDupes, bool noAncestors, bool onlyOrthologs)
+    : _sequence(sequence), _refPosition(position), _nextPosition(NULL_INDEX), _lastPosition(lastPosition), _length(0),
+      _lastBlock(false), _numColumnsComputed(1) {
+    _colIt = sequence->getColumnIterator(targets, 0, position, lastPosition, noDupes, noAncestors, false, false, onlyOrthologs);
+    readBlock();
+}
+
+void ColumnBlockIterator::toRight() {
+    assert(not _lastBlock);
+    _refPosition = _nextPosition;
+    readBlock();
+}
+
+/* The column iterator is at the first column of the block.  Add gapless
+ * runs to the block until a column that doesn't continue the rows or the
+ * end is reached, leaving the iterator at the first column of the next
+ * block. */
+void ColumnBlockIterator::readBlock() {
+    _rows.clear();
+    for (const ColumnIterator::Row &colRow : _colIt->getRows()) {
+        _rows.push_back(Row(colRow._sequence, colRow._dna->getArrayIndex(), colRow._dna->getReversed()));
+    }
+    _length = 0;
+    hal_index_t position = _refPosition;
+    do {
+        hal_size_t run = _colIt->getGaplessLength();
+        _length += run;
+        position += run;
+        if (position > _lastPosition) {
+            _lastBlock = true;
+            return;
+        }
+        _colIt->toRight(run);
+        ++_numColumnsComputed;
+    } while (extendsBlock());
+    _nextPosition = position;
+}
+
+/* does the current column of the column iterator continue every row of
+ * the block, and have no other bases? */
+bool ColumnBlockIterator::extendsBlock() const {
+    const ColumnIterator::Rows &colRows = _colIt->getRows();
+    if (colRows.size() != _rows.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < _rows.size(); ++i) {
+        const Row &row = _rows[i];
+        const DnaIteratorPtr &dnaIt = colRows[i]._dna;
+        if (row._sequence != colRows[i]._sequence || row._reversed != dnaIt->getReversed() ||
+            row.getPosition(_length) != dnaIt->getArrayIndex()) {
+            return false;
+        }
+    }
+    return true;
+}
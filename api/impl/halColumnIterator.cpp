@@ -5,11 +5,13 @@
  * Released under the MIT license, see LICENSE.txt
  */
 #include "halColumnIterator.h"
+#include "halAlignment.h"
 #include "halBottomSegmentIterator.h"
 #include <algorithm>
 #include <cassert>
 #include <deque>
 #include <iostream>
+#include <limits>
 #include <string>
 
 using namespace std;
@@ -18,8 +20,9 @@ using namespace hal;
 ColumnIterator::ColumnIterator(const Genome *reference, const set<const Genome *> *targets, hal_index_t columnIndex,
                                hal_index_t lastColumnIndex, hal_size_t maxInsertLength, bool noDupes, bool noAncestors,
                                bool reverseStrand, bool unique, bool onlyOrthologs)
-    : _maxInsertionLength(maxInsertLength), _noDupes(noDupes), _noAncestors(noAncestors),
-      _treeCache(NULL), _unique(unique), _onlyOrthologs(onlyOrthologs) {
+    : _stack(&_pool), _indelStack(&_pool), _insertionStack(&_pool), _deletionStack(&_pool),
+      _maxInsertionLength(maxInsertLength), _noDupes(noDupes), _noAncestors(noAncestors),
+      _rowsSorted(true), _colMapValid(false), _treeCache(NULL), _unique(unique), _onlyOrthologs(onlyOrthologs) {
     assert(columnIndex >= 0 && lastColumnIndex >= columnIndex && lastColumnIndex < (hal_index_t)reference->getSequenceLength());
     // allocate temp iterators
     if (reference->getNumTopSegments() > 0) {
@@ -42,6 +45,18 @@ ColumnIterator::ColumnIterator(const Genome *reference, const set<const Genome *
     assert(sequence != NULL);
     _ref = sequence;
 
+    // rank genomes by name once, rather than comparing names for every base
+    const Alignment *alignment = reference->getAlignment();
+    deque<string> names(1, alignment->getRootName());
+    while (not names.empty()) {
+        _genomeNames.push_back(names.front());
+        names.pop_front();
+        for (const string &child : alignment->getChildNames(_genomeNames.back())) {
+            names.push_back(child);
+        }
+    }
+    sort(_genomeNames.begin(), _genomeNames.end());
+
     // compute all genomes in search scope (spanning tree of reference and targets)
     // if targets is empty we just visit everything.
     if (targets != NULL && !targets->empty()) {
@@ -106,16 +121,7 @@ void ColumnIterator::toRight() {
             _stack.top()->_index++;
         }
 
-        // jump to next sequence in genome if necessary
-        const Sequence *seq = _stack.top()->_sequence;
-        if (_stack.size() == 1 &&
-            (_stack.top()->_index < seq->getStartPosition() ||
-             (_stack.top()->_index >= (hal_index_t)(seq->getStartPosition() + seq->getSequenceLength()) &&
-            _stack.top()->_index < (hal_index_t)(seq->getGenome()->getSequenceLength())))) {
-            _stack.top()->_sequence = seq->getGenome()->getSequenceBySite(_stack.top()->_index);
-            assert(_stack.top()->_sequence != NULL);
-            _ref = _stack.top()->_sequence;
-        }
+        updateReferenceSequence();
     } while (_break == true);
 
     // push the indel stack.
@@ -131,18 +137,49 @@ void ColumnIterator::toRight() {
 
 #ifndef NDEBUG
     set<pair<const Sequence *, hal_index_t>> coordSet;
-    ColumnMap::const_iterator i, iNext;
-    DNASet::const_iterator j;
-    for (i = _colMap.begin(); i != _colMap.end(); ++i) {
+    for (const Row &row : _rows) {
         // check that the same coordinate not present for the same sequence
-        for (j = i->second->begin(); j != i->second->end(); ++j) {
-            pair<const Sequence *, hal_index_t> data(i->first, (*j)->getArrayIndex());
-            assert(coordSet.insert(data).second == true);
-        }
+        pair<const Sequence *, hal_index_t> data(row._sequence, row._dna->getArrayIndex());
+        assert(coordSet.insert(data).second == true);
     }
 #endif
 }
 
+hal_size_t ColumnIterator::getGaplessLength() const {
+    if (_maxInsertionLength > 0 || _unique || !_visitCache.empty() || _stack.size() != 1 || lastColumn()) {
+        return 1;
+    }
+    // the index is already one past the current column
+    const StackEntry *entry = _stack.top();
+    hal_size_t columnsLeft = entry->_reversed ? entry->_index - entry->_firstIndex + 2 : entry->_lastIndex - entry->_index + 2;
+    return min(_gaplessLength, columnsLeft);
+}
+
+void ColumnIterator::toRight(hal_size_t numColumns) {
+    assert(numColumns > 0 && numColumns <= getGaplessLength());
+    if (numColumns > 1) {
+        // the skipped columns only differ in position from the current
+        // one, so just move the index to the last of them
+        hal_index_t skip = numColumns - 1;
+        _stack.top()->_index += _stack.top()->_reversed ? -skip : skip;
+        updateReferenceSequence();
+    }
+    toRight();
+}
+
+// jump to next sequence in genome if necessary
+void ColumnIterator::updateReferenceSequence() {
+    const Sequence *seq = _stack.top()->_sequence;
+    if (_stack.size() == 1 &&
+        ((_stack.top()->_index >= 0 && _stack.top()->_index < seq->getStartPosition()) ||
+         (_stack.top()->_index >= (hal_index_t)(seq->getStartPosition() + seq->getSequenceLength()) &&
+          _stack.top()->_index < (hal_index_t)(seq->getGenome()->getSequenceLength())))) {
+        _stack.top()->_sequence = seq->getGenome()->getSequenceBySite(_stack.top()->_index);
+        assert(_stack.top()->_sequence != NULL);
+        _ref = _stack.top()->_sequence;
+    }
+}
+
 void ColumnIterator::toSite(hal_index_t columnIndex, hal_index_t lastColumnIndex, bool clearCache) {
     clearTree();
 
@@ -180,7 +217,42 @@ hal_index_t ColumnIterator::getReferenceSequencePosition() const {
     return _prevRefIndex;
 }
 
+const ColumnIterator::Rows &ColumnIterator::getRows() const {
+    if (not _rowsSorted) {
+        sortRows();
+    }
+    return _rows;
+}
+
+/* The map has an entry for every sequence seen since it was last
+ * defragmented, merged in id order with the rows of the column. */
 const ColumnIterator::ColumnMap *ColumnIterator::getColumnMap() const {
+    if (not _colMapValid) {
+        const Rows &rows = getRows();
+        for (Rows::const_iterator i = rows.begin(); i != rows.end(); ++i) {
+            if (i == rows.begin() || i->_sequenceId != (i - 1)->_sequenceId) {
+                pair<hal_size_t, const Sequence *> seqKey(i->_sequenceId, i->_sequence);
+                vector<pair<hal_size_t, const Sequence *>>::iterator j =
+                    lower_bound(_colMapSequences.begin(), _colMapSequences.end(), seqKey);
+                if (j == _colMapSequences.end() || j->first != i->_sequenceId) {
+                    _colMapSequences.insert(j, seqKey);
+                }
+            }
+        }
+        while (_dnaSets.size() < _colMapSequences.size()) {
+            _dnaSets.push_back(new DNASet());
+        }
+        Rows::const_iterator row = rows.begin();
+        for (size_t i = 0; i < _colMapSequences.size(); ++i) {
+            DNASet *dnaSet = _dnaSets[i];
+            for (; row != rows.end() && row->_sequenceId == _colMapSequences[i].first; ++row) {
+                dnaSet->push_back(row->_dna);
+            }
+            _colMap._entries.push_back(ColumnMap::value_type(_colMapSequences[i].second, dnaSet));
+        }
+        assert(row == rows.end());
+        _colMapValid = true;
+    }
     return &_colMap;
 }
 
@@ -190,18 +262,8 @@ hal_index_t ColumnIterator::getArrayIndex() const {
 }
 
 void ColumnIterator::defragment() {
-    ColumnMap::iterator i = _colMap.begin();
-    ColumnMap::iterator next;
-    while (i != _colMap.end()) {
-        next = i;
-        ++next;
-        if (i->second->empty()) {
-            delete i->second;
-            _colMap.erase(i);
-        }
-        i = next;
-    }
-
+    _colMapSequences.clear();
+    resetColMap(false);
     _stack.resetLinks();
 }
 
@@ -228,12 +290,17 @@ void ColumnIterator::setVisitCache(ColumnIterator::VisitCache *visitCache) {
 }
 
 void ColumnIterator::print(ostream &os) const {
-    const ColumnIterator::ColumnMap *cmap = getColumnMap();
-    for (ColumnIterator::ColumnMap::const_iterator i = cmap->begin(); i != cmap->end(); ++i) {
-        os << i->first->getName() << ": ";
-        for (size_t j = 0; j < i->second->size(); ++j) {
-            os << i->second->at(j)->getArrayIndex() << ", ";
+    const Rows &rows = getRows();
+    for (Rows::const_iterator i = rows.begin(); i != rows.end(); ++i) {
+        if (i == rows.begin() || i->_sequence != (i - 1)->_sequence) {
+            if (i != rows.begin()) {
+                os << "\n";
+            }
+            os << i->_sequence->getName() << ": ";
         }
+        os << i->_dna->getArrayIndex() << ", ";
+    }
+    if (not rows.empty()) {
         os << "\n";
     }
 }
@@ -248,6 +315,7 @@ void ColumnIterator::recursiveUpdate(bool init) {
     clearTree();
     _break = false;
     _leftmostRefPos = _stack[0]->_index;
+    _gaplessLength = numeric_limits<hal_size_t>::max();
 
     const Sequence *refSequence = _stack.top()->_sequence;
     const Genome *refGenome = refSequence->getGenome();
@@ -256,9 +324,12 @@ void ColumnIterator::recursiveUpdate(bool init) {
         LinkedTopIterator *linkTopIt = &_stack.top()->_top;
         // first column, we search the genome for the site
         if (init == true) {
-            linkTopIt->_it = refSequence->getTopSegmentIterator();
+            _pool.releaseIterators(linkTopIt);
+            linkTopIt->_it = _pool.getTopIterator(refGenome);
+            linkTopIt->_dna = _pool.getDnaIterator(refGenome);
             linkTopIt->_it->toSite(_stack.top()->_index, true);
-            linkTopIt->_dna = refGenome->getDnaIterator(_stack.top()->_index);
+            linkTopIt->_dna->jumpTo(_stack.top()->_index);
+            linkTopIt->_dna->setReversed(false);
             if (_stack.top()->_reversed) {
                 linkTopIt->_it->toReverseInPlace();
                 linkTopIt->_dna->toReverse();
@@ -290,6 +361,7 @@ void ColumnIterator::recursiveUpdate(bool init) {
         assert(linkTopIt->_dna->getArrayIndex() == _stack.top()->_index);
         assert(_stack.top()->_index <= _stack.top()->_lastIndex);
         assert(linkTopIt->_it->getStartPosition() == linkTopIt->_dna->getArrayIndex());
+        updateGaplessLength(linkTopIt->_it.get());
 
         if (colMapInsert(linkTopIt->_dna) == false) {
             _break = true;
@@ -307,9 +379,12 @@ void ColumnIterator::recursiveUpdate(bool init) {
         assert(_stack.size() > 0);
         LinkedBottomIterator *linkBotIt = &_stack.top()->_bottom;
         if (init == true) {
-            linkBotIt->_it = refSequence->getBottomSegmentIterator();
+            _pool.releaseIterators(linkBotIt);
+            linkBotIt->_it = _pool.getBottomIterator(refGenome);
+            linkBotIt->_dna = _pool.getDnaIterator(refGenome);
             linkBotIt->_it->toSite(_stack.top()->_index, true);
-            linkBotIt->_dna = refGenome->getDnaIterator(_stack.top()->_index);
+            linkBotIt->_dna->jumpTo(_stack.top()->_index);
+            linkBotIt->_dna->setReversed(false);
             if (_stack.top()->_reversed) {
                 linkBotIt->_it->toReverseInPlace();
                 linkBotIt->_dna->toReverse();
@@ -338,6 +413,7 @@ void ColumnIterator::recursiveUpdate(bool init) {
 
         assert(linkBotIt->_it->getStartPosition() == linkBotIt->_dna->getArrayIndex());
         assert(linkBotIt->_dna->getArrayIndex() == _stack.top()->_index);
+        updateGaplessLength(linkBotIt->_it.get());
 
         if (colMapInsert(linkBotIt->_dna) == false) {
             _break = true;
@@ -430,7 +506,7 @@ static void buildTreeR(BottomSegmentIteratorPtr botSegIt, stTree *tree) {
     // attach a node and recurse for each of this segment's children
     // (and paralogous segments)
     for (hal_size_t i = 0; i < botSegIt->bseg()->getNumChildren(); i++) {
-        if (botSegIt->bseg()->hasChild(i)) {
+        if (botSegIt->hasChild(i)) {
             const Genome *child = genome->getChild(i);
             TopSegmentIteratorPtr topSegIt = child->getTopSegmentIterator();
             topSegIt->toChild(botSegIt, i);
@@ -462,21 +538,10 @@ static void buildTreeR(BottomSegmentIteratorPtr botSegIt, stTree *tree) {
 // Build cached gene-tree from a column iterator.
 stTree *ColumnIterator::buildTree() const {
     // Get any base from the column to begin building the tree
-    const ColumnIterator::ColumnMap *colMap = getColumnMap();
-    ColumnIterator::ColumnMap::const_iterator colMapIt = colMap->begin();
-    const Sequence *sequence = NULL;
-    hal_index_t index = NULL_INDEX;
-    while (colMapIt != colMap->end()) {
-        if (!colMapIt->second->empty()) {
-            // Found a non-empty column map entry, just take the index and
-            // sequence of the first base found
-            sequence = colMapIt->first;
-            index = colMapIt->second->at(0)->getArrayIndex();
-            break;
-        }
-        colMapIt++;
-    }
-    assert(sequence != NULL && index != NULL_INDEX);
+    const Rows &rows = getRows();
+    assert(not rows.empty());
+    const Sequence *sequence = rows[0]._sequence;
+    hal_index_t index = rows[0]._dna->getArrayIndex();
     const Genome *genome = sequence->getGenome();
 
     // Get the bottom segment that is the common ancestor of all entries
@@ -489,7 +554,7 @@ stTree *ColumnIterator::buildTree() const {
     } else {
         // Keep heading up the tree until we hit the root segment.
         topSegIt->toSite(index);
-        while (topSegIt->tseg()->hasParent()) {
+        while (topSegIt->hasParent()) {
             const Genome *parent = topSegIt->getGenome()->getParent();
             botSegIt = parent->getBottomSegmentIterator();
             botSegIt->toParent(topSegIt);
@@ -556,7 +621,7 @@ void ColumnIterator::clearTree() {
 
 void ColumnIterator::updateParent(LinkedTopIterator *linkTopIt) {
     const Genome *genome = linkTopIt->_it->getTopSegment()->getGenome();
-    if (!_break && linkTopIt->_it->tseg()->hasParent() && parentInScope(genome) &&
+    if (!_break && linkTopIt->_it->hasParent() && parentInScope(genome) &&
         (!_noDupes || linkTopIt->_it->tseg()->isCanonicalParalog())) {
         const Genome *parentGenome = genome->getParent();
 
@@ -565,8 +630,8 @@ void ColumnIterator::updateParent(LinkedTopIterator *linkTopIt) {
         if (linkTopIt->_parent == NULL) {
             assert(parentGenome != NULL);
             linkTopIt->_parent = linkTopIt->_entry->newBottom();
-            linkTopIt->_parent->_it = parentGenome->getBottomSegmentIterator();
-            linkTopIt->_parent->_dna = parentGenome->getDnaIterator();
+            linkTopIt->_parent->_it = _pool.getBottomIterator(parentGenome);
+            linkTopIt->_parent->_dna = _pool.getDnaIterator(parentGenome);
             hal_size_t numChildren = parentGenome->getNumChildren();
             if (numChildren > linkTopIt->_parent->_children.size()) {
                 linkTopIt->_parent->_children.resize(numChildren, NULL);
@@ -581,6 +646,7 @@ void ColumnIterator::updateParent(LinkedTopIterator *linkTopIt) {
         // advance the parent's iterator to match linkTopIt's (which should
         // already have been updated.
         linkTopIt->_parent->_it->toParent(linkTopIt->_it);
+        updateGaplessLength(linkTopIt->_parent->_it.get());
         linkTopIt->_parent->_dna->jumpTo(linkTopIt->_parent->_it->getStartPosition());
         linkTopIt->_parent->_dna->setReversed(linkTopIt->_parent->_it->getReversed());
         if (colMapInsert(linkTopIt->_parent->_dna) == false) {
@@ -606,7 +672,7 @@ void ColumnIterator::updateParent(LinkedTopIterator *linkTopIt) {
 
 void ColumnIterator::updateChild(LinkedBottomIterator *linkBotIt, hal_size_t index) {
     const Genome *genome = linkBotIt->_it->getBottomSegment()->getGenome();
-    if (!_break && linkBotIt->_it->bseg()->hasChild(index) && childInScope(genome, index)) {
+    if (!_break && linkBotIt->_it->hasChild(index) && childInScope(genome, index)) {
         assert(index < linkBotIt->_children.size());
         const Genome *childGenome = genome->getChild(index);
 
@@ -615,14 +681,15 @@ void ColumnIterator::updateChild(LinkedBottomIterator *linkBotIt, hal_size_t ind
         if (linkBotIt->_children[index] == NULL) {
             assert(childGenome != NULL);
             linkBotIt->_children[index] = linkBotIt->_entry->newTop();
-            linkBotIt->_children[index]->_it = childGenome->getTopSegmentIterator();
-            linkBotIt->_children[index]->_dna = childGenome->getDnaIterator();
+            linkBotIt->_children[index]->_it = _pool.getTopIterator(childGenome);
+            linkBotIt->_children[index]->_dna = _pool.getDnaIterator(childGenome);
             linkBotIt->_children[index]->_parent = linkBotIt;
         }
 
         // advance the child's iterator to match linkBotIt's (which should
         // have already been updated)
         linkBotIt->_children[index]->_it->toChild(linkBotIt->_it, index);
+        updateGaplessLength(linkBotIt->_children[index]->_it.get());
         linkBotIt->_children[index]->_dna->jumpTo(linkBotIt->_children[index]->_it->getStartPosition());
         linkBotIt->_children[index]->_dna->setReversed(linkBotIt->_children[index]->_it->getReversed());
         if (colMapInsert(linkBotIt->_children[index]->_dna) == false) {
@@ -654,15 +721,16 @@ void ColumnIterator::updateNextTopDup(LinkedTopIterator *linkTopIt) {
         // no linked iterator for paralog. we create a new one and add link
         if (currentTopIt->_nextDup == NULL) {
             currentTopIt->_nextDup = currentTopIt->_entry->newTop();
-            currentTopIt->_nextDup->_it = genome->getTopSegmentIterator();
-            currentTopIt->_nextDup->_dna = genome->getDnaIterator();
+            currentTopIt->_nextDup->_it = _pool.getTopIterator(genome);
+            currentTopIt->_nextDup->_dna = _pool.getDnaIterator(genome);
             currentTopIt->_nextDup->_parent = currentTopIt->_parent;
         }
 
         // advance the dups's iterator to match currentTopIt's (which should
         // have already been updated)
-        currentTopIt->_nextDup->_it = currentTopIt->_it->clone();
+        currentTopIt->_nextDup->_it->copy(currentTopIt->_it);
         currentTopIt->_nextDup->_it->toNextParalogy();
+        updateGaplessLength(currentTopIt->_nextDup->_it.get());
         currentTopIt->_nextDup->_dna->jumpTo(currentTopIt->_nextDup->_it->getStartPosition());
         currentTopIt->_nextDup->_dna->setReversed(currentTopIt->_nextDup->_it->getReversed());
         if (colMapInsert(currentTopIt->_nextDup->_dna) == false) {
@@ -687,13 +755,14 @@ void ColumnIterator::updateParseUp(LinkedBottomIterator *linkBotIt) {
         // no linked iterator for top parse, we create a new one
         if (linkBotIt->_topParse == NULL) {
             linkBotIt->_topParse = linkBotIt->_entry->newTop();
-            linkBotIt->_topParse->_it = genome->getTopSegmentIterator();
-            linkBotIt->_topParse->_dna = genome->getDnaIterator();
+            linkBotIt->_topParse->_it = _pool.getTopIterator(genome);
+            linkBotIt->_topParse->_dna = _pool.getDnaIterator(genome);
             linkBotIt->_topParse->_bottomParse = linkBotIt;
         }
 
         // advance the parse link's iterator to match linkBotIt
         linkBotIt->_topParse->_it->toParseUp(linkBotIt->_it);
+        updateGaplessLength(linkBotIt->_topParse->_it.get());
         linkBotIt->_topParse->_dna->jumpTo(linkBotIt->_topParse->_it->getStartPosition());
         linkBotIt->_topParse->_dna->setReversed(linkBotIt->_topParse->_it->getReversed());
         assert(linkBotIt->_topParse->_dna->getArrayIndex() == linkBotIt->_dna->getArrayIndex());
@@ -715,8 +784,8 @@ void ColumnIterator::updateParseDown(LinkedTopIterator *linkTopIt) {
         // no linked iterator for down parse, we create a new one
         if (linkTopIt->_bottomParse == NULL) {
             linkTopIt->_bottomParse = linkTopIt->_entry->newBottom();
-            linkTopIt->_bottomParse->_it = genome->getBottomSegmentIterator();
-            linkTopIt->_bottomParse->_dna = genome->getDnaIterator();
+            linkTopIt->_bottomParse->_it = _pool.getBottomIterator(genome);
+            linkTopIt->_bottomParse->_dna = _pool.getDnaIterator(genome);
             linkTopIt->_bottomParse->_topParse = linkTopIt;
             hal_size_t numChildren = genome->getNumChildren();
             if (numChildren > linkTopIt->_bottomParse->_children.size()) {
@@ -731,6 +800,7 @@ void ColumnIterator::updateParseDown(LinkedTopIterator *linkTopIt) {
 
         // advance the parse link's iterator to match linkTopIt
         linkTopIt->_bottomParse->_it->toParseDown(linkTopIt->_it);
+        updateGaplessLength(linkTopIt->_bottomParse->_it.get());
 
         linkTopIt->_bottomParse->_dna->jumpTo(linkTopIt->_bottomParse->_it->getStartPosition());
         linkTopIt->_bottomParse->_dna->setReversed(linkTopIt->_bottomParse->_it->getReversed());
@@ -763,7 +833,7 @@ void ColumnIterator::nextFreeIndex() {
     _stack.top()->_index = index;
 }
 
-bool ColumnIterator::colMapInsert(DnaIteratorPtr dnaIt) {
+bool ColumnIterator::colMapInsert(const DnaIteratorPtr &dnaIt) {
     const Sequence *sequence = dnaIt->getSequence();
     const Genome *genome = dnaIt->getGenome();
     assert(sequence != NULL);
@@ -801,14 +871,16 @@ bool ColumnIterator::colMapInsert(DnaIteratorPtr dnaIt) {
     // insert into the column data structure to pass out to client
     if (found == false && (!_noAncestors || genome->getNumChildren() == 0) &&
         (_targets.empty() || _targets.find(genome) != _targets.end())) {
-        ColumnMap::iterator i = _colMap.lower_bound(sequence);
-        if (i != _colMap.end() && !(_colMap.key_comp()(sequence, i->first))) {
-            i->second->push_back(dnaIt);
-        } else {
-            DNASet *dnaSet = new DNASet();
-            dnaSet->push_back(dnaIt);
-            _colMap.insert(i, ColumnMap::value_type(sequence, dnaSet));
+        hal_size_t sequenceId = getSequenceId(sequence);
+        if (not _rows.empty() && sequenceId < _rows.back()._sequenceId) {
+            _rowsSorted = false;
         }
+        _rows.push_back(Row());
+        Row &row = _rows.back();
+        row._sequence = sequence;
+        row._dna = dnaIt;
+        row._sequenceId = sequenceId;
+        row._visit = _rows.size() - 1;
     }
 
     // update leftmost ref pos which is used by isCanonicalOnRef()
@@ -818,15 +890,46 @@ bool ColumnIterator::colMapInsert(DnaIteratorPtr dnaIt) {
     return !found;
 }
 
-void ColumnIterator::resetColMap() {
-    for (ColumnMap::iterator i = _colMap.begin(); i != _colMap.end(); ++i) {
-        i->second->clear();
+/* the genome ranks are looked up by name the first time a genome is seen */
+hal_size_t ColumnIterator::getSequenceId(const Sequence *sequence) {
+    const Genome *genome = sequence->getGenome();
+    map<const Genome *, hal_size_t>::const_iterator i = _genomeRanks.find(genome);
+    if (i == _genomeRanks.end()) {
+        vector<string>::const_iterator name = lower_bound(_genomeNames.begin(), _genomeNames.end(), genome->getName());
+        assert(name != _genomeNames.end() && *name == genome->getName());
+        i = _genomeRanks.insert(make_pair(genome, (hal_size_t)(name - _genomeNames.begin()))).first;
+    }
+    return (i->second << 32) | (hal_size_t)sequence->getArrayIndex();
+}
+
+static bool rowLess(const ColumnIterator::Row &r1, const ColumnIterator::Row &r2) {
+    return (r1._sequenceId < r2._sequenceId) || ((r1._sequenceId == r2._sequenceId) && (r1._visit < r2._visit));
+}
+
+/* the visit order makes the sort stable without std::stable_sort, which
+ * allocates */
+void ColumnIterator::sortRows() const {
+    sort(_rows.begin(), _rows.end(), rowLess);
+    _rowsSorted = true;
+}
+
+// the column map's bases are released too, so the pool can reuse their
+// iterators
+void ColumnIterator::resetColMap(bool clearRows) {
+    for (const ColumnMap::value_type &entry : _colMap._entries) {
+        entry.second->clear();
+    }
+    _colMap._entries.clear();
+    _colMapValid = false;
+    if (clearRows) {
+        _rows.clear();
+        _rowsSorted = true;
     }
 }
 
 void ColumnIterator::eraseColMap() {
-    for (ColumnMap::iterator i = _colMap.begin(); i != _colMap.end(); ++i) {
-        delete i->second;
+    for (DNASet *dnaSet : _dnaSets) {
+        delete dnaSet;
     }
-    _colMap.clear();
+    _dnaSets.clear();
 }
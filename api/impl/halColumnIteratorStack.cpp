@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halColumnIteratorStack.h"
+#include "halBottomSegmentIterator.h"
+#include "halDnaIterator.h"
+#include "halGenome.h"
+#include "halTopSegmentIterator.h"
+
+using namespace std;
+using namespace hal;
+
+ColumnIteratorStack::LinkedTopIterator *ColumnIteratorStack::Entry::newTop() {
+    LinkedTopIterator *top = _pool->newTop(this);
+    _topLinks.push_back(top);
+    return top;
+}
+
+ColumnIteratorStack::LinkedBottomIterator *ColumnIteratorStack::Entry::newBottom() {
+    LinkedBottomIterator *bottom = _pool->newBottom(this);
+    _bottomLinks.push_back(bottom);
+    return bottom;
+}
+
+void ColumnIteratorStack::Entry::freeLinks() {
+    for (LinkedTopIterator *top : _topLinks) {
+        _pool->freeTop(top);
+    }
+    _topLinks.clear();
+    _top._bottomParse = NULL;
+    _top._parent = NULL;
+    _top._nextDup = NULL;
+
+    for (LinkedBottomIterator *bottom : _bottomLinks) {
+        _pool->freeBottom(bottom);
+    }
+    _bottomLinks.clear();
+    _bottom._topParse = NULL;
+    _bottom._children.clear();
+}
+
+ColumnIteratorStack::Pool::~Pool() {
+    for (Entry *entry : _entries) {
+        delete entry;
+    }
+    for (LinkedTopIterator *top : _tops) {
+        delete top;
+    }
+    for (LinkedBottomIterator *bottom : _bottoms) {
+        delete bottom;
+    }
+}
+
+ColumnIteratorStack::Entry *ColumnIteratorStack::Pool::newEntry(const Sequence *seq, hal_index_t first, hal_index_t index,
+                                                                hal_index_t last, hal_size_t size, bool reversed) {
+    Entry *entry;
+    if (_entries.empty()) {
+        entry = new Entry(this);
+        _stats._created++;
+    } else {
+        entry = _entries.back();
+        _entries.pop_back();
+        _stats._reused++;
+    }
+    entry->init(seq, first, index, last, size, reversed);
+    return entry;
+}
+
+/* an entry is returned without links or iterators, so that the
+ * ColumnIterator initializes it for its first column */
+void ColumnIteratorStack::Pool::freeEntry(Entry *entry) {
+    entry->freeLinks();
+    releaseIterators(&entry->_top);
+    releaseIterators(&entry->_bottom);
+    _entries.push_back(entry);
+}
+
+ColumnIteratorStack::LinkedTopIterator *ColumnIteratorStack::Pool::newTop(Entry *entry) {
+    LinkedTopIterator *top;
+    if (_tops.empty()) {
+        top = new LinkedTopIterator();
+        _stats._created++;
+    } else {
+        top = _tops.back();
+        _tops.pop_back();
+        _stats._reused++;
+    }
+    top->_entry = entry;
+    return top;
+}
+
+ColumnIteratorStack::LinkedBottomIterator *ColumnIteratorStack::Pool::newBottom(Entry *entry) {
+    LinkedBottomIterator *bottom;
+    if (_bottoms.empty()) {
+        bottom = new LinkedBottomIterator();
+        _stats._created++;
+    } else {
+        bottom = _bottoms.back();
+        _bottoms.pop_back();
+        _stats._reused++;
+    }
+    bottom->_entry = entry;
+    return bottom;
+}
+
+void ColumnIteratorStack::Pool::freeTop(LinkedTopIterator *top) {
+    releaseIterators(top);
+    top->_bottomParse = NULL;
+    top->_parent = NULL;
+    top->_nextDup = NULL;
+    top->_entry = NULL;
+    _tops.push_back(top);
+}
+
+void ColumnIteratorStack::Pool::freeBottom(LinkedBottomIterator *bottom) {
+    releaseIterators(bottom);
+    bottom->_topParse = NULL;
+    bottom->_children.clear();
+    bottom->_entry = NULL;
+    _bottoms.push_back(bottom);
+}
+
+/* few genomes are visited, so a linear search is fastest */
+ColumnIteratorStack::Pool::GenomeIterators &ColumnIteratorStack::Pool::getGenomeIterators(const Genome *genome) {
+    for (GenomeIterators &genomeIts : _genomes) {
+        if (genomeIts._genome == genome) {
+            return genomeIts;
+        }
+    }
+    _genomes.push_back(GenomeIterators());
+    _genomes.back()._genome = genome;
+    return _genomes.back();
+}
+
+/* take the last free iterator that is held only by the pool, iterators
+ * still held elsewhere are dropped */
+template <typename ITER> static bool takeFree(vector<ITER> &freeIts, ITER &it) {
+    while (not freeIts.empty()) {
+        it.swap(freeIts.back());
+        freeIts.pop_back();
+        if (it.use_count() == 1) {
+            return true;
+        }
+        it.reset();
+    }
+    return false;
+}
+
+TopSegmentIteratorPtr ColumnIteratorStack::Pool::getTopIterator(const Genome *genome) {
+    TopSegmentIteratorPtr topSegIt;
+    if (takeFree(getGenomeIterators(genome)._tops, topSegIt)) {
+        _stats._reused++;
+        if (topSegIt->getReversed()) {
+            topSegIt->setArrayIndex(const_cast<Genome *>(genome), 0);
+            topSegIt->toReverse();
+        }
+    } else {
+        topSegIt = genome->getTopSegmentIterator();
+        _stats._created++;
+    }
+    return topSegIt;
+}
+
+BottomSegmentIteratorPtr ColumnIteratorStack::Pool::getBottomIterator(const Genome *genome) {
+    BottomSegmentIteratorPtr botSegIt;
+    if (takeFree(getGenomeIterators(genome)._bottoms, botSegIt)) {
+        _stats._reused++;
+        if (botSegIt->getReversed()) {
+            botSegIt->setArrayIndex(const_cast<Genome *>(genome), 0);
+            botSegIt->toReverse();
+        }
+    } else {
+        botSegIt = genome->getBottomSegmentIterator();
+        _stats._created++;
+    }
+    return botSegIt;
+}
+
+DnaIteratorPtr ColumnIteratorStack::Pool::getDnaIterator(const Genome *genome) {
+    DnaIteratorPtr dnaIt;
+    if (takeFree(getGenomeIterators(genome)._dnas, dnaIt)) {
+        _stats._reused++;
+    } else {
+        dnaIt = genome->getDnaIterator();
+        _stats._created++;
+    }
+    return dnaIt;
+}
+
+void ColumnIteratorStack::Pool::releaseIterators(LinkedTopIterator *top) {
+    if (top->_it.get() != NULL) {
+        GenomeIterators &genomeIts = getGenomeIterators(top->_it->getGenome());
+        genomeIts._tops.push_back(TopSegmentIteratorPtr());
+        genomeIts._tops.back().swap(top->_it);
+    }
+    if (top->_dna.get() != NULL) {
+        GenomeIterators &genomeIts = getGenomeIterators(top->_dna->getGenome());
+        genomeIts._dnas.push_back(DnaIteratorPtr());
+        genomeIts._dnas.back().swap(top->_dna);
+    }
+}
+
+void ColumnIteratorStack::Pool::releaseIterators(LinkedBottomIterator *bottom) {
+    if (bottom->_it.get() != NULL) {
+        GenomeIterators &genomeIts = getGenomeIterators(bottom->_it->getGenome());
+        genomeIts._bottoms.push_back(BottomSegmentIteratorPtr());
+        genomeIts._bottoms.back().swap(bottom->_it);
+    }
+    if (bottom->_dna.get() != NULL) {
+        GenomeIterators &genomeIts = getGenomeIterators(bottom->_dna->getGenome());
+        genomeIts._dnas.push_back(DnaIteratorPtr());
+        genomeIts._dnas.back().swap(bottom->_dna);
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halCommon.h"
+#include <algorithm>
+#include <cstdint>
+#if defined(__x86_64__) && defined(__GNUC__)
+#define HAL_DNA_UNPACK_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace hal;
+
+/*
+ * Bulk decoding of nibble-encoded DNA.  Each byte holds two bases, the
+ * first in the high nibble.  A nibble is mapped to a character with a
+ * 16-entry table, which is exactly the size of a SSSE3/AVX2 byte shuffle.
+ * The SIMD versions are compiled with target attributes and selected at
+ * run time, so no special compiler flags are needed.
+ */
+
+/* map of 4-bit encoding to complement character */
+static const char dnaUnpackComplementMap[16] = {'t', 'g', 'c', 'a', 'n', '\x00', '\x00', '\x00',
+                                                'T', 'G', 'C', 'A', 'N', '\x00', '\x00', '\x00'};
+
+typedef void (*UnpackBytesFunc)(const uint8_t *packed, size_t numBytes, const char *map, char *out);
+
+static void unpackBytesScalar(const uint8_t *packed, size_t numBytes, const char *map, char *out) {
+    for (size_t i = 0; i < numBytes; i++) {
+        out[2 * i] = map[packed[i] >> 4];
+        out[2 * i + 1] = map[packed[i] & 0x0F];
+    }
+}
+
+#ifdef HAL_DNA_UNPACK_X86
+__attribute__((target("ssse3"))) static void unpackBytesSsse3(const uint8_t *packed, size_t numBytes, const char *map,
+                                                              char *out) {
+    const __m128i table = _mm_loadu_si128(reinterpret_cast<const __m128i *>(map));
+    const __m128i lowMask = _mm_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 16 <= numBytes; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(packed + i));
+        __m128i high = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(bytes, 4), lowMask));
+        __m128i low = _mm_shuffle_epi8(table, _mm_and_si128(bytes, lowMask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
+    }
+    unpackBytesScalar(packed + i, numBytes - i, map, out + 2 * i);
+}
+
+__attribute__((target("avx2"))) static void unpackBytesAvx2(const uint8_t *packed, size_t numBytes, const char *map,
+                                                            char *out) {
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(map)));
+    const __m256i lowMask = _mm256_set1_epi8(0x0F);
+    size_t i = 0;
+    for (; i + 32 <= numBytes; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(packed + i));
+        __m256i high = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), lowMask));
+        __m256i low = _mm256_shuffle_epi8(table, _mm256_and_si256(bytes, lowMask));
+        // unpack works within 128-bit lanes, so put the lanes back in order
+        __m256i first = _mm256_unpacklo_epi8(high, low);
+        __m256i second = _mm256_unpackhi_epi8(high, low);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i), _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 2 * i + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    unpackBytesScalar(packed + i, numBytes - i, map, out + 2 * i);
+}
+#endif
+
+static UnpackBytesFunc selectUnpackBytes() {
+#ifdef HAL_DNA_UNPACK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return unpackBytesAvx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return unpackBytesSsse3;
+    }
+#endif
+    return unpackBytesScalar;
+}
+
+
+void hal::dnaUnpackString(const char *packed, hal_index_t index, hal_size_t length, bool reverseComplement,
+                          char *outBuffer) {
+    const char *map = reverseComplement ? dnaUnpackComplementMap : dnaUnpackMap;
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(packed);
+    char *out = outBuffer;
+    if ((length > 0) and (index & 1)) {
+        *out++ = map[bytes[index / 2] & 0x0F];
+        index++;
+        length--;
+    }
+    static const UnpackBytesFunc unpackBytes = selectUnpackBytes();
+    hal_size_t numBytes = length / 2;
+    unpackBytes(bytes + index / 2, numBytes, map, out);
+    out += 2 * numBytes;
+    index += 2 * numBytes;
+    if (length & 1) {
+        *out++ = map[bytes[index / 2] >> 4];
+    }
+    if (reverseComplement) {
+        std::reverse(outBuffer, out);
+    }
+}
@@ -22,6 +22,11 @@ MappedSegment::MappedSegment(SegmentIteratorPtr sourceSegIt, SegmentIteratorPtr
     assert(_source->getLength() == _target->getLength());
 }
 
+MappedSegment::MappedSegment(const MappedSegmentRecord &record)
+    : _source(record._source.makeIterator()), _target(record._target.makeIterator()) {
+    assert(_source->getLength() == _target->getLength());
+}
+
 bool hal::MappedSegmentLess::operator()(const hal::MappedSegment &m1, const hal::MappedSegment &m2) const {
     return m1.lessThan(&m2);
 }
@@ -30,6 +35,53 @@ bool hal::MappedSegmentLess::operator()(const hal::MappedSegmentPtr &m1, const h
     return m1->lessThan(m2.get());
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// SLICED SEGMENT RECORD
+//////////////////////////////////////////////////////////////////////////////
+SlicedSegmentRecord::SlicedSegmentRecord(const SegmentIterator *segIt)
+    : _genome(segIt->getGenome()), _arrayIndex(segIt->getArrayIndex()), _segStart(segIt->getSegment()->getStartPosition()),
+      _segLength(segIt->getSegment()->getLength()), _startOffset(segIt->getStartOffset()),
+      _endOffset(segIt->getEndOffset()), _isTop(segIt->isTop()), _reversed(segIt->getReversed()) {
+}
+
+void SlicedSegmentRecord::loadIterator(SegmentIterator *segIt) const {
+    assert(segIt->isTop() == _isTop);
+    segIt->setArrayIndex(const_cast<Genome *>(_genome), _arrayIndex);
+    segIt->slice(_startOffset, _endOffset);
+    if (segIt->getReversed() != _reversed) {
+        segIt->toReverse();
+    }
+}
+
+SegmentIteratorPtr SlicedSegmentRecord::makeIterator() const {
+    SegmentIteratorPtr segIt;
+    if (_isTop) {
+        segIt = _genome->getTopSegmentIterator(_arrayIndex);
+    } else {
+        segIt = _genome->getBottomSegmentIterator(_arrayIndex);
+    }
+    if (_reversed) {
+        segIt->toReverse();
+    }
+    segIt->slice(_startOffset, _endOffset);
+    return segIt;
+}
+
+int SlicedSegmentRecord::compare(const SlicedSegmentRecord &other) const {
+    assert(_genome == other._genome);
+    hal_index_t lo1 = _segStart + (hal_index_t)(_reversed ? _endOffset : _startOffset);
+    hal_index_t lo2 = other._segStart + (hal_index_t)(other._reversed ? other._endOffset : other._startOffset);
+    if (lo1 != lo2) {
+        return (lo1 < lo2) ? -1 : 1;
+    }
+    hal_index_t hi1 = lo1 + (hal_index_t)getLength();
+    hal_index_t hi2 = lo2 + (hal_index_t)other.getLength();
+    if (hi1 != hi2) {
+        return (hi1 < hi2) ? -1 : 1;
+    }
+    return 0;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // MAPPED SEGMENT INTERFACE
 //////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halMappedSegmentVector.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+using namespace hal;
+
+static hal_index_t getLowPosition(const SlicedSegmentRecord &seg) {
+    return min(seg.getStartPosition(), seg.getEndPosition());
+}
+
+static hal_index_t getHighPosition(const SlicedSegmentRecord &seg) {
+    return max(seg.getStartPosition(), seg.getEndPosition());
+}
+
+/* cut a segment to the part whose target is in [lowPos, highPos] */
+static MappedSegmentRecord cutSegment(const MappedSegmentRecord &mappedSeg, hal_index_t lowPos, hal_index_t highPos) {
+    hal_offset_t lowDelta = lowPos - getLowPosition(mappedSeg._target);
+    hal_offset_t highDelta = getHighPosition(mappedSeg._target) - highPos;
+    hal_offset_t startDelta = mappedSeg._target._reversed ? highDelta : lowDelta;
+    hal_offset_t endDelta = mappedSeg._target._reversed ? lowDelta : highDelta;
+    MappedSegmentRecord piece(mappedSeg);
+    piece._target.slice(piece._target._startOffset + startDelta, piece._target._endOffset + endDelta);
+    piece._source.slice(piece._source._startOffset + startDelta, piece._source._endOffset + endDelta);
+    assert(piece._source.getLength() == piece._target.getLength());
+    return piece;
+}
+
+void MappedSegmentVector::resolve() {
+    if (_resolved) {
+        return;
+    }
+    // A target is cut wherever another target starts or ends within it,
+    // which is the result of cutting overlaps as each segment is inserted.
+    vector<hal_index_t> cuts;
+    cuts.reserve(2 * _segments.size());
+    for (const MappedSegmentRecord &mappedSeg : _segments) {
+        cuts.push_back(getLowPosition(mappedSeg._target));
+        cuts.push_back(getHighPosition(mappedSeg._target) + 1);
+    }
+    sort(cuts.begin(), cuts.end());
+    cuts.erase(unique(cuts.begin(), cuts.end()), cuts.end());
+
+    vector<MappedSegmentRecord> pieces;
+    pieces.reserve(_segments.size());
+    for (const MappedSegmentRecord &mappedSeg : _segments) {
+        hal_index_t lowPos = getLowPosition(mappedSeg._target);
+        hal_index_t highPos = getHighPosition(mappedSeg._target);
+        vector<hal_index_t>::const_iterator cutIt = upper_bound(cuts.begin(), cuts.end(), lowPos);
+        if (*cutIt > highPos) {
+            pieces.push_back(mappedSeg);
+            continue;
+        }
+        for (; *cutIt <= highPos; ++cutIt) {
+            pieces.push_back(cutSegment(mappedSeg, lowPos, *cutIt - 1));
+            lowPos = *cutIt;
+        }
+        pieces.push_back(cutSegment(mappedSeg, lowPos, highPos));
+    }
+
+    // stable, so the first of any duplicates added is kept, as a set would
+    stable_sort(pieces.begin(), pieces.end(), MappedSegmentRecord::Less());
+    pieces.erase(unique(pieces.begin(), pieces.end(), MappedSegmentRecord::EqualTo()), pieces.end());
+    _segments.swap(pieces);
+    _resolved = true;
+}
+
+void MappedSegmentVector::toSet(MappedSegmentSet &segSet) const {
+    assert(_resolved);
+    segSet.clear();
+    for (const MappedSegmentRecord &mappedSeg : _segments) {
+        segSet.insert(segSet.end(), MappedSegmentPtr(new MappedSegment(mappedSeg)));
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halProjectionCache.h"
+#include "halBottomSegmentIterator.h"
+#include "halGenome.h"
+#include "halTopSegmentIterator.h"
+#include <iomanip>
+
+using namespace std;
+using namespace hal;
+
+ProjectionCache::ProjectionCache(const Genome *genome, hal_index_t childIndex, size_t maxBytes, ProjectionCacheStats *stats)
+    : _genome(genome), _childIndex(childIndex),
+      _numSegments((childIndex == NULL_INDEX) ? genome->getNumTopSegments() : genome->getNumBottomSegments()),
+      _maxPages(max(size_t(1), maxBytes / (PAGE_SIZE * sizeof(hal_index_t)))), _stats(stats),
+      _pages((_numSegments + PAGE_SIZE - 1) / PAGE_SIZE) {
+}
+
+/* read the projections of a page of segments through the genome's
+ * segment objects, dropping the oldest page if over budget */
+const vector<hal_index_t> &ProjectionCache::loadPage(hal_size_t pageNum) {
+    if (_loadedPages.size() >= _maxPages) {
+        vector<hal_index_t>().swap(_pages[_loadedPages.front()]);
+        _loadedPages.pop_front();
+        _stats->_evictions++;
+    }
+    hal_index_t first = pageNum * PAGE_SIZE;
+    hal_index_t last = min(first + (hal_index_t)PAGE_SIZE, (hal_index_t)_numSegments);
+    vector<hal_index_t> &page = _pages[pageNum];
+    page.resize(last - first);
+    Genome *genome = const_cast<Genome *>(_genome);
+    if (_childIndex == NULL_INDEX) {
+        TopSegmentIteratorPtr topSegIt = _genome->getTopSegmentIterator();
+        for (hal_index_t i = first; i < last; ++i) {
+            topSegIt->setArrayIndex(genome, i);
+            page[i - first] = 2 * topSegIt->tseg()->getParentIndex() + (topSegIt->tseg()->getParentReversed() ? 1 : 0);
+        }
+    } else {
+        BottomSegmentIteratorPtr botSegIt = _genome->getBottomSegmentIterator();
+        for (hal_index_t i = first; i < last; ++i) {
+            botSegIt->setArrayIndex(genome, i);
+            page[i - first] =
+                2 * botSegIt->bseg()->getChildIndex(_childIndex) + (botSegIt->bseg()->getChildReversed(_childIndex) ? 1 : 0);
+        }
+    }
+    _loadedPages.push_back(pageNum);
+    return page;
+}
+
+string ProjectionCache::getPairName(const Genome *genome, hal_index_t childIndex) {
+    const Genome *target = (childIndex == NULL_INDEX) ? genome->getParent() : genome->getChild(childIndex);
+    return genome->getName() + "->" + target->getName();
+}
+
+static void printStatsLine(const string &name, const ProjectionCacheStats &stats, ostream &out) {
+    size_t lookups = stats._hits + stats._misses;
+    double hitRate = (lookups == 0) ? 0.0 : double(stats._hits) / double(lookups);
+    out << name << "\t" << stats._hits << "\t" << stats._misses << "\t" << stats._evictions << "\t" << fixed
+        << setprecision(4) << hitRate << endl;
+}
+
+void ProjectionCache::printStats(const map<string, ProjectionCacheStats> &allStats, ostream &out) {
+    ProjectionCacheStats total;
+    out << "projectionCache\thits\tmisses\tevictions\thitRate" << endl;
+    for (const auto &name_stats : allStats) {
+        printStatsLine(name_stats.first, name_stats.second, out);
+        total._hits += name_stats.second._hits;
+        total._misses += name_stats.second._misses;
+        total._evictions += name_stats.second._evictions;
+    }
+    printStatsLine("total", total, out);
+}
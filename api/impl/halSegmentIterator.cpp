@@ -119,6 +119,18 @@ bool SegmentIterator::isMissingData(double nThreshold) const {
     return getSegment()->isMissingData(nThreshold);
 }
 
+void SegmentIterator::prefetchTo(hal_index_t lastIndex) const {
+    hal_index_t firstIndex = getArrayIndex();
+    if (lastIndex < firstIndex) {
+        swap(firstIndex, lastIndex);
+    }
+    if (isTop()) {
+        getGenome()->prefetchTopSegments(firstIndex, lastIndex);
+    } else {
+        getGenome()->prefetchBottomSegments(firstIndex, lastIndex);
+    }
+}
+
 bool SegmentIterator::isTop() const {
     return getSegment()->isTop();
 }
@@ -8,9 +8,13 @@
 #include "halBottomSegmentIterator.h"
 #include "halCommon.h"
 #include "halMappedSegment.h"
+#include "halMappedSegmentVector.h"
 #include "halSegment.h"
+#include "halSegmentCursor.h"
 #include "halSegmentIterator.h"
 #include "halTopSegmentIterator.h"
+#include "mmapSegmentAccess.h"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -19,80 +23,116 @@ using namespace hal;
 
 enum OverlapCat { Same, Disjoint, AContainsB, BContainsA, AOverlapsLeftOfB, BOverlapsLeftOfA };
 
-static hal_size_t mapSelf(MappedSegmentPtr mappedSeg, list<MappedSegmentPtr> &results, hal_size_t minLength);
+/*
+ * Segments being mapped are kept as MappedSegmentRecords in vectors that are
+ * reused between levels of the tree.  To follow alignment edges, a record
+ * is loaded into a segment cursor (halSegmentCursor.h), which reads the
+ * segments through the accessors of its genome.  The accessors are created
+ * once per genome for each halMapSegment or halMapSegments call.  The
+ * mapping functions are templates over the storage traits of the accessors,
+ * so that the segment arrays of mmap alignments are read directly, without
+ * virtual calls.  MappedSegments are only created for the final results.
+ */
+typedef vector<MappedSegmentRecord> MappedSegmentRecords;
+
+template <class Access>
+static hal_size_t mapSelf(const MappedSegmentRecord &mappedSeg, MappedSegmentRecords &results, hal_size_t minLength,
+                          SegmentAccessCache<Access> &access);
+
+// apply the change in offsets of a target when it is mapped to a source
+static SlicedSegmentRecord sliceSource(const SlicedSegmentRecord &source, hal_index_t startDelta, hal_index_t endDelta) {
+    SlicedSegmentRecord newSource(source);
+    assert((hal_index_t)newSource.getLength() > startDelta + endDelta);
+    newSource.slice(newSource._startOffset + startDelta, newSource._endOffset + endDelta);
+    return newSource;
+}
+
+// map the source whose target is topCursor to the parent.
+template <class Access>
+static hal_size_t mapTopUp(const SlicedSegmentRecord &source, hal_size_t inputIndex, const TopSegmentCursor<Access> &topCursor,
+                           MappedSegmentRecords &results, bool doDupes, hal_size_t minLength,
+                           SegmentAccessCache<Access> &access) {
+    if (topCursor.hasParent() == true && topCursor.getLength() >= minLength &&
+        (doDupes == true || topCursor.isCanonicalParalog() == true)) {
+        BottomSegmentCursor<Access> botCursor;
+        botCursor.toParent(topCursor, access.getBottom(topCursor.getGenome()->getParent()));
+        results.push_back(MappedSegmentRecord(source, botCursor.getRecord(), inputIndex));
+        return 1;
+    }
+    return 0;
+}
 
-// note: takes smart pointer as it maybe added to the results
-static hal_size_t mapUp(MappedSegmentPtr mappedSeg, list<MappedSegmentPtr> &results, bool doDupes, hal_size_t minLength) {
-    const Genome *parent = mappedSeg->getGenome()->getParent();
-    assert(parent != NULL);
+template <class Access>
+static hal_size_t mapUp(const MappedSegmentRecord &mappedSeg, MappedSegmentRecords &results, bool doDupes,
+                        hal_size_t minLength, SegmentAccessCache<Access> &access) {
+    const Genome *genome = mappedSeg.getGenome();
+    assert(genome->getParent() != NULL);
+    TopSegmentCursor<Access> topCursor;
+    if (mappedSeg._target._isTop == true) {
+        topCursor.load(access.getTop(genome), mappedSeg._target);
+        return mapTopUp(mappedSeg._source, mappedSeg._inputIndex, topCursor, results, doDupes, minLength, access);
+    }
     hal_size_t added = 0;
-    if (mappedSeg->isTop() == true) {
-        BottomSegmentIteratorPtr botSegIt = parent->getBottomSegmentIterator();
-        TopSegmentIteratorPtr topSegIt = mappedSeg->targetAsTop();
-        if (topSegIt->tseg()->hasParent() == true && topSegIt->getLength() >= minLength &&
-            (doDupes == true || topSegIt->tseg()->isCanonicalParalog() == true)) {
-            botSegIt->toParent(topSegIt);
-            mappedSeg->setTarget(std::dynamic_pointer_cast<SegmentIterator>(botSegIt));
-            results.push_back(mappedSeg);
-            ++added;
+    hal_index_t rightCutoff = mappedSeg._target.getEndPosition();
+    BottomSegmentCursor<Access> botCursor;
+    botCursor.load(access.getBottom(genome), mappedSeg._target);
+    hal_index_t startOffset = (hal_index_t)botCursor.getStartOffset();
+    hal_index_t endOffset = (hal_index_t)botCursor.getEndOffset();
+    BottomSegmentCursor<Access> backBotCursor;
+    topCursor.toParseUp(botCursor, access.getTop(genome));
+    do {
+        // we map the new target back to see how the offsets have
+        // changed.  these changes are then applied to the source segment
+        // as deltas
+        backBotCursor.toParseDown(topCursor, botCursor.getAccess());
+        hal_index_t startBack = (hal_index_t)backBotCursor.getStartOffset();
+        hal_index_t endBack = (hal_index_t)backBotCursor.getEndOffset();
+        assert(startBack >= startOffset);
+        assert(endBack >= endOffset);
+        SlicedSegmentRecord newSource = sliceSource(mappedSeg._source, startBack - startOffset, endBack - endOffset);
+        added += mapTopUp(newSource, mappedSeg._inputIndex, topCursor, results, doDupes, minLength, access);
+        // stupid that we have to make this check but odn't want to
+        // make fundamental api change now
+        if (topCursor.getEndPosition() != rightCutoff) {
+            topCursor.toRight(rightCutoff);
+        } else {
+            break;
         }
-    } else {
-        hal_index_t rightCutoff = mappedSeg->getEndPosition();
-        BottomSegmentIteratorPtr botSegIt = mappedSeg->targetAsBottom();
-        hal_index_t startOffset = (hal_index_t)botSegIt->getStartOffset();
-        hal_index_t endOffset = (hal_index_t)botSegIt->getEndOffset();
-        TopSegmentIteratorPtr topSegIt = mappedSeg->getGenome()->getTopSegmentIterator();
-        topSegIt->toParseUp(botSegIt);
-        do {
-            TopSegmentIteratorPtr newTopSegIt = topSegIt->clone();
-
-            // we map the new target back to see how the offsets have
-            // changed.  these changes are then applied to the source segment
-            // as deltas
-            BottomSegmentIteratorPtr backBotSegIt = botSegIt->clone();
-            backBotSegIt->toParseDown(newTopSegIt);
-            hal_index_t startBack = (hal_index_t)backBotSegIt->getStartOffset();
-            hal_index_t endBack = (hal_index_t)backBotSegIt->getEndOffset();
-            assert(startBack >= startOffset);
-            assert(endBack >= endOffset);
-            SegmentIteratorPtr newSourceSegIt = mappedSeg->sourceClone();
-            hal_index_t startDelta = startBack - startOffset;
-            hal_index_t endDelta = endBack - endOffset;
-            assert((hal_index_t)newSourceSegIt->getLength() > startDelta + endDelta);
-            newSourceSegIt->slice(newSourceSegIt->getStartOffset() + startDelta, newSourceSegIt->getEndOffset() + endDelta);
-
-            MappedSegmentPtr newMappedSeg(new MappedSegment(newSourceSegIt, newTopSegIt));
-
-            assert(newMappedSeg->isTop() == true);
-            assert(newMappedSeg->getSource()->getGenome() == mappedSeg->getSource()->getGenome());
-
-            added += mapUp(newMappedSeg, results, doDupes, minLength);
-            // stupid that we have to make this check but odn't want to
-            // make fundamental api change now
-            if (topSegIt->getEndPosition() != rightCutoff) {
-                topSegIt->toRight(rightCutoff);
-            } else {
-                break;
-            }
-        } while (true);
-    }
+    } while (true);
     return added;
 }
 
+// order by input, then by source
+static bool lessInputSource(const MappedSegmentRecord &ms1, const MappedSegmentRecord &ms2) {
+    if (ms1._inputIndex != ms2._inputIndex) {
+        return ms1._inputIndex < ms2._inputIndex;
+    }
+    return ms1.lessThanBySource(ms2);
+}
+
+static bool equalInput(const MappedSegmentRecord &ms1, const MappedSegmentRecord &ms2) {
+    return (ms1._inputIndex == ms2._inputIndex) && ms1.equals(ms2);
+}
+
+// sort by source and remove duplicates, keeping the segments of each
+// input separate
+static void sortUnique(MappedSegmentRecords &segs) {
+    stable_sort(segs.begin(), segs.end(), lessInputSource);
+    segs.erase(unique(segs.begin(), segs.end(), equalInput), segs.end());
+}
+
 // Map the input segments up until reaching the target genome. If the
 // target genome is below the source genome, fail miserably.
-// Destructive to any data in the input or results list.
-static hal_size_t mapRecursiveUp(list<MappedSegmentPtr> &input, list<MappedSegmentPtr> &results, const Genome *tgtGenome,
-                                 hal_size_t minLength) {
-    list<MappedSegmentPtr> *inputPtr = &input;
-    list<MappedSegmentPtr> *outputPtr = &results;
-
-    if (inputPtr->empty() || (*inputPtr->begin())->getGenome() == tgtGenome) {
-        results = *inputPtr;
+// Destructive to any data in the input or results vector.
+template <class Access>
+static hal_size_t mapRecursiveUp(MappedSegmentRecords &input, MappedSegmentRecords &results, const Genome *tgtGenome,
+                                 hal_size_t minLength, SegmentAccessCache<Access> &access) {
+    if (input.empty() || input.front().getGenome() == tgtGenome) {
+        results.swap(input);
         return 0;
     }
 
-    const Genome *curGenome = (*inputPtr->begin())->getGenome();
+    const Genome *curGenome = input.front().getGenome();
     assert(curGenome != NULL);
     const Genome *nextGenome = curGenome->getParent();
 
@@ -102,108 +142,92 @@ static hal_size_t mapRecursiveUp(list<MappedSegmentPtr> &input, list<MappedSegme
     }
 
     // Map all segments to the parent.
-    list<MappedSegmentPtr>::iterator i = inputPtr->begin();
-    for (; i != inputPtr->end(); ++i) {
-        assert((*i)->getGenome() == curGenome);
-        mapUp(*i, *outputPtr, true, minLength);
+    results.clear();
+    for (const MappedSegmentRecord &mappedSeg : input) {
+        assert(mappedSeg.getGenome() == curGenome);
+        mapUp(mappedSeg, results, true, minLength, access);
     }
 
     if (nextGenome != tgtGenome) {
         // Continue the recursion.
-        swap(inputPtr, outputPtr);
-        outputPtr->clear();
-        mapRecursiveUp(*inputPtr, *outputPtr, tgtGenome, minLength);
-    }
-
-    if (outputPtr != &results) {
-        results = *outputPtr;
+        input.clear();
+        mapRecursiveUp(results, input, tgtGenome, minLength, access);
+        results.swap(input);
     }
 
-    results.sort(MappedSegment::LessSourcePtr());
-    results.unique(MappedSegment::EqualToPtr());
+    sortUnique(results);
     return results.size();
 }
 
-// note: takes smart pointer as it maybe added to the results
-static hal_size_t mapDown(MappedSegmentPtr mappedSeg, hal_size_t childIndex, list<MappedSegmentPtr> &results,
-                          hal_size_t minLength) {
-    const Genome *child = mappedSeg->getGenome()->getChild(childIndex);
-    assert(child != NULL);
+// map the source whose target is botCursor to the child.
+template <class Access>
+static hal_size_t mapBottomDown(const SlicedSegmentRecord &source, hal_size_t inputIndex,
+                                const BottomSegmentCursor<Access> &botCursor, hal_size_t childIndex,
+                                MappedSegmentRecords &results, hal_size_t minLength, SegmentAccessCache<Access> &access) {
+    if (botCursor.hasChild(childIndex) == true && botCursor.getLength() >= minLength) {
+        TopSegmentCursor<Access> topCursor;
+        topCursor.toChild(botCursor, childIndex, access.getTop(botCursor.getGenome()->getChild(childIndex)));
+        results.push_back(MappedSegmentRecord(source, topCursor.getRecord(), inputIndex));
+        return 1;
+    }
+    return 0;
+}
+
+template <class Access>
+static hal_size_t mapDown(const MappedSegmentRecord &mappedSeg, hal_size_t childIndex, MappedSegmentRecords &results,
+                          hal_size_t minLength, SegmentAccessCache<Access> &access) {
+    const Genome *genome = mappedSeg.getGenome();
+    assert(genome->getChild(childIndex) != NULL);
+    BottomSegmentCursor<Access> botCursor;
+    if (mappedSeg._target._isTop == false) {
+        botCursor.load(access.getBottom(genome), mappedSeg._target);
+        return mapBottomDown(mappedSeg._source, mappedSeg._inputIndex, botCursor, childIndex, results, minLength, access);
+    }
     hal_size_t added = 0;
-    if (mappedSeg->isTop() == false) {
-        TopSegmentIteratorPtr topSegIt = child->getTopSegmentIterator();
-        SegmentIteratorPtr targetSegIt = mappedSeg->getTargetIteratorPtr();
-        BottomSegmentIteratorPtr botSegIt = std::dynamic_pointer_cast<BottomSegmentIterator>(targetSegIt);
-
-        if (botSegIt->bseg()->hasChild(childIndex) == true && botSegIt->getLength() >= minLength) {
-            topSegIt->toChild(botSegIt, childIndex);
-            mappedSeg->setTarget(std::dynamic_pointer_cast<SegmentIterator>(topSegIt));
-            results.push_back(MappedSegmentPtr(mappedSeg));
-            ++added;
+    hal_index_t rightCutoff = mappedSeg._target.getEndPosition();
+    TopSegmentCursor<Access> topCursor;
+    topCursor.load(access.getTop(genome), mappedSeg._target);
+    hal_index_t startOffset = (hal_index_t)topCursor.getStartOffset();
+    hal_index_t endOffset = (hal_index_t)topCursor.getEndOffset();
+    TopSegmentCursor<Access> backTopCursor;
+    botCursor.toParseDown(topCursor, access.getBottom(genome));
+    do {
+        // we map the new target back to see how the offsets have
+        // changed.  these changes are then applied to the source segment
+        // as deltas
+        backTopCursor.toParseUp(botCursor, topCursor.getAccess());
+        hal_index_t startBack = (hal_index_t)backTopCursor.getStartOffset();
+        hal_index_t endBack = (hal_index_t)backTopCursor.getEndOffset();
+        assert(startBack >= startOffset);
+        assert(endBack >= endOffset);
+        SlicedSegmentRecord newSource = sliceSource(mappedSeg._source, startBack - startOffset, endBack - endOffset);
+        added += mapBottomDown(newSource, mappedSeg._inputIndex, botCursor, childIndex, results, minLength, access);
+
+        // stupid that we have to make this check but odn't want to
+        // make fundamental api change now
+        if (botCursor.getEndPosition() != rightCutoff) {
+            botCursor.toRight(rightCutoff);
+        } else {
+            break;
         }
-    } else {
-        hal_index_t rightCutoff = mappedSeg->getEndPosition();
-        TopSegmentIteratorPtr topSegIt = mappedSeg->targetAsTop();
-        hal_index_t startOffset = (hal_index_t)topSegIt->getStartOffset();
-        hal_index_t endOffset = (hal_index_t)topSegIt->getEndOffset();
-        BottomSegmentIteratorPtr botSegIt = mappedSeg->getGenome()->getBottomSegmentIterator();
-        botSegIt->toParseDown(topSegIt);
-        do {
-            BottomSegmentIteratorPtr newBotSegIt = botSegIt->clone();
-
-            // we map the new target back to see how the offsets have
-            // changed.  these changes are then applied to the source segment
-            // as deltas
-            TopSegmentIteratorPtr backTopSegIt = topSegIt->clone();
-            backTopSegIt->toParseUp(newBotSegIt);
-            hal_index_t startBack = (hal_index_t)backTopSegIt->getStartOffset();
-            hal_index_t endBack = (hal_index_t)backTopSegIt->getEndOffset();
-            assert(startBack >= startOffset);
-            assert(endBack >= endOffset);
-            SegmentIteratorPtr newSourceSegIt = mappedSeg->sourceClone();
-            hal_index_t startDelta = startBack - startOffset;
-            hal_index_t endDelta = endBack - endOffset;
-            assert((hal_index_t)newSourceSegIt->getLength() > startDelta + endDelta);
-            newSourceSegIt->slice(newSourceSegIt->getStartOffset() + startDelta, newSourceSegIt->getEndOffset() + endDelta);
-
-            MappedSegmentPtr newMappedSeg(new MappedSegment(newSourceSegIt, newBotSegIt));
-
-            assert(newMappedSeg->isTop() == false);
-            assert(newMappedSeg->getSource()->getGenome() == mappedSeg->getSource()->getGenome());
-
-            added += mapDown(newMappedSeg, childIndex, results, minLength);
-
-            // stupid that we have to make this check but odn't want to
-            // make fundamental api change now
-            if (botSegIt->getEndPosition() != rightCutoff) {
-                botSegIt->toRight(rightCutoff);
-            } else {
-                break;
-            }
-        } while (true);
-    }
+    } while (true);
     return added;
 }
 
 // Map the input segments down until reaching the target genome. If the
 // target genome is above the source genome, fail miserably.
-// Destructive to any data in the input or results list.
-static hal_size_t mapRecursiveDown(list<MappedSegmentPtr> &input, list<MappedSegmentPtr> &results, const Genome *tgtGenome,
-                                   const set<string> &namesOnPath, bool doDupes, hal_size_t minLength) {
-    list<MappedSegmentPtr> *inputPtr = &input;
-    list<MappedSegmentPtr> *outputPtr = &results;
-
-    if (inputPtr->empty()) {
-        results = *inputPtr;
+// Destructive to any data in the input or results vector.
+template <class Access>
+static hal_size_t mapRecursiveDown(MappedSegmentRecords &input, MappedSegmentRecords &results, const Genome *tgtGenome,
+                                   const set<string> &namesOnPath, bool doDupes, hal_size_t minLength,
+                                   SegmentAccessCache<Access> &access) {
+    if (input.empty() || input.front().getGenome() == tgtGenome) {
+        results.swap(input);
         return 0;
     }
 
-    const Genome *curGenome = (*inputPtr->begin())->getGenome();
+    const Genome *curGenome = input.front().getGenome();
     assert(curGenome != NULL);
-    if (curGenome == tgtGenome) {
-        results = *inputPtr;
-        return 0;
-    }
 
     // Find the correct child to move down into.
     const Genome *nextGenome = NULL;
@@ -226,106 +250,88 @@ static hal_size_t mapRecursiveDown(list<MappedSegmentPtr> &input, list<MappedSeg
     assert(nextGenome->getParent() == curGenome);
 
     // Map the actual segments down.
-    list<MappedSegmentPtr>::iterator i = inputPtr->begin();
-    for (; i != inputPtr->end(); ++i) {
-        assert((*i)->getGenome() == curGenome);
-        mapDown(*i, nextChildIndex, *outputPtr, minLength);
+    results.clear();
+    for (const MappedSegmentRecord &mappedSeg : input) {
+        assert(mappedSeg.getGenome() == curGenome);
+        mapDown(mappedSeg, nextChildIndex, results, minLength, access);
     }
 
     // Find paralogs.
     if (doDupes == true) {
-        swap(inputPtr, outputPtr);
-        outputPtr->clear();
-        list<MappedSegmentPtr>::iterator i = inputPtr->begin();
-        for (; i != inputPtr->end(); ++i) {
-            assert((*i)->getGenome() == nextGenome);
-            mapSelf(*i, *outputPtr, minLength);
+        input.clear();
+        for (const MappedSegmentRecord &mappedSeg : results) {
+            assert(mappedSeg.getGenome() == nextGenome);
+            mapSelf(mappedSeg, input, minLength, access);
         }
+        results.swap(input);
     }
 
     if (nextGenome != tgtGenome) {
         // Continue the recursion.
-        swap(inputPtr, outputPtr);
-        outputPtr->clear();
-        mapRecursiveDown(*inputPtr, *outputPtr, tgtGenome, namesOnPath, doDupes, minLength);
+        input.clear();
+        mapRecursiveDown(results, input, tgtGenome, namesOnPath, doDupes, minLength, access);
+        results.swap(input);
     }
 
-    if (outputPtr != &results) {
-        results = *outputPtr;
-    }
-
-    results.sort(MappedSegment::LessSourcePtr());
-    results.unique(MappedSegment::EqualToPtr());
+    sortUnique(results);
     return results.size();
 }
 
-// note: takes smart pointer as it maybe added to the results
-static hal_size_t mapSelf(MappedSegmentPtr mappedSeg, list<MappedSegmentPtr> &results, hal_size_t minLength) {
+// add the source with the target top and all of its paralogs.
+template <class Access>
+static hal_size_t mapTopSelf(const SlicedSegmentRecord &source, hal_size_t inputIndex, const TopSegmentCursor<Access> &top,
+                             MappedSegmentRecords &results, hal_size_t minLength) {
     hal_size_t added = 0;
-    if (mappedSeg->isTop() == true) {
-        SegmentIteratorPtr target = mappedSeg->getTargetIteratorPtr();
-        SegmentIteratorPtr source = mappedSeg->getSourceIteratorPtr();
-        TopSegmentIteratorPtr top = std::dynamic_pointer_cast<TopSegmentIterator>(target);
-        TopSegmentIteratorPtr topCopy = top->clone();
-        do {
-            // FIXME: why isn't clone() polymorphic?
-            SegmentIteratorPtr newSource;
-            if (source->isTop()) {
-                newSource = std::dynamic_pointer_cast<TopSegmentIterator>(source)->clone();
-            } else {
-                newSource = std::dynamic_pointer_cast<BottomSegmentIterator>(source)->clone();
-            }
-            TopSegmentIteratorPtr newTop = topCopy->clone();
-            MappedSegmentPtr newMappedSeg(new MappedSegment(newSource, newTop));
-            assert(newMappedSeg->getGenome() == mappedSeg->getGenome());
-            assert(newMappedSeg->getSource()->getGenome() == mappedSeg->getSource()->getGenome());
-            results.push_back(newMappedSeg);
-            ++added;
-            if (topCopy->tseg()->hasNextParalogy()) {
-                topCopy->toNextParalogy();
-            }
-        } while (topCopy->tseg()->hasNextParalogy() == true && topCopy->getLength() >= minLength &&
-                 topCopy->getArrayIndex() != top->getArrayIndex());
-    } else if (mappedSeg->getGenome()->getParent() != NULL) {
-        hal_index_t rightCutoff = mappedSeg->getEndPosition();
-        BottomSegmentIteratorPtr bottom = mappedSeg->targetAsBottom();
-        hal_index_t startOffset = (hal_index_t)bottom->getStartOffset();
-        hal_index_t endOffset = (hal_index_t)bottom->getEndOffset();
-        TopSegmentIteratorPtr top = mappedSeg->getGenome()->getTopSegmentIterator();
-        top->toParseUp(bottom);
-        do {
-            TopSegmentIteratorPtr topNew = top->clone();
-
-            // we map the new target back to see how the offsets have
-            // changed.  these changes are then applied to the source segment
-            // as deltas
-            BottomSegmentIteratorPtr bottomBack = bottom->clone();
-            bottomBack->toParseDown(topNew);
-            hal_index_t startBack = (hal_index_t)bottomBack->getStartOffset();
-            hal_index_t endBack = (hal_index_t)bottomBack->getEndOffset();
-            assert(startBack >= startOffset);
-            assert(endBack >= endOffset);
-            SegmentIteratorPtr newSource = mappedSeg->sourceClone();
-            hal_index_t startDelta = startBack - startOffset;
-            hal_index_t endDelta = endBack - endOffset;
-            assert((hal_index_t)newSource->getLength() > startDelta + endDelta);
-            newSource->slice(newSource->getStartOffset() + startDelta, newSource->getEndOffset() + endDelta);
-
-            MappedSegmentPtr newMappedSeg(new MappedSegment(newSource, topNew));
-
-            assert(newMappedSeg->isTop() == true);
-            assert(newMappedSeg->getSource()->getGenome() == mappedSeg->getSource()->getGenome());
-
-            added += mapSelf(newMappedSeg, results, minLength);
-            // stupid that we have to make this check but odn't want to
-            // make fundamental api change now
-            if (top->getEndPosition() != rightCutoff) {
-                top->toRight(rightCutoff);
-            } else {
-                break;
-            }
-        } while (true);
+    TopSegmentCursor<Access> topCopy(top);
+    do {
+        results.push_back(MappedSegmentRecord(source, topCopy.getRecord(), inputIndex));
+        ++added;
+        if (topCopy.hasNextParalogy()) {
+            topCopy.toNextParalogy();
+        }
+    } while (topCopy.hasNextParalogy() == true && topCopy.getLength() >= minLength &&
+             topCopy.getArrayIndex() != top.getArrayIndex());
+    return added;
+}
+
+template <class Access>
+static hal_size_t mapSelf(const MappedSegmentRecord &mappedSeg, MappedSegmentRecords &results, hal_size_t minLength,
+                          SegmentAccessCache<Access> &access) {
+    const Genome *genome = mappedSeg.getGenome();
+    TopSegmentCursor<Access> top;
+    if (mappedSeg._target._isTop == true) {
+        top.load(access.getTop(genome), mappedSeg._target);
+        return mapTopSelf(mappedSeg._source, mappedSeg._inputIndex, top, results, minLength);
+    } else if (genome->getParent() == NULL) {
+        return 0;
     }
+    hal_size_t added = 0;
+    hal_index_t rightCutoff = mappedSeg._target.getEndPosition();
+    BottomSegmentCursor<Access> bottom;
+    bottom.load(access.getBottom(genome), mappedSeg._target);
+    hal_index_t startOffset = (hal_index_t)bottom.getStartOffset();
+    hal_index_t endOffset = (hal_index_t)bottom.getEndOffset();
+    BottomSegmentCursor<Access> bottomBack;
+    top.toParseUp(bottom, access.getTop(genome));
+    do {
+        // we map the new target back to see how the offsets have
+        // changed.  these changes are then applied to the source segment
+        // as deltas
+        bottomBack.toParseDown(top, bottom.getAccess());
+        hal_index_t startBack = (hal_index_t)bottomBack.getStartOffset();
+        hal_index_t endBack = (hal_index_t)bottomBack.getEndOffset();
+        assert(startBack >= startOffset);
+        assert(endBack >= endOffset);
+        SlicedSegmentRecord newSource = sliceSource(mappedSeg._source, startBack - startOffset, endBack - endOffset);
+        added += mapTopSelf(newSource, mappedSeg._inputIndex, top, results, minLength);
+        // stupid that we have to make this check but odn't want to
+        // make fundamental api change now
+        if (top.getEndPosition() != rightCutoff) {
+            top.toRight(rightCutoff);
+        } else {
+            break;
+        }
+    } while (true);
     return added;
 }
 
@@ -521,129 +527,118 @@ static void insertAndBreakOverlaps(MappedSegmentPtr seg, MappedSegmentSet &resul
 
 // Map all segments from the input to any segments in the same genome
 // that coalesce in or before the given "coalescence limit" genome.
-// Destructive to any data in the input list.
-static hal_size_t mapRecursiveParalogies(const Genome *srcGenome, list<MappedSegmentPtr> &input,
-                                         list<MappedSegmentPtr> &results, const set<string> &namesOnPath,
-                                         const Genome *coalescenceLimit, hal_size_t minLength) {
-    if (input.empty()) {
-        results = input;
-        return 0;
-    }
-
-    const Genome *curGenome = (*input.begin())->getGenome();
-    assert(curGenome != NULL);
-    if (curGenome == coalescenceLimit) {
-        results = input;
+// Destructive to any data in the input vector.
+template <class Access>
+static hal_size_t mapRecursiveParalogies(const Genome *srcGenome, MappedSegmentRecords &input,
+                                         MappedSegmentRecords &results, const set<string> &namesOnPath,
+                                         const Genome *coalescenceLimit, hal_size_t minLength,
+                                         SegmentAccessCache<Access> &access) {
+    if (input.empty() || input.front().getGenome() == coalescenceLimit) {
+        results.swap(input);
         return 0;
     }
 
+    const Genome *curGenome = input.front().getGenome();
     const Genome *nextGenome = curGenome->getParent();
 
     if (nextGenome == NULL) {
         throw hal_exception("Hit root genome when attempting to map paralogies");
     }
-    list<MappedSegmentPtr> paralogs;
+    MappedSegmentRecords paralogs;
     // Map to any paralogs in the current genome.
     // FIXME: I think the original segments are included in this, which is a waste.
-    list<MappedSegmentPtr>::iterator i = input.begin();
-    for (; i != input.end(); ++i) {
-        assert((*i)->getGenome() == curGenome);
-        mapSelf(*i, paralogs, minLength);
+    for (const MappedSegmentRecord &mappedSeg : input) {
+        assert(mappedSeg.getGenome() == curGenome);
+        mapSelf(mappedSeg, paralogs, minLength, access);
     }
 
+    results.clear();
     if (nextGenome != coalescenceLimit) {
-        list<MappedSegmentPtr> nextSegments;
+        MappedSegmentRecords nextSegments;
         // Map all of the original segments (not the paralogs, which is a
         // waste) up to the next genome.
-        i = input.begin();
-        for (; i != input.end(); ++i) {
-            assert((*i)->getGenome() == curGenome);
-            mapUp(*i, nextSegments, true, minLength);
+        for (const MappedSegmentRecord &mappedSeg : input) {
+            assert(mappedSeg.getGenome() == curGenome);
+            mapUp(mappedSeg, nextSegments, true, minLength, access);
         }
 
         // Recurse on the mapped segments.
-        mapRecursiveParalogies(srcGenome, nextSegments, results, namesOnPath, coalescenceLimit, minLength);
+        mapRecursiveParalogies(srcGenome, nextSegments, results, namesOnPath, coalescenceLimit, minLength, access);
     }
 
     // Map all the paralogs we found in this genome back to the source.
-    list<MappedSegmentPtr> paralogsMappedToSrc;
-    mapRecursiveDown(paralogs, paralogsMappedToSrc, srcGenome, namesOnPath, false, minLength);
+    MappedSegmentRecords paralogsMappedToSrc;
+    mapRecursiveDown(paralogs, paralogsMappedToSrc, srcGenome, namesOnPath, false, minLength, access);
 
-    results.splice(results.begin(), paralogsMappedToSrc);
-    results.sort(MappedSegment::LessSourcePtr());
-    results.unique(MappedSegment::EqualToPtr());
+    results.insert(results.begin(), paralogsMappedToSrc.begin(), paralogsMappedToSrc.end());
+    sortUnique(results);
     return results.size();
 }
 
-static hal_size_t mapSource(const SegmentIterator *source, MappedSegmentSet &results, const Genome *tgtGenome,
-                            const set<const Genome *> *genomesOnPath, bool doDupes, hal_size_t minLength,
-                            const Genome *coalescenceLimit, const Genome *mrca) {
-    assert(source != NULL);
-
-    // FIXME: why does target start out as source??  This is all a bit clunky
-    SegmentIteratorPtr startSourceSegIt;
-    SegmentIteratorPtr startTargetSegIt;
-    if (source->isTop()) {
-        startSourceSegIt = dynamic_cast<const TopSegmentIterator *>(source)->clone();
-        startTargetSegIt = dynamic_cast<const TopSegmentIterator *>(source)->clone();
-    } else {
-        startSourceSegIt = dynamic_cast<const BottomSegmentIterator *>(source)->clone();
-        startTargetSegIt = dynamic_cast<const BottomSegmentIterator *>(source)->clone();
-    }
-
-    MappedSegmentPtr newMappedSeg(new MappedSegment(startSourceSegIt, startTargetSegIt));
-
-    list<MappedSegmentPtr> input;
-    input.push_back(newMappedSeg);
-    list<MappedSegmentPtr> output;
-
-    set<string> namesOnPath;
-    assert(genomesOnPath != NULL);
-    for (set<const Genome *>::const_iterator i = genomesOnPath->begin(); i != genomesOnPath->end(); ++i) {
-        namesOnPath.insert((*i)->getName());
-    }
-
-    // FIXME: using multiple lists is probably much slower than just
-    // reusing the results list over and over.
-    list<MappedSegmentPtr> upResults;
+// mapRecords with the segment accessors of a storage backend
+template <class Access>
+static void mapRecordsWithAccess(MappedSegmentRecords &input, MappedSegmentRecords &results, const Genome *srcGenome,
+                                 const Genome *tgtGenome, const set<string> &namesOnPath, bool doDupes,
+                                 hal_size_t minLength, const Genome *coalescenceLimit, const Genome *mrca) {
+    // Each step maps input to output, then swaps them to be the input of
+    // the next step, so the buffers are reused.
+    SegmentAccessCache<Access> access;
+    MappedSegmentRecords output;
     // Map all segments up to the MRCA of src and tgt.
-    if (source->getGenome() != mrca) {
-        mapRecursiveUp(input, upResults, mrca, minLength);
-    } else {
-        upResults = input;
+    if (srcGenome != mrca) {
+        mapRecursiveUp(input, output, mrca, minLength, access);
+        input.swap(output);
     }
 
-    list<MappedSegmentPtr> paralogResults;
     // Map to all paralogs that coalesce in or below the coalescenceLimit.
     if (mrca != coalescenceLimit && doDupes) {
-        mapRecursiveParalogies(mrca, upResults, paralogResults, namesOnPath, coalescenceLimit, minLength);
-    } else {
-        paralogResults = upResults;
+        mapRecursiveParalogies(mrca, input, output, namesOnPath, coalescenceLimit, minLength, access);
+        input.swap(output);
     }
 
     // Finally, map back down to the target genome.
     if (tgtGenome != mrca) {
-        mapRecursiveDown(paralogResults, output, tgtGenome, namesOnPath, doDupes, minLength);
-    } else {
-        output = paralogResults;
+        mapRecursiveDown(input, output, tgtGenome, namesOnPath, doDupes, minLength, access);
+        input.swap(output);
     }
+    results.swap(input);
+}
 
-    list<MappedSegmentPtr>::iterator outIt = output.begin();
-    for (; outIt != output.end(); ++outIt) {
-        insertAndBreakOverlaps(*outIt, results);
+// Map input segments in the source genome to the target, through the mrca
+// and down the path.  Segments from several inputs can be mapped at
+// once; they are kept apart by their input index.  Destructive to any
+// data in the input vector.
+static void mapRecords(MappedSegmentRecords &input, MappedSegmentRecords &results, const Genome *srcGenome,
+                       const Genome *tgtGenome, const set<const Genome *> *genomesOnPath, bool doDupes,
+                       hal_size_t minLength, const Genome *coalescenceLimit, const Genome *mrca) {
+    set<string> namesOnPath;
+    assert(genomesOnPath != NULL);
+    for (set<const Genome *>::const_iterator i = genomesOnPath->begin(); i != genomesOnPath->end(); ++i) {
+        namesOnPath.insert((*i)->getName());
     }
 
-    return output.size();
+    // read the segment arrays of mmap alignments directly when they are
+    // entirely mapped; this bypasses the projection cache, which saves no
+    // work in that case.
+    const MMapGenome *mmapGenome = dynamic_cast<const MMapGenome *>(srcGenome);
+    if ((mmapGenome != NULL) && mmapGenome->hasDirectSegmentAccess()) {
+        mapRecordsWithAccess<MMapSegmentAccess>(input, results, srcGenome, tgtGenome, namesOnPath, doDupes, minLength,
+                                                coalescenceLimit, mrca);
+    } else {
+        mapRecordsWithAccess<GenericSegmentAccess>(input, results, srcGenome, tgtGenome, namesOnPath, doDupes, minLength,
+                                                   coalescenceLimit, mrca);
+    }
 }
 
-hal_size_t hal::halMapSegment(const SegmentIterator *source, MappedSegmentSet &outSegments, const Genome *tgtGenome,
-                              const set<const Genome *> *genomesOnPath, bool doDupes, hal_size_t minLength,
-                              const Genome *coalescenceLimit, const Genome *mrca) {
+// fill in the defaults for the mrca, coalescence limit and path, which
+// is stored in pathSet if it must be computed.
+static void getMappingPath(const Genome *srcGenome, const Genome *tgtGenome, const set<const Genome *> *&genomesOnPath,
+                           const Genome *&coalescenceLimit, const Genome *&mrca, set<const Genome *> &pathSet) {
     assert(tgtGenome != NULL);
 
     if (mrca == NULL) {
         set<const Genome *> inputSet;
-        inputSet.insert(source->getGenome());
+        inputSet.insert(srcGenome);
         inputSet.insert(tgtGenome);
         mrca = getLowestCommonAncestor(inputSet);
     }
@@ -655,7 +650,6 @@ hal_size_t hal::halMapSegment(const SegmentIterator *source, MappedSegmentSet &o
     // Get the path from the coalescence limit to the target (necessary
     // for choosing which children to move through to get to the
     // target).
-    set<const Genome *> pathSet;
     if (genomesOnPath == NULL) {
         set<const Genome *> inputSet;
         inputSet.insert(tgtGenome);
@@ -663,10 +657,42 @@ hal_size_t hal::halMapSegment(const SegmentIterator *source, MappedSegmentSet &o
         getGenomesInSpanningTree(inputSet, pathSet);
         genomesOnPath = &pathSet;
     }
+}
+
+// fill in the defaults for halMapSegment and map the source
+static void mapSegment(const SegmentIterator *source, MappedSegmentRecords &results, const Genome *tgtGenome,
+                       const set<const Genome *> *genomesOnPath, bool doDupes, hal_size_t minLength,
+                       const Genome *coalescenceLimit, const Genome *mrca) {
+    assert(source != NULL);
+    set<const Genome *> pathSet;
+    getMappingPath(source->getGenome(), tgtGenome, genomesOnPath, coalescenceLimit, mrca, pathSet);
 
-    hal_size_t numResults =
-        mapSource(source, outSegments, tgtGenome, genomesOnPath, doDupes, minLength, coalescenceLimit, mrca);
-    return numResults;
+    // FIXME: why does target start out as source??  This is all a bit clunky
+    SlicedSegmentRecord startSource(source);
+    MappedSegmentRecords input(1, MappedSegmentRecord(startSource, source));
+    mapRecords(input, results, source->getGenome(), tgtGenome, genomesOnPath, doDupes, minLength, coalescenceLimit, mrca);
+}
+
+hal_size_t hal::halMapSegment(const SegmentIterator *source, MappedSegmentSet &outSegments, const Genome *tgtGenome,
+                              const set<const Genome *> *genomesOnPath, bool doDupes, hal_size_t minLength,
+                              const Genome *coalescenceLimit, const Genome *mrca) {
+    MappedSegmentRecords results;
+    mapSegment(source, results, tgtGenome, genomesOnPath, doDupes, minLength, coalescenceLimit, mrca);
+    for (const MappedSegmentRecord &mappedSeg : results) {
+        insertAndBreakOverlaps(MappedSegmentPtr(new MappedSegment(mappedSeg)), outSegments);
+    }
+    return results.size();
+}
+
+hal_size_t hal::halMapSegment(const SegmentIterator *source, MappedSegmentVector &outSegments, const Genome *tgtGenome,
+                              const set<const Genome *> *genomesOnPath, bool doDupes, hal_size_t minLength,
+                              const Genome *coalescenceLimit, const Genome *mrca) {
+    MappedSegmentRecords results;
+    mapSegment(source, results, tgtGenome, genomesOnPath, doDupes, minLength, coalescenceLimit, mrca);
+    for (const MappedSegmentRecord &mappedSeg : results) {
+        outSegments.add(mappedSeg);
+    }
+    return results.size();
 }
 
 /* call main function with smart pointer */
@@ -675,3 +701,77 @@ hal_size_t hal::halMapSegmentSP(const SegmentIteratorPtr &source, MappedSegmentS
                                 const Genome *coalescenceLimit, const Genome *mrca) {
     return halMapSegment(source.get(), outSegments, tgtGenome, genomesOnPath, doDupes, minLength, coalescenceLimit, mrca);
 }
+
+/* call main function with smart pointer */
+hal_size_t hal::halMapSegmentSP(const SegmentIteratorPtr &source, MappedSegmentVector &outSegments, const Genome *tgtGenome,
+                                const std::set<const Genome *> *genomesOnPath, bool doDupes, hal_size_t minLength,
+                                const Genome *coalescenceLimit, const Genome *mrca) {
+    return halMapSegment(source.get(), outSegments, tgtGenome, genomesOnPath, doDupes, minLength, coalescenceLimit, mrca);
+}
+
+hal_size_t hal::halMapSegmentRecords(const Genome *srcGenome, const vector<SourceInterval> &intervals,
+                                    vector<MappedSegmentRecord> &outRecords, const Genome *tgtGenome,
+                                    const set<const Genome *> *genomesOnPath, bool doDupes, hal_size_t minLength,
+                                    const Genome *coalescenceLimit, const Genome *mrca) {
+    set<const Genome *> pathSet;
+    getMappingPath(srcGenome, tgtGenome, genomesOnPath, coalescenceLimit, mrca, pathSet);
+
+    // cut the intervals into source segments, tagged by interval
+    SegmentIteratorPtr srcSegIt;
+    hal_index_t lastIndex;
+    if (srcGenome->getNumTopSegments() > 0) {
+        srcSegIt = srcGenome->getTopSegmentIterator();
+        lastIndex = (hal_index_t)srcGenome->getNumTopSegments();
+    } else {
+        srcSegIt = srcGenome->getBottomSegmentIterator();
+        lastIndex = (hal_index_t)srcGenome->getNumBottomSegments();
+    }
+    MappedSegmentRecords input;
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        const SourceInterval &interval = intervals[i];
+        if (interval._end < interval._start) {
+            continue;
+        }
+        srcSegIt->toSite(interval._start, false);
+        hal_offset_t endOffset = 0;
+        if (interval._end <= srcSegIt->getEndPosition()) {
+            endOffset = srcSegIt->getEndPosition() - interval._end;
+        }
+        srcSegIt->slice(interval._start - srcSegIt->getStartPosition(), endOffset);
+        while (srcSegIt->getArrayIndex() < lastIndex && srcSegIt->getStartPosition() <= interval._end) {
+            if (interval._reversed) {
+                srcSegIt->toReverseInPlace();
+            }
+            input.push_back(MappedSegmentRecord(SlicedSegmentRecord(srcSegIt.get()), srcSegIt.get(), i));
+            if (interval._reversed) {
+                srcSegIt->toReverseInPlace();
+            }
+            srcSegIt->toRight(interval._end);
+        }
+    }
+
+    outRecords.clear();
+    mapRecords(input, outRecords, srcGenome, tgtGenome, genomesOnPath, doDupes, minLength, coalescenceLimit, mrca);
+    return outRecords.size();
+}
+
+hal_size_t hal::halMapSegments(const Genome *srcGenome, const vector<SourceInterval> &intervals,
+                               vector<MappedSegmentVector> &outSegments, const Genome *tgtGenome,
+                               const set<const Genome *> *genomesOnPath, bool doDupes, hal_size_t minLength,
+                               const Genome *coalescenceLimit, const Genome *mrca) {
+    MappedSegmentRecords results;
+    halMapSegmentRecords(srcGenome, intervals, results, tgtGenome, genomesOnPath, doDupes, minLength, coalescenceLimit,
+                         mrca);
+
+    outSegments.resize(intervals.size());
+    for (MappedSegmentVector &segVector : outSegments) {
+        segVector.clear();
+    }
+    for (const MappedSegmentRecord &mappedSeg : results) {
+        outSegments[mappedSeg._inputIndex].add(mappedSeg);
+    }
+    for (MappedSegmentVector &segVector : outSegments) {
+        segVector.resolve();
+    }
+    return results.size();
+}
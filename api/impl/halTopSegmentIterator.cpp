@@ -34,11 +34,21 @@ void TopSegmentIterator::print(ostream &os) const {
 // TOP SEGMENT ITERATOR INTERFACE
 //////////////////////////////////////////////////////////////////////////////
 void TopSegmentIterator::toChild(const BottomSegmentIteratorPtr &botSegIt, hal_size_t child) {
-    _topSegment->setArrayIndex(botSegIt->getGenome()->getChild(child), botSegIt->bseg()->getChildIndex(child));
+    Genome *genome = botSegIt->getGenome();
+    hal_index_t childIndex;
+    bool childReversed;
+    ProjectionCache *projectionCache = genome->getChildProjectionCache(child);
+    if (projectionCache != NULL) {
+        projectionCache->get(botSegIt->getArrayIndex(), childIndex, childReversed);
+    } else {
+        childIndex = botSegIt->bseg()->getChildIndex(child);
+        childReversed = botSegIt->bseg()->getChildReversed(child);
+    }
+    _topSegment->setArrayIndex(genome->getChild(child), childIndex);
     _startOffset = botSegIt->getStartOffset();
     _endOffset = botSegIt->getEndOffset();
     _reversed = botSegIt->getReversed();
-    if (botSegIt->bseg()->getChildReversed(child) == true) {
+    if (childReversed == true) {
         toReverse();
     }
     assert(inRange() == true);
@@ -52,6 +62,17 @@ void TopSegmentIterator::toChildG(const BottomSegmentIteratorPtr &botSegIt, cons
     assert(getGenome() == childGenome);
 }
 
+bool TopSegmentIterator::hasParent() const {
+    ProjectionCache *projectionCache = getGenome()->getParentProjectionCache();
+    if (projectionCache == NULL) {
+        return tseg()->hasParent();
+    }
+    hal_index_t parentIndex;
+    bool parentReversed;
+    projectionCache->get(getArrayIndex(), parentIndex, parentReversed);
+    return parentIndex != NULL_INDEX;
+}
+
 void TopSegmentIterator::toParseUp(const BottomSegmentIteratorPtr &botSegIt) {
     Genome *genome = botSegIt->getGenome();
     hal_index_t index = botSegIt->bseg()->getTopParseIndex();
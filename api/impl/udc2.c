@@ -1966,6 +1966,22 @@ if (udc2CacheEnabled() && !sameString(file->protocol, "transparent"))
 return ((char*)file->mmapBase) + offset;
 }
 
+void udc2Prefetch(struct udc2File *file, bits64 offset, bits64 size)
+/* Fetch a region of the file into the cache without reading it, clipped to
+ * the end of the file.  Blocks already cached are not fetched.  Handles are
+ * not thread-safe, but several handles open on the same URL share the
+ * cache, so threads using their own handle may fetch in parallel.  Two
+ * handles may fetch the same block at once, which just writes the same
+ * data twice. */
+{
+if (offset >= file->size)
+    return;
+if ((offset + size) > file->size)
+    size = file->size - offset;
+if (udc2CacheEnabled() && !sameString(file->protocol, "transparent"))
+    udcCachePreload(file, offset, size);
+}
+
 void udc2VerboseSetLevel(int l)
 /* set the verbose level; */
 {
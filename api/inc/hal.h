@@ -64,6 +64,7 @@
 #include "halBottomSegment.h"
 #include "halBottomSegmentIterator.h"
 #include "halCLParser.h"
+#include "halColumnBlockIterator.h"
 #include "halColumnIterator.h"
 #include "halCommon.h"
 #include "halDefs.h"
@@ -72,8 +73,10 @@
 #include "halGappedTopSegmentIterator.h"
 #include "halGenome.h"
 #include "halMappedSegment.h"
+#include "halMappedSegmentVector.h"
 #include "halMetaData.h"
 #include "halPositionCache.h"
+#include "halProjectionCache.h"
 #include "halRearrangement.h"
 #include "halSegment.h"
 #include "halSegmentIterator.h"
@@ -9,6 +9,9 @@
 #define _HALALIGNMENT_H
 
 #include "halDefs.h"
+#include "halProjectionCache.h"
+#include <map>
+#include <ostream>
 #include <string>
 #include <vector>
 
@@ -28,6 +31,10 @@ namespace hal {
      */
     class Alignment {
       public:
+        /** Constructor */
+        Alignment() : _projectionCacheBytes(0) {
+        }
+
         /** Destructor */
         virtual ~Alignment() {
         }
@@ -159,6 +166,43 @@ namespace hal {
 
         /** Replace the newick tree with a new string */
         virtual void replaceNewickTree(const std::string &newick) = 0;
+
+        /** Was the alignment opened to be shared between threads? */
+        virtual bool isConcurrentReadAccess() const {
+            return false;
+        }
+
+        /** Cache the projections of segments to the parent and children of
+         * each genome (see ProjectionCache), using up to maxBytes for each
+         * genome pair.  Zero, the default, disables caching.  Only genomes
+         * opened afterwards are affected.  The alignment must be read-only and
+         * not opened with CONCURRENT_READ_ACCESS. */
+        void setProjectionCacheBytes(size_t maxBytes) {
+            if (maxBytes > 0 && (!isReadOnly() || isConcurrentReadAccess())) {
+                throw hal_exception("projection cache requires an alignment opened for single-threaded read-only access");
+            }
+            _projectionCacheBytes = maxBytes;
+        }
+
+        /** Get the maximum bytes of each projection cache, zero if disabled */
+        size_t getProjectionCacheBytes() const {
+            return _projectionCacheBytes;
+        }
+
+        /** Get the statistics of the projection cache for a genome pair,
+         * created if needed.  They are kept after the genomes are closed. */
+        ProjectionCacheStats *getProjectionCacheStats(const std::string &pairName) const {
+            return &_projectionCacheStats[pairName];
+        }
+
+        /** Print the projection cache hit rates of all genome pairs */
+        void printProjectionCacheStats(std::ostream &out) const {
+            ProjectionCache::printStats(_projectionCacheStats, out);
+        }
+
+      private:
+        size_t _projectionCacheBytes;
+        mutable std::map<std::string, ProjectionCacheStats> _projectionCacheStats;
     };
 }
 #endif
@@ -34,9 +34,10 @@ namespace hal {
      * Open modes for files.
      */
     enum {
-        READ_ACCESS = 0x01,  // read-access
-        WRITE_ACCESS = 0x02, // write-access
-        CREATE_ACCESS = 0x04 // initialize a new file, truncate if exist
+        READ_ACCESS = 0x01,           // read-access
+        WRITE_ACCESS = 0x02,          // write-access
+        CREATE_ACCESS = 0x04,         // initialize a new file, truncate if exist
+        CONCURRENT_READ_ACCESS = 0x08 // read-only, object may be shared between threads (mmap only)
     };
 
     /* Default values and validate HAL mode. */
@@ -48,6 +49,12 @@ namespace hal {
         if (mode & WRITE_ACCESS) {
             mode |= READ_ACCESS;
         }
+        if (mode & CONCURRENT_READ_ACCESS) {
+            if (mode & WRITE_ACCESS) {
+                throw hal_exception("CONCURRENT_READ_ACCESS can't be combined with WRITE_ACCESS or CREATE_ACCESS");
+            }
+            mode |= READ_ACCESS;
+        }
         if ((mode & (READ_ACCESS | WRITE_ACCESS | CREATE_ACCESS)) == 0) {
             throw hal_exception("must specify at least one of READ_ACCESS, WRITE_ACCESS, or CREATE_ACCESS on open");
         }
@@ -55,10 +62,78 @@ namespace hal {
     }
 
     /*
-     * MMap file default size when opening file for write access.
+     * MMap file default initial size when opening file for write access.
+     * The file is grown as needed and trimmed to the size of the data on
+     * close.
+     */
+    static const size_t MMAP_DEFAULT_FILE_SIZE_GB = 1;
+    static const size_t MMAP_DEFAULT_FILE_SIZE = MMAP_DEFAULT_FILE_SIZE_GB * GIGABYTE;
+
+    /*
+     * Layout of the segment arrays in a mmap file, chosen when the file is
+     * created.  Packed files are compact, but segments may not be modified
+     * once a genome is closed.
+     */
+    enum MMapSegmentLayout {
+        MMAP_SEGMENT_LAYOUT_ROWS = 0,    // array of records, the original layout
+        MMAP_SEGMENT_LAYOUT_COLUMNS = 1, // separate array for each field (mmap API 1.2)
+        MMAP_SEGMENT_LAYOUT_PACKED = 2   // columns with bit-packed integers (mmap API 1.3)
+    };
+
+    /* convert a segment layout to/from the names used in options */
+    const std::string &mmapSegmentLayoutToString(MMapSegmentLayout segmentLayout);
+    MMapSegmentLayout mmapSegmentLayoutFromString(const std::string &name);
+
+    /*
+     * Storage of DNA in a mmap file, chosen when the file is created.
+     * Two-bit DNA is about half the size, but may not be modified once
+     * the alignment is closed.
+     */
+    enum MMapDnaLayout {
+        MMAP_DNA_LAYOUT_NIBBLES = 0, // one base per nibble, the original layout
+        MMAP_DNA_LAYOUT_TWO_BIT = 1  // two bits per base, with N and lower-case runs (mmap API 1.4)
+    };
+
+    /* convert a DNA layout to/from the names used in options */
+    const std::string &mmapDnaLayoutToString(MMapDnaLayout dnaLayout);
+    MMapDnaLayout mmapDnaLayoutFromString(const std::string &name);
+
+    /*
+     * Expected pattern of reads from a mmap file, passed to the kernel as
+     * madvise() hints for the segment and DNA arrays of each genome.
      */
-    static const size_t MMAP_DEFAULT_FILE_SIZE_GB = 64;
-    static const size_t MMAP_DEFAULT_FILE_SIZE = 64 * GIGABYTE;
+    enum MMapAccessPattern {
+        MMAP_ACCESS_NORMAL = 0,     // default kernel read-ahead
+        MMAP_ACCESS_SEQUENTIAL = 1, // scans over whole genomes, such as hal2maf
+        MMAP_ACCESS_RANDOM = 2      // scattered lookups, such as a liftover server
+    };
+
+    /* convert an access pattern to/from the names used in options */
+    const std::string &mmapAccessPatternToString(MMapAccessPattern accessPattern);
+    MMapAccessPattern mmapAccessPatternFromString(const std::string &name);
+
+    /*
+     * Options controlling how a mmap file is read.  These only affect
+     * performance.  The access pattern is applied to each genome as it is
+     * opened.  The segment and DNA arrays of the prefetch genomes are read
+     * into memory, and optionally locked there, when the file is opened;
+     * with UDC this fetches them into the cache.  Populate and huge pages
+     * apply to the whole mapping of a local file.  With UDC, prefetched
+     * ranges are fetched in the background by a pool of threads, zero
+     * threads fetches them synchronously.
+     */
+    struct MMapAccessOptions {
+        MMapAccessOptions()
+            : _accessPattern(MMAP_ACCESS_NORMAL), _lockPrefetch(false), _populate(false), _hugePages(false),
+              _udcFetchThreads(4) {
+        }
+        MMapAccessPattern _accessPattern;
+        std::vector<std::string> _prefetchGenomes;
+        bool _lockPrefetch; // mlock() prefetched genomes
+        bool _populate;     // read the whole file when it is mapped (MAP_POPULATE)
+        bool _hugePages;    // request transparent huge pages (MADV_HUGEPAGE)
+        unsigned _udcFetchThreads; // threads fetching prefetched ranges of a URL
+    };
 
     /* get default FileCreatPropList with HAL default properties set */
     const H5::FileCreatPropList &hdf5DefaultFileCreatPropList();
@@ -92,9 +167,16 @@ namespace hal {
      * @param alignmentPath Path to file or URL for UDC access.
      * @param mode Access mode bit map
      * @param fileSize Size to allocate when creating new file (CREATE_ACCESS)
+     * @param segmentLayout Layout of segment arrays when creating a new
+     *  file (CREATE_ACCESS)
+     * @param dnaLayout Storage of DNA when creating a new file (CREATE_ACCESS)
+     * @param accessOptions Hints on how the file will be read
      */
     Alignment *mmapAlignmentInstance(const std::string &alignmentPath, unsigned mode = hal::READ_ACCESS,
-                                     size_t fileSize = hal::MMAP_DEFAULT_FILE_SIZE);
+                                     size_t fileSize = hal::MMAP_DEFAULT_FILE_SIZE,
+                                     MMapSegmentLayout segmentLayout = MMAP_SEGMENT_LAYOUT_ROWS,
+                                     MMapDnaLayout dnaLayout = MMAP_DNA_LAYOUT_NIBBLES,
+                                     const MMapAccessOptions &accessOptions = MMapAccessOptions());
 
     /** Attempt to detect HAL alignment format, or return empty string if it doesn't
      * appear to be a hal file */
@@ -50,6 +50,12 @@ namespace hal {
          * @param topSegIt Top iterator to parse down on */
         void toParseDown(const TopSegmentIteratorPtr &topSegIt);
 
+        /** Does the current segment have a child in the given child genome?
+         * Same as bseg()->hasChild(), but uses the genome's projection
+         * cache if enabled.
+         * @param child Index of child genome */
+        bool hasChild(hal_size_t child) const;
+
         /** Return a pointer to the current BottomSegment. NOTE: changes when iterator is modified.  */
         BottomSegment *getBottomSegment() {
             return _bottomSegment.get();
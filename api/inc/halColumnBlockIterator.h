@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#ifndef _HALCOLUMNBLOCKITERATOR_H
+#define _HALCOLUMNBLOCKITERATOR_H
+
+#include "halColumnIterator.h"
+#include "halDefs.h"
+#include <set>
+#include <vector>
+
+namespace hal {
+
+    /**
+     * Iterates over the columns of a reference sequence range a block at a
+     * time rather than a column at a time.  A block is a maximal run of the
+     * columns a ColumnIterator would return where the same rows are present
+     * on the same strands and each row advances by one base per column,
+     * that is a gapless piece of the alignment.  Within a gapless run of
+     * segments the columns are not computed, so this is much faster than
+     * calling ColumnIterator::toRight() on every column.
+     *
+     * Indels are not followed (maxInsertLength is zero) and columns are
+     * not unique, so the blocks have the same columns as
+     * Sequence::getColumnIterator() with the same arguments.
+     */
+    class ColumnBlockIterator {
+      public:
+        /* a row of a block: the position of its base in the first column */
+        struct Row {
+            Row(const Sequence *sequence, hal_index_t start, bool reversed)
+                : _sequence(sequence), _start(start), _reversed(reversed) {
+            }
+            /* genome position of the base in column i of the block */
+            hal_index_t getPosition(hal_size_t i) const {
+                return _reversed ? _start - (hal_index_t)i : _start + (hal_index_t)i;
+            }
+            const Sequence *_sequence;
+            hal_index_t _start; // genome coordinates
+            bool _reversed;
+        };
+        typedef std::vector<Row> Rows;
+
+        /** Iterate over the columns from position to lastPosition
+         * (inclusive) of the sequence, in sequence coordinates.  The other
+         * arguments are as for Sequence::getColumnIterator(). */
+        ColumnBlockIterator(const Sequence *sequence, const std::set<const Genome *> *targets, hal_index_t position,
+                            hal_index_t lastPosition, bool noDupes = false, bool noAncestors = false,
+                            bool onlyOrthologs = false);
+
+        /** Move to the next block.  Must not be called when lastBlock() is
+         * true */
+        void toRight();
+
+        /** Is this the block containing the last column? */
+        bool lastBlock() const {
+            return _lastBlock;
+        }
+
+        /** Get the rows of the block, in the order of
+         * ColumnIterator::getRows() for its first column */
+        const Rows &getRows() const {
+            return _rows;
+        }
+
+        /** Get the number of columns in the block */
+        hal_size_t getLength() const {
+            return _length;
+        }
+
+        /** Get the position of the first column of the block on the
+         * reference sequence, in sequence coordinates */
+        hal_index_t getReferenceSequencePosition() const {
+            return _refPosition;
+        }
+
+        /** Get the total number of ColumnIterator columns computed, which
+         * is much less than the number of columns iterated over when most
+         * of the alignment is in long gapless runs */
+        hal_size_t getNumColumnsComputed() const {
+            return _numColumnsComputed;
+        }
+
+      private:
+        void readBlock();
+        bool extendsBlock() const;
+
+        const Sequence *_sequence;
+        ColumnIteratorPtr _colIt;
+        hal_index_t _refPosition;  // sequence coordinates
+        hal_index_t _nextPosition; // column of _colIt when not the last block
+        hal_index_t _lastPosition;
+        Rows _rows;
+        hal_size_t _length;
+        bool _lastBlock;
+        hal_size_t _numColumnsComputed;
+    };
+}
+
+#endif
+// Local Variables:
+// mode: c++
+// End:
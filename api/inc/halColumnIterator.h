@@ -12,11 +12,15 @@
 #include "halDefs.h"
 #include "halDnaIterator.h"
 #include "halPositionCache.h"
+#include "halSegmentIterator.h"
 #include "halSequence.h"
 #include "sonLib.h"
+#include <algorithm>
 #include <list>
 #include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace hal {
 
@@ -40,8 +44,8 @@ namespace hal {
         /// @cond TEST
         // Originally could compared genomes by pointers (because they are
         // persistent and unique).  However this lead to output instability
-        // problems for tests, so we use names.  If this shows up as a performance issue,
-        // we can sort only in MAF code.
+        // problems for tests, so we use names.  The column itself is ordered
+        // by integer ids that give the same order, see Row::_sequenceId.
         struct SequenceLess {
             bool operator()(const Sequence *s1, const Sequence *s2) const {
                 int diff = s1->getGenome()->getName().compare(s2->getGenome()->getName());
@@ -50,13 +54,73 @@ namespace hal {
         };
         /// @endcond
 
+        /* a base of the column */
+        struct Row {
+            const Sequence *_sequence;
+            DnaIteratorPtr _dna;
+            // rank of the genome name among all genomes in the upper 32
+            // bits, index of the sequence in the genome in the lower ones,
+            // so rows sort in SequenceLess order
+            hal_size_t _sequenceId;
+            hal_size_t _visit; // order the base was visited in the column
+        };
+        typedef std::vector<Row> Rows;
+
         typedef std::vector<DnaIteratorPtr> DNASet;
-        typedef std::map<const Sequence *, DNASet *, SequenceLess> ColumnMap;
+
+        /** Read-only view of a column as a map from sequences to their bases
+         * in the column, in the order of getRows().  This has the interface
+         * and contents of the std::map that getRows() replaced: sequences
+         * that had bases in an earlier column have an empty entry until
+         * defragment() or toSite() is called. */
+        class ColumnMap {
+          public:
+            typedef std::pair<const Sequence *, DNASet *> value_type;
+            typedef std::vector<value_type>::const_iterator const_iterator;
+
+            const_iterator begin() const {
+                return _entries.begin();
+            }
+            const_iterator end() const {
+                return _entries.end();
+            }
+            size_t size() const {
+                return _entries.size();
+            }
+            bool empty() const {
+                return _entries.empty();
+            }
+            /* sequences are matched by genome name and index, as a
+             * std::map with SequenceLess does */
+            const_iterator find(const Sequence *sequence) const {
+                SequenceLess less;
+                const_iterator i = std::lower_bound(
+                    begin(), end(), sequence, [&less](const value_type &v, const Sequence *s) { return less(v.first, s); });
+                return (i != end() && !less(sequence, i->first)) ? i : end();
+            }
+
+          private:
+            friend class ColumnIterator;
+            std::vector<value_type> _entries;
+        };
 
         /** Move column iterator one column to the right along reference
          * genoem sequence */
         virtual void toRight();
 
+        /** Get the number of columns, starting with the current one, in
+         * which every base of the column map is one position further along
+         * its strand than in the previous column and no bases are added or
+         * removed.  The run stops at the last column.  It is always 1 when
+         * the iterator follows indels, is unique or has a visit cache,
+         * as these can change a column without a segment boundary. */
+        virtual hal_size_t getGaplessLength() const;
+
+        /** Same as calling toRight() numColumns times, where numColumns is no
+         * greater than getGaplessLength().  The columns in between are
+         * skipped rather than computed. */
+        virtual void toRight(hal_size_t numColumns);
+
         /** Move column iterator to arbitrary site in genome -- effectively
          * resetting the iterator (convenience function to avoid creation of
          * new iterators in some cases).
@@ -85,20 +149,22 @@ namespace hal {
          * Must go back and review but it is concerning. */
         virtual hal_index_t getReferenceSequencePosition() const;
 
-        /** Get a pointer to the column map */
+        /** Get the bases of the column, ordered by genome name, then by
+         * sequence in the genome and then in the order they were visited.
+         * The vector is reused by the next column. */
+        virtual const Rows &getRows() const;
+
+        /** Get a pointer to the column map, a view of getRows() that is
+         * built when first asked for in a column */
         virtual const ColumnMap *getColumnMap() const;
 
         /** Get the index of the column in the reference genome's array */
         virtual hal_index_t getArrayIndex() const;
 
-        /** As we iterate along, we keep a column map entry for each sequence
-         * visited.  This works out pretty well except for extreme cases (such
-         * as iterating over entire fly genomes where we can accumulate 10s of
-         * thousands of empty entries for all the different scaffolds when
-         * in truth we only need a handful at any given time). Under these
-         * circumstances, calling this method every 1M bases or so will help
-         * reduce memory as well as speed up queries on the column map. Perhaps
-         * this should eventually be built in and made transparent? */
+        /** Erase the empty entries of the column map, which pile up when
+         * iterating over many sequences (such as the scaffolds of a fly
+         * genome).  Code that only uses getRows() has no need to call this,
+         * as the rows only hold the bases of the current column. */
         virtual void defragment();
 
         /** Check whether the column iterator's left-most reference coordinate
@@ -116,6 +182,12 @@ namespace hal {
          * tree. */
         virtual stTree *getTree() const;
 
+        /** Get the number of stack entries, links and iterators that were
+         * created, and that were recycled rather than allocated. */
+        const ColumnIteratorStack::PoolStats &getPoolStats() const {
+            return _pool.getStats();
+        }
+
         // temp -- probably want to have a "global column iterator" object
         // instead
         typedef std::map<const Genome *, PositionCache *> VisitCache;
@@ -142,9 +214,13 @@ namespace hal {
         bool parentInScope(const Genome *) const;
         bool childInScope(const Genome *, hal_size_t child) const;
         void nextFreeIndex();
-        bool colMapInsert(DnaIteratorPtr dnaIt);
+        void updateReferenceSequence();
+        void updateGaplessLength(const SegmentIterator *segIt);
+        bool colMapInsert(const DnaIteratorPtr &dnaIt);
+        hal_size_t getSequenceId(const Sequence *sequence);
+        void sortRows() const;
 
-        void resetColMap();
+        void resetColMap(bool clearRows = true);
         void eraseColMap();
 
         stTree *buildTree() const;
@@ -153,6 +229,7 @@ namespace hal {
       private:
         std::set<const Genome *> _targets;
         std::set<const Genome *> _scope;
+        ColumnIteratorStack::Pool _pool; // before the stacks, which return entries to it
         ColumnIteratorStack _stack;
         ColumnIteratorStack _indelStack;
         ColumnIteratorStack _insertionStack;
@@ -164,7 +241,14 @@ namespace hal {
         bool _noDupes;
         bool _noAncestors;
 
-        ColumnMap _colMap;
+        std::vector<std::string> _genomeNames; // all genomes of the alignment, sorted
+        std::map<const Genome *, hal_size_t> _genomeRanks;
+        mutable Rows _rows;
+        mutable bool _rowsSorted;
+        mutable ColumnMap _colMap;
+        mutable bool _colMapValid;
+        mutable std::vector<std::pair<hal_size_t, const Sequence *>> _colMapSequences; // sorted by id
+        mutable std::vector<DNASet *> _dnaSets; // reused by _colMap
         TopSegmentIteratorPtr _top;
         TopSegmentIteratorPtr _next;
         VisitCache _visitCache;
@@ -172,6 +256,7 @@ namespace hal {
         const Sequence *_prevRefSequence;
         hal_index_t _prevRefIndex;
         hal_index_t _leftmostRefPos;
+        hal_size_t _gaplessLength; // least bases left in segments of the column
         mutable stTree *_treeCache;
         bool _unique;
         bool _onlyOrthologs;
@@ -186,6 +271,10 @@ namespace hal {
         return _scope.empty() || _scope.find(genome->getParent()) != _scope.end();
     }
 
+    inline void ColumnIterator::updateGaplessLength(const SegmentIterator *segIt) {
+        _gaplessLength = std::min(_gaplessLength, (hal_size_t)segIt->getEndOffset() + 1);
+    }
+
     inline bool ColumnIterator::childInScope(const Genome *genome, hal_size_t child) const {
         assert(genome != NULL && genome->getChild(child) != NULL);
         return _scope.empty() || _scope.find(genome->getChild(child)) != _scope.end();
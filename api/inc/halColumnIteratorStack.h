@@ -44,10 +44,10 @@ namespace hal {
             Entry *_entry;
         };
 
+        class Pool;
         class Entry {
           public:
-            Entry(const Sequence *seq, hal_index_t first, hal_index_t index, hal_index_t last, hal_size_t size, bool reversed)
-                : _sequence(seq), _firstIndex(first), _index(index), _lastIndex(last), _cumulativeSize(size), _reversed(reversed) {
+            Entry(Pool *pool) : _pool(pool) {
                 _top._entry = this;
                 _bottom._entry = this;
             }
@@ -55,6 +55,17 @@ namespace hal {
                 freeLinks();
             }
 
+            /* set the range of a new or recycled entry */
+            void init(const Sequence *seq, hal_index_t first, hal_index_t index, hal_index_t last, hal_size_t size,
+                      bool reversed) {
+                _sequence = seq;
+                _firstIndex = first;
+                _index = index;
+                _lastIndex = last;
+                _cumulativeSize = size;
+                _reversed = reversed;
+            }
+
             bool pastEnd() const {
                 if (_reversed) {
                     return _index < _firstIndex;
@@ -63,37 +74,11 @@ namespace hal {
                 }
             }
 
-            LinkedTopIterator *newTop() {
-                LinkedTopIterator *top = new LinkedTopIterator();
-                top->_entry = this;
-                _topLinks.push_back(top);
-                return top;
-            }
-
-            LinkedBottomIterator *newBottom() {
-                LinkedBottomIterator *bottom = new LinkedBottomIterator();
-                bottom->_entry = this;
-                _bottomLinks.push_back(bottom);
-                return bottom;
-            }
-
-            void freeLinks() {
-                size_t i;
-                for (i = 0; i < _topLinks.size(); ++i) {
-                    delete _topLinks[i];
-                }
-                _topLinks.clear();
-                _top._bottomParse = NULL;
-                _top._parent = NULL;
-                _top._nextDup = NULL;
+            LinkedTopIterator *newTop();
+            LinkedBottomIterator *newBottom();
+            void freeLinks();
 
-                for (i = 0; i < _bottomLinks.size(); ++i) {
-                    delete _bottomLinks[i];
-                }
-                _bottomLinks.clear();
-                _bottom._topParse = NULL;
-                _bottom._children.clear();
-            }
+            Pool *_pool;
             const Sequence *_sequence;
             hal_index_t _firstIndex;
             hal_index_t _index;
@@ -106,7 +91,72 @@ namespace hal {
             bool _reversed;
         };
 
+        /* number of objects created and reused by a Pool */
+        struct PoolStats {
+            PoolStats() : _created(0), _reused(0) {
+            }
+            size_t _created;
+            size_t _reused;
+        };
+
+        /**
+         * Recycles the stack entries and links of a ColumnIterator, and
+         * the segment and DNA iterators of the links.  These would otherwise
+         * be allocated and freed for most columns and for every insertion
+         * and deletion pushed on the stack.  Iterators are kept by genome and
+         * are only reused once nothing outside of the pool, such as the
+         * column map, holds them.
+         */
+        class Pool {
+          public:
+            Pool() {
+            }
+            ~Pool();
+
+            Entry *newEntry(const Sequence *seq, hal_index_t first, hal_index_t index, hal_index_t last, hal_size_t size,
+                            bool reversed);
+            void freeEntry(Entry *entry);
+            LinkedTopIterator *newTop(Entry *entry);
+            LinkedBottomIterator *newBottom(Entry *entry);
+            void freeTop(LinkedTopIterator *top);
+            void freeBottom(LinkedBottomIterator *bottom);
+
+            /* iterators of a genome, segment iterators are on the forward
+             * strand */
+            TopSegmentIteratorPtr getTopIterator(const Genome *genome);
+            BottomSegmentIteratorPtr getBottomIterator(const Genome *genome);
+            DnaIteratorPtr getDnaIterator(const Genome *genome);
+
+            /* return the iterators of a link to the pool */
+            void releaseIterators(LinkedTopIterator *top);
+            void releaseIterators(LinkedBottomIterator *bottom);
+
+            const PoolStats &getStats() const {
+                return _stats;
+            }
+
+          private:
+            struct GenomeIterators {
+                const Genome *_genome;
+                std::vector<TopSegmentIteratorPtr> _tops;
+                std::vector<BottomSegmentIteratorPtr> _bottoms;
+                std::vector<DnaIteratorPtr> _dnas;
+            };
+            GenomeIterators &getGenomeIterators(const Genome *genome);
+
+            std::vector<Entry *> _entries;
+            std::vector<LinkedTopIterator *> _tops;
+            std::vector<LinkedBottomIterator *> _bottoms;
+            std::vector<GenomeIterators> _genomes;
+            PoolStats _stats;
+
+            Pool(const Pool &) = delete;
+            Pool &operator=(const Pool &) = delete;
+        };
+
       public:
+        explicit ColumnIteratorStack(Pool *pool) : _pool(pool) {
+        }
         ~ColumnIteratorStack() {
             clear();
         }
@@ -117,8 +167,7 @@ namespace hal {
             if (_stack.size() > 0) {
                 cumulative = top()->_cumulativeSize + lastIndex - index + 1;
             }
-            Entry *entry = new Entry(ref, index, reversed ? lastIndex : index, lastIndex, cumulative, reversed);
-            _stack.push_back(entry);
+            _stack.push_back(_pool->newEntry(ref, index, reversed ? lastIndex : index, lastIndex, cumulative, reversed));
         }
         void pushStack(ColumnIteratorStack &otherStack) {
             for (size_t i = 0; i < otherStack.size(); ++i) {
@@ -133,7 +182,7 @@ namespace hal {
             otherStack._stack.clear();
         }
         void popDelete() {
-            delete _stack.back();
+            _pool->freeEntry(_stack.back());
             _stack.pop_back();
         }
         void clear() {
@@ -167,6 +216,7 @@ namespace hal {
         }
 
       private:
+        Pool *_pool;
         std::vector<Entry *> _stack;
     };
 }
@@ -194,6 +194,11 @@ namespace hal {
         uint8_t code = dnaPackMap[uint8_t(unpackedChar)];
         return (index & 1) ? ((packedChar & 0xF0) | code) : ((packedChar & 0x0F) | (code << 4));
     }
+
+    /** Unpack length DNA characters starting at index of a nibble-encoded
+     * array into outBuffer (not zero-terminated), as the reverse complement
+     * if reverseComplement is set.  Uses SIMD instructions if available. */
+    void dnaUnpackString(const char *packed, hal_index_t index, hal_size_t length, bool reverseComplement, char *outBuffer);
 }
 
 #endif
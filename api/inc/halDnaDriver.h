@@ -8,6 +8,7 @@
 #ifndef _HALDNADRIVER_H
 #define _HALDNADRIVER_H
 #include "halCommon.h"
+#include <algorithm>
 
 namespace hal {
     /**
@@ -41,6 +42,27 @@ namespace hal {
             _dirty = true;
         }
 
+        /* get length bases starting at index into outBuffer, as the reverse
+         * complement if reversed is set.  Decodes a buffer at a time, which is
+         * much faster than calling getBase() for each base. */
+        inline void getBases(hal_index_t index, hal_size_t length, bool reversed, char *outBuffer) const {
+            // with reversed, the buffers are filled from the end of the output
+            char *out = reversed ? outBuffer + length : outBuffer;
+            while (length > 0) {
+                hal_index_t relIndex = access(index);
+                hal_size_t count = std::min(length, hal_size_t(_endIndex - index));
+                if (reversed) {
+                    out -= count;
+                    dnaUnpackString(_buffer, relIndex, count, true, out);
+                } else {
+                    dnaUnpackString(_buffer, relIndex, count, false, out);
+                    out += count;
+                }
+                index += count;
+                length -= count;
+            }
+        }
+
       protected:
         /* constructor */
         DnaAccess(hal_index_t startIndex, hal_index_t endIndex, char *buffer)
@@ -108,6 +108,10 @@ namespace hal {
         /* read a DNA string */
         void readString(std::string &outString, hal_size_t length);
 
+        /* read length bases into a buffer (not zero-terminated), moving in
+         * the direction of the iterator.  Bases are decoded in bulk. */
+        void readBases(char *outBuffer, hal_size_t length);
+
         /* write a DNA string */
         void writeString(const std::string &inString, hal_size_t length);
 
@@ -163,12 +167,25 @@ namespace hal {
     }
 
     inline void DnaIterator::readString(std::string &outString, hal_size_t length) {
-        assert(length == 0 || inRange() == true);
         outString.resize(length);
+        if (length > 0) {
+            readBases(&outString[0], length);
+        }
+    }
 
-        for (hal_size_t i = 0; i < length; ++i) {
-            outString[i] = getBase();
-            toRight();
+    inline void DnaIterator::readBases(char *outBuffer, hal_size_t length) {
+        assert(length == 0 || inRange() == true);
+        if (length == 0) {
+            return;
+        }
+        if (not _reversed) {
+            assert(_index + length <= _genome->getSequenceLength());
+            _dnaAccess->getBases(_index, length, false, outBuffer);
+            _index += length;
+        } else {
+            assert(_index + 1 >= (hal_index_t)length);
+            _dnaAccess->getBases(_index + 1 - length, length, true, outBuffer);
+            _index -= length;
         }
     }
 
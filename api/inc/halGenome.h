@@ -138,6 +138,16 @@ namespace hal {
          * @child child genome */
         hal_index_t getChildIndex(const Genome *child) const;
 
+        /** Get the cache of the projections of the top segments to the
+         * parent, NULL if the alignment doesn't enable projection caches
+         * (see Alignment::setProjectionCacheBytes) or this is the root. */
+        ProjectionCache *getParentProjectionCache() const;
+
+        /** Get the cache of the projections of the bottom segments to a
+         * child, NULL if the alignment doesn't enable projection caches.
+         * @param childIdx index of child genome */
+        ProjectionCache *getChildProjectionCache(hal_size_t childIdx) const;
+
         /** Test if the genome stores DNA sequence.  Will be true unless
          * storeDNAArrays was set to false in setDimensions */
         virtual bool containsDNAArray() const = 0;
@@ -148,6 +158,17 @@ namespace hal {
         /** Get a pointer to the alignment object that contains the genome. */
         virtual Alignment *getAlignment() = 0;
 
+        /** Announce that top segments [firstIndex, lastIndex] will soon be
+         * read, so that storage that fetches data on demand, such as a mmap
+         * file URL, can start fetching them in parallel.  No-op by default. */
+        virtual void prefetchTopSegments(hal_index_t firstIndex, hal_index_t lastIndex) const {
+        }
+
+        /** Announce that bottom segments [firstIndex, lastIndex] will soon
+         * be read, see prefetchTopSegments() */
+        virtual void prefetchBottomSegments(hal_index_t firstIndex, hal_index_t lastIndex) const {
+        }
+
         /** Copy all information from this genome to another. The genomes
          * must be in different alignments. The genome must not have
          * uninitialized data.
@@ -205,6 +226,8 @@ namespace hal {
             _numChildren = _alignment->getChildNames(_name).size();
             _childCache.empty();
             _parentCache = NULL;
+            _parentProjection.reset();
+            _childProjections.clear();
         };
 
       protected:
@@ -213,6 +236,8 @@ namespace hal {
         hal_index_t _numChildren;
         mutable Genome *_parentCache;
         mutable std::vector<Genome *> _childCache;
+        mutable std::unique_ptr<ProjectionCache> _parentProjection;
+        mutable std::vector<std::unique_ptr<ProjectionCache>> _childProjections;
     };
 
     inline Genome *Genome::getChild(hal_size_t childIdx) {
@@ -274,6 +299,30 @@ namespace hal {
         }
         return _parentCache;
     }
+
+    inline ProjectionCache *Genome::getParentProjectionCache() const {
+        if ((_parentProjection == NULL) && (_alignment->getProjectionCacheBytes() > 0) && (getParent() != NULL)) {
+            _parentProjection.reset(new ProjectionCache(this, NULL_INDEX, _alignment->getProjectionCacheBytes(),
+                                                        _alignment->getProjectionCacheStats(
+                                                            ProjectionCache::getPairName(this, NULL_INDEX))));
+        }
+        return _parentProjection.get();
+    }
+
+    inline ProjectionCache *Genome::getChildProjectionCache(hal_size_t childIdx) const {
+        if (_alignment->getProjectionCacheBytes() == 0) {
+            return NULL;
+        }
+        if (_childProjections.size() < _numChildren) {
+            _childProjections.resize(_numChildren);
+        }
+        std::unique_ptr<ProjectionCache> &cache = _childProjections.at(childIdx);
+        if (cache == NULL) {
+            cache.reset(new ProjectionCache(this, childIdx, _alignment->getProjectionCacheBytes(),
+                                            _alignment->getProjectionCacheStats(ProjectionCache::getPairName(this, childIdx))));
+        }
+        return cache.get();
+    }
 }
 #endif
 // Local Variables:
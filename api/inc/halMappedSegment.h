@@ -13,9 +13,127 @@
 #include "halSegmentIterator.h"
 #include "halSlicedSegment.h"
 #include "halTopSegmentIterator.h"
+#include <cassert>
 #include <list>
 
 namespace hal {
+    /**
+     * Value representation of a sliced segment iterator: the genome, array
+     * index and kind of segment, the slice offsets and strand.  The
+     * coordinates of the whole segment are copied when the record is made,
+     * so positions can be computed and compared without accessing the
+     * genome.  Used by halMapSegment in place of segment iterators so that
+     * mapping doesn't allocate iterators for each intermediate segment.
+     */
+    struct SlicedSegmentRecord {
+        SlicedSegmentRecord() : _genome(NULL), _arrayIndex(NULL_INDEX), _segStart(NULL_INDEX), _segLength(0),
+                                _startOffset(0), _endOffset(0), _isTop(false), _reversed(false) {
+        }
+
+        /* copy the position of an iterator */
+        explicit SlicedSegmentRecord(const SegmentIterator *segIt);
+
+        /* move an iterator of the same kind and genome to this position */
+        void loadIterator(SegmentIterator *segIt) const;
+
+        /* create a new iterator at this position */
+        SegmentIteratorPtr makeIterator() const;
+
+        hal_index_t getStartPosition() const {
+            return _reversed ? _segStart + (hal_index_t)_segLength - 1 - (hal_index_t)_startOffset
+                             : _segStart + (hal_index_t)_startOffset;
+        }
+        hal_index_t getEndPosition() const {
+            return _reversed ? _segStart + (hal_index_t)_endOffset
+                             : _segStart + (hal_index_t)_segLength - 1 - (hal_index_t)_endOffset;
+        }
+        hal_size_t getLength() const {
+            return _segLength - _startOffset - _endOffset;
+        }
+        void slice(hal_offset_t startOffset, hal_offset_t endOffset) {
+            assert(startOffset < _segLength && endOffset < _segLength);
+            _startOffset = startOffset;
+            _endOffset = endOffset;
+        }
+
+        /* compare by lowest then highest position, ignoring strand, like
+         * MappedSegment comparisons */
+        int compare(const SlicedSegmentRecord &other) const;
+
+        const Genome *_genome;
+        hal_index_t _arrayIndex;
+        hal_index_t _segStart;
+        hal_size_t _segLength;
+        hal_offset_t _startOffset;
+        hal_offset_t _endOffset;
+        bool _isTop;
+        bool _reversed;
+    };
+
+    /**
+     * Value representation of a MappedSegment, see SlicedSegmentRecord.
+     */
+    struct MappedSegmentRecord {
+        MappedSegmentRecord() : _inputIndex(0) {
+        }
+        MappedSegmentRecord(const SlicedSegmentRecord &source, const SegmentIterator *targetSegIt, hal_size_t inputIndex = 0)
+            : _source(source), _target(targetSegIt), _inputIndex(inputIndex) {
+            assert(_source.getLength() == _target.getLength());
+        }
+        MappedSegmentRecord(const SlicedSegmentRecord &source, const SlicedSegmentRecord &target, hal_size_t inputIndex = 0)
+            : _source(source), _target(target), _inputIndex(inputIndex) {
+            assert(_source.getLength() == _target.getLength());
+        }
+
+        const Genome *getGenome() const {
+            return _target._genome;
+        }
+
+        /* same order as MappedSegment::lessThan */
+        bool lessThan(const MappedSegmentRecord &other) const {
+            int res = _target.compare(other._target);
+            return ((res == 0) ? _source.compare(other._source) : res) < 0;
+        }
+
+        /* same order as MappedSegment::lessThanBySource */
+        bool lessThanBySource(const MappedSegmentRecord &other) const {
+            int res = _source.compare(other._source);
+            return ((res == 0) ? _target.compare(other._target) : res) < 0;
+        }
+
+        /* same as MappedSegment::equals */
+        bool equals(const MappedSegmentRecord &other) const {
+            return (_source.compare(other._source) == 0) && (_target.compare(other._target) == 0);
+        }
+
+        /** Functor for sorting by source as primary index */
+        struct LessSource {
+            bool operator()(const MappedSegmentRecord &ms1, const MappedSegmentRecord &ms2) const {
+                return ms1.lessThanBySource(ms2);
+            }
+        };
+
+        /** Functor for sorting by target as primary index */
+        struct Less {
+            bool operator()(const MappedSegmentRecord &ms1, const MappedSegmentRecord &ms2) const {
+                return ms1.lessThan(ms2);
+            }
+        };
+
+        /** Functor to test for uniqueness */
+        struct EqualTo {
+            bool operator()(const MappedSegmentRecord &ms1, const MappedSegmentRecord &ms2) const {
+                return ms1.equals(ms2);
+            }
+        };
+
+        SlicedSegmentRecord _source;
+        SlicedSegmentRecord _target;
+        /* index of the input this segment was mapped from when mapping
+         * several at once with halMapSegments; not used in comparisons */
+        hal_size_t _inputIndex;
+    };
+
     /**
      * Interface for a mapped segment.  A mapped segment stores a source segment
      * and a homologous region in a target genome (to which it was mapped).  Mapped
@@ -27,6 +145,9 @@ namespace hal {
         /* Constructor */
         MappedSegment(SegmentIteratorPtr sourceSegIt, SegmentIteratorPtr targetSegIt);
 
+        /* Constructor, creating iterators from a record */
+        MappedSegment(const MappedSegmentRecord &record);
+
         /** Destructor */
         virtual ~MappedSegment() {
         }
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#ifndef _HALMAPPEDSEGMENTVECTOR_H
+#define _HALMAPPEDSEGMENTVECTOR_H
+
+#include "halDefs.h"
+#include "halMappedSegment.h"
+#include "halMappedSegmentContainers.h"
+#include <vector>
+
+namespace hal {
+    /**
+     * Flat alternative to MappedSegmentSet as output of halMapSegment.
+     * Mapped segments are appended as MappedSegmentRecords without any
+     * ordering or overlap checks.  Once all segments have been mapped,
+     * resolve() sorts them and breaks overlapping targets in one pass,
+     * giving the same segments in the same order as inserting them into a
+     * MappedSegmentSet, which does a tree search and overlap check for each
+     * segment.  All segments must map to the same target genome.
+     */
+    class MappedSegmentVector {
+      public:
+        typedef std::vector<MappedSegmentRecord>::const_iterator const_iterator;
+
+        MappedSegmentVector() : _resolved(true) {
+        }
+
+        /* add a mapped segment; resolve() must be called before accessing
+         * the segments */
+        void add(const MappedSegmentRecord &mappedSeg) {
+            _segments.push_back(mappedSeg);
+            _resolved = false;
+        }
+
+        /* Sort the segments by target and cut segments whose targets
+         * overlap, so that the targets of any two segments are either
+         * identical or disjoint.  Duplicates are removed. */
+        void resolve();
+
+        bool isResolved() const {
+            return _resolved;
+        }
+
+        void clear() {
+            _segments.clear();
+            _resolved = true;
+        }
+
+        bool empty() const {
+            return _segments.empty();
+        }
+
+        size_t size() const {
+            return _segments.size();
+        }
+
+        const MappedSegmentRecord &operator[](size_t i) const {
+            assert(_resolved);
+            return _segments[i];
+        }
+
+        const_iterator begin() const {
+            assert(_resolved);
+            return _segments.begin();
+        }
+
+        const_iterator end() const {
+            return _segments.end();
+        }
+
+        /* Replace the contents of a MappedSegmentSet with the resolved
+         * segments.  As they are already in order, this doesn't search the
+         * set. */
+        void toSet(MappedSegmentSet &segSet) const;
+
+      private:
+        std::vector<MappedSegmentRecord> _segments;
+        bool _resolved;
+    };
+}
+
+#endif
+// Local Variables:
+// mode: c++
+// End:
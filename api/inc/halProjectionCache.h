@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#ifndef _HALPROJECTIONCACHE_H
+#define _HALPROJECTIONCACHE_H
+
+#include "halDefs.h"
+#include <cassert>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace hal {
+    /* hit statistics for the projection cache of a genome pair */
+    struct ProjectionCacheStats {
+        ProjectionCacheStats() : _hits(0), _misses(0), _evictions(0) {
+        }
+        size_t _hits;
+        size_t _misses;    // pages loaded
+        size_t _evictions; // pages dropped to stay within the budget
+    };
+
+    /**
+     * Cache of the projection of the segments of a genome to its parent
+     * (top segments) or to one of its children (bottom segments): the
+     * array index of the aligned segment in the other genome and whether
+     * it is on the opposite strand.  This is what
+     * BottomSegmentIterator::toParent() and TopSegmentIterator::toChild()
+     * read through the segment objects of the file for every column of
+     * a ColumnIterator and every step of a halMapSegment.
+     *
+     * The projections are kept in flat arrays, loaded a page of segments at
+     * a time on first use.  When more than maxBytes of pages are loaded,
+     * the oldest pages are dropped.  Caches are created by the Genome when
+     * enabled with Alignment::setProjectionCacheBytes().  A cache is not
+     * thread-safe and is only used with read-only alignments.
+     */
+    class ProjectionCache {
+      public:
+        /* number of segments in a page, as a power of two */
+        static const int PAGE_BITS = 12;
+        static const hal_size_t PAGE_SIZE = hal_size_t(1) << PAGE_BITS;
+
+        /* cache the projection of genome to its parent if childIndex is
+         * NULL_INDEX, otherwise to the child. */
+        ProjectionCache(const Genome *genome, hal_index_t childIndex, size_t maxBytes, ProjectionCacheStats *stats);
+
+        /* get the index of the segment aligned to the segment arrayIndex,
+         * NULL_INDEX if none, and if it is reversed */
+        void get(hal_index_t arrayIndex, hal_index_t &targetIndex, bool &targetReversed) {
+            assert(arrayIndex >= 0 && arrayIndex < (hal_index_t)_numSegments);
+            hal_size_t pageNum = hal_size_t(arrayIndex) >> PAGE_BITS;
+            const std::vector<hal_index_t> &page = _pages[pageNum];
+            hal_index_t entry;
+            if (page.empty()) {
+                entry = loadPage(pageNum)[arrayIndex & (PAGE_SIZE - 1)];
+                _stats->_misses++;
+            } else {
+                entry = page[arrayIndex & (PAGE_SIZE - 1)];
+                _stats->_hits++;
+            }
+            // entries are twice the index, plus one if reversed
+            targetIndex = entry >> 1;
+            targetReversed = entry & 1;
+        }
+
+        const Genome *getGenome() const {
+            return _genome;
+        }
+        hal_index_t getChildIndex() const {
+            return _childIndex;
+        }
+        size_t getUsedBytes() const {
+            return _loadedPages.size() * PAGE_SIZE * sizeof(hal_index_t);
+        }
+
+        /* name of a genome pair for statistics, as "genome->target" */
+        static std::string getPairName(const Genome *genome, hal_index_t childIndex);
+
+        /* print the statistics of each genome pair and the total */
+        static void printStats(const std::map<std::string, ProjectionCacheStats> &allStats, std::ostream &out);
+
+      private:
+        const std::vector<hal_index_t> &loadPage(hal_size_t pageNum);
+
+        const Genome *_genome;
+        hal_index_t _childIndex;
+        hal_size_t _numSegments;
+        size_t _maxPages;
+        ProjectionCacheStats *_stats;
+        std::vector<std::vector<hal_index_t>> _pages;
+        std::deque<hal_size_t> _loadedPages; // oldest first
+
+        ProjectionCache(const ProjectionCache &) = delete;
+        ProjectionCache &operator=(const ProjectionCache &) = delete;
+    };
+}
+#endif
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,422 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#ifndef _HALSEGMENTCURSOR_H
+#define _HALSEGMENTCURSOR_H
+
+#include "halBottomSegmentIterator.h"
+#include "halDefs.h"
+#include "halGenome.h"
+#include "halMappedSegment.h"
+#include "halTopSegmentIterator.h"
+#include <algorithm>
+#include <cassert>
+#include <deque>
+
+/*
+ * Non-virtual segment iterators used internally by halMapSegment.
+ *
+ * A cursor is a SlicedSegmentRecord bound to an accessor for the segment
+ * array of its genome.  Accessors read the fields of a segment by array
+ * index.  They are grouped by storage backend in a traits class with
+ * TopAccess and BottomAccess types, the cursors and the code using them are
+ * templates over this class.  GenericSegmentAccess reads through the
+ * polymorphic segment objects and works with any alignment;
+ * MMapSegmentAccess (mmapSegmentAccess.h) reads the mmap arrays
+ * directly, so field access is inlined into the mapping loops.
+ *
+ * Cursor methods have the same results as the SegmentIterator methods of the
+ * same name.  Genome accessors are passed explicitly when moving to another
+ * segment array.
+ */
+namespace hal {
+    /* top segments, read through a TopSegmentIterator, with parent links from
+     * the projection cache if enabled */
+    class GenericTopSegmentAccess {
+      public:
+        explicit GenericTopSegmentAccess(const Genome *genome)
+            : _genome(genome), _numSegments(genome->getNumTopSegments()),
+              _parentCache(genome->getParentProjectionCache()) {
+        }
+        const Genome *getGenome() const {
+            return _genome;
+        }
+        hal_size_t getNumSegments() const {
+            return _numSegments;
+        }
+        hal_index_t getStartPosition(hal_index_t i) const {
+            return seg(i)->getStartPosition();
+        }
+        hal_size_t getLength(hal_index_t i) const {
+            return seg(i)->getLength();
+        }
+        hal_index_t getParentIndex(hal_index_t i) const {
+            if (_parentCache != NULL) {
+                hal_index_t parentIndex;
+                bool parentReversed;
+                _parentCache->get(i, parentIndex, parentReversed);
+                return parentIndex;
+            }
+            return seg(i)->getParentIndex();
+        }
+        bool getParentReversed(hal_index_t i) const {
+            if (_parentCache != NULL) {
+                hal_index_t parentIndex;
+                bool parentReversed;
+                _parentCache->get(i, parentIndex, parentReversed);
+                return parentReversed;
+            }
+            return seg(i)->getParentReversed();
+        }
+        hal_index_t getBottomParseIndex(hal_index_t i) const {
+            return seg(i)->getBottomParseIndex();
+        }
+        hal_index_t getNextParalogyIndex(hal_index_t i) const {
+            return seg(i)->getNextParalogyIndex();
+        }
+        bool isCanonicalParalog(hal_index_t i) const {
+            return seg(i)->isCanonicalParalog();
+        }
+
+      private:
+        /* the iterator only moves when the index changes */
+        const TopSegment *seg(hal_index_t i) const {
+            if (_segIt.get() == NULL) {
+                _segIt = _genome->getTopSegmentIterator(i);
+            } else if (_segIt->getArrayIndex() != i) {
+                _segIt->setArrayIndex(const_cast<Genome *>(_genome), i);
+            }
+            return _segIt->tseg();
+        }
+        const Genome *_genome;
+        hal_size_t _numSegments;
+        ProjectionCache *_parentCache;
+        mutable TopSegmentIteratorPtr _segIt;
+    };
+
+    /* bottom segments, read through a BottomSegmentIterator, with child links
+     * from the projection caches if enabled */
+    class GenericBottomSegmentAccess {
+      public:
+        explicit GenericBottomSegmentAccess(const Genome *genome)
+            : _genome(genome), _numSegments(genome->getNumBottomSegments()) {
+        }
+        const Genome *getGenome() const {
+            return _genome;
+        }
+        hal_size_t getNumSegments() const {
+            return _numSegments;
+        }
+        hal_index_t getStartPosition(hal_index_t i) const {
+            return seg(i)->getStartPosition();
+        }
+        hal_size_t getLength(hal_index_t i) const {
+            return seg(i)->getLength();
+        }
+        hal_index_t getChildIndex(hal_index_t i, hal_size_t child) const {
+            ProjectionCache *childCache = _genome->getChildProjectionCache(child);
+            if (childCache != NULL) {
+                hal_index_t childIndex;
+                bool childReversed;
+                childCache->get(i, childIndex, childReversed);
+                return childIndex;
+            }
+            return seg(i)->getChildIndex(child);
+        }
+        bool getChildReversed(hal_index_t i, hal_size_t child) const {
+            ProjectionCache *childCache = _genome->getChildProjectionCache(child);
+            if (childCache != NULL) {
+                hal_index_t childIndex;
+                bool childReversed;
+                childCache->get(i, childIndex, childReversed);
+                return childReversed;
+            }
+            return seg(i)->getChildReversed(child);
+        }
+        hal_index_t getTopParseIndex(hal_index_t i) const {
+            return seg(i)->getTopParseIndex();
+        }
+
+      private:
+        /* the iterator only moves when the index changes */
+        const BottomSegment *seg(hal_index_t i) const {
+            if (_segIt.get() == NULL) {
+                _segIt = _genome->getBottomSegmentIterator(i);
+            } else if (_segIt->getArrayIndex() != i) {
+                _segIt->setArrayIndex(const_cast<Genome *>(_genome), i);
+            }
+            return _segIt->bseg();
+        }
+        const Genome *_genome;
+        hal_size_t _numSegments;
+        mutable BottomSegmentIteratorPtr _segIt;
+    };
+
+    /* storage traits for any alignment */
+    struct GenericSegmentAccess {
+        typedef GenericTopSegmentAccess TopAccess;
+        typedef GenericBottomSegmentAccess BottomAccess;
+    };
+
+    /* accessors of the genomes visited, created on first use */
+    template <class Access> class SegmentAccessCache {
+      public:
+        const typename Access::TopAccess *getTop(const Genome *genome) {
+            GenomeAccess &genomeAccess = getGenomeAccess(genome);
+            if (genomeAccess._top.empty()) {
+                genomeAccess._top.emplace_back(genome);
+            }
+            return &genomeAccess._top.front();
+        }
+        const typename Access::BottomAccess *getBottom(const Genome *genome) {
+            GenomeAccess &genomeAccess = getGenomeAccess(genome);
+            if (genomeAccess._bottom.empty()) {
+                genomeAccess._bottom.emplace_back(genome);
+            }
+            return &genomeAccess._bottom.front();
+        }
+
+      private:
+        /* a deque holds zero or one accessor without requiring it be
+         * copyable and doesn't move it when growing */
+        struct GenomeAccess {
+            const Genome *_genome;
+            std::deque<typename Access::TopAccess> _top;
+            std::deque<typename Access::BottomAccess> _bottom;
+        };
+
+        /* few genomes are visited, so a linear search is fastest */
+        GenomeAccess &getGenomeAccess(const Genome *genome) {
+            for (GenomeAccess &genomeAccess : _genomes) {
+                if (genomeAccess._genome == genome) {
+                    return genomeAccess;
+                }
+            }
+            _genomes.push_back(GenomeAccess());
+            _genomes.back()._genome = genome;
+            return _genomes.back();
+        }
+
+        std::deque<GenomeAccess> _genomes;
+    };
+
+    /* position, slice and strand common to top and bottom cursors */
+    template <class SegAccess> class SegmentCursor {
+      public:
+        SegmentCursor(bool isTop) : _access(NULL) {
+            _record._isTop = isTop;
+        }
+
+        /* move to the position of a record of the accessor's genome */
+        void load(const SegAccess *access, const SlicedSegmentRecord &record) {
+            assert(record._genome == access->getGenome() && record._isTop == _record._isTop);
+            _access = access;
+            _record = record;
+        }
+        const SlicedSegmentRecord &getRecord() const {
+            return _record;
+        }
+        const Genome *getGenome() const {
+            return _record._genome;
+        }
+        hal_index_t getArrayIndex() const {
+            return _record._arrayIndex;
+        }
+        hal_offset_t getStartOffset() const {
+            return _record._startOffset;
+        }
+        hal_offset_t getEndOffset() const {
+            return _record._endOffset;
+        }
+        bool getReversed() const {
+            return _record._reversed;
+        }
+        hal_index_t getStartPosition() const {
+            return _record.getStartPosition();
+        }
+        hal_index_t getEndPosition() const {
+            return _record.getEndPosition();
+        }
+        hal_size_t getLength() const {
+            return _record.getLength();
+        }
+        void toReverse() {
+            _record._reversed = !_record._reversed;
+        }
+
+        /* move to the next slice on the strand, up to rightCutoff */
+        void toRight(hal_index_t rightCutoff) {
+            if (_record._reversed == false) {
+                if (_record._endOffset == 0) {
+                    setArrayIndex(_record._arrayIndex + 1);
+                    _record._startOffset = 0;
+                } else {
+                    _record._startOffset = _record._segLength - _record._endOffset;
+                    _record._endOffset = 0;
+                }
+                if ((hal_size_t)_record._arrayIndex < _access->getNumSegments() && rightCutoff != NULL_INDEX &&
+                    overlaps(rightCutoff)) {
+                    _record._endOffset = _record._segStart + _record._segLength - rightCutoff - 1;
+                }
+            } else {
+                if (_record._endOffset == 0) {
+                    setArrayIndex(_record._arrayIndex - 1);
+                    _record._startOffset = 0;
+                } else {
+                    _record._startOffset = _record._segLength - _record._endOffset;
+                    _record._endOffset = 0;
+                }
+                if (_record._arrayIndex >= 0 && rightCutoff != NULL_INDEX && overlaps(rightCutoff)) {
+                    _record._endOffset = rightCutoff - _record._segStart;
+                }
+            }
+        }
+
+      protected:
+        /* move to a segment of the accessor's genome, reading its
+         * coordinates if it is in range */
+        void setArrayIndex(hal_index_t arrayIndex) {
+            _record._arrayIndex = arrayIndex;
+            if (arrayIndex >= 0 && (hal_size_t)arrayIndex < _access->getNumSegments()) {
+                _record._segStart = _access->getStartPosition(arrayIndex);
+                _record._segLength = _access->getLength(arrayIndex);
+            }
+        }
+        void setArrayIndex(const SegAccess *access, hal_index_t arrayIndex) {
+            _access = access;
+            _record._genome = access->getGenome();
+            setArrayIndex(arrayIndex);
+        }
+
+        /* move to the segment at or after a position, starting from index */
+        void toPosition(const SegAccess *access, hal_index_t arrayIndex, hal_index_t position) {
+            setArrayIndex(access, arrayIndex);
+            while (position >= _record._segStart + (hal_index_t)_record._segLength) {
+                setArrayIndex(++arrayIndex);
+            }
+        }
+
+        bool overlaps(hal_index_t genomePos) const {
+            hal_index_t startPos = getStartPosition();
+            hal_index_t length = (hal_index_t)getLength();
+            if (_record._reversed == false) {
+                return (startPos + length > genomePos) && (startPos <= genomePos);
+            } else {
+                return (startPos >= genomePos) && (startPos - length < genomePos);
+            }
+        }
+
+        /* set the slice that covers the same positions as another cursor
+         * at or after the start of this segment */
+        template <class OtherAccess> void sliceToMatch(const SegmentCursor<OtherAccess> &other) {
+            hal_index_t startPos = other.getStartPosition();
+            hal_index_t segStart = _record._segStart;
+            hal_index_t segEnd = segStart + (hal_index_t)_record._segLength;
+            if (_record._reversed == false) {
+                _record._startOffset = startPos - segStart;
+                hal_index_t otherEnd = startPos + (hal_index_t)other.getLength();
+                _record._endOffset = std::max((hal_index_t)0, segEnd - otherEnd);
+            } else {
+                _record._startOffset = segEnd - 1 - startPos;
+                hal_index_t otherEnd = startPos - (hal_index_t)other.getLength() + 1;
+                _record._endOffset = std::max((hal_index_t)0, otherEnd - segStart);
+            }
+            assert(_record._startOffset + _record._endOffset <= _record._segLength);
+        }
+
+        /* take the slice and strand of an aligned segment */
+        template <class OtherAccess> void copySlice(const SegmentCursor<OtherAccess> &other, bool otherReversed) {
+            _record._startOffset = other.getStartOffset();
+            _record._endOffset = other.getEndOffset();
+            _record._reversed = other.getReversed();
+            if (otherReversed) {
+                toReverse();
+            }
+        }
+
+        const SegAccess *_access;
+        SlicedSegmentRecord _record;
+    };
+
+    template <class Access> class BottomSegmentCursor;
+
+    template <class Access> class TopSegmentCursor : public SegmentCursor<typename Access::TopAccess> {
+      public:
+        typedef typename Access::TopAccess TopAccess;
+        typedef typename Access::BottomAccess BottomAccess;
+
+        TopSegmentCursor() : SegmentCursor<TopAccess>(true) {
+        }
+        bool hasParent() const {
+            return this->_access->getParentIndex(this->_record._arrayIndex) != NULL_INDEX;
+        }
+        bool isCanonicalParalog() const {
+            return this->_access->isCanonicalParalog(this->_record._arrayIndex);
+        }
+        bool hasNextParalogy() const {
+            return this->_access->getNextParalogyIndex(this->_record._arrayIndex) != NULL_INDEX;
+        }
+        void toNextParalogy() {
+            hal_index_t arrayIndex = this->_record._arrayIndex;
+            assert(this->_access->getNextParalogyIndex(arrayIndex) != NULL_INDEX);
+            bool reversed = this->_access->getParentReversed(arrayIndex);
+            this->setArrayIndex(this->_access->getNextParalogyIndex(arrayIndex));
+            if (this->_access->getParentReversed(this->_record._arrayIndex) != reversed) {
+                this->toReverse();
+            }
+        }
+        /* childAccess is for the child genome */
+        void toChild(const BottomSegmentCursor<Access> &botCursor, hal_size_t child, const TopAccess *childAccess) {
+            const BottomAccess *botAccess = botCursor.getAccess();
+            hal_index_t botIndex = botCursor.getArrayIndex();
+            this->setArrayIndex(childAccess, botAccess->getChildIndex(botIndex, child));
+            this->copySlice(botCursor, botAccess->getChildReversed(botIndex, child));
+        }
+        /* access is for the genome of botCursor */
+        void toParseUp(const BottomSegmentCursor<Access> &botCursor, const TopAccess *access) {
+            this->toPosition(access, botCursor.getAccess()->getTopParseIndex(botCursor.getArrayIndex()),
+                             botCursor.getStartPosition());
+            this->_record._reversed = botCursor.getReversed();
+            this->sliceToMatch(botCursor);
+        }
+        const TopAccess *getAccess() const {
+            return this->_access;
+        }
+    };
+
+    template <class Access> class BottomSegmentCursor : public SegmentCursor<typename Access::BottomAccess> {
+      public:
+        typedef typename Access::TopAccess TopAccess;
+        typedef typename Access::BottomAccess BottomAccess;
+
+        BottomSegmentCursor() : SegmentCursor<BottomAccess>(false) {
+        }
+        bool hasChild(hal_size_t child) const {
+            return this->_access->getChildIndex(this->_record._arrayIndex, child) != NULL_INDEX;
+        }
+        /* parentAccess is for the parent genome */
+        void toParent(const TopSegmentCursor<Access> &topCursor, const BottomAccess *parentAccess) {
+            const TopAccess *topAccess = topCursor.getAccess();
+            hal_index_t topIndex = topCursor.getArrayIndex();
+            this->setArrayIndex(parentAccess, topAccess->getParentIndex(topIndex));
+            this->copySlice(topCursor, topAccess->getParentReversed(topIndex));
+        }
+        /* access is for the genome of topCursor */
+        void toParseDown(const TopSegmentCursor<Access> &topCursor, const BottomAccess *access) {
+            this->toPosition(access, topCursor.getAccess()->getBottomParseIndex(topCursor.getArrayIndex()),
+                             topCursor.getStartPosition());
+            this->_record._reversed = topCursor.getReversed();
+            this->sliceToMatch(topCursor);
+        }
+        const BottomAccess *getAccess() const {
+            return this->_access;
+        }
+    };
+}
+#endif
+// Local Variables:
+// mode: c++
+// End:
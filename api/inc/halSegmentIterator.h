@@ -51,6 +51,10 @@ namespace hal {
          * though it should be faster on average*/
         virtual void toSite(hal_index_t position, bool slice = true);
 
+        /** announce that the segments from the current one to lastIndex
+         * will soon be visited, see Genome::prefetchTopSegments() */
+        void prefetchTo(hal_index_t lastIndex) const;
+
         /** has the iterator reach the end of the traversal in the direction of
          * movement? */
         bool atEnd() const {
@@ -10,10 +10,13 @@
 #include "halDefs.h"
 #include "halSegmentIterator.h"
 #include <set>
+#include <vector>
 
 namespace hal {
     class Segment;
     class MappedSegmentSet;
+    class MappedSegmentVector;
+    struct MappedSegmentRecord;
     class Genome;
 
     /** Get homologous segments in target genome.  Returns the number
@@ -43,9 +46,67 @@ namespace hal {
                              const std::set<const Genome *> *genomesOnPath = NULL, bool doDupes = true,
                              hal_size_t minLength = 0, const Genome *coalescenceLimit = NULL, const Genome *mrca = NULL);
 
+    /** Get homologous segments in target genome, appending them to a
+      * MappedSegmentVector.  The vector must be resolved once all
+      * segments have been mapped, which is much faster than inserting each
+      * segment into a MappedSegmentSet when many segments are mapped.
+      * Returns the number of mapped segments added.  Parameters are as
+      * for the MappedSegmentSet version.  */
+    hal_size_t halMapSegment(const SegmentIterator *source, MappedSegmentVector &outSegments, const Genome *tgtGenome,
+                             const std::set<const Genome *> *genomesOnPath = NULL, bool doDupes = true,
+                             hal_size_t minLength = 0, const Genome *coalescenceLimit = NULL, const Genome *mrca = NULL);
+
+    /** Interval of a source genome to map with halMapSegments, in genome
+      * coordinates.  The end position is inclusive, so an interval with
+      * an end before its start is empty. */
+    struct SourceInterval {
+        SourceInterval(hal_index_t start, hal_index_t end, bool reversed = false)
+            : _start(start), _end(end), _reversed(reversed) {
+        }
+        hal_index_t _start;
+        hal_index_t _end;
+        bool _reversed;
+    };
+
+    /** Get homologous segments in target genome for each of a batch of
+      * source intervals.  The segments of all intervals are mapped
+      * together, one level of the tree at a time, so the path is only
+      * computed once and the iterators used to follow the alignment are
+      * shared.  Giving the intervals sorted by position keeps these
+      * iterators close together, but the results don't depend on the
+      * order.  Returns the total number of mapped segments found.
+      * @param srcGenome Genome containing the intervals.
+      * @param intervals Input intervals.  Reversed intervals are mapped
+      * from the reverse strand.
+      * @param outSegments Output.  Resized to have a resolved
+      * MappedSegmentVector for each interval, containing the same segments
+      * as calling halMapSegment on each segment of the interval would.
+      * Other parameters are as for halMapSegment. */
+    hal_size_t halMapSegments(const Genome *srcGenome, const std::vector<SourceInterval> &intervals,
+                              std::vector<MappedSegmentVector> &outSegments, const Genome *tgtGenome,
+                              const std::set<const Genome *> *genomesOnPath = NULL, bool doDupes = true,
+                              hal_size_t minLength = 0, const Genome *coalescenceLimit = NULL, const Genome *mrca = NULL);
+
+    /** Map a batch of source intervals as halMapSegments does, but return
+      * the mapped segments of all intervals in one vector without
+      * resolving them.  Each record's _inputIndex is the index of its
+      * interval.  Segments whose targets overlap are not cut, so the
+      * records of a segment can later be sliced and resolved together with
+      * others.  Returns the number of records. */
+    hal_size_t halMapSegmentRecords(const Genome *srcGenome, const std::vector<SourceInterval> &intervals,
+                                    std::vector<MappedSegmentRecord> &outRecords, const Genome *tgtGenome,
+                                    const std::set<const Genome *> *genomesOnPath = NULL, bool doDupes = true,
+                                    hal_size_t minLength = 0, const Genome *coalescenceLimit = NULL,
+                                    const Genome *mrca = NULL);
+
     /* call main function with smart pointer */
     hal_size_t halMapSegmentSP(const SegmentIteratorPtr &source, MappedSegmentSet &outSegments, const Genome *tgtGenome,
                                const std::set<const Genome *> *genomesOnPath = NULL, bool doDupes = true,
                                hal_size_t minLength = 0, const Genome *coalescenceLimit = NULL, const Genome *mrca = NULL);
+
+    /* call main function with smart pointer */
+    hal_size_t halMapSegmentSP(const SegmentIteratorPtr &source, MappedSegmentVector &outSegments, const Genome *tgtGenome,
+                               const std::set<const Genome *> *genomesOnPath = NULL, bool doDupes = true,
+                               hal_size_t minLength = 0, const Genome *coalescenceLimit = NULL, const Genome *mrca = NULL);
 }
 #endif
@@ -159,6 +159,15 @@ namespace hal {
          * @param length Length of substring */
         virtual void getSubString(std::string &outString, hal_size_t start, hal_size_t length) const = 0;
 
+        /** Get the substring of character string underlying the
+         * sequence into a buffer, decoding DNA in bulk.
+         * @param outBuffer Buffer of at least length characters into which
+         * we copy the result (not zero-terminated)
+         * @param start First position of substring
+         * @param length Length of substring
+         * @param reversed Get the reverse complement of the substring */
+        virtual void getSubString(char *outBuffer, hal_size_t start, hal_size_t length, bool reversed = false) const = 0;
+
         /** Set the character string underlying the sequence
           * @param inString input string to copy
           * @param start First position of substring
@@ -51,6 +51,11 @@ namespace hal {
          * @param childGenome genome of child in bottom segment */
         void toChildG(const BottomSegmentIteratorPtr &botSegIt, const Genome *childGenome);
 
+        /** Does the current segment have a parent?  Same as
+         * tseg()->hasParent(), but uses the genome's projection cache
+         * if enabled. */
+        bool hasParent() const;
+
         /** Given a bottom segment, move to the top segment that contains
          * its start position.  The genome remains unchanged.  The iterator
          * will be sliced accordingly (reversed state also taken into account)
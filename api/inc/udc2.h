@@ -201,6 +201,12 @@ void *udc2MMapFetch(struct udc2File *file, bits64 offset, bits64 size);
  * maybe returned.  Maybe called multiple times on a range or overlapping
  * returns. */
 
+void udc2Prefetch(struct udc2File *file, bits64 offset, bits64 size);
+/* Fetch a region of the file into the cache without reading it, clipped to
+ * the end of the file.  Blocks already cached are not fetched.  Handles are
+ * not thread-safe, but several handles open on the same URL share the
+ * cache, so threads using their own handle may fetch in parallel. */
+
     
 /* below are added to avoid comflicts with including common.h */
 void udc2VerboseSetLevel(int l);
@@ -1,5 +1,6 @@
 #include "mmapAlignment.h"
 #include "halCLParser.h"
+#include "halCommon.h"
 #include "mmapGenome.h"
 
 using namespace hal;
@@ -7,10 +8,13 @@ using namespace std;
 
 static const int NAME_HASH_GROWTH_FACTOR = 1024; // allow lots of initial space
 
-MMapAlignment::MMapAlignment(const std::string &alignmentPath, unsigned mode, size_t fileSize)
-    : _alignmentPath(alignmentPath), _mode(mode), _fileSize(fileSize), _file(NULL), _data(NULL), _genomeNameHash(NULL),
-      _tree(NULL) {
-    _file = MMapFile::factory(alignmentPath, mode, fileSize);
+MMapAlignment::MMapAlignment(const std::string &alignmentPath, unsigned mode, size_t fileSize,
+                             MMapSegmentLayout segmentLayout, MMapDnaLayout dnaLayout,
+                             const MMapAccessOptions &accessOptions)
+    : _alignmentPath(alignmentPath), _mode(halDefaultAccessMode(mode)), _fileSize(fileSize), _file(NULL), _data(NULL),
+      _genomeNameHash(NULL), _tree(NULL), _allGenomesOpen(false), _createSegmentLayout(segmentLayout),
+      _createDnaLayout(dnaLayout), _accessOptions(accessOptions), _writeStats(false) {
+    _file = MMapFile::factory(alignmentPath, mode, fileSize, _accessOptions);
     if (mode & CREATE_ACCESS) {
         create();
     } else {
@@ -20,9 +24,10 @@ MMapAlignment::MMapAlignment(const std::string &alignmentPath, unsigned mode, si
 
 MMapAlignment::MMapAlignment(const std::string &alignmentPath, unsigned mode, const CLParser *parser)
     : _alignmentPath(alignmentPath), _mode(halDefaultAccessMode(mode)), _fileSize(0), _file(NULL), _data(NULL),
-      _genomeNameHash(NULL), _tree(NULL) {
+      _genomeNameHash(NULL), _tree(NULL), _allGenomesOpen(false), _createSegmentLayout(MMAP_SEGMENT_LAYOUT_ROWS),
+      _createDnaLayout(MMAP_DNA_LAYOUT_NIBBLES), _writeStats(false) {
     initializeFromOptions(parser);
-    _file = MMapFile::factory(alignmentPath, _mode, _fileSize);
+    _file = MMapFile::factory(alignmentPath, _mode, _fileSize, _accessOptions);
     if (mode & CREATE_ACCESS) {
         create();
     } else {
@@ -31,28 +36,58 @@ MMapAlignment::MMapAlignment(const std::string &alignmentPath, unsigned mode, co
 }
 
 void MMapAlignment::close() {
-    // Free the memory used by all open genomes.
+    // Write packed segments and DNA, and free the memory used by all open genomes.
     for (auto kv : _openGenomes) {
+        if (not isReadOnly()) {
+            kv.second->packSegmentColumns();
+            kv.second->packDna();
+        }
         delete kv.second;
     }
     // Close the actual file.
     delete _genomeNameHash;
     _genomeNameHash = NULL;
+    if (_writeStats) {
+        _file->printWriteStats(cerr);
+    }
     _file->close();
 }
 
 void MMapAlignment::defineOptions(CLParser *parser, unsigned mode) {
     if (mode & CREATE_ACCESS) {
-        parser->addOption("mmapFileSize", "mmap HAL file initial size (in gigabytes)", MMAP_DEFAULT_FILE_SIZE_GB);
+        parser->addOption("mmapFileSize", "mmap HAL file initial size (in gigabytes), the file is grown as needed",
+                          MMAP_DEFAULT_FILE_SIZE_GB);
+        parser->addOption("mmapSegmentLayout", "mmap segment array layout: rows, columns or packed",
+                          mmapSegmentLayoutToString(MMAP_SEGMENT_LAYOUT_ROWS));
+        parser->addOption("mmapDnaLayout", "mmap DNA storage: nibbles or twoBit",
+                          mmapDnaLayoutToString(MMAP_DNA_LAYOUT_NIBBLES));
     } else if (mode & WRITE_ACCESS) {
-        parser->addOption("mmapSizeIncrease", "additional space to reserve at end of file (in gigabytes)", 1);
+        parser->addOption("mmapSizeIncrease",
+                          "additional space to initially reserve at end of file (in gigabytes), the file is grown as needed",
+                          1);
+    }
+    if (mode & (CREATE_ACCESS | WRITE_ACCESS)) {
+        parser->addOptionFlag("mmapWriteStats", "report mmap data size and write throughput to stderr on close", false);
     }
+    parser->addOption("mmapAccess", "expected mmap access pattern: normal, sequential or random",
+                      mmapAccessPatternToString(MMAP_ACCESS_NORMAL));
+    parser->addOption("mmapPrefetch", "comma-separated list of genomes whose segments and DNA are read into memory on open",
+                      "");
+    parser->addOptionFlag("mmapLockPrefetch", "lock genomes given by --mmapPrefetch in memory", false);
+    parser->addOptionFlag("mmapPopulate", "read the whole mmap file into memory on open", false);
+    parser->addOptionFlag("mmapHugePages", "request transparent huge pages for the mmap file", false);
+#ifdef ENABLE_UDC
+    parser->addOption("udcFetchThreads", "number of threads fetching prefetched parts of a mmap file URL in parallel",
+                      MMapAccessOptions()._udcFetchThreads);
+#endif
 }
 
 /* initialize class from options */
 void MMapAlignment::initializeFromOptions(const CLParser *parser) {
     if (_mode & CREATE_ACCESS) {
         _fileSize = GIGABYTE * parser->get<size_t>("mmapFileSize");
+        _createSegmentLayout = mmapSegmentLayoutFromString(parser->getOption<const std::string &>("mmapSegmentLayout"));
+        _createDnaLayout = mmapDnaLayoutFromString(parser->getOption<const std::string &>("mmapDnaLayout"));
     } else if (_mode & WRITE_ACCESS) {
         // TODO: this causes _fileSize's meaning to be far too
         // overloaded: sometimes (CREATE_ACCESS) it is a requested
@@ -62,6 +97,20 @@ void MMapAlignment::initializeFromOptions(const CLParser *parser) {
         // 3 separate factory functions.
         _fileSize = GIGABYTE * parser->get<size_t>("mmapSizeIncrease");
     }
+    if (_mode & (CREATE_ACCESS | WRITE_ACCESS)) {
+        _writeStats = parser->getFlag("mmapWriteStats");
+    }
+    _accessOptions._accessPattern = mmapAccessPatternFromString(parser->getOption<const std::string &>("mmapAccess"));
+    const std::string &prefetchGenomes = parser->getOption<const std::string &>("mmapPrefetch");
+    if (not prefetchGenomes.empty()) {
+        _accessOptions._prefetchGenomes = chopString(prefetchGenomes, ",");
+    }
+    _accessOptions._lockPrefetch = parser->getFlag("mmapLockPrefetch");
+    _accessOptions._populate = parser->getFlag("mmapPopulate");
+    _accessOptions._hugePages = parser->getFlag("mmapHugePages");
+#ifdef ENABLE_UDC
+    _accessOptions._udcFetchThreads = parser->getOption<unsigned>("udcFetchThreads");
+#endif
 }
 
 void MMapAlignment::create() {
@@ -69,6 +118,9 @@ void MMapAlignment::create() {
     _data = static_cast<MMapAlignmentData *>(resolveOffset(_file->getRootOffset(), sizeof(MMapAlignmentData)));
     _data->_numGenomes = 0;
     _data->_genomeNameHashOffset = MMAP_NULL_OFFSET;
+    _data->_segmentLayout = _createSegmentLayout;
+    _data->_dnaLayout = _createDnaLayout;
+    _data->_siteMapSearchArrays = true;
 }
 
 void MMapAlignment::open() {
@@ -76,7 +128,98 @@ void MMapAlignment::open() {
     if (_data->_genomeNameHashOffset != MMAP_NULL_OFFSET) {
         _genomeNameHash = new MMapPerfectHashTable(_file, _data->_genomeNameHashOffset, NAME_HASH_GROWTH_FACTOR);
     }
+    if (getSegmentLayout() > MMAP_SEGMENT_LAYOUT_PACKED) {
+        throw hal_exception(_alignmentPath + ": unknown mmap segment layout " + std::to_string(getSegmentLayout()) +
+                            ", file requires a newer mmap API version");
+    }
+    if (getDnaLayout() > MMAP_DNA_LAYOUT_TWO_BIT) {
+        throw hal_exception(_alignmentPath + ": unknown mmap DNA layout " + std::to_string(getDnaLayout()) +
+                            ", file requires a newer mmap API version");
+    }
     loadTree();
+    if (_mode & CONCURRENT_READ_ACCESS) {
+        loadForConcurrentAccess();
+    }
+    prefetchGenomes();
+}
+
+/* read the genomes requested in the access options into memory */
+void MMapAlignment::prefetchGenomes() {
+    for (const string &name : _accessOptions._prefetchGenomes) {
+        MMapGenome *genome = static_cast<MMapGenome *>(_openGenome(name));
+        if (genome == NULL) {
+            throw hal_exception(_alignmentPath + ": genome " + name + " to prefetch not found in alignment");
+        }
+        genome->prefetch(_accessOptions._lockPrefetch);
+    }
+}
+
+/* Open all genomes and fill every lazily-populated cache (child names,
+ * genome objects, parent/child links and sequence objects), so that
+ * no object is modified by later read-only access from multiple threads. */
+void MMapAlignment::loadForConcurrentAccess() {
+    if (_file->isUdcProtocol()) {
+        throw hal_exception(_alignmentPath + ": concurrent read access is not supported with UDC");
+    }
+    vector<string> genomeNames = _data->getGenomeNames(this);
+    for (const string &name : genomeNames) {
+        getChildNamesRef(name);
+    }
+    for (const string &name : genomeNames) {
+        _openGenome(name);
+    }
+    for (auto &name_genome : _openGenomes) {
+        name_genome.second->loadForConcurrentAccess();
+    }
+    _allGenomesOpen = true;
+}
+
+static const std::string MMAP_SEGMENT_LAYOUT_NAMES[] = {"rows", "columns", "packed"};
+
+const std::string &hal::mmapSegmentLayoutToString(MMapSegmentLayout segmentLayout) {
+    assert(segmentLayout <= MMAP_SEGMENT_LAYOUT_PACKED);
+    return MMAP_SEGMENT_LAYOUT_NAMES[segmentLayout];
+}
+
+MMapSegmentLayout hal::mmapSegmentLayoutFromString(const std::string &name) {
+    for (int layout = MMAP_SEGMENT_LAYOUT_ROWS; layout <= MMAP_SEGMENT_LAYOUT_PACKED; layout++) {
+        if (name == MMAP_SEGMENT_LAYOUT_NAMES[layout]) {
+            return MMapSegmentLayout(layout);
+        }
+    }
+    throw hal_exception("invalid mmap segment layout '" + name + "', expected one of rows, columns or packed");
+}
+
+static const std::string MMAP_DNA_LAYOUT_NAMES[] = {"nibbles", "twoBit"};
+
+const std::string &hal::mmapDnaLayoutToString(MMapDnaLayout dnaLayout) {
+    assert(dnaLayout <= MMAP_DNA_LAYOUT_TWO_BIT);
+    return MMAP_DNA_LAYOUT_NAMES[dnaLayout];
+}
+
+MMapDnaLayout hal::mmapDnaLayoutFromString(const std::string &name) {
+    for (int layout = MMAP_DNA_LAYOUT_NIBBLES; layout <= MMAP_DNA_LAYOUT_TWO_BIT; layout++) {
+        if (name == MMAP_DNA_LAYOUT_NAMES[layout]) {
+            return MMapDnaLayout(layout);
+        }
+    }
+    throw hal_exception("invalid mmap DNA layout '" + name + "', expected one of nibbles or twoBit");
+}
+
+static const std::string MMAP_ACCESS_PATTERN_NAMES[] = {"normal", "sequential", "random"};
+
+const std::string &hal::mmapAccessPatternToString(MMapAccessPattern accessPattern) {
+    assert(accessPattern <= MMAP_ACCESS_RANDOM);
+    return MMAP_ACCESS_PATTERN_NAMES[accessPattern];
+}
+
+MMapAccessPattern hal::mmapAccessPatternFromString(const std::string &name) {
+    for (int pattern = MMAP_ACCESS_NORMAL; pattern <= MMAP_ACCESS_RANDOM; pattern++) {
+        if (name == MMAP_ACCESS_PATTERN_NAMES[pattern]) {
+            return MMapAccessPattern(pattern);
+        }
+    }
+    throw hal_exception("invalid mmap access pattern '" + name + "', expected one of normal, sequential or random");
 }
 
 MMapGenome *MMapAlignmentData::addGenome(MMapAlignment *alignment, const std::string &name) {
@@ -161,11 +304,13 @@ Genome *MMapAlignment::addRootGenome(const string &name, double branchLength) {
 }
 
 Genome *MMapAlignment::_openGenome(const string &name) const {
-    if (_openGenomes.find(name) != _openGenomes.end()) {
+    auto it = _openGenomes.find(name);
+    if (it != _openGenomes.end()) {
         // Already loaded.
-        return _openGenomes[name];
+        return it->second;
     }
-    if (_genomeNameHash == NULL) {
+    if ((_genomeNameHash == NULL) or _allGenomesOpen) {
+        // with concurrent access, all genomes are loaded on open
         return NULL;
     }
     hal_index_t genomeIndex = _genomeNameHash->getIndex(name);
@@ -180,5 +325,8 @@ Genome *MMapAlignment::_openGenome(const string &name) const {
     }
     MMapGenome *genome = new MMapGenome(const_cast<MMapAlignment *>(this), &genomeDataArray[genomeIndex], genomeIndex);
     _openGenomes[name] = genome;
+    if (_accessOptions._accessPattern != MMAP_ACCESS_NORMAL) {
+        genome->adviseAccess(_accessOptions._accessPattern);
+    }
     return genome;
 }
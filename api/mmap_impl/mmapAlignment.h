@@ -11,6 +11,7 @@ namespace hal {
     class CLParser;
     class MMapAlignment;
     class MMapGenome;
+
     class MMapAlignmentData {
         friend class MMapAlignment;
 
@@ -27,15 +28,35 @@ namespace hal {
         size_t _newickStringLength;
         size_t _genomeArrayOffset;
         size_t _genomeNameHashOffset;
-        char _reserved[265];   // 256 bytes of reserved added in mmap API 1.1
+        size_t _segmentLayout; // MMapSegmentLayout, added in mmap API 1.2
+        size_t _dnaLayout;     // MMapDnaLayout, added in mmap API 1.4
+        size_t _siteMapSearchArrays; // genome site maps have search arrays, added in mmap API 1.5
+        char _reserved[265 - 3 * sizeof(size_t)]; // 256 bytes of reserved added in mmap API 1.1
     };
 
+    /**
+     * Mmap implementation of Alignment.
+     *
+     * Concurrent read access: when opened with CONCURRENT_READ_ACCESS, all
+     * genomes, sequence objects and tree-derived caches are loaded when the
+     * file is opened and are never modified afterwards.  A single object may
+     * then be shared by any number of threads without locking, with
+     * openGenome(), sequence lookup by name or site, segment iterators and DNA
+     * iterators all being safe to call concurrently.  Iterators themselves are
+     * not shared; each thread must obtain its own.  closeGenome() is a no-op
+     * and close() must only be called once all threads are done.  This mode is
+     * only supported for local files, not UDC URLs.
+     */
     class MMapAlignment : public Alignment {
         friend class MMapAlignmentData;
 
       public:
-        /* constructor with all arguments specified */
-        MMapAlignment(const std::string &alignmentPath, unsigned mode = READ_ACCESS, size_t fileSize = MMAP_DEFAULT_FILE_SIZE);
+        /* constructor with all arguments specified, segmentLayout and
+         * dnaLayout are used when creating a file */
+        MMapAlignment(const std::string &alignmentPath, unsigned mode = READ_ACCESS, size_t fileSize = MMAP_DEFAULT_FILE_SIZE,
+                      MMapSegmentLayout segmentLayout = MMAP_SEGMENT_LAYOUT_ROWS,
+                      MMapDnaLayout dnaLayout = MMAP_DNA_LAYOUT_NIBBLES,
+                      const MMapAccessOptions &accessOptions = MMapAccessOptions());
 
         /* constructor from command line options */
         MMapAlignment(const std::string &alignmentPath, unsigned mode, const CLParser *parser);
@@ -125,31 +146,26 @@ namespace hal {
         };
 
         std::vector<std::string> getChildNames(const std::string &name) const {
-            if (_childNames.find(name) != _childNames.end()) {
-                return _childNames[name];
-            } else {
-                _fillChildNames(name);
-                return _childNames[name];
-            }
+            return getChildNamesRef(name);
         }
 
         std::vector<std::string> &getChildNamesRef(const std::string &name) const {
-            if (_childNames.find(name) != _childNames.end()) {
-                return _childNames[name];
-            } else {
-                _fillChildNames(name);
-                return _childNames[name];
+            // only use find() on cache hits, so concurrent readers never modify the map
+            auto it = _childNames.find(name);
+            if (it == _childNames.end()) {
+                it = _fillChildNames(name);
             }
+            return it->second;
         }
 
-        void _fillChildNames(const std::string &name) const {
+        std::map<std::string, std::vector<std::string>>::iterator _fillChildNames(const std::string &name) const {
             stTree *node = getGenomeNode(name);
             std::vector<std::string> childNames;
             for (int64_t i = 0; i < stTree_getChildNumber(node); i++) {
                 const char *name = stTree_getLabel(stTree_getChild(node, i));
                 childNames.push_back(std::string(name));
             }
-            _childNames[name] = childNames;
+            return _childNames.insert(std::make_pair(name, childNames)).first;
         };
 
         std::vector<std::string> getLeafNamesBelow(const std::string &name) const {
@@ -195,6 +211,39 @@ namespace hal {
             return _file->isReadOnly();
         };
 
+        /* layout of the segment arrays in the file, recorded in the file
+         * starting with mmap API 1.2, older files are always rows. */
+        MMapSegmentLayout getSegmentLayout() const {
+            if (_file->getMinorVersion() < 2) {
+                return MMAP_SEGMENT_LAYOUT_ROWS;
+            }
+            return MMapSegmentLayout(_data->_segmentLayout);
+        }
+
+        /* storage of DNA in the file, recorded in the file starting with
+         * mmap API 1.4, older files are always nibbles. */
+        MMapDnaLayout getDnaLayout() const {
+            if (_file->getMinorVersion() < 4) {
+                return MMAP_DNA_LAYOUT_NIBBLES;
+            }
+            return MMapDnaLayout(_data->_dnaLayout);
+        }
+
+        /* do the genome site maps include the Eytzinger search arrays?
+         * They are written starting with mmap API 1.5, however genomes
+         * added to an older file don't use them. */
+        bool hasSiteMapSearchArrays() const {
+            if (_file->getMinorVersion() < 5) {
+                return false;
+            }
+            return _data->_siteMapSearchArrays;
+        }
+
+        /* was the alignment opened for sharing between threads? */
+        bool isConcurrentReadAccess() const {
+            return _mode & CONCURRENT_READ_ACCESS;
+        }
+
         void replaceNewickTree(const std::string &newNewickString) {
             _data->setNewickString(this, newNewickString.c_str());
             loadTree();
@@ -204,6 +253,8 @@ namespace hal {
         void initializeFromOptions(const CLParser *parser);
         void create();
         void open();
+        void loadForConcurrentAccess();
+        void prefetchGenomes();
         void addGenomeToNameHash(const MMapGenome *genome, vector<string> &existingNames);
         Genome *_openGenome(const std::string &name) const;
         stTree *getGenomeNode(const std::string &name) const {
@@ -237,6 +288,11 @@ namespace hal {
         MMapPerfectHashTable *_genomeNameHash;
         stTree *_tree;
         mutable std::map<std::string, std::vector<std::string>> _childNames;
+        bool _allGenomesOpen; // all genomes loaded, _openGenomes is never modified
+        MMapSegmentLayout _createSegmentLayout; // layout for new files
+        MMapDnaLayout _createDnaLayout;         // DNA layout for new files
+        MMapAccessOptions _accessOptions;       // read hints
+        bool _writeStats;                       // report write statistics on close
     };
 
     inline const char *MMapAlignmentData::getNewickString(const MMapAlignment *alignment) {
@@ -0,0 +1,146 @@
+#include "mmapBlockPrefetcher.h"
+#include <algorithm>
+#include <cassert>
+#include <exception>
+#include <iterator>
+
+using namespace hal;
+
+/* start the worker threads */
+MMapBlockPrefetcher::MMapBlockPrefetcher(size_t fileSize, size_t blockSize, unsigned numWorkers, size_t maxRequestSize,
+                                         const FetchFunc &fetchFunc)
+    : _fileSize(fileSize), _blockSize(blockSize), _maxRequestSize(std::max(maxRequestSize, blockSize)),
+      _fetchFunc(fetchFunc), _numOutstanding(0), _numRequests(0), _stopping(false) {
+    assert(numWorkers > 0);
+    for (unsigned worker = 0; worker < numWorkers; worker++) {
+        _workers.push_back(std::thread(&MMapBlockPrefetcher::runWorker, this, worker));
+    }
+}
+
+/* stop the workers, dropping queued ranges and waiting for requests in
+ * progress */
+MMapBlockPrefetcher::~MMapBlockPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _queued.notify_all();
+    for (std::thread &worker : _workers) {
+        worker.join();
+    }
+}
+
+void MMapBlockPrefetcher::prefetch(size_t offset, size_t length) {
+    if ((length == 0) or (offset >= _fileSize)) {
+        return;
+    }
+    size_t start = (offset / _blockSize) * _blockSize;
+    size_t end = std::min(((offset + length + _blockSize - 1) / _blockSize) * _blockSize, _fileSize);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (const RequestMap::value_type &request : _inProgress) {
+            if ((request.first <= start) and (end <= request.second)) {
+                return; // already being fetched
+            }
+        }
+        // merge with queued ranges that overlap or touch this one
+        RangeMap::iterator it = _queue.upper_bound(start);
+        if ((it != _queue.begin()) and (std::prev(it)->second >= start)) {
+            --it;
+            start = it->first;
+        }
+        while ((it != _queue.end()) and (it->first <= end)) {
+            end = std::max(end, it->second);
+            it = _queue.erase(it);
+        }
+        _queue[start] = end;
+        _numOutstanding.store(_queue.size() + _inProgress.size(), std::memory_order_release);
+    }
+    _queued.notify_one();
+}
+
+/* is any part of a range being fetched?  Requests in progress are
+ * bounded by the number of workers, so a scan is fine */
+bool MMapBlockPrefetcher::overlapsInProgress(size_t start, size_t end) const {
+    for (const RequestMap::value_type &request : _inProgress) {
+        if ((request.first < end) and (start < request.second)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Wait for overlapping requests in progress.  The caller is about to fetch
+ * the range itself, so it is removed from the queue. */
+void MMapBlockPrefetcher::waitForOverlapping(size_t offset, size_t length) {
+    size_t start = (offset / _blockSize) * _blockSize;
+    size_t end = ((offset + length + _blockSize - 1) / _blockSize) * _blockSize;
+    std::unique_lock<std::mutex> lock(_mutex);
+    RangeMap::iterator it = _queue.upper_bound(start);
+    if (it != _queue.begin()) {
+        --it;
+    }
+    while ((it != _queue.end()) and (it->first < end)) {
+        size_t rangeStart = it->first, rangeEnd = it->second;
+        if (rangeEnd <= start) {
+            ++it;
+            continue;
+        }
+        it = _queue.erase(it);
+        if (rangeStart < start) {
+            _queue[rangeStart] = start;
+        }
+        if (end < rangeEnd) {
+            it = _queue.insert(it, RangeMap::value_type(end, rangeEnd));
+            break;
+        }
+    }
+    _numOutstanding.store(_queue.size() + _inProgress.size(), std::memory_order_release);
+    _completed.wait(lock, [this, start, end]() { return not overlapsInProgress(start, end); });
+}
+
+void MMapBlockPrefetcher::waitAll() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _completed.wait(lock, [this]() { return _queue.empty() and _inProgress.empty(); });
+}
+
+/* Take up to maxRequestSize bytes from the start of the first queued
+ * range, so a large range is split over several workers.  Must be called
+ * with the mutex held. */
+bool MMapBlockPrefetcher::takeRequest(RequestMap::iterator &request) {
+    if (_queue.empty()) {
+        return false;
+    }
+    RangeMap::iterator it = _queue.begin();
+    size_t start = it->first;
+    size_t end = std::min(it->second, start + _maxRequestSize);
+    if (end < it->second) {
+        _queue[end] = it->second;
+    }
+    _queue.erase(it);
+    request = _inProgress.insert(RequestMap::value_type(start, end));
+    return true;
+}
+
+void MMapBlockPrefetcher::runWorker(unsigned worker) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _queued.wait(lock, [this]() { return _stopping or not _queue.empty(); });
+        RequestMap::iterator request;
+        if (_stopping or not takeRequest(request)) {
+            break;
+        }
+        size_t start = request->first, end = request->second;
+        lock.unlock();
+        _numRequests++;
+        try {
+            _fetchFunc(worker, start, end - start);
+        } catch (const std::exception &) {
+            // only a hint, any error is reported when the range is read
+        }
+        lock.lock();
+        _inProgress.erase(request);
+        _numOutstanding.store(_queue.size() + _inProgress.size(), std::memory_order_release);
+        _completed.notify_all();
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef _MMAPBLOCKPREFETCHER_H
+#define _MMAPBLOCKPREFETCHER_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hal {
+    /**
+     * Asynchronous fetching of ranges of a file whose blocks are fetched on
+     * first access, such as a remote mmap file read through UDC.  Announced
+     * ranges are rounded out to whole blocks and queued; adjacent and
+     * overlapping ranges are coalesced, so a scan that announces many small
+     * ranges results in a few large requests.  A pool of worker threads
+     * takes requests of at most maxRequestSize bytes from the queue and
+     * passes them to the fetch function, so requests are made in parallel.
+     * The fetch function is called with the worker number, allowing it to
+     * use a per-worker connection.
+     *
+     * Queued requests are only hints.  Before reading a range, waitFor()
+     * must be called to wait for any request in progress that overlaps it;
+     * the caller then fetches the range synchronously, which only needs to
+     * fetch blocks that no worker has fetched yet.
+     */
+    class MMapBlockPrefetcher {
+      public:
+        typedef std::function<void(unsigned worker, size_t offset, size_t length)> FetchFunc;
+
+        MMapBlockPrefetcher(size_t fileSize, size_t blockSize, unsigned numWorkers, size_t maxRequestSize,
+                            const FetchFunc &fetchFunc);
+        ~MMapBlockPrefetcher();
+
+        /* queue a range to be fetched */
+        void prefetch(size_t offset, size_t length);
+
+        /* wait for requests in progress overlapping a range */
+        void waitFor(size_t offset, size_t length) {
+            if (_numOutstanding.load(std::memory_order_acquire) > 0) {
+                waitForOverlapping(offset, length);
+            }
+        }
+
+        /* wait until the queue is empty and no requests are in progress */
+        void waitAll();
+
+        /* number of requests made so far */
+        size_t getNumRequests() const {
+            return _numRequests.load();
+        }
+
+      private:
+        typedef std::map<size_t, size_t> RangeMap;        // start -> end
+        typedef std::multimap<size_t, size_t> RequestMap; // start -> end, may overlap
+
+        void waitForOverlapping(size_t offset, size_t length);
+        bool overlapsInProgress(size_t start, size_t end) const;
+        bool takeRequest(RequestMap::iterator &request);
+        void runWorker(unsigned worker);
+
+        const size_t _fileSize;
+        const size_t _blockSize;
+        const size_t _maxRequestSize;
+        FetchFunc _fetchFunc;
+        std::mutex _mutex;
+        std::condition_variable _queued;    // signaled when a range is queued or stopping
+        std::condition_variable _completed; // signaled when a request completes
+        RangeMap _queue;                    // coalesced ranges waiting for a worker
+        RequestMap _inProgress;             // requests being fetched
+        std::atomic<size_t> _numOutstanding; // queued plus in progress, to avoid locking when idle
+        std::atomic<size_t> _numRequests;
+        bool _stopping;
+        std::vector<std::thread> _workers;
+    };
+}
+
+#endif
+// Local Variables:
+// mode: c++
+// End:
@@ -9,19 +9,19 @@
 namespace hal {
     class MMapBottomSegment : public BottomSegment {
       public:
-        MMapBottomSegment(MMapGenome *genome, hal_index_t arrayIndex)
-            : BottomSegment(genome, arrayIndex), _data(genome->getBottomSegmentPointer(arrayIndex)) {
+        MMapBottomSegment(MMapGenome *genome, hal_index_t arrayIndex) : BottomSegment(genome, arrayIndex) {
+            resolveData();
         }
 
         // SEGMENT INTERFACE
         void setArrayIndex(Genome *genome, hal_index_t arrayIndex) {
             _genome = genome;
-            _data = getMMapGenome()->getBottomSegmentPointer(arrayIndex);
             _index = arrayIndex;
+            resolveData();
         };
         const Sequence *getSequence() const;
         hal_index_t getStartPosition() const {
-            return _data->getStartPosition();
+            return (_columns == NULL) ? _data->getStartPosition() : _columns->getStartPosition(_index);
         };
         hal_index_t getEndPosition() const;
         hal_size_t getLength() const;
@@ -34,25 +34,38 @@ namespace hal {
         // BOTTOM SEGMENT INTERFACE
         hal_size_t getNumChildren() const;
         hal_index_t getChildIndex(hal_size_t i) const {
-            return _data->getChildIndex(i);
+            return (_columns == NULL) ? _data->getChildIndex(i) : _columns->getChildIndex(_index, i);
         };
         hal_index_t getChildIndexG(const Genome *childGenome) const;
         bool hasChild(hal_size_t child) const;
         bool hasChildG(const Genome *childGenome) const;
         void setChildIndex(hal_size_t i, hal_index_t childIndex) {
-            _data->setChildIndex(i, childIndex);
+            if (_columns == NULL) {
+                _data->setChildIndex(i, childIndex);
+            } else {
+                _columns->setChildIndex(_index, i, childIndex);
+            }
         };
         bool getChildReversed(hal_size_t i) const {
-            return _data->getChildReversed(_genome->getNumChildren(), i);
+            return (_columns == NULL) ? _data->getChildReversed(_genome->getNumChildren(), i)
+                                      : _columns->getChildReversed(_index, i);
         };
         void setChildReversed(hal_size_t child, bool isReversed) {
-            _data->setChildReversed(_genome->getNumChildren(), child, isReversed);
+            if (_columns == NULL) {
+                _data->setChildReversed(_genome->getNumChildren(), child, isReversed);
+            } else {
+                _columns->setChildReversed(_index, child, isReversed);
+            }
         };
         hal_index_t getTopParseIndex() const {
-            return _data->getTopParseIndex();
+            return (_columns == NULL) ? _data->getTopParseIndex() : _columns->getTopParseIndex(_index);
         };
         void setTopParseIndex(hal_index_t parseIndex) {
-            _data->setTopParseIndex(parseIndex);
+            if (_columns == NULL) {
+                _data->setTopParseIndex(parseIndex);
+            } else {
+                _columns->setTopParseIndex(_index, parseIndex);
+            }
         };
         hal_offset_t getTopParseOffset() const;
         bool hasParseUp() const;
@@ -64,11 +77,20 @@ namespace hal {
             return static_cast<MMapGenome *>(_genome);
         }
 
+        void resolveData() {
+            _columns = getMMapGenome()->getBottomSegmentColumns(_index);
+            _data = (_columns == NULL) ? getMMapGenome()->getBottomSegmentPointer(_index) : NULL;
+        }
+
         // Return a pointer to the data for the segment *after* this one in the array.
         MMapBottomSegmentData *getNextData() const {
             return (MMapBottomSegmentData *)(((char *)_data) + MMapBottomSegmentData::getSize(_genome));
         };
-        MMapBottomSegmentData *_data;
+        hal_index_t getNextStartPosition() const {
+            return (_columns == NULL) ? getNextData()->getStartPosition() : _columns->getStartPosition(_index + 1);
+        }
+        MMapBottomSegmentData *_data;       // row layout
+        MMapBottomSegmentColumns *_columns; // columnar layout, NULL for rows
     };
 
     inline hal_index_t MMapBottomSegment::getEndPosition() const {
@@ -76,7 +98,7 @@ namespace hal {
     }
 
     inline hal_size_t MMapBottomSegment::getLength() const {
-        return getNextData()->getStartPosition() - _data->getStartPosition();
+        return getNextStartPosition() - getStartPosition();
     }
 
     inline const Sequence *MMapBottomSegment::getSequence() const {
@@ -7,15 +7,37 @@
 #include "mmapDnaDriver.h"
 #include "mmapAlignment.h"
 #include "mmapGenome.h"
+#include <algorithm>
+#include <cstring>
 
+using namespace std;
 using namespace hal;
 
 static const int UDC_FETCH_SIZE = 64 * 1024; // size to bring in for UDC access
+static const int TWO_BIT_FETCH_SIZE = 4 * 1024; // number of bases to decode for two-bit access
 
 MMapDnaAccess::MMapDnaAccess(MMapGenome *genome, hal_index_t index)
     : DnaAccess(0, 0, NULL), _genome(genome),
-      _isUdcProtocol(dynamic_cast<MMapAlignment *>(_genome->getAlignment())->getMMapFile()->isUdcProtocol()) {
-    if (_isUdcProtocol) {
+      _isUdcProtocol(dynamic_cast<MMapAlignment *>(_genome->getAlignment())->getMMapFile()->isUdcProtocol()),
+      _twoBitData(NULL), _nRuns(NULL), _lowerRuns(NULL) {
+    if (_genome->getDnaStaging() != NULL) {
+        // two-bit DNA being written is in memory, nibble-encoded
+        _endIndex = _genome->getSequenceLength();
+        _buffer = _genome->getDnaStaging();
+    } else if (_genome->getDnaLayout() == MMAP_DNA_LAYOUT_TWO_BIT) {
+        _twoBitData = _genome->getTwoBitDnaData();
+        if (_twoBitData == NULL) {
+            return; // no DNA
+        }
+        MMapAlignment *alignment = dynamic_cast<MMapAlignment *>(_genome->getAlignment());
+        _nRuns = static_cast<const MMapDnaRun *>(
+            alignment->resolveOffset(_twoBitData->_nRunsOffset, _twoBitData->_numNRuns * sizeof(MMapDnaRun)));
+        _lowerRuns = static_cast<const MMapDnaRun *>(
+            alignment->resolveOffset(_twoBitData->_lowerRunsOffset, _twoBitData->_numLowerRuns * sizeof(MMapDnaRun)));
+        if (index < (hal_index_t)_twoBitData->_length) {
+            fetch(index);
+        }
+    } else if (_isUdcProtocol) {
         fetch(index);
     } else {
         // for local mmap, just include the whole thing
@@ -25,12 +47,17 @@ MMapDnaAccess::MMapDnaAccess(MMapGenome *genome, hal_index_t index)
 }
 
 void MMapDnaAccess::flush() {
+    if (_twoBitData != NULL) {
+        checkTwoBitNotModified();
+    }
     // kernel handles page out
     _dirty = false;
 }
 
 void MMapDnaAccess::fetch(hal_index_t index) const {
-    if (_isUdcProtocol) {
+    if (_twoBitData != NULL) {
+        fetchTwoBit(index);
+    } else if (_isUdcProtocol) {
         _startIndex = 2 * (index / 2); // even boundary
         _endIndex = std::max(hal_size_t(_startIndex + UDC_FETCH_SIZE), _genome->getSequenceLength());
         _buffer = _genome->getDNA(_startIndex / 2, (((_endIndex - _startIndex) + 1) / 2));
@@ -39,3 +66,107 @@ void MMapDnaAccess::fetch(hal_index_t index) const {
     }
     _dirty = false; // keep consistent, but not actually used
 }
+
+/* the buffer of two-bit DNA is a decoded copy, so changes would be lost */
+void MMapDnaAccess::checkTwoBitNotModified() const {
+    if (_dirty) {
+        _dirty = false; // don't also throw in destructor
+        throw hal_exception("DNA of genome " + _genome->getName() +
+                            " in two-bit mmap layout can't be modified after the alignment is closed");
+    }
+}
+
+/* set the nibble-encoded bases in a run overlapping the buffer, keeping only
+ * the bits in keepMask and setting those in setBits */
+static void applyDnaRun(char *buffer, hal_index_t startIndex, hal_index_t endIndex, const MMapDnaRun &run,
+                        uint8_t keepMask, uint8_t setBits) {
+    hal_index_t end = std::min(run._end, endIndex);
+    for (hal_index_t i = std::max(run._start, startIndex); i < end; i++) {
+        hal_index_t relIndex = i - startIndex;
+        uint8_t &packed = reinterpret_cast<uint8_t &>(buffer[relIndex / 2]);
+        int shift = (relIndex & 1) ? 0 : 4;
+        uint8_t code = (((packed >> shift) & 0x0F) & keepMask) | setBits;
+        packed = (packed & ~(0x0F << shift)) | (code << shift);
+    }
+}
+
+/* apply the runs that overlap [startIndex, endIndex) */
+static void applyDnaRuns(char *buffer, hal_index_t startIndex, hal_index_t endIndex, const MMapDnaRun *runs,
+                         hal_size_t numRuns, uint8_t keepMask, uint8_t setBits) {
+    const MMapDnaRun *run = std::upper_bound(runs, runs + numRuns, startIndex,
+                                             [](hal_index_t pos, const MMapDnaRun &run) { return pos < run._end; });
+    for (; (run < runs + numRuns) and (run->_start < endIndex); run++) {
+        applyDnaRun(buffer, startIndex, endIndex, *run, keepMask, setBits);
+    }
+}
+
+/* decode a window of two-bit DNA, starting on a byte boundary */
+void MMapDnaAccess::fetchTwoBit(hal_index_t index) const {
+    checkTwoBitNotModified();
+    if ((index < 0) or (index >= (hal_index_t)_twoBitData->_length)) {
+        throw hal_exception("DNA index " + std::to_string(index) + " out of range for genome " + _genome->getName());
+    }
+    MMapAlignment *alignment = dynamic_cast<MMapAlignment *>(_genome->getAlignment());
+    _startIndex = 4 * (index / 4);
+    _endIndex = std::min(hal_index_t(_startIndex + TWO_BIT_FETCH_SIZE), hal_index_t(_twoBitData->_length));
+    hal_size_t numBytes = (_endIndex - _startIndex + 3) / 4;
+    const uint8_t *bases = static_cast<const uint8_t *>(
+        alignment->resolveOffset(_twoBitData->_basesOffset + _startIndex / 4, numBytes));
+    _twoBitBuffer.resize(2 * numBytes);
+    for (hal_size_t i = 0; i < numBytes; i++) {
+        // four two-bit codes become four upper-case nibbles
+        uint8_t b = bases[i];
+        _twoBitBuffer[2 * i] = (((b >> 6) | 0x08) << 4) | (((b >> 4) & 0x03) | 0x08);
+        _twoBitBuffer[2 * i + 1] = ((((b >> 2) & 0x03) | 0x08) << 4) | ((b & 0x03) | 0x08);
+    }
+    _buffer = _twoBitBuffer.data();
+    applyDnaRuns(_buffer, _startIndex, _endIndex, _nRuns, _twoBitData->_numNRuns, 0x08, 0x04);
+    applyDnaRuns(_buffer, _startIndex, _endIndex, _lowerRuns, _twoBitData->_numLowerRuns, 0x07, 0x00);
+}
+
+/* add base to the current run if it continues it, otherwise start a new
+ * one */
+static void addToDnaRun(vector<MMapDnaRun> &runs, hal_index_t i) {
+    if (runs.empty() or (runs.back()._end != i)) {
+        runs.push_back({i, i + 1});
+    } else {
+        runs.back()._end = i + 1;
+    }
+}
+
+/* allocate and copy an array to the file, returning the offset */
+static size_t writeDnaArray(MMapAlignment *alignment, const void *data, size_t size) {
+    size_t offset = alignment->allocateNewArray(size);
+    if (size > 0) {
+        memcpy(alignment->resolveOffset(offset, size), data, size);
+    }
+    return offset;
+}
+
+size_t hal::mmapPackTwoBitDna(MMapAlignment *alignment, const char *nibbleDna, hal_size_t length) {
+    vector<uint8_t> bases((length + 3) / 4, 0);
+    vector<MMapDnaRun> nRuns, lowerRuns;
+    for (hal_size_t i = 0; i < length; i++) {
+        uint8_t code = (i & 1) ? (nibbleDna[i / 2] & 0x0F) : (uint8_t(nibbleDna[i / 2]) >> 4);
+        if ((code & 0x07) == 0x04) {
+            addToDnaRun(nRuns, i);
+        } else {
+            bases[i / 4] |= (code & 0x03) << (6 - 2 * (i % 4));
+        }
+        if ((code & 0x08) == 0) {
+            addToDnaRun(lowerRuns, i);
+        }
+    }
+
+    // allocate the record first, as resolved pointers are only valid until the next allocation
+    size_t dnaOffset = alignment->allocateNewArray(sizeof(MMapTwoBitDnaData));
+    MMapTwoBitDnaData dnaData;
+    dnaData._length = length;
+    dnaData._basesOffset = writeDnaArray(alignment, bases.data(), bases.size());
+    dnaData._numNRuns = nRuns.size();
+    dnaData._nRunsOffset = writeDnaArray(alignment, nRuns.data(), nRuns.size() * sizeof(MMapDnaRun));
+    dnaData._numLowerRuns = lowerRuns.size();
+    dnaData._lowerRunsOffset = writeDnaArray(alignment, lowerRuns.data(), lowerRuns.size() * sizeof(MMapDnaRun));
+    *static_cast<MMapTwoBitDnaData *>(alignment->resolveOffset(dnaOffset, sizeof(MMapTwoBitDnaData))) = dnaData;
+    return dnaOffset;
+}
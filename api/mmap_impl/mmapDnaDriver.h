@@ -7,13 +7,43 @@
 #ifndef _MMAPDNADRIVER_H
 #define _MMAPDNADRIVER_H
 #include "halDnaDriver.h"
+#include <vector>
 
 namespace hal {
     class MMapGenome;
     class MMapAlignment;
 
+    /*
+     * Two-bit DNA layout (MMAP_DNA_LAYOUT_TWO_BIT, mmap API 1.4).  Bases are
+     * stored as two-bit codes in the order (a,c,g,t), four per byte with the
+     * first base in the high bits.  N and lower-case bases are recorded as
+     * sorted arrays of non-overlapping runs, with N stored as a in the bases.
+     * This represents exactly the characters of the nibble encoding.  Since
+     * the runs are only known once all bases are set, DNA is kept
+     * nibble-encoded in memory while being written and packed into the file
+     * when the alignment is closed, after which it is read-only.
+     */
+    struct MMapDnaRun {
+        hal_index_t _start;
+        hal_index_t _end; // half-open
+    };
+
+    struct MMapTwoBitDnaData {
+        hal_size_t _length;
+        size_t _basesOffset;
+        hal_size_t _numNRuns;
+        size_t _nRunsOffset; // array of MMapDnaRun
+        hal_size_t _numLowerRuns;
+        size_t _lowerRunsOffset; // array of MMapDnaRun
+    };
+
+    /* pack nibble-encoded DNA into the file, returning the offset of the
+     * MMapTwoBitDnaData */
+    size_t mmapPackTwoBitDna(MMapAlignment *alignment, const char *nibbleDna, hal_size_t length);
+
     /**
-     * Mmap implementation of DnaAccess.
+     * Mmap implementation of DnaAccess.  Two-bit DNA is decoded a window at
+     * a time into a nibble-encoded buffer.
      */
     class MMapDnaAccess : public DnaAccess {
       public:
@@ -28,8 +58,15 @@ namespace hal {
         virtual void fetch(hal_index_t index) const;
 
       private:
+        void fetchTwoBit(hal_index_t index) const;
+        void checkTwoBitNotModified() const;
+
         MMapGenome *_genome;
         bool _isUdcProtocol;
+        const MMapTwoBitDnaData *_twoBitData; // NULL unless reading two-bit DNA
+        const MMapDnaRun *_nRuns;
+        const MMapDnaRun *_lowerRuns;
+        mutable std::vector<char> _twoBitBuffer;
     };
 }
 
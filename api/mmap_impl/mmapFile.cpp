@@ -1,12 +1,15 @@
 #include "mmapFile.h"
 #include "halCommon.h"
+#include <algorithm>
 #include <errno.h>
+#include <iostream>
 #include <fcntl.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
 #ifdef ENABLE_UDC
+#include "mmapBlockPrefetcher.h"
 extern "C" {
 #include "common.h"
 #include "udc2.h"
@@ -33,7 +36,18 @@ bool hal::MMapFile::isMmapFile(const std::string &initialBytes) {
 /* constructor, used only by derived classes */
 hal::MMapFile::MMapFile(const std::string alignmentPath, unsigned mode, bool mustFetch)
     : _alignmentPath(alignmentPath), _mode(halDefaultAccessMode(mode)), _basePtr(NULL), _fileSize(0), _mustFetch(mustFetch),
-      _majorVersion(0), _minorVersion(0) {
+      _numGrows(0), _openDataSize(0), _openTime(std::chrono::steady_clock::now()), _majorVersion(0), _minorVersion(0) {
+}
+
+/* report write statistics */
+void hal::MMapFile::printWriteStats(std::ostream &out) const {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _openTime).count();
+    size_t bytesWritten = _header->nextOffset - _openDataSize;
+    out << _alignmentPath << ": wrote " << bytesWritten << " bytes in " << seconds << " seconds";
+    if (seconds > 0.0) {
+        out << " (" << (bytesWritten / seconds) / (1024.0 * 1024.0) << " MB/sec)";
+    }
+    out << ", data size " << _header->nextOffset << " bytes, file grown " << _numGrows << " times" << std::endl;
 }
 
 /* error if file is not open for write accecss */
@@ -111,23 +125,45 @@ void hal::MMapFile::createHeader() {
     strncpy(_header->mmapVersion, getMmapApiVersion().c_str(), sizeof(_header->mmapVersion) - 1);
     assert(HAL_VERSION.size() < sizeof(_header->halVersion));
     strncpy(_header->halVersion, HAL_VERSION.c_str(), sizeof(_header->halVersion) - 1);
+    _majorVersion = MMAP_API_MAJOR_VERSION;
+    _minorVersion = MMAP_API_MINOR_VERSION;
+    _version = getMmapApiVersion();
     _header->nextOffset = alignRound(sizeof(MMapHeader));
     _header->dirty = true;
     _header->nextOffset = _header->nextOffset;
 }
 
 namespace hal {
+    /* Address space reserved when mapping a file for write access.  The
+     * file is mapped beyond its end so it can be grown with ftruncate()
+     * without moving the mapping, which would invalidate pointers into
+     * it.  Only pages up to the end of the file are ever touched. */
+    static const size_t MMAP_WRITE_ADDRESS_SPACE = size_t(8) << 40;
+
+    /* Minimum and maximum amount to grow a file by when it is full. Growth
+     * is geometric between these limits, so large files are built with few
+     * calls to ftruncate(). */
+    static const size_t MMAP_MIN_GROWTH = size_t(64) << 20;
+    static const size_t MMAP_MAX_GROWTH = size_t(64) << 30;
+
     /* Class that implements local file version of MMapFile */
     class MMapFileLocal : public MMapFile {
       public:
-        MMapFileLocal(const std::string &alignmentPath, unsigned mode, size_t fileSize);
+        MMapFileLocal(const std::string &alignmentPath, unsigned mode, size_t fileSize,
+                      const MMapAccessOptions &accessOptions);
         virtual void close();
         virtual ~MMapFileLocal();
         virtual bool isUdcProtocol() const {
             return false;
         }
+        virtual void adviseAccess(size_t offset, size_t length, MMapAccessPattern accessPattern) const;
+        virtual void prefetch(size_t offset, size_t length, bool lock) const;
+
+      protected:
+        virtual void growFile(size_t minSize);
 
       private:
+        void pageAlign(size_t offset, size_t length, char *&start, size_t &alignedLength) const;
         int openFile();
         void closeFile();
         void adjustFileSize(size_t size);
@@ -136,13 +172,18 @@ namespace hal {
         void openRead();
         void openWrite(size_t fileSize);
 
-        int _fd; // open file descriptor
+        int _fd;         // open file descriptor
+        size_t _mapSize; // size of the mapping, larger than the file when writing
+        bool _populate;  // read whole file when mapping
+        bool _hugePages; // advise transparent huge pages
     };
 }
 
 /* Constructor. Open or create the specified file. */
-hal::MMapFileLocal::MMapFileLocal(const std::string &alignmentPath, unsigned mode, size_t fileSize)
-    : MMapFile(alignmentPath, mode, false), _fd(-1) {
+hal::MMapFileLocal::MMapFileLocal(const std::string &alignmentPath, unsigned mode, size_t fileSize,
+                                  const MMapAccessOptions &accessOptions)
+    : MMapFile(alignmentPath, mode, false), _fd(-1), _mapSize(0), _populate(accessOptions._populate),
+      _hugePages(accessOptions._hugePages) {
     if (_mode & WRITE_ACCESS) {
         openWrite(fileSize);
     } else {
@@ -150,7 +191,8 @@ hal::MMapFileLocal::MMapFileLocal(const std::string &alignmentPath, unsigned mod
     }
 }
 
-/* close file, marking as clean.  Don't  */
+/* close file, marking as clean.  Space allocated by growing the file
+ * and not used is trimmed.  */
 void hal::MMapFileLocal::close() {
     if (_basePtr == NULL) {
         throw hal_exception(_alignmentPath + ": MMapFile::close() called on closed file");
@@ -194,7 +236,22 @@ void hal::MMapFileLocal::adjustFileSize(size_t size) {
     _fileSize = size;
 }
 
-/* map file into memory */
+/* Grow the file geometrically to hold at least minSize bytes.  The
+ * mapping already covers the reserved address space, so only the file
+ * size changes. */
+void hal::MMapFileLocal::growFile(size_t minSize) {
+    if (minSize > _mapSize) {
+        throw hal_exception(_alignmentPath + ": mmap file is full, can't grow file beyond mapped size of " +
+                            std::to_string(_mapSize) + ", specify a larger initial file size");
+    }
+    size_t growth = std::min(std::max(_fileSize, MMAP_MIN_GROWTH), MMAP_MAX_GROWTH);
+    adjustFileSize(std::min(std::max(minSize, _fileSize + growth), _mapSize));
+    _numGrows++;
+}
+
+/* Map file into memory.  For write access, address space is reserved
+ * beyond the end of the file for growing it.  If that much can't be
+ * mapped, only the file is mapped and it can't grow.  */
 void *hal::MMapFileLocal::mapFile(void *requiredAddr) {
     assert(_basePtr == NULL);
     unsigned prot = PROT_READ | ((_mode & WRITE_ACCESS) ? PROT_WRITE : 0);
@@ -206,20 +263,72 @@ void *hal::MMapFileLocal::mapFile(void *requiredAddr) {
         // *do* want MAP_FIXED otherwise.
         flags |= MAP_FIXED;
     }
-    void *ptr = mmap(requiredAddr, _fileSize, prot, flags, _fd, 0);
+#ifdef MAP_POPULATE
+    if (_populate and not(_mode & WRITE_ACCESS)) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    _mapSize = (_mode & WRITE_ACCESS) ? std::max(_fileSize, MMAP_WRITE_ADDRESS_SPACE) : _fileSize;
+    void *ptr = mmap(requiredAddr, _mapSize, prot, flags, _fd, 0);
+    if ((ptr == MAP_FAILED) and (_mapSize > _fileSize)) {
+        _mapSize = _fileSize;
+        ptr = mmap(requiredAddr, _mapSize, prot, flags, _fd, 0);
+    }
     if (ptr == MAP_FAILED) {
         throw hal_errno_exception(_alignmentPath, "mmap failed", errno);
     }
+#ifdef MADV_HUGEPAGE
+    if (_hugePages) {
+        // only a hint; fails if the kernel doesn't support huge pages for files
+        ::madvise(ptr, _mapSize, MADV_HUGEPAGE);
+    }
+#endif
     if (requiredAddr != NULL && ptr != requiredAddr) {
         throw hal_exception("unable to remap file at same address");
     }
     return ptr;
 }
 
+/* get the page-aligned address range covering a range of the file */
+void hal::MMapFileLocal::pageAlign(size_t offset, size_t length, char *&start, size_t &alignedLength) const {
+    static const size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t end = std::min(offset + length, _fileSize);
+    size_t alignedOffset = (offset / pageSize) * pageSize;
+    start = static_cast<char *>(_basePtr) + alignedOffset;
+    alignedLength = (end > alignedOffset) ? (end - alignedOffset) : 0;
+}
+
+/* advise kernel of the access pattern of a range */
+void hal::MMapFileLocal::adviseAccess(size_t offset, size_t length, MMapAccessPattern accessPattern) const {
+    static const int advice[] = {MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM};
+    char *start;
+    size_t alignedLength;
+    pageAlign(offset, length, start, alignedLength);
+    if ((alignedLength > 0) and (::madvise(start, alignedLength, advice[accessPattern]) < 0)) {
+        throw hal_errno_exception(_alignmentPath, "madvise failed", errno);
+    }
+}
+
+/* start read-ahead of a range, and lock it in memory if requested */
+void hal::MMapFileLocal::prefetch(size_t offset, size_t length, bool lock) const {
+    char *start;
+    size_t alignedLength;
+    pageAlign(offset, length, start, alignedLength);
+    if (alignedLength == 0) {
+        return;
+    }
+    if (::madvise(start, alignedLength, MADV_WILLNEED) < 0) {
+        throw hal_errno_exception(_alignmentPath, "madvise failed", errno);
+    }
+    if (lock and (::mlock(start, alignedLength) < 0)) {
+        throw hal_errno_exception(_alignmentPath, "mlock of " + std::to_string(alignedLength) + " bytes failed", errno);
+    }
+}
+
 /* unmap file, if mapped */
 void hal::MMapFileLocal::unmapFile() {
     if (_basePtr != NULL) {
-        if (::munmap(const_cast<void *>(_basePtr), _fileSize) < 0) {
+        if (::munmap(const_cast<void *>(_basePtr), _mapSize) < 0) {
             throw hal_errno_exception(_alignmentPath, "munmap failed", errno);
         }
         _basePtr = NULL;
@@ -249,6 +358,7 @@ void hal::MMapFileLocal::openWrite(size_t fileSize) {
     } else {
         loadHeader(true);
     }
+    _openDataSize = _header->nextOffset;
 }
 
 /* close the file if open */
@@ -263,40 +373,84 @@ void hal::MMapFileLocal::closeFile() {
 
 #ifdef ENABLE_UDC
 namespace hal {
-    /* Class that implements UDC file version of MMapFile */
+    /* largest request made by a UDC prefetch worker */
+    static const size_t UDC_MAX_PREFETCH_REQUEST_SIZE = 64 * UDC_BLOCK_SIZE;
+
+    /* Class that implements UDC file version of MMapFile.  Prefetched
+     * ranges are fetched in parallel by an MMapBlockPrefetcher, with each
+     * worker using its own UDC handle. */
     class MMapFileUdc : public MMapFile {
       public:
-        MMapFileUdc(const std::string &alignmentPath, unsigned mode, size_t fileSize);
+        MMapFileUdc(const std::string &alignmentPath, unsigned mode, size_t fileSize,
+                    const MMapAccessOptions &accessOptions);
         virtual void close();
         virtual ~MMapFileUdc();
         virtual bool isUdcProtocol() const {
             return true;
         }
 
+        virtual void prefetch(size_t offset, size_t length, bool lock) const;
+
       protected:
         virtual void fetch(size_t offset, size_t accessSize) const;
 
       private:
+        struct udc2File *openUdcFile();
+        void closeUdcFiles();
+
         struct udc2File *_udcFile;
+        std::vector<struct udc2File *> _workerUdcFiles;
+        MMapBlockPrefetcher *_prefetcher;
     };
 }
 
 /* Constructor. Open or create the specified file. */
-hal::MMapFileUdc::MMapFileUdc(const std::string &alignmentPath, unsigned mode, size_t fileSize)
-    : MMapFile(alignmentPath, mode, true), _udcFile(NULL) {
+hal::MMapFileUdc::MMapFileUdc(const std::string &alignmentPath, unsigned mode, size_t fileSize,
+                              const MMapAccessOptions &accessOptions)
+    : MMapFile(alignmentPath, mode, true), _udcFile(NULL), _prefetcher(NULL) {
     if (_mode & WRITE_ACCESS) {
         throw hal_exception("write access not supported for UDC:" + alignmentPath);
     }
-    _udcFile = udc2FileMayOpen(const_cast<char *>(alignmentPath.c_str()), NULL, UDC_BLOCK_SIZE);
-    if (_udcFile == NULL) {
-        throw hal_exception("can't open " + alignmentPath);
-    }
+    _udcFile = openUdcFile();
     udc2MMap(_udcFile);
 
     // get base point and fetch header
     _basePtr = udc2MMapFetch(_udcFile, 0, sizeof(MMapHeader));
     _fileSize = udc2SizeFromCache(const_cast<char *>(_alignmentPath.c_str()), NULL);
     loadHeader(false);
+
+    // handles are opened here, as opening is not thread-safe
+    for (unsigned i = 0; i < accessOptions._udcFetchThreads; i++) {
+        _workerUdcFiles.push_back(openUdcFile());
+    }
+    if (not _workerUdcFiles.empty()) {
+        _prefetcher = new MMapBlockPrefetcher(_fileSize, UDC_BLOCK_SIZE, _workerUdcFiles.size(),
+                                              UDC_MAX_PREFETCH_REQUEST_SIZE,
+                                              [this](unsigned worker, size_t offset, size_t length) {
+                                                  udc2Prefetch(_workerUdcFiles[worker], offset, length);
+                                              });
+    }
+}
+
+struct udc2File *hal::MMapFileUdc::openUdcFile() {
+    struct udc2File *udcFile = udc2FileMayOpen(const_cast<char *>(_alignmentPath.c_str()), NULL, UDC_BLOCK_SIZE);
+    if (udcFile == NULL) {
+        throw hal_exception("can't open " + _alignmentPath);
+    }
+    return udcFile;
+}
+
+/* stop the prefetcher and close all handles */
+void hal::MMapFileUdc::closeUdcFiles() {
+    delete _prefetcher;
+    _prefetcher = NULL;
+    for (struct udc2File *&workerUdcFile : _workerUdcFiles) {
+        udc2FileClose(&workerUdcFile);
+    }
+    _workerUdcFiles.clear();
+    if (_udcFile != NULL) {
+        udc2FileClose(&_udcFile);
+    }
 }
 
 /* close file, marking as clean.  Don't  */
@@ -304,14 +458,23 @@ void hal::MMapFileUdc::close() {
     if (_basePtr == NULL) {
         throw hal_exception(_alignmentPath + ": MMapFile::close() called on closed file");
     }
-    udc2FileClose(&_udcFile);
+    closeUdcFiles();
 }
 
 /* Destructor. write fields to header and close.  If write access and close
  * has not been called, file will me left mark dirty */
 hal::MMapFileUdc::~MMapFileUdc() {
-    if (_udcFile != NULL) {
-        udc2FileClose(&_udcFile);
+    closeUdcFiles();
+}
+
+/* queue range to be fetched in the background, or fetch it now if there
+ * are no workers */
+void hal::MMapFileUdc::prefetch(size_t offset, size_t length, bool lock) const {
+    // can't lock the UDC cache
+    if (_prefetcher != NULL) {
+        _prefetcher->prefetch(offset, length);
+    } else {
+        fetch(offset, length);
     }
 }
 
@@ -322,23 +485,27 @@ void hal::MMapFileUdc::fetch(size_t offset, size_t accessSize) const {
         accessSize = _fileSize - offset;
     }
 
+    if (_prefetcher != NULL) {
+        _prefetcher->waitFor(offset, accessSize);
+    }
     udc2MMapFetch(_udcFile, offset, accessSize);
 }
 
 #endif
 
 /** create a MMapFile object, opening a local file */
-hal::MMapFile *hal::MMapFile::factory(const std::string &alignmentPath, unsigned mode, size_t fileSize) {
+hal::MMapFile *hal::MMapFile::factory(const std::string &alignmentPath, unsigned mode, size_t fileSize,
+                                      const MMapAccessOptions &accessOptions) {
     if (isUrl(alignmentPath)) {
         if (mode & (CREATE_ACCESS | WRITE_ACCESS)) {
             throw hal_exception("create or write access not support with URL: " + alignmentPath);
         }
 #ifdef ENABLE_UDC
-        return new MMapFileUdc(alignmentPath, mode, fileSize);
+        return new MMapFileUdc(alignmentPath, mode, fileSize, accessOptions);
 #else
         throw hal_exception("URL access requires UDC support to be compiled into HAL library: " + alignmentPath);
 #endif
     } else {
-        return new MMapFileLocal(alignmentPath, mode, fileSize);
+        return new MMapFileLocal(alignmentPath, mode, fileSize, accessOptions);
     }
 }
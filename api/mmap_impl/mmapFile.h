@@ -3,14 +3,17 @@
 #include "halAlignmentInstance.h"
 #include "halDefs.h"
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace hal {
     /* Current API major and minor versions */
     static const unsigned MMAP_API_MAJOR_VERSION = 1;
-    static const unsigned MMAP_API_MINOR_VERSION = 1;
+    static const unsigned MMAP_API_MINOR_VERSION = 5; // 1.2 added columnar, 1.3 packed segment layouts, 1.4 two-bit DNA,
+                                                      // 1.5 site map search arrays
 
     /* get current mmap version as a string */
     const std::string& getMmapCurentVersion();
@@ -31,6 +34,13 @@ namespace hal {
     };
     typedef struct MMapHeader MMapHeader;
 
+    /* a range of the file, used for access hints */
+    struct MMapRegion {
+        size_t _offset;
+        size_t _length;
+    };
+    typedef std::vector<MMapRegion> MMapRegions;
+
     /**
      * An mmapped HAL file.  This handles creation and opening of mapped
      * file.
@@ -76,6 +86,19 @@ namespace hal {
         };
         virtual ~MMapFile() {
         }
+        /* advise the kernel how a range of the file will be accessed,
+         * no-op by default */
+        virtual void adviseAccess(size_t offset, size_t length, MMapAccessPattern accessPattern) const {
+        }
+        /* start reading a range of the file into memory, optionally locking
+         * it there, no-op by default */
+        virtual void prefetch(size_t offset, size_t length, bool lock) const {
+        }
+
+        /* report the size of the data, the number of times the file was
+         * grown and the write throughput since it was opened */
+        void printWriteStats(std::ostream &out) const;
+
         /* round up to alignment size */
         static size_t alignRound(size_t size) {
             return ((size + (sizeof(size_t) - 1)) / sizeof(size_t)) * sizeof(size_t);
@@ -88,6 +111,11 @@ namespace hal {
         virtual void fetch(size_t offset, size_t accessSize) const {
             // no-op by default
         }
+        /* Extend the file to at least minSize bytes, without changing the
+         * address it is mapped at.  Not supported by default. */
+        virtual void growFile(size_t minSize) {
+            throw hal_exception("mmap file is full, specify file size larger than " + std::to_string(_fileSize));
+        }
 
         void setHeaderPtr();
         void createHeader();
@@ -101,6 +129,9 @@ namespace hal {
         MMapHeader *_header;              // pointer to header
         size_t _fileSize;                 // size of file
         bool _mustFetch;                  // fetch must be called on each access.
+        size_t _numGrows;                 // number of times growFile() extended the file
+        size_t _openDataSize;             // size of data when opened, for write statistics
+        std::chrono::steady_clock::time_point _openTime;
 
       private:
         MMapFile() {
@@ -109,7 +140,8 @@ namespace hal {
         void parseCheckVersion();
 
         static MMapFile *factory(const std::string &alignmentPath, unsigned mode = READ_ACCESS,
-                                 size_t fileSize = MMAP_DEFAULT_FILE_SIZE);
+                                 size_t fileSize = MMAP_DEFAULT_FILE_SIZE,
+                                 const MMapAccessOptions &accessOptions = MMapAccessOptions());
 
         std::string _version;
         unsigned _majorVersion;
@@ -145,12 +177,12 @@ const void *hal::MMapFile::toPtr(size_t offset, size_t accessSize) const {
     return static_cast<const char *>(_basePtr) + offset;
 }
 
-/** Allocate new memory, resize file if necessary. If isRoot is specified, it
+/** Allocate new memory, growing file if necessary. If isRoot is specified, it
  * is stored as the root used to find all object.  */
 size_t hal::MMapFile::allocMem(size_t size, bool isRoot) {
     validateWriteAccess();
     if (_header->nextOffset + size > _fileSize) {
-        throw hal_exception("mmap file is full, specify file size larger than " + std::to_string(_fileSize));
+        growFile(_header->nextOffset + size);
     }
     size_t offset = _header->nextOffset;
     _header->nextOffset += alignRound(size);
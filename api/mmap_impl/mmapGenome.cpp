@@ -37,10 +37,16 @@ void MMapGenome::setDimensions(const vector<Sequence::Info> &sequenceDimensions,
         bottomDimensions.push_back(Sequence::UpdateInfo(i->_name, i->_numBottomSegments));
     }
 
-    // Write the new DNA/sequence information, allocating one base per nibble
+    // Write the new DNA/sequence information, allocating one base per nibble.
+    // Two-bit DNA is kept in memory until packed by packDna().
     hal_size_t dnaLength = (totalSequenceLength + 1) / 2;
     _data->_totalSequenceLength = totalSequenceLength;
-    _data->_dnaOffset = _alignment->allocateNewArray(dnaLength);
+    if (_dnaLayout == MMAP_DNA_LAYOUT_TWO_BIT) {
+        _dnaStaging.assign(dnaLength, 0);
+        _data->_dnaOffset = MMAP_NULL_OFFSET;
+    } else {
+        _data->_dnaOffset = _alignment->allocateNewArray(dnaLength);
+    }
     // Reverse space for the sequence data (plus an extra at the end
     // to indicate the end position of the sequence iterator).  FIXME: extra no longer needed
     _data->_sequencesOffset = _alignment->allocateNewArray(sizeof(MMapSequenceData) * sequenceDimensions.size() + 1);
@@ -138,7 +144,11 @@ void MMapGenome::updateTopDimensions(const vector<Sequence::UpdateInfo> &updated
     }
     _data->_numTopSegments = numTopSegments;
 
-    _data->_topSegmentsOffset = _alignment->allocateNewArray((_data->_numTopSegments + 1) * sizeof(MMapTopSegmentData));
+    if (_segmentLayout != MMAP_SEGMENT_LAYOUT_ROWS) {
+        createTopSegmentColumns();
+    } else {
+        _data->_topSegmentsOffset = _alignment->allocateNewArray((_data->_numTopSegments + 1) * sizeof(MMapTopSegmentData));
+    }
     hal_index_t topSegmentStartIndex = 0;
     for (size_t i = 0; i < topDimensions.size(); i++) {
         MMapSequence seq(this, getSequenceData(i));
@@ -156,8 +166,12 @@ void MMapGenome::updateBottomDimensions(const vector<Sequence::UpdateInfo> &upda
         numBottomSegments += i._numSegments;
     }
     _data->_numBottomSegments = numBottomSegments;
-    _data->_bottomSegmentsOffset =
-        _alignment->allocateNewArray((_data->_numBottomSegments + 1) * MMapBottomSegmentData::getSize(this));
+    if (_segmentLayout != MMAP_SEGMENT_LAYOUT_ROWS) {
+        createBottomSegmentColumns();
+    } else {
+        _data->_bottomSegmentsOffset =
+            _alignment->allocateNewArray((_data->_numBottomSegments + 1) * MMapBottomSegmentData::getSize(this));
+    }
     hal_index_t bottomSegmentStartIndex = 0;
     for (size_t i = 0; i < bottomDimensions.size(); i++) {
         MMapSequence seq(this, getSequenceData(i));
@@ -168,6 +182,326 @@ void MMapGenome::updateBottomDimensions(const vector<Sequence::UpdateInfo> &upda
     reload();
 }
 
+void MMapGenome::initSegmentColumns() {
+    _segmentLayout = _alignment->getSegmentLayout();
+    _fetchSegmentColumns = (_segmentLayout != MMAP_SEGMENT_LAYOUT_ROWS) and _alignment->getMMapFile()->isUdcProtocol();
+}
+
+/* Allocate the columns and record, there is an extra entry in each column,
+ * as with the row layout.  With the packed layout, the index columns are
+ * kept in memory until packSegmentColumns() is called. */
+void MMapGenome::createTopSegmentColumns() {
+    size_t numEntries = _data->_numTopSegments + 1;
+    MMapTopSegmentColumnsData columnsData;
+    if (_segmentLayout == MMAP_SEGMENT_LAYOUT_PACKED) {
+        _topSegmentStaging.assign(4 * numEntries, 0);
+        columnsData._startPositionsOffset = MMAP_NULL_OFFSET;
+        columnsData._bottomParseIndexesOffset = MMAP_NULL_OFFSET;
+        columnsData._paralogyIndexesOffset = MMAP_NULL_OFFSET;
+        columnsData._parentIndexesOffset = MMAP_NULL_OFFSET;
+    } else {
+        columnsData._startPositionsOffset = _alignment->allocateNewArray(numEntries * sizeof(hal_index_t));
+        columnsData._bottomParseIndexesOffset = _alignment->allocateNewArray(numEntries * sizeof(hal_index_t));
+        columnsData._paralogyIndexesOffset = _alignment->allocateNewArray(numEntries * sizeof(hal_index_t));
+        columnsData._parentIndexesOffset = _alignment->allocateNewArray(numEntries * sizeof(hal_index_t));
+    }
+    columnsData._reversedFlagsOffset = _alignment->allocateNewArray(segmentFlagWords(numEntries) * sizeof(uint64_t));
+    _data->_topSegmentsOffset = _alignment->allocateNewArray(sizeof(MMapTopSegmentColumnsData));
+    *static_cast<MMapTopSegmentColumnsData *>(_alignment->resolveOffset(_data->_topSegmentsOffset,
+                                                                        sizeof(MMapTopSegmentColumnsData))) = columnsData;
+    loadTopSegmentColumns();
+}
+
+void MMapGenome::createBottomSegmentColumns() {
+    size_t numEntries = _data->_numBottomSegments + 1;
+    size_t numChildren = getNumChildren();
+    MMapBottomSegmentColumnsData columnsData;
+    columnsData._numChildren = numChildren;
+    if (_segmentLayout == MMAP_SEGMENT_LAYOUT_PACKED) {
+        _bottomSegmentStaging.assign((2 + numChildren) * numEntries, 0);
+        columnsData._startPositionsOffset = MMAP_NULL_OFFSET;
+        columnsData._topParseIndexesOffset = MMAP_NULL_OFFSET;
+        columnsData._childIndexesOffset = MMAP_NULL_OFFSET;
+    } else {
+        columnsData._startPositionsOffset = _alignment->allocateNewArray(numEntries * sizeof(hal_index_t));
+        columnsData._topParseIndexesOffset = _alignment->allocateNewArray(numEntries * sizeof(hal_index_t));
+        columnsData._childIndexesOffset = _alignment->allocateNewArray(numEntries * numChildren * sizeof(hal_index_t));
+    }
+    columnsData._childReversedFlagsOffset =
+        _alignment->allocateNewArray(segmentFlagWords(numEntries * numChildren) * sizeof(uint64_t));
+    _data->_bottomSegmentsOffset = _alignment->allocateNewArray(sizeof(MMapBottomSegmentColumnsData));
+    *static_cast<MMapBottomSegmentColumnsData *>(_alignment->resolveOffset(_data->_bottomSegmentsOffset,
+                                                                           sizeof(MMapBottomSegmentColumnsData))) = columnsData;
+    loadBottomSegmentColumns();
+}
+
+/* Resolve pointers to an index column in the file.  Only the first element
+ * is fetched here, with UDC the rest is fetched per-segment by
+ * fetch*SegmentColumns(). */
+void MMapGenome::loadIndexColumn(MMapIndexColumn &column, size_t offset) {
+    if (_segmentLayout == MMAP_SEGMENT_LAYOUT_PACKED) {
+        const MMapPackedArrayData *packedData =
+            static_cast<const MMapPackedArrayData *>(_alignment->resolveOffset(offset, sizeof(MMapPackedArrayData)));
+        column._values = NULL;
+        column._blocks = static_cast<const MMapPackedBlock *>(
+            _alignment->resolveOffset(packedData->_blocksOffset, sizeof(MMapPackedBlock)));
+        column._packedData =
+            static_cast<const uint64_t *>(_alignment->resolveOffset(packedData->_dataOffset, sizeof(uint64_t)));
+    } else {
+        column._values = static_cast<hal_index_t *>(_alignment->resolveOffset(offset, sizeof(hal_index_t)));
+    }
+}
+
+void MMapGenome::loadTopSegmentColumns() {
+    const MMapTopSegmentColumnsData *columnsData = static_cast<const MMapTopSegmentColumnsData *>(
+        _alignment->resolveOffset(_data->_topSegmentsOffset, sizeof(MMapTopSegmentColumnsData)));
+    if (not _topSegmentStaging.empty()) {
+        size_t numEntries = _data->_numTopSegments + 1;
+        _topSegmentColumns._startPositions = MMapIndexColumn(&_topSegmentStaging[0]);
+        _topSegmentColumns._bottomParseIndexes = MMapIndexColumn(&_topSegmentStaging[numEntries]);
+        _topSegmentColumns._paralogyIndexes = MMapIndexColumn(&_topSegmentStaging[2 * numEntries]);
+        _topSegmentColumns._parentIndexes = MMapIndexColumn(&_topSegmentStaging[3 * numEntries]);
+    } else {
+        loadIndexColumn(_topSegmentColumns._startPositions, columnsData->_startPositionsOffset);
+        loadIndexColumn(_topSegmentColumns._bottomParseIndexes, columnsData->_bottomParseIndexesOffset);
+        loadIndexColumn(_topSegmentColumns._paralogyIndexes, columnsData->_paralogyIndexesOffset);
+        loadIndexColumn(_topSegmentColumns._parentIndexes, columnsData->_parentIndexesOffset);
+    }
+    _topSegmentColumns._reversedFlags =
+        static_cast<uint64_t *>(_alignment->resolveOffset(columnsData->_reversedFlagsOffset, sizeof(uint64_t)));
+}
+
+void MMapGenome::loadBottomSegmentColumns() {
+    const MMapBottomSegmentColumnsData *columnsData = static_cast<const MMapBottomSegmentColumnsData *>(
+        _alignment->resolveOffset(_data->_bottomSegmentsOffset, sizeof(MMapBottomSegmentColumnsData)));
+    _bottomSegmentColumns._numChildren = columnsData->_numChildren;
+    if (not _bottomSegmentStaging.empty()) {
+        size_t numEntries = _data->_numBottomSegments + 1;
+        _bottomSegmentColumns._startPositions = MMapIndexColumn(&_bottomSegmentStaging[0]);
+        _bottomSegmentColumns._topParseIndexes = MMapIndexColumn(&_bottomSegmentStaging[numEntries]);
+        _bottomSegmentColumns._childIndexes = MMapIndexColumn(&_bottomSegmentStaging[2 * numEntries]);
+    } else {
+        loadIndexColumn(_bottomSegmentColumns._startPositions, columnsData->_startPositionsOffset);
+        loadIndexColumn(_bottomSegmentColumns._topParseIndexes, columnsData->_topParseIndexesOffset);
+        loadIndexColumn(_bottomSegmentColumns._childIndexes, columnsData->_childIndexesOffset);
+    }
+    _bottomSegmentColumns._childReversedFlags =
+        static_cast<uint64_t *>(_alignment->resolveOffset(columnsData->_childReversedFlagsOffset, sizeof(uint64_t)));
+}
+
+/* write in-memory index columns of the packed layout to the file */
+void MMapGenome::packSegmentColumns() {
+    if (not _topSegmentStaging.empty()) {
+        size_t numEntries = _data->_numTopSegments + 1;
+        size_t startPositionsOffset = mmapPackIndexes(_alignment, &_topSegmentStaging[0], numEntries);
+        size_t bottomParseIndexesOffset = mmapPackIndexes(_alignment, &_topSegmentStaging[numEntries], numEntries);
+        size_t paralogyIndexesOffset = mmapPackIndexes(_alignment, &_topSegmentStaging[2 * numEntries], numEntries);
+        size_t parentIndexesOffset = mmapPackIndexes(_alignment, &_topSegmentStaging[3 * numEntries], numEntries);
+        MMapTopSegmentColumnsData *columnsData = static_cast<MMapTopSegmentColumnsData *>(
+            _alignment->resolveOffset(_data->_topSegmentsOffset, sizeof(MMapTopSegmentColumnsData)));
+        columnsData->_startPositionsOffset = startPositionsOffset;
+        columnsData->_bottomParseIndexesOffset = bottomParseIndexesOffset;
+        columnsData->_paralogyIndexesOffset = paralogyIndexesOffset;
+        columnsData->_parentIndexesOffset = parentIndexesOffset;
+        vector<hal_index_t>().swap(_topSegmentStaging);
+        loadTopSegmentColumns();
+    }
+    if (not _bottomSegmentStaging.empty()) {
+        size_t numEntries = _data->_numBottomSegments + 1;
+        size_t startPositionsOffset = mmapPackIndexes(_alignment, &_bottomSegmentStaging[0], numEntries);
+        size_t topParseIndexesOffset = mmapPackIndexes(_alignment, &_bottomSegmentStaging[numEntries], numEntries);
+        size_t childIndexesOffset = mmapPackIndexes(_alignment, &_bottomSegmentStaging[2 * numEntries],
+                                                    numEntries * _bottomSegmentColumns._numChildren);
+        MMapBottomSegmentColumnsData *columnsData = static_cast<MMapBottomSegmentColumnsData *>(
+            _alignment->resolveOffset(_data->_bottomSegmentsOffset, sizeof(MMapBottomSegmentColumnsData)));
+        columnsData->_startPositionsOffset = startPositionsOffset;
+        columnsData->_topParseIndexesOffset = topParseIndexesOffset;
+        columnsData->_childIndexesOffset = childIndexesOffset;
+        vector<hal_index_t>().swap(_bottomSegmentStaging);
+        loadBottomSegmentColumns();
+    }
+}
+
+void MMapGenome::packDna() {
+    if (not _dnaStaging.empty()) {
+        size_t dnaOffset = mmapPackTwoBitDna(_alignment, &_dnaStaging[0], _data->_totalSequenceLength);
+        _data->_dnaOffset = dnaOffset;
+        vector<char>().swap(_dnaStaging);
+    }
+}
+
+const MMapTwoBitDnaData *MMapGenome::getTwoBitDnaData() const {
+    if ((_dnaLayout != MMAP_DNA_LAYOUT_TWO_BIT) or (not _dnaStaging.empty()) or (_data->_totalSequenceLength == 0)) {
+        return NULL;
+    }
+    return static_cast<const MMapTwoBitDnaData *>(_alignment->resolveOffset(_data->_dnaOffset, sizeof(MMapTwoBitDnaData)));
+}
+
+/* file regions holding numEntries top segments starting at first; packed
+ * columns still held in memory are skipped */
+void MMapGenome::getTopSegmentRegions(MMapRegions &regions, size_t first, size_t numEntries) const {
+    if (_segmentLayout == MMAP_SEGMENT_LAYOUT_ROWS) {
+        regions.push_back({_data->_topSegmentsOffset + first * sizeof(MMapTopSegmentData),
+                           numEntries * sizeof(MMapTopSegmentData)});
+        return;
+    }
+    MMapTopSegmentColumnsData columnsData = *static_cast<const MMapTopSegmentColumnsData *>(
+        _alignment->resolveOffset(_data->_topSegmentsOffset, sizeof(MMapTopSegmentColumnsData)));
+    regions.push_back({_data->_topSegmentsOffset, sizeof(MMapTopSegmentColumnsData)});
+    regions.push_back(segmentFlagsRegion(columnsData._reversedFlagsOffset, first, numEntries));
+    if (_segmentLayout == MMAP_SEGMENT_LAYOUT_COLUMNS) {
+        for (size_t offset : {columnsData._startPositionsOffset, columnsData._bottomParseIndexesOffset,
+                              columnsData._paralogyIndexesOffset, columnsData._parentIndexesOffset}) {
+            regions.push_back({offset + first * sizeof(hal_index_t), numEntries * sizeof(hal_index_t)});
+        }
+    } else if (_topSegmentStaging.empty()) {
+        for (size_t offset : {columnsData._startPositionsOffset, columnsData._bottomParseIndexesOffset,
+                              columnsData._paralogyIndexesOffset, columnsData._parentIndexesOffset}) {
+            mmapPackedIndexesRegions(_alignment, offset, regions, first, numEntries);
+        }
+    }
+}
+
+void MMapGenome::getBottomSegmentRegions(MMapRegions &regions, size_t first, size_t numEntries) const {
+    if (_segmentLayout == MMAP_SEGMENT_LAYOUT_ROWS) {
+        size_t segmentSize = MMapBottomSegmentData::getSize(this);
+        regions.push_back({_data->_bottomSegmentsOffset + first * segmentSize, numEntries * segmentSize});
+        return;
+    }
+    MMapBottomSegmentColumnsData columnsData = *static_cast<const MMapBottomSegmentColumnsData *>(
+        _alignment->resolveOffset(_data->_bottomSegmentsOffset, sizeof(MMapBottomSegmentColumnsData)));
+    size_t numChildren = columnsData._numChildren;
+    regions.push_back({_data->_bottomSegmentsOffset, sizeof(MMapBottomSegmentColumnsData)});
+    if (numChildren > 0) {
+        regions.push_back(
+            segmentFlagsRegion(columnsData._childReversedFlagsOffset, first * numChildren, numEntries * numChildren));
+    }
+    if (_segmentLayout == MMAP_SEGMENT_LAYOUT_COLUMNS) {
+        regions.push_back({columnsData._startPositionsOffset + first * sizeof(hal_index_t), numEntries * sizeof(hal_index_t)});
+        regions.push_back({columnsData._topParseIndexesOffset + first * sizeof(hal_index_t), numEntries * sizeof(hal_index_t)});
+        regions.push_back({columnsData._childIndexesOffset + first * numChildren * sizeof(hal_index_t),
+                           numEntries * numChildren * sizeof(hal_index_t)});
+    } else if (_bottomSegmentStaging.empty()) {
+        mmapPackedIndexesRegions(_alignment, columnsData._startPositionsOffset, regions, first, numEntries);
+        mmapPackedIndexesRegions(_alignment, columnsData._topParseIndexesOffset, regions, first, numEntries);
+        mmapPackedIndexesRegions(_alignment, columnsData._childIndexesOffset, regions, first * numChildren,
+                                 numEntries * numChildren);
+    }
+}
+
+void MMapGenome::getDnaRegions(MMapRegions &regions) const {
+    if (_dnaLayout == MMAP_DNA_LAYOUT_NIBBLES) {
+        regions.push_back({_data->_dnaOffset, (_data->_totalSequenceLength + 1) / 2});
+    } else if (getTwoBitDnaData() != NULL) {
+        MMapTwoBitDnaData dnaData = *getTwoBitDnaData();
+        regions.push_back({_data->_dnaOffset, sizeof(MMapTwoBitDnaData)});
+        regions.push_back({dnaData._basesOffset, (dnaData._length + 3) / 4});
+        regions.push_back({dnaData._nRunsOffset, dnaData._numNRuns * sizeof(MMapDnaRun)});
+        regions.push_back({dnaData._lowerRunsOffset, dnaData._numLowerRuns * sizeof(MMapDnaRun)});
+    }
+}
+
+/* get the file regions holding the segment and DNA arrays, which is
+ * most of the genome's data */
+void MMapGenome::getDataRegions(MMapRegions &regions) const {
+    if (_data->_topSegmentsOffset != MMAP_NULL_OFFSET) {
+        getTopSegmentRegions(regions, 0, _data->_numTopSegments + 1);
+    }
+    if (_data->_bottomSegmentsOffset != MMAP_NULL_OFFSET) {
+        getBottomSegmentRegions(regions, 0, _data->_numBottomSegments + 1);
+    }
+    if ((_data->_dnaOffset != MMAP_NULL_OFFSET) and (_data->_totalSequenceLength > 0)) {
+        getDnaRegions(regions);
+    }
+}
+
+void MMapGenome::adviseAccess(MMapAccessPattern accessPattern) const {
+    MMapRegions regions;
+    getDataRegions(regions);
+    for (const MMapRegion &region : regions) {
+        _alignment->getMMapFile()->adviseAccess(region._offset, region._length, accessPattern);
+    }
+}
+
+void MMapGenome::prefetch(bool lock) const {
+    MMapRegions regions;
+    getDataRegions(regions);
+    for (const MMapRegion &region : regions) {
+        _alignment->getMMapFile()->prefetch(region._offset, region._length, lock);
+    }
+}
+
+/* segments [firstIndex, lastIndex] and the start of the following one,
+ * which is needed for the length */
+void MMapGenome::prefetchTopSegments(hal_index_t firstIndex, hal_index_t lastIndex) const {
+    firstIndex = std::max(firstIndex, hal_index_t(0));
+    lastIndex = std::min(lastIndex, hal_index_t(_data->_numTopSegments) - 1);
+    if ((_data->_topSegmentsOffset == MMAP_NULL_OFFSET) or (lastIndex < firstIndex)) {
+        return;
+    }
+    MMapRegions regions;
+    getTopSegmentRegions(regions, firstIndex, lastIndex - firstIndex + 2);
+    for (const MMapRegion &region : regions) {
+        _alignment->getMMapFile()->prefetch(region._offset, region._length, false);
+    }
+}
+
+void MMapGenome::prefetchBottomSegments(hal_index_t firstIndex, hal_index_t lastIndex) const {
+    firstIndex = std::max(firstIndex, hal_index_t(0));
+    lastIndex = std::min(lastIndex, hal_index_t(_data->_numBottomSegments) - 1);
+    if ((_data->_bottomSegmentsOffset == MMAP_NULL_OFFSET) or (lastIndex < firstIndex)) {
+        return;
+    }
+    MMapRegions regions;
+    getBottomSegmentRegions(regions, firstIndex, lastIndex - firstIndex + 2);
+    for (const MMapRegion &region : regions) {
+        _alignment->getMMapFile()->prefetch(region._offset, region._length, false);
+    }
+}
+
+/* fetch count entries of an index column starting at first (UDC only) */
+void MMapGenome::fetchIndexColumn(size_t offset, size_t first, size_t count) {
+    if (_segmentLayout == MMAP_SEGMENT_LAYOUT_PACKED) {
+        mmapFetchPackedIndexes(_alignment, offset, first, count);
+    } else {
+        _alignment->resolveOffset(offset + first * sizeof(hal_index_t), count * sizeof(hal_index_t));
+    }
+}
+
+/* fetch the parts of the columns for a segment and the start of the
+ * following segment, which is needed for the length */
+void MMapGenome::fetchTopSegmentColumns(hal_index_t index) {
+    if ((index < 0) or (index > (hal_index_t)_data->_numTopSegments)) {
+        return;
+    }
+    const MMapTopSegmentColumnsData *columnsData = static_cast<const MMapTopSegmentColumnsData *>(
+        _alignment->resolveOffset(_data->_topSegmentsOffset, sizeof(MMapTopSegmentColumnsData)));
+    size_t numFetch = (index < (hal_index_t)_data->_numTopSegments) ? 2 : 1;
+    fetchIndexColumn(columnsData->_startPositionsOffset, index, numFetch);
+    fetchIndexColumn(columnsData->_bottomParseIndexesOffset, index, 1);
+    fetchIndexColumn(columnsData->_paralogyIndexesOffset, index, 1);
+    fetchIndexColumn(columnsData->_parentIndexesOffset, index, 1);
+    _alignment->resolveOffset(columnsData->_reversedFlagsOffset + (index / 64) * sizeof(uint64_t), sizeof(uint64_t));
+}
+
+void MMapGenome::fetchBottomSegmentColumns(hal_index_t index) {
+    if ((index < 0) or (index > (hal_index_t)_data->_numBottomSegments)) {
+        return;
+    }
+    const MMapBottomSegmentColumnsData *columnsData = static_cast<const MMapBottomSegmentColumnsData *>(
+        _alignment->resolveOffset(_data->_bottomSegmentsOffset, sizeof(MMapBottomSegmentColumnsData)));
+    size_t numChildren = columnsData->_numChildren;
+    size_t numFetch = (index < (hal_index_t)_data->_numBottomSegments) ? 2 : 1;
+    fetchIndexColumn(columnsData->_startPositionsOffset, index, numFetch);
+    fetchIndexColumn(columnsData->_topParseIndexesOffset, index, 1);
+    if (numChildren > 0) {
+        fetchIndexColumn(columnsData->_childIndexesOffset, index * numChildren, numChildren);
+        size_t firstWord = (index * numChildren) / 64, lastWord = ((index + 1) * numChildren - 1) / 64;
+        _alignment->resolveOffset(columnsData->_childReversedFlagsOffset + firstWord * sizeof(uint64_t),
+                                  (lastWord - firstWord + 1) * sizeof(uint64_t));
+    }
+}
+
 hal_size_t MMapGenome::getNumSequences() const {
     return _data->_numSequences;
 }
@@ -331,6 +665,14 @@ void MMapGenome::getSubString(string &outString, hal_size_t start, hal_size_t le
     dnaIt->readString(outString, length);
 }
 
+void MMapGenome::getSubString(char *outBuffer, hal_size_t start, hal_size_t length, bool reversed) const {
+    if (length > 0) {
+        DnaIteratorPtr dnaIt(getDnaIterator(reversed ? start + length - 1 : start));
+        dnaIt->setReversed(reversed);
+        dnaIt->readBases(outBuffer, length);
+    }
+}
+
 void MMapGenome::setSubString(const string &inString, hal_size_t start, hal_size_t length) {
     if (length != inString.length()) {
         throw hal_exception(string("setString: input string has differnt") + "length from target string in genome");
@@ -365,6 +707,16 @@ void MMapGenome::rename(const std::string &name) {
     _data->setName(_alignment, name);
 }
 
+void MMapGenome::loadForConcurrentAccess() {
+    for (size_t i = 0; i < _data->_numSequences; i++) {
+        getSequenceByIndex(i);
+    }
+    getParent();
+    for (hal_size_t i = 0; i < getNumChildren(); i++) {
+        getChild(i);
+    }
+}
+
 void MMapGenome::deleteSequenceCache() {
     for (auto seq : _sequenceObjCache) {
         delete seq;
@@ -6,15 +6,18 @@
 #include "mmapGenomeSiteMap.h"
 #include "mmapMetaData.h"
 #include "mmapPerfectHashTable.h"
+#include "mmapSegmentColumns.h"
 #include "mmapString.h"
 #include "mmapTopSegmentData.h"
 #include <map>
+#include <vector>
 
 namespace hal {
     class MMapBottomSegmentData;
     class MMapSequence;
     class MMapSequenceData;
     class MmapAlignment;
+    struct MMapTwoBitDnaData;
 
     class MMapGenomeData {
         friend class MMapGenome;
@@ -51,16 +54,26 @@ namespace hal {
             : Genome(alignment, data->getName(alignment)), _alignment(alignment), _data(data), _arrayIndex(arrayIndex),
               _name(data->getName(_alignment)), _metaData(_alignment, _data->_metadataOffset),
               _sequenceNameHash(alignment->getMMapFile(), data->_sequenceHashOffset),
-              _genomeSiteMap(alignment->getMMapFile(), data->_genomeSiteMapOffset) {
+              _genomeSiteMap(alignment->getMMapFile(), data->_genomeSiteMapOffset, alignment->hasSiteMapSearchArrays()),
+              _dnaLayout(alignment->getDnaLayout()) {
             _sequenceObjCache.resize(data->_numSequences);
+            initSegmentColumns();
+            if ((_segmentLayout != MMAP_SEGMENT_LAYOUT_ROWS) and (_data->_topSegmentsOffset != MMAP_NULL_OFFSET)) {
+                loadTopSegmentColumns();
+            }
+            if ((_segmentLayout != MMAP_SEGMENT_LAYOUT_ROWS) and (_data->_bottomSegmentsOffset != MMAP_NULL_OFFSET)) {
+                loadBottomSegmentColumns();
+            }
         };
         MMapGenome(MMapAlignment *alignment, MMapGenomeData *data, size_t arrayIndex, const std::string &name)
             : Genome(alignment, name), _alignment(alignment), _data(data), _arrayIndex(arrayIndex), _name(name),
               _metaData(_alignment), _sequenceNameHash(alignment->getMMapFile(), data->_sequenceHashOffset),
-              _genomeSiteMap(alignment->getMMapFile(), data->_genomeSiteMapOffset) {
+              _genomeSiteMap(alignment->getMMapFile(), data->_genomeSiteMapOffset, alignment->hasSiteMapSearchArrays()),
+              _dnaLayout(alignment->getDnaLayout()) {
             _data->initializeName(_alignment, _name);
             _data->_metadataOffset = _metaData.getOffset();
             _sequenceObjCache.resize(data->_numSequences);
+            initSegmentColumns();
         };
 
         virtual ~MMapGenome();
@@ -72,6 +85,41 @@ namespace hal {
             return _data->getBottomSegmentData(_alignment, this, index);
         };
 
+        /* get the columns for accessing a top segment, or NULL if stored in rows */
+        MMapTopSegmentColumns *getTopSegmentColumns(hal_index_t index) {
+            if (_fetchSegmentColumns) {
+                fetchTopSegmentColumns(index);
+            }
+            return (_segmentLayout != MMAP_SEGMENT_LAYOUT_ROWS) ? &_topSegmentColumns : NULL;
+        }
+        /* get the columns for accessing a bottom segment, or NULL if stored in rows */
+        MMapBottomSegmentColumns *getBottomSegmentColumns(hal_index_t index) {
+            if (_fetchSegmentColumns) {
+                fetchBottomSegmentColumns(index);
+            }
+            return (_segmentLayout != MMAP_SEGMENT_LAYOUT_ROWS) ? &_bottomSegmentColumns : NULL;
+        }
+
+        /* can the segment arrays be read through the pointers from
+         * getTopSegmentPointer(0) and getTopSegmentColumns() for any index?
+         * Not with UDC, where data is fetched on access, or when writing,
+         * as the file is remapped when it grows. */
+        bool hasDirectSegmentAccess() const {
+            return _alignment->isReadOnly() and not _alignment->getMMapFile()->isUdcProtocol();
+        }
+
+        /* with the packed layout, write segments that are being held in
+         * memory to the file, after which they can't be modified */
+        void packSegmentColumns();
+
+        /* with the two-bit DNA layout, write DNA that is being held in
+         * memory to the file, after which it can't be modified */
+        void packDna();
+
+        const MMapGenomeSiteMap &getGenomeSiteMap() const {
+            return _genomeSiteMap;
+        }
+
         void updateGenomeArrayBasePtr(MMapGenomeData *base) {
             _data = base + _arrayIndex;
         }
@@ -118,6 +166,19 @@ namespace hal {
 
         void rename(const std::string &newName);
 
+        /* fill all lazily-loaded caches, see MMapAlignment concurrent access */
+        void loadForConcurrentAccess();
+
+        /* advise the kernel how the segment and DNA arrays will be read */
+        void adviseAccess(MMapAccessPattern accessPattern) const;
+
+        /* read the segment and DNA arrays into memory, optionally locking them */
+        void prefetch(bool lock) const;
+
+        void prefetchTopSegments(hal_index_t firstIndex, hal_index_t lastIndex) const;
+
+        void prefetchBottomSegments(hal_index_t firstIndex, hal_index_t lastIndex) const;
+
         // SEGMENTED SEQUENCE INTERFACE
 
         hal_size_t getSequenceLength() const;
@@ -147,6 +208,7 @@ namespace hal {
         void setString(const std::string &inString);
 
         void getSubString(std::string &outString, hal_size_t start, hal_size_t length) const;
+        void getSubString(char *outBuffer, hal_size_t start, hal_size_t length, bool reversed = false) const;
 
         void setSubString(const std::string &intString, hal_size_t start, hal_size_t length);
 
@@ -164,15 +226,39 @@ namespace hal {
         char *getDNA(size_t start, size_t length) {
             return _data->getDNA(_alignment, start, length);
         }
+        MMapDnaLayout getDnaLayout() const {
+            return _dnaLayout;
+        }
+        /* nibble-encoded DNA of a two-bit layout genome that is being
+         * written, or NULL if not held in memory */
+        char *getDnaStaging() {
+            return _dnaStaging.empty() ? NULL : &_dnaStaging[0];
+        }
+        /* two-bit DNA in the file, or NULL if not in the two-bit layout or
+         * not yet packed */
+        const MMapTwoBitDnaData *getTwoBitDnaData() const;
         void createSequenceNameHash(size_t numSequences);
 
       private:
+        void initSegmentColumns();
+        void createTopSegmentColumns();
+        void createBottomSegmentColumns();
+        void loadIndexColumn(MMapIndexColumn &column, size_t offset);
+        void loadTopSegmentColumns();
+        void loadBottomSegmentColumns();
+        void fetchIndexColumn(size_t offset, size_t first, size_t count);
+        void fetchTopSegmentColumns(hal_index_t index);
+        void fetchBottomSegmentColumns(hal_index_t index);
         void createGenomeSiteMap(size_t numSequences);
         void setSequenceData(size_t i, hal_index_t startPos, hal_index_t topSegmentStartIndex,
                              hal_index_t bottomSegmentStartIndex, const Sequence::Info &sequenceInfo);
         std::vector<Sequence::UpdateInfo> getCompleteInputDimensions(const std::vector<Sequence::UpdateInfo> &inputDimensions,
                                                                      bool isTop);
         void deleteSequenceCache();
+        void getDataRegions(MMapRegions &regions) const;
+        void getTopSegmentRegions(MMapRegions &regions, size_t first, size_t numEntries) const;
+        void getBottomSegmentRegions(MMapRegions &regions, size_t first, size_t numEntries) const;
+        void getDnaRegions(MMapRegions &regions) const;
 
         MMapGenomeData *_data;
         size_t _arrayIndex; // Index within the alignment's genome array.
@@ -180,6 +266,14 @@ namespace hal {
         MMapMetaData _metaData;
         MMapPerfectHashTable _sequenceNameHash;
         MMapGenomeSiteMap _genomeSiteMap;
+        MMapSegmentLayout _segmentLayout;
+        bool _fetchSegmentColumns; // columns must be fetched on access (UDC)
+        MMapTopSegmentColumns _topSegmentColumns;
+        MMapBottomSegmentColumns _bottomSegmentColumns;
+        std::vector<hal_index_t> _topSegmentStaging;    // packed layout index columns while writing
+        std::vector<hal_index_t> _bottomSegmentStaging; // packed layout index columns while writing
+        MMapDnaLayout _dnaLayout;
+        std::vector<char> _dnaStaging; // two-bit layout DNA while writing
 
         mutable std::vector<MMapSequence *> _sequenceObjCache;
     };
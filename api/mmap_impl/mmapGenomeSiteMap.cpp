@@ -1,6 +1,8 @@
 #include "mmapGenomeSiteMap.h"
 #include "mmapRbTree.h"
 #include "mmapSequence.h"
+#include <algorithm>
+#include <atomic>
 using namespace std;
 using namespace hal;
 
@@ -28,27 +30,68 @@ namespace hal {
             return 0;
         }
     }
+
+    /* Per-thread cache of the last sequence found in a few site maps,
+     * indexed by map id.  Ids are never reused, so an entry can't match a
+     * map that was deleted. */
+    static const size_t SITE_MAP_CACHE_SIZE = 8;
+    struct SiteMapCacheEntry {
+        size_t _mapId;
+        MMapGenomeSiteMapHit _hit;
+    };
+    static thread_local SiteMapCacheEntry siteMapCache[SITE_MAP_CACHE_SIZE];
+}
+
+/* get a unique id for a site map object, zero is never used */
+size_t hal::MMapGenomeSiteMap::newMapId() {
+    static std::atomic<size_t> nextMapId(1);
+    return nextMapId++;
 }
 
-/* calculate space required for the map in bytes */
-size_t hal::MMapGenomeSiteMap::calcRequiredSpace(size_t numSequences) {
+/* calculate space required for the tree in bytes */
+size_t hal::MMapGenomeSiteMap::calcTreeSpace(size_t numSequences) {
     // root is in header
     return MMapFile::alignRound(sizeof(MMapGenomeSiteMapData)) +
            ((numSequences - 1) * MMapFile::alignRound(sizeof(MMapGenomeSiteMapNode)));
 }
 
+/* calculate space required for the map in bytes, the search arrays follow
+ * the tree and have an unused first element */
+size_t hal::MMapGenomeSiteMap::calcRequiredSpace(size_t numSequences, bool hasSearchArray) {
+    size_t space = calcTreeSpace(numSequences);
+    if (hasSearchArray) {
+        space += MMapFile::alignRound((numSequences + 1) * sizeof(size_t)) +
+                 MMapFile::alignRound((numSequences + 1) * sizeof(MMapGenomeSiteMapSearchEntry));
+    }
+    return space;
+}
+
 /* read header information */
 void hal::MMapGenomeSiteMap::readGsm(size_t gsmOffset) {
     _gsmOffset = gsmOffset;
     _data = static_cast<MMapGenomeSiteMapData *>(_file->toPtr(gsmOffset, sizeof(MMapGenomeSiteMapData)));
     // prefetch full table
-    _file->toPtr(gsmOffset, calcRequiredSpace(_data->_numSequences));
+    _file->toPtr(gsmOffset, calcRequiredSpace(_data->_numSequences, _hasSearchArray));
+    if (_hasSearchArray) {
+        setSearchArrayPtrs();
+    }
 }
 
 void hal::MMapGenomeSiteMap::createGsm(size_t numSequences) {
-    _gsmOffset = _file->allocMem(calcRequiredSpace(numSequences));
-    _data = static_cast<MMapGenomeSiteMapData *>(_file->toPtr(_gsmOffset, calcRequiredSpace(numSequences)));
+    _gsmOffset = _file->allocMem(calcRequiredSpace(numSequences, true));
+    _data = static_cast<MMapGenomeSiteMapData *>(_file->toPtr(_gsmOffset, calcRequiredSpace(numSequences, true)));
     _data->_numSequences = numSequences;
+    setSearchArrayPtrs();
+    _mapId = newMapId(); // invalidate cache entries for a previous build
+}
+
+void hal::MMapGenomeSiteMap::setSearchArrayPtrs() {
+    size_t numSequences = _data->_numSequences;
+    size_t endsOffset = _gsmOffset + calcTreeSpace(numSequences);
+    size_t entriesOffset = endsOffset + MMapFile::alignRound((numSequences + 1) * sizeof(size_t));
+    _searchEnds = static_cast<size_t *>(_file->toPtr(endsOffset, (numSequences + 1) * sizeof(size_t)));
+    _searchEntries = static_cast<MMapGenomeSiteMapSearchEntry *>(
+        _file->toPtr(entriesOffset, (numSequences + 1) * sizeof(MMapGenomeSiteMapSearchEntry)));
 }
 
 /* load into temporary site tree, which is balanced */
@@ -84,6 +127,35 @@ hal_index_t hal::MMapGenomeSiteMap::copyTree(struct rb_tree_node *tmpNode, int &
     return nodeIdx;
 }
 
+/* recursively store sequences in Eytzinger order: an in-order walk of the
+ * implicit tree where the children of k are 2k and 2k+1 */
+void hal::MMapGenomeSiteMap::fillSearchArray(const vector<MMapSequence *> &sortedSequences, size_t k,
+                                             size_t &nextSequence) {
+    if (k <= sortedSequences.size()) {
+        fillSearchArray(sortedSequences, 2 * k, nextSequence);
+        const MMapSequence *seq = sortedSequences[nextSequence++];
+        _searchEnds[k] = seq->getStartPosition() + seq->getSequenceLength();
+        _searchEntries[k]._startPosition = seq->getStartPosition();
+        _searchEntries[k]._sequenceIndex = seq->getArrayIndex();
+        fillSearchArray(sortedSequences, 2 * k + 1, nextSequence);
+    }
+}
+
+/* Build the search arrays.  A search finds the first sequence ending after
+ * a position; empty sequences sort before the sequence at the same
+ * position, so they are never found. */
+void hal::MMapGenomeSiteMap::buildSearchArray(const vector<MMapSequence *> &sequences) {
+    vector<MMapSequence *> sortedSequences(sequences);
+    std::stable_sort(sortedSequences.begin(), sortedSequences.end(), [](const MMapSequence *lhs, const MMapSequence *rhs) {
+        return (lhs->getStartPosition() + lhs->getSequenceLength()) < (rhs->getStartPosition() + rhs->getSequenceLength());
+    });
+    _searchEnds[0] = 0;
+    _searchEntries[0]._startPosition = 0;
+    _searchEntries[0]._sequenceIndex = NULL_INDEX;
+    size_t nextSequence = 0;
+    fillSearchArray(sortedSequences, 1, nextSequence);
+}
+
 size_t hal::MMapGenomeSiteMap::build(const vector<MMapSequence *> &sequences) {
     struct rb_tree tmpTree;
     TmpTreeNodes tmpTreeNodes; // manages memory for tmp tree
@@ -93,11 +165,11 @@ size_t hal::MMapGenomeSiteMap::build(const vector<MMapSequence *> &sequences) {
     createGsm(sequences.size());
     int nextNodeIdx = 0;
     copyTree(tmpTree.root, nextNodeIdx);
+    buildSearchArray(sequences);
     return _gsmOffset;
 }
 
-hal_index_t MMapGenomeSiteMap::getSequenceIndexBySite(size_t position) {
-    assert(_gsmOffset != MMAP_NULL_OFFSET);
+bool hal::MMapGenomeSiteMap::treeSearch(size_t position, MMapGenomeSiteMapHit &hit) const {
     const MMapGenomeSiteMapNode *node = getNodePtr(0);
     while (node != NULL) {
         int dir = node->positionCmp(position);
@@ -106,8 +178,27 @@ hal_index_t MMapGenomeSiteMap::getSequenceIndexBySite(size_t position) {
         } else if (dir > 0) {
             node = getNodePtr(node->_rightNodeIndex);
         } else {
-            return node->_sequenceIndex;
+            hit._startPosition = node->_startPosition;
+            hit._endPosition = node->_startPosition + node->_length;
+            hit._sequenceIndex = node->_sequenceIndex;
+            return true;
         }
     }
-    return NULL_INDEX;
+    return false;
+}
+
+hal_index_t MMapGenomeSiteMap::getSequenceIndexBySite(size_t position) const {
+    assert(_gsmOffset != MMAP_NULL_OFFSET);
+    SiteMapCacheEntry &cached = siteMapCache[_mapId % SITE_MAP_CACHE_SIZE];
+    if ((cached._mapId == _mapId) and (cached._hit._startPosition <= position) and
+        (position < cached._hit._endPosition)) {
+        return cached._hit._sequenceIndex;
+    }
+    MMapGenomeSiteMapHit hit;
+    if (not(hasSearchArray() ? arraySearch(position, hit) : treeSearch(position, hit))) {
+        return NULL_INDEX;
+    }
+    cached._mapId = _mapId;
+    cached._hit = hit;
+    return hit._sequenceIndex;
 }
@@ -47,17 +47,41 @@ namespace hal {
         MMapGenomeSiteMapNode _root;
     };
 
+    /* sequence found by a site map search */
+    struct MMapGenomeSiteMapHit {
+        size_t _startPosition;
+        size_t _endPosition; // exclusive
+        hal_index_t _sequenceIndex;
+    };
+
+    /* entry in the search array, parallel to the sequence end positions */
+    struct MMapGenomeSiteMapSearchEntry {
+        size_t _startPosition;
+        hal_index_t _sequenceIndex;
+    };
+
     /**
      * MMap file structure used to map position in genome to specific
      * sequence.  This builds a balance binary tree and stores it in the
      * mmapped file for direct access.
+     *
+     * Starting with mmap API 1.5, the tree is followed by the sequence end
+     * positions in Eytzinger (breadth-first) order, which is searched
+     * without branches and with the top levels of the implicit tree
+     * sharing cache lines.  A parallel array gives the start position and
+     * index of each sequence.  The tree is still written so older readers
+     * can use the file.  The last sequence found in each map is cached per
+     * thread, as lookups are usually near the previous one.
      */
     class MMapGenomeSiteMap {
       public:
         /** Construct new object for accessing site map in HAL file.
          * If the hash table is being created, then gsmOffset
-         * should be MMAP_NULL_OFFSET.  */
-        MMapGenomeSiteMap(MMapFile *mmapFile, size_t gsmOffset) : _file(mmapFile), _gsmOffset(gsmOffset), _data(NULL) {
+         * should be MMAP_NULL_OFFSET.  If hasSearchArray is false,
+         * only the tree is used when reading. */
+        MMapGenomeSiteMap(MMapFile *mmapFile, size_t gsmOffset, bool hasSearchArray)
+            : _file(mmapFile), _gsmOffset(gsmOffset), _hasSearchArray(hasSearchArray), _mapId(newMapId()), _data(NULL),
+              _searchEnds(NULL), _searchEntries(NULL) {
             if (gsmOffset != MMAP_NULL_OFFSET) {
                 readGsm(gsmOffset);
             }
@@ -68,7 +92,36 @@ namespace hal {
         size_t build(const std::vector<MMapSequence *> &sequences);
 
         /** find the sequence index containing a position */
-        hal_index_t getSequenceIndexBySite(size_t position);
+        hal_index_t getSequenceIndexBySite(size_t position) const;
+
+        /* is the search array used for lookups? */
+        bool hasSearchArray() const {
+            return _searchEnds != NULL;
+        }
+
+        /* search the tree, without using the cache */
+        bool treeSearch(size_t position, MMapGenomeSiteMapHit &hit) const;
+
+        /* search the search array, which must exist, without using the
+         * cache */
+        bool arraySearch(size_t position, MMapGenomeSiteMapHit &hit) const {
+            // descend to the leaf below the first end greater than position,
+            // then go back up to it by dropping the trailing right turns
+            size_t numSequences = _data->_numSequences;
+            size_t k = 1;
+            while (k <= numSequences) {
+                __builtin_prefetch(_searchEnds + 16 * k);
+                k = 2 * k + (_searchEnds[k] <= position);
+            }
+            k >>= __builtin_ffsll(~k);
+            if ((k == 0) or (position < _searchEntries[k]._startPosition)) {
+                return false;
+            }
+            hit._startPosition = _searchEntries[k]._startPosition;
+            hit._endPosition = _searchEnds[k];
+            hit._sequenceIndex = _searchEntries[k]._sequenceIndex;
+            return true;
+        }
 
         /** find the sequence containing a position */
         const Sequence *getSequenceBySite(hal_size_t position) const {
@@ -76,11 +129,16 @@ namespace hal {
         }
 
       private:
-        static size_t calcRequiredSpace(size_t numSequences);
+        static size_t newMapId();
+        static size_t calcTreeSpace(size_t numSequences);
+        static size_t calcRequiredSpace(size_t numSequences, bool hasSearchArray);
         void readGsm(size_t gsmOffset);
         void createGsm(size_t numSequences);
+        void setSearchArrayPtrs();
         void loadTmpTree(const std::vector<MMapSequence *> &sequences, struct rb_tree *tmpTree, TmpTreeNodes &tmpTreeNodes);
         hal_index_t copyTree(struct rb_tree_node *tmpNode, int &nextNodeIdx);
+        void buildSearchArray(const std::vector<MMapSequence *> &sequences);
+        void fillSearchArray(const std::vector<MMapSequence *> &sortedSequences, size_t k, size_t &nextSequence);
 
         /* returns null for NULL_INDEX */
         MMapGenomeSiteMapNode *getNodePtr(int nodeIndex) {
@@ -98,7 +156,11 @@ namespace hal {
 
         MMapFile *_file;
         size_t _gsmOffset;
+        bool _hasSearchArray;
+        size_t _mapId; // unique id of this object, used as the cache key
         MMapGenomeSiteMapData *_data;
+        size_t *_searchEnds;                          // Eytzinger order, starting at 1
+        MMapGenomeSiteMapSearchEntry *_searchEntries; // parallel to _searchEnds
     };
 }
 #endif
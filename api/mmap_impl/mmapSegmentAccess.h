@@ -0,0 +1,131 @@
+#ifndef _MMAPSEGMENTACCESS_H
+#define _MMAPSEGMENTACCESS_H
+#include "halSegmentCursor.h"
+#include "mmapBottomSegmentData.h"
+#include "mmapGenome.h"
+#include "mmapSegmentColumns.h"
+#include "mmapTopSegmentData.h"
+
+/*
+ * Segment accessors for halSegmentCursor.h that read the mmap segment
+ * arrays in place, either as rows of MMapTopSegmentData and
+ * MMapBottomSegmentData or as columns.  Only for genomes where
+ * MMapGenome::hasDirectSegmentAccess() is true.
+ */
+namespace hal {
+    class MMapBottomSegmentAccess {
+      public:
+        MMapBottomSegmentAccess()
+            : _genome(NULL), _numSegments(0), _numChildren(0), _rowSize(0), _rows(NULL), _columns(NULL) {
+        }
+        explicit MMapBottomSegmentAccess(const Genome *genome)
+            : _genome(genome), _numSegments(genome->getNumBottomSegments()), _numChildren(genome->getNumChildren()),
+              _rowSize(MMapBottomSegmentData::getSize(genome)), _rows(NULL), _columns(NULL) {
+            MMapGenome *mmapGenome = const_cast<MMapGenome *>(static_cast<const MMapGenome *>(genome));
+            assert(mmapGenome->hasDirectSegmentAccess());
+            if (_numSegments > 0) {
+                _columns = mmapGenome->getBottomSegmentColumns(0);
+                if (_columns == NULL) {
+                    _rows = reinterpret_cast<const char *>(mmapGenome->getBottomSegmentPointer(0));
+                }
+            }
+        }
+        const Genome *getGenome() const {
+            return _genome;
+        }
+        hal_size_t getNumSegments() const {
+            return _numSegments;
+        }
+        hal_index_t getStartPosition(hal_index_t i) const {
+            return (_columns == NULL) ? row(i)->getStartPosition() : _columns->getStartPosition(i);
+        }
+        hal_size_t getLength(hal_index_t i) const {
+            return getStartPosition(i + 1) - getStartPosition(i);
+        }
+        hal_index_t getChildIndex(hal_index_t i, hal_size_t child) const {
+            return (_columns == NULL) ? row(i)->getChildIndex(child) : _columns->getChildIndex(i, child);
+        }
+        bool getChildReversed(hal_index_t i, hal_size_t child) const {
+            return (_columns == NULL) ? row(i)->getChildReversed(_numChildren, child) : _columns->getChildReversed(i, child);
+        }
+        hal_index_t getTopParseIndex(hal_index_t i) const {
+            return (_columns == NULL) ? row(i)->getTopParseIndex() : _columns->getTopParseIndex(i);
+        }
+
+      private:
+        const MMapBottomSegmentData *row(hal_index_t i) const {
+            return reinterpret_cast<const MMapBottomSegmentData *>(_rows + i * _rowSize);
+        }
+        const Genome *_genome;
+        hal_size_t _numSegments;
+        hal_size_t _numChildren;
+        size_t _rowSize;
+        const char *_rows;                        // row layout
+        const MMapBottomSegmentColumns *_columns; // columnar layout, NULL for rows
+    };
+
+    class MMapTopSegmentAccess {
+      public:
+        explicit MMapTopSegmentAccess(const Genome *genome)
+            : _genome(genome), _numSegments(genome->getNumTopSegments()), _rows(NULL), _columns(NULL),
+              _childIndexInParent(NULL_INDEX) {
+            MMapGenome *mmapGenome = const_cast<MMapGenome *>(static_cast<const MMapGenome *>(genome));
+            assert(mmapGenome->hasDirectSegmentAccess());
+            if (_numSegments > 0) {
+                _columns = mmapGenome->getTopSegmentColumns(0);
+                if (_columns == NULL) {
+                    _rows = mmapGenome->getTopSegmentPointer(0);
+                }
+                _parentAccess = MMapBottomSegmentAccess(genome->getParent());
+                _childIndexInParent = genome->getParent()->getChildIndex(genome);
+            }
+        }
+        const Genome *getGenome() const {
+            return _genome;
+        }
+        hal_size_t getNumSegments() const {
+            return _numSegments;
+        }
+        hal_index_t getStartPosition(hal_index_t i) const {
+            return (_columns == NULL) ? _rows[i].getStartPosition() : _columns->getStartPosition(i);
+        }
+        hal_size_t getLength(hal_index_t i) const {
+            return getStartPosition(i + 1) - getStartPosition(i);
+        }
+        hal_index_t getParentIndex(hal_index_t i) const {
+            return (_columns == NULL) ? _rows[i].getParentIndex() : _columns->getParentIndex(i);
+        }
+        bool getParentReversed(hal_index_t i) const {
+            return (_columns == NULL) ? _rows[i].getReversed() : _columns->getReversed(i);
+        }
+        hal_index_t getBottomParseIndex(hal_index_t i) const {
+            return (_columns == NULL) ? _rows[i].getBottomParseIndex() : _columns->getBottomParseIndex(i);
+        }
+        hal_index_t getNextParalogyIndex(hal_index_t i) const {
+            return (_columns == NULL) ? _rows[i].getNextParalogyIndex() : _columns->getNextParalogyIndex(i);
+        }
+        /* same as MMapTopSegment::isCanonicalParalog */
+        bool isCanonicalParalog(hal_index_t i) const {
+            hal_index_t parentIndex = getParentIndex(i);
+            return (parentIndex != NULL_INDEX) && (_parentAccess.getChildIndex(parentIndex, _childIndexInParent) == i);
+        }
+
+      private:
+        const Genome *_genome;
+        hal_size_t _numSegments;
+        const MMapTopSegmentData *_rows;       // row layout
+        const MMapTopSegmentColumns *_columns; // columnar layout, NULL for rows
+        MMapBottomSegmentAccess _parentAccess; // for isCanonicalParalog
+        hal_index_t _childIndexInParent;
+    };
+
+    /* storage traits for mmap alignments with direct segment access */
+    struct MMapSegmentAccess {
+        typedef MMapTopSegmentAccess TopAccess;
+        typedef MMapBottomSegmentAccess BottomAccess;
+    };
+}
+#endif
+// Local Variables:
+// mode: c++
+// End:
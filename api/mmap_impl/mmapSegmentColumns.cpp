@@ -0,0 +1,115 @@
+#include "mmapSegmentColumns.h"
+#include "mmapAlignment.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+using namespace hal;
+
+/* number of bits needed to store a value */
+static unsigned bitsNeeded(uint64_t value) {
+    unsigned width = 0;
+    while (value != 0) {
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+static void writePackedBits(vector<uint64_t> &words, uint64_t bitPos, unsigned width, uint64_t value) {
+    if (width == 0) {
+        return;
+    }
+    uint64_t wordIdx = bitPos >> 6;
+    unsigned shift = bitPos & 63;
+    words[wordIdx] |= value << shift;
+    if (shift + width > 64) {
+        words[wordIdx + 1] |= value >> (64 - shift);
+    }
+}
+
+size_t hal::mmapPackIndexes(MMapAlignment *alignment, const hal_index_t *values, size_t numValues) {
+    // compute block headers, then pack into memory
+    size_t numBlocks = (numValues + MMAP_PACKED_BLOCK_SIZE - 1) / MMAP_PACKED_BLOCK_SIZE;
+    vector<MMapPackedBlock> blocks(numBlocks);
+    uint64_t numBits = 0;
+    for (size_t iBlock = 0; iBlock < numBlocks; iBlock++) {
+        const hal_index_t *first = values + iBlock * MMAP_PACKED_BLOCK_SIZE;
+        const hal_index_t *last = values + min(numValues, (iBlock + 1) * MMAP_PACKED_BLOCK_SIZE);
+        hal_index_t minValue = *min_element(first, last);
+        hal_index_t maxValue = *max_element(first, last);
+        unsigned width = bitsNeeded(uint64_t(maxValue) - uint64_t(minValue));
+        blocks[iBlock]._base = minValue;
+        blocks[iBlock]._bitOffsetWidth = (numBits << 8) | width;
+        numBits += width * (last - first);
+    }
+    vector<uint64_t> words(((numBits + 63) / 64) + 1, 0);
+    for (size_t i = 0; i < numValues; i++) {
+        const MMapPackedBlock &block = blocks[i / MMAP_PACKED_BLOCK_SIZE];
+        writePackedBits(words, block.getBitOffset() + (i % MMAP_PACKED_BLOCK_SIZE) * block.getWidth(), block.getWidth(),
+                        uint64_t(values[i]) - uint64_t(block._base));
+    }
+
+    // allocate all before resolving, as allocation can move the mapping
+    size_t arrayOffset = alignment->allocateNewArray(sizeof(MMapPackedArrayData));
+    size_t blocksOffset = alignment->allocateNewArray(numBlocks * sizeof(MMapPackedBlock));
+    size_t dataOffset = alignment->allocateNewArray(words.size() * sizeof(uint64_t));
+    MMapPackedArrayData *arrayData =
+        static_cast<MMapPackedArrayData *>(alignment->resolveOffset(arrayOffset, sizeof(MMapPackedArrayData)));
+    arrayData->_numValues = numValues;
+    arrayData->_blocksOffset = blocksOffset;
+    arrayData->_dataOffset = dataOffset;
+    if (numBlocks > 0) {
+        memcpy(alignment->resolveOffset(blocksOffset, numBlocks * sizeof(MMapPackedBlock)), blocks.data(),
+               numBlocks * sizeof(MMapPackedBlock));
+    }
+    memcpy(alignment->resolveOffset(dataOffset, words.size() * sizeof(uint64_t)), words.data(),
+           words.size() * sizeof(uint64_t));
+    return arrayOffset;
+}
+
+void hal::mmapPackedIndexesRegions(MMapAlignment *alignment, size_t packedOffset, MMapRegions &regions, size_t first,
+                                   size_t count) {
+    MMapPackedArrayData arrayData =
+        *static_cast<const MMapPackedArrayData *>(alignment->resolveOffset(packedOffset, sizeof(MMapPackedArrayData)));
+    regions.push_back({packedOffset, sizeof(MMapPackedArrayData)});
+    if ((count == 0) or (first >= arrayData._numValues)) {
+        return;
+    }
+    size_t firstBlock = first / MMAP_PACKED_BLOCK_SIZE;
+    size_t lastBlock = (min(count, arrayData._numValues - first) + first - 1) / MMAP_PACKED_BLOCK_SIZE;
+    MMapPackedBlock firstBlockData = *static_cast<const MMapPackedBlock *>(alignment->resolveOffset(
+        arrayData._blocksOffset + firstBlock * sizeof(MMapPackedBlock), sizeof(MMapPackedBlock)));
+    MMapPackedBlock lastBlockData = *static_cast<const MMapPackedBlock *>(alignment->resolveOffset(
+        arrayData._blocksOffset + lastBlock * sizeof(MMapPackedBlock), sizeof(MMapPackedBlock)));
+    size_t lastBlockSize = min(MMAP_PACKED_BLOCK_SIZE, arrayData._numValues - lastBlock * MMAP_PACKED_BLOCK_SIZE);
+    uint64_t firstWord = firstBlockData.getBitOffset() / 64;
+    // include the extra word that allows reading past the end
+    uint64_t endWord = ((lastBlockData.getBitOffset() + lastBlockSize * lastBlockData.getWidth() + 63) / 64) + 1;
+    regions.push_back({arrayData._blocksOffset + firstBlock * sizeof(MMapPackedBlock),
+                       (lastBlock - firstBlock + 1) * sizeof(MMapPackedBlock)});
+    regions.push_back({arrayData._dataOffset + firstWord * sizeof(uint64_t), (endWord - firstWord) * sizeof(uint64_t)});
+}
+
+void hal::mmapFetchPackedIndexes(MMapAlignment *alignment, size_t packedOffset, size_t first, size_t count) {
+    const MMapPackedArrayData *arrayData =
+        static_cast<const MMapPackedArrayData *>(alignment->resolveOffset(packedOffset, sizeof(MMapPackedArrayData)));
+    if ((count == 0) or (first >= arrayData->_numValues)) {
+        return;
+    }
+    size_t firstBlock = first / MMAP_PACKED_BLOCK_SIZE;
+    size_t lastBlock = (min(first + count, arrayData->_numValues) - 1) / MMAP_PACKED_BLOCK_SIZE;
+    size_t blocksOffset = arrayData->_blocksOffset, dataOffset = arrayData->_dataOffset;
+    const MMapPackedBlock *blocks = static_cast<const MMapPackedBlock *>(alignment->resolveOffset(
+        blocksOffset + firstBlock * sizeof(MMapPackedBlock), (lastBlock - firstBlock + 1) * sizeof(MMapPackedBlock)));
+    for (size_t iBlock = firstBlock; iBlock <= lastBlock; iBlock++) {
+        const MMapPackedBlock &block = blocks[iBlock - firstBlock];
+        size_t blockSize = min(MMAP_PACKED_BLOCK_SIZE, arrayData->_numValues - iBlock * MMAP_PACKED_BLOCK_SIZE);
+        uint64_t firstWord = block.getBitOffset() / 64;
+        uint64_t endWord = (block.getBitOffset() + blockSize * block.getWidth() + 63) / 64;
+        if (endWord > firstWord) {
+            alignment->resolveOffset(dataOffset + firstWord * sizeof(uint64_t), (endWord - firstWord) * sizeof(uint64_t));
+        }
+    }
+}
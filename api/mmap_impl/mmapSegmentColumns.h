@@ -0,0 +1,242 @@
+#ifndef _MMAPSEGMENTCOLUMNS_H
+#define _MMAPSEGMENTCOLUMNS_H
+#include "halDefs.h"
+#include "mmapFile.h"
+#include <cstdint>
+
+/*
+ * Columnar layouts of the top and bottom segment arrays, alternatives to
+ * the array of MMapTopSegmentData/MMapBottomSegmentData structures.
+ *
+ * MMAP_SEGMENT_LAYOUT_COLUMNS (mmap API 1.2) stores each field in a
+ * separate dense array, so that searching and scanning start positions
+ * doesn't pull the rest of the segment into cache.  Reversed flags are
+ * bit-packed.  All arrays have numSegments + 1 entries, the start
+ * position of the extra segment is the end of the last segment.
+ *
+ * MMAP_SEGMENT_LAYOUT_PACKED (mmap API 1.3) has the same columns, with
+ * the index columns compressed by frame-of-reference packing: each block
+ * of MMAP_PACKED_BLOCK_SIZE values is stored as the offset from the block
+ * minimum, using the number of bits needed for the largest offset.  The
+ * block headers act as a skip index, so any value is decoded in constant
+ * time.  Since the bit widths are only known once all values are set,
+ * index columns are kept in memory while being written and packed into
+ * the file when the alignment is closed, after which they are read-only.
+ * Reversed flags are written directly to the file.
+ *
+ * The genome's segments offset points to a MMapTopSegmentColumnsData or
+ * MMapBottomSegmentColumnsData record containing the offsets of the
+ * columns; for packed index columns these are offsets of
+ * MMapPackedArrayData records.  MMapTopSegmentColumns and
+ * MMapBottomSegmentColumns are the in-memory views of these.
+ */
+namespace hal {
+    class MMapAlignment;
+
+    /* number of 64-bit words to hold bit-packed flags */
+    inline size_t segmentFlagWords(size_t numFlags) {
+        return (numFlags + 63) / 64;
+    }
+    inline bool getSegmentFlag(const uint64_t *flags, size_t i) {
+        return (flags[i >> 6] >> (i & 63)) & 1;
+    }
+    /* file region holding flags [first, first + count) */
+    inline MMapRegion segmentFlagsRegion(size_t flagsOffset, size_t first, size_t count) {
+        size_t firstWord = first / 64;
+        return {flagsOffset + firstWord * sizeof(uint64_t), (segmentFlagWords(first + count) - firstWord) * sizeof(uint64_t)};
+    }
+    inline void setSegmentFlag(uint64_t *flags, size_t i, bool value) {
+        if (value) {
+            flags[i >> 6] |= (uint64_t(1) << (i & 63));
+        } else {
+            flags[i >> 6] &= ~(uint64_t(1) << (i & 63));
+        }
+    }
+
+    /* on-disk offsets of the top segment columns */
+    struct MMapTopSegmentColumnsData {
+        size_t _startPositionsOffset;
+        size_t _bottomParseIndexesOffset;
+        size_t _paralogyIndexesOffset;
+        size_t _parentIndexesOffset;
+        size_t _reversedFlagsOffset;
+    };
+
+    /* on-disk offsets of the bottom segment columns.  Child indexes
+     * and reversed flags are stored numChildren per segment. */
+    struct MMapBottomSegmentColumnsData {
+        size_t _numChildren;
+        size_t _startPositionsOffset;
+        size_t _topParseIndexesOffset;
+        size_t _childIndexesOffset;
+        size_t _childReversedFlagsOffset;
+    };
+
+    /* number of values in a frame-of-reference block */
+    static const size_t MMAP_PACKED_BLOCK_SIZE = 64;
+
+    /* on-disk header of a block of packed values */
+    struct MMapPackedBlock {
+        hal_index_t _base;        // minimum value in block
+        uint64_t _bitOffsetWidth; // bit offset of block in data << 8 | bits per value
+
+        uint64_t getBitOffset() const {
+            return _bitOffsetWidth >> 8;
+        }
+        unsigned getWidth() const {
+            return _bitOffsetWidth & 0xff;
+        }
+    };
+
+    /* on-disk packed array */
+    struct MMapPackedArrayData {
+        size_t _numValues;
+        size_t _blocksOffset; // array of MMapPackedBlock
+        size_t _dataOffset;   // array of uint64_t, with an extra word to allow reading past the end
+    };
+
+    /* Get width bits at bitPos from a bit-packed array */
+    inline uint64_t readPackedBits(const uint64_t *words, uint64_t bitPos, unsigned width) {
+        if (width == 0) {
+            return 0;
+        }
+        uint64_t wordIdx = bitPos >> 6;
+        unsigned shift = bitPos & 63;
+        uint64_t value = words[wordIdx] >> shift;
+        if (shift + width > 64) {
+            value |= words[wordIdx + 1] << (64 - shift);
+        }
+        return (width == 64) ? value : (value & ((uint64_t(1) << width) - 1));
+    }
+
+    /* pack an array of values into the file, returning the offset of the
+     * MMapPackedArrayData */
+    size_t mmapPackIndexes(MMapAlignment *alignment, const hal_index_t *values, size_t numValues);
+
+    /* fetch the blocks needed to access values [first, first+count) of a
+     * packed array, only needed with UDC */
+    void mmapFetchPackedIndexes(MMapAlignment *alignment, size_t packedOffset, size_t first, size_t count);
+
+    /* add the file regions occupied by values [first, first+count) of a
+     * packed array, by default the whole array */
+    void mmapPackedIndexesRegions(MMapAlignment *alignment, size_t packedOffset, MMapRegions &regions, size_t first = 0,
+                                  size_t count = SIZE_MAX);
+
+    /* a column of indexes or positions, either an array of values or a
+     * packed array */
+    class MMapIndexColumn {
+      public:
+        MMapIndexColumn() : _values(NULL), _blocks(NULL), _packedData(NULL) {
+        }
+        explicit MMapIndexColumn(hal_index_t *values) : _values(values), _blocks(NULL), _packedData(NULL) {
+        }
+        hal_index_t get(hal_index_t i) const {
+            if (_values != NULL) {
+                return _values[i];
+            }
+            const MMapPackedBlock &block = _blocks[i / MMAP_PACKED_BLOCK_SIZE];
+            return block._base + readPackedBits(_packedData,
+                                                block.getBitOffset() + (i % MMAP_PACKED_BLOCK_SIZE) * block.getWidth(),
+                                                block.getWidth());
+        }
+        void set(hal_index_t i, hal_index_t value) {
+            if (_values == NULL) {
+                throw hal_exception("segments in packed mmap layout can't be modified after the alignment is closed");
+            }
+            _values[i] = value;
+        }
+
+      private:
+        friend class MMapGenome;
+        hal_index_t *_values; // array of values, NULL if packed
+        const MMapPackedBlock *_blocks;
+        const uint64_t *_packedData;
+    };
+
+    class MMapTopSegmentColumns {
+      public:
+        MMapTopSegmentColumns() : _reversedFlags(NULL) {
+        }
+        hal_index_t getStartPosition(hal_index_t i) const {
+            return _startPositions.get(i);
+        }
+        hal_index_t getBottomParseIndex(hal_index_t i) const {
+            return _bottomParseIndexes.get(i);
+        }
+        hal_index_t getNextParalogyIndex(hal_index_t i) const {
+            return _paralogyIndexes.get(i);
+        }
+        hal_index_t getParentIndex(hal_index_t i) const {
+            return _parentIndexes.get(i);
+        }
+        bool getReversed(hal_index_t i) const {
+            return getSegmentFlag(_reversedFlags, i);
+        }
+        void setStartPosition(hal_index_t i, hal_index_t startPosition) {
+            _startPositions.set(i, startPosition);
+        }
+        void setBottomParseIndex(hal_index_t i, hal_index_t parseIndex) {
+            _bottomParseIndexes.set(i, parseIndex);
+        }
+        void setNextParalogyIndex(hal_index_t i, hal_index_t paralogyIndex) {
+            _paralogyIndexes.set(i, paralogyIndex);
+        }
+        void setParentIndex(hal_index_t i, hal_index_t parentIndex) {
+            _parentIndexes.set(i, parentIndex);
+        }
+        void setReversed(hal_index_t i, bool reversed) {
+            setSegmentFlag(_reversedFlags, i, reversed);
+        }
+
+      private:
+        friend class MMapGenome;
+        MMapIndexColumn _startPositions;
+        MMapIndexColumn _bottomParseIndexes;
+        MMapIndexColumn _paralogyIndexes;
+        MMapIndexColumn _parentIndexes;
+        uint64_t *_reversedFlags;
+    };
+
+    class MMapBottomSegmentColumns {
+      public:
+        MMapBottomSegmentColumns() : _numChildren(0), _childReversedFlags(NULL) {
+        }
+        hal_index_t getStartPosition(hal_index_t i) const {
+            return _startPositions.get(i);
+        }
+        hal_index_t getTopParseIndex(hal_index_t i) const {
+            return _topParseIndexes.get(i);
+        }
+        hal_index_t getChildIndex(hal_index_t i, hal_size_t child) const {
+            return _childIndexes.get(i * _numChildren + child);
+        }
+        bool getChildReversed(hal_index_t i, hal_size_t child) const {
+            return getSegmentFlag(_childReversedFlags, i * _numChildren + child);
+        }
+        void setStartPosition(hal_index_t i, hal_index_t startPosition) {
+            _startPositions.set(i, startPosition);
+        }
+        void setTopParseIndex(hal_index_t i, hal_index_t parseIndex) {
+            _topParseIndexes.set(i, parseIndex);
+        }
+        void setChildIndex(hal_index_t i, hal_size_t child, hal_index_t childIndex) {
+            _childIndexes.set(i * _numChildren + child, childIndex);
+        }
+        void setChildReversed(hal_index_t i, hal_size_t child, bool childReversed) {
+            setSegmentFlag(_childReversedFlags, i * _numChildren + child, childReversed);
+        }
+
+      private:
+        friend class MMapGenome;
+        hal_size_t _numChildren;
+        MMapIndexColumn _startPositions;
+        MMapIndexColumn _topParseIndexes;
+        MMapIndexColumn _childIndexes;
+        uint64_t *_childReversedFlags;
+    };
+
+}
+#endif
+// Local Variables:
+// mode: c++
+// End:
@@ -71,6 +71,14 @@ void MMapSequence::getSubString(std::string &outString, hal_size_t start, hal_si
     dnaIt->readString(outString, length);
 }
 
+void MMapSequence::getSubString(char *outBuffer, hal_size_t start, hal_size_t length, bool reversed) const {
+    if (length > 0) {
+        DnaIteratorPtr dnaIt(getDnaIterator(reversed ? start + length - 1 : start));
+        dnaIt->setReversed(reversed);
+        dnaIt->readBases(outBuffer, length);
+    }
+}
+
 void MMapSequence::setSubString(const std::string &inString, hal_size_t start, hal_size_t length) {
     if (length != inString.length()) {
         throw hal_exception("setString: input string of length " + std::to_string(inString.length()) +
@@ -9,19 +9,19 @@
 namespace hal {
     class MMapTopSegment : public TopSegment {
       public:
-        MMapTopSegment(MMapGenome *genome, hal_index_t arrayIndex)
-            : TopSegment(genome, arrayIndex), _data(getMMapGenome()->getTopSegmentPointer(arrayIndex)) {
+        MMapTopSegment(MMapGenome *genome, hal_index_t arrayIndex) : TopSegment(genome, arrayIndex) {
+            resolveData();
         }
 
         // SEGMENT INTERFACE
         void setArrayIndex(Genome *genome, hal_index_t arrayIndex) {
             _genome = genome;
-            _data = getMMapGenome()->getTopSegmentPointer(arrayIndex);
             _index = arrayIndex;
+            resolveData();
         }
         const Sequence *getSequence() const;
         hal_index_t getStartPosition() const {
-            return _data->getStartPosition();
+            return (_columns == NULL) ? _data->getStartPosition() : _columns->getStartPosition(_index);
         };
         hal_index_t getEndPosition() const;
         hal_size_t getLength() const;
@@ -33,32 +33,48 @@ namespace hal {
 
         // TOP SEGMENT INTERFACE
         hal_index_t getParentIndex() const {
-            return _data->getParentIndex();
+            return (_columns == NULL) ? _data->getParentIndex() : _columns->getParentIndex(_index);
         };
         bool hasParent() const;
         void setParentIndex(hal_index_t parIdx) {
-            _data->setParentIndex(parIdx);
+            if (_columns == NULL) {
+                _data->setParentIndex(parIdx);
+            } else {
+                _columns->setParentIndex(_index, parIdx);
+            }
         };
         bool getParentReversed() const {
-            return _data->getReversed();
+            return (_columns == NULL) ? _data->getReversed() : _columns->getReversed(_index);
         };
         void setParentReversed(bool isReversed) {
-            _data->setReversed(isReversed);
+            if (_columns == NULL) {
+                _data->setReversed(isReversed);
+            } else {
+                _columns->setReversed(_index, isReversed);
+            }
         };
         hal_index_t getBottomParseIndex() const {
-            return _data->getBottomParseIndex();
+            return (_columns == NULL) ? _data->getBottomParseIndex() : _columns->getBottomParseIndex(_index);
         };
         void setBottomParseIndex(hal_index_t botParseIdx) {
-            _data->setBottomParseIndex(botParseIdx);
+            if (_columns == NULL) {
+                _data->setBottomParseIndex(botParseIdx);
+            } else {
+                _columns->setBottomParseIndex(_index, botParseIdx);
+            }
         };
         hal_offset_t getBottomParseOffset() const;
         bool hasParseDown() const;
         hal_index_t getNextParalogyIndex() const {
-            return _data->getNextParalogyIndex();
+            return (_columns == NULL) ? _data->getNextParalogyIndex() : _columns->getNextParalogyIndex(_index);
         }
         bool hasNextParalogy() const;
         void setNextParalogyIndex(hal_index_t parIdx) {
-            _data->setNextParalogyIndex(parIdx);
+            if (_columns == NULL) {
+                _data->setNextParalogyIndex(parIdx);
+            } else {
+                _columns->setNextParalogyIndex(_index, parIdx);
+            }
         };
         hal_index_t getLeftParentIndex() const;
         hal_index_t getRightParentIndex() const;
@@ -68,7 +84,15 @@ namespace hal {
         MMapGenome *getMMapGenome() const {
             return static_cast<MMapGenome *>(_genome);
         }
-        MMapTopSegmentData *_data;
+        void resolveData() {
+            _columns = getMMapGenome()->getTopSegmentColumns(_index);
+            _data = (_columns == NULL) ? getMMapGenome()->getTopSegmentPointer(_index) : NULL;
+        }
+        hal_index_t getNextStartPosition() const {
+            return (_columns == NULL) ? (_data + 1)->getStartPosition() : _columns->getStartPosition(_index + 1);
+        }
+        MMapTopSegmentData *_data;       // row layout
+        MMapTopSegmentColumns *_columns; // columnar layout, NULL for rows
     };
 
     inline hal_index_t MMapTopSegment::getEndPosition() const {
@@ -76,7 +100,7 @@ namespace hal {
     }
 
     inline hal_size_t MMapTopSegment::getLength() const {
-        return (_data + 1)->getStartPosition() - _data->getStartPosition();
+        return getNextStartPosition() - getStartPosition();
     }
 
     inline const Sequence *MMapTopSegment::getSequence() const {
@@ -21,6 +21,9 @@ using namespace hal;
  */
 static string storageDriverToTest;
 
+const string TEST_STORAGE_FORMAT_MMAP_COLUMNAR = "mmapColumnar";
+const string TEST_STORAGE_FORMAT_MMAP_PACKED = "mmapPacked";
+
 AlignmentPtr getTestAlignmentInstances(const std::string &storageFormat, const std::string &alignmentPath, unsigned mode) {
     if (storageFormat == STORAGE_FORMAT_HDF5) {
         return AlignmentPtr(hdf5AlignmentInstance(alignmentPath, mode, hdf5DefaultFileCreatPropList(), hdf5DefaultFileAccPropList(),
@@ -30,6 +33,11 @@ AlignmentPtr getTestAlignmentInstances(const std::string &storageFormat, const s
         // We use a default init size of only 1GiB here, because the test
         // alignments we create are relatively small.
         return AlignmentPtr(mmapAlignmentInstance(alignmentPath, mode, 1024 * 1024 * 1024));
+    } else if (storageFormat == TEST_STORAGE_FORMAT_MMAP_COLUMNAR) {
+        return AlignmentPtr(mmapAlignmentInstance(alignmentPath, mode, 1024 * 1024 * 1024, MMAP_SEGMENT_LAYOUT_COLUMNS));
+    } else if (storageFormat == TEST_STORAGE_FORMAT_MMAP_PACKED) {
+        return AlignmentPtr(mmapAlignmentInstance(alignmentPath, mode, 1024 * 1024 * 1024, MMAP_SEGMENT_LAYOUT_PACKED,
+                                                  MMAP_DNA_LAYOUT_TWO_BIT));
     } else {
         throw hal_exception("invalid storage format: " + storageFormat);
     }
@@ -43,9 +51,12 @@ int runHalTestSuite(int argc, char *argv[], CuSuite *suite) {
         return 1;
     } else if (argc == 2) {
         storageDriverToTest = argv[1];
-        if (not((storageDriverToTest == hal::STORAGE_FORMAT_HDF5) or (storageDriverToTest == hal::STORAGE_FORMAT_MMAP))) {
+        if (not((storageDriverToTest == hal::STORAGE_FORMAT_HDF5) or (storageDriverToTest == hal::STORAGE_FORMAT_MMAP) or
+                (storageDriverToTest == TEST_STORAGE_FORMAT_MMAP_COLUMNAR) or
+                (storageDriverToTest == TEST_STORAGE_FORMAT_MMAP_PACKED))) {
             cerr << "Invalid storage driver '" << storageDriverToTest << "', expected on of: " << hal::STORAGE_FORMAT_HDF5
-                      << " or " << hal::STORAGE_FORMAT_MMAP << endl;
+                      << ", " << hal::STORAGE_FORMAT_MMAP << ", " << TEST_STORAGE_FORMAT_MMAP_COLUMNAR << " or "
+                      << TEST_STORAGE_FORMAT_MMAP_PACKED << endl;
             return 1;
         }
     } else {
@@ -116,6 +127,12 @@ void AlignmentTest::check(CuTest *testCase) {
         if (storageDriverToTest.empty() or (storageDriverToTest == STORAGE_FORMAT_MMAP)) {
             checkOne(testCase, STORAGE_FORMAT_MMAP);
         }
+        if (storageDriverToTest.empty() or (storageDriverToTest == TEST_STORAGE_FORMAT_MMAP_COLUMNAR)) {
+            checkOne(testCase, TEST_STORAGE_FORMAT_MMAP_COLUMNAR);
+        }
+        if (storageDriverToTest.empty() or (storageDriverToTest == TEST_STORAGE_FORMAT_MMAP_PACKED)) {
+            checkOne(testCase, TEST_STORAGE_FORMAT_MMAP_PACKED);
+        }
     } catch (const exception &e) {
         CuFail(testCase, stString_print("Caught exception while testing: %s", e.what()));
     }
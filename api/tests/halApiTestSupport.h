@@ -18,6 +18,10 @@ extern "C" {
 using namespace hal;
 using namespace std;
 
+/* test-only storage driver name for mmap with the columnar segment layout */
+extern const string TEST_STORAGE_FORMAT_MMAP_COLUMNAR;
+extern const string TEST_STORAGE_FORMAT_MMAP_PACKED;
+
 AlignmentPtr getTestAlignmentInstances(const string &storageFormat, const string &alignmentPath, unsigned mode);
 
 /** parse command line and run a test suite for the given storage driver,
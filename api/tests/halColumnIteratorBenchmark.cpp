@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "hal.h"
+#include "halApiTestSupport.h"
+#include "halCLParser.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * Profile column iteration as done by hal2maf: time and count of heap
+ * allocations per column, and the number of stack entries, links and
+ * iterators recycled by the ColumnIterator rather than allocated.  Each
+ * sequence of the reference genome is walked with a ColumnIterator until
+ * the requested number of columns is reached.  A random alignment is
+ * created unless an existing HAL file is given.
+ */
+
+/* all allocations made by the program are counted */
+static size_t numAllocs = 0;
+
+void *operator new(size_t size) {
+    numAllocs++;
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == NULL) {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.setDescription("Profile allocations of hal2maf-style column iteration");
+    optionsParser.addOption("halFile", "existing HAL file to use rather than a random alignment", "");
+    optionsParser.addOption("refGenome", "reference genome (default: root)", "");
+    optionsParser.addOption("seed", "random number seed", 0);
+    optionsParser.addOption("minGenomes", "minimum number of genomes in random alignment", 8);
+    optionsParser.addOption("maxGenomes", "maximum number of genomes in random alignment", 12);
+    optionsParser.addOption("numSegments", "number of segments per sequence in random alignment", 5000);
+    optionsParser.addOption("numColumns", "maximum number of columns to visit", 1000000);
+    optionsParser.addOption("maxRefGap", "maximum gap length in reference, as for hal2maf", 0);
+    optionsParser.addOptionFlag("noDupes", "don't follow paralogy edges", false);
+    optionsParser.addOption("tmpDir", "directory for temporary HAL files", "/tmp");
+}
+
+static void createAlignment(const string &halPath, const CLParser &optionsParser) {
+    RandNumberGen rng(false, optionsParser.getOption<int>("seed"));
+    AlignmentPtr alignment(getTestAlignmentInstances(STORAGE_FORMAT_MMAP, halPath, CREATE_ACCESS));
+    hal_size_t numSegments = optionsParser.getOption<hal_size_t>("numSegments");
+    createRandomAlignment(rng, alignment, 1.5, 0.3, optionsParser.getOption<hal_size_t>("minGenomes"),
+                          optionsParser.getOption<hal_size_t>("maxGenomes"), 10, 200, numSegments, numSegments);
+    alignment->close();
+}
+
+struct ColumnCounts {
+    ColumnCounts() : _numColumns(0), _numBases(0), _checksum(0) {
+    }
+    hal_size_t _numColumns;
+    hal_size_t _numBases;
+    hal_size_t _checksum;
+    ColumnIteratorStack::PoolStats _poolStats;
+};
+
+/* visit the columns of the reference genome the way MafExport does */
+static ColumnCounts iterateColumns(const Genome *refGenome, hal_size_t maxColumns, hal_size_t maxRefGap, bool noDupes) {
+    ColumnCounts counts;
+    for (SequenceIteratorPtr seqIt(refGenome->getSequenceIterator()); not seqIt->atEnd() && counts._numColumns < maxColumns;
+         seqIt->toNext()) {
+        const Sequence *sequence = seqIt->getSequence();
+        if (sequence->getSequenceLength() == 0) {
+            continue;
+        }
+        hal_size_t length = min(sequence->getSequenceLength(), maxColumns - counts._numColumns);
+        ColumnIteratorPtr colIt = sequence->getColumnIterator(NULL, maxRefGap, 0, length - 1, noDupes);
+        while (true) {
+            for (const ColumnIterator::Row &row : colIt->getRows()) {
+                counts._numBases++;
+                counts._checksum += row._dna->getArrayIndex() + (row._dna->getReversed() ? 1 : 0);
+            }
+            counts._numColumns++;
+            if (colIt->lastColumn()) {
+                break;
+            }
+            colIt->toRight();
+        }
+        counts._poolStats._created += colIt->getPoolStats()._created;
+        counts._poolStats._reused += colIt->getPoolStats()._reused;
+    }
+    return counts;
+}
+
+static void runBenchmark(const string &halPath, const CLParser &optionsParser) {
+    AlignmentPtr alignment(openHalAlignment(halPath, &optionsParser));
+    string refName = optionsParser.getOption<string>("refGenome");
+    const Genome *refGenome = alignment->openGenome(refName.empty() ? alignment->getRootName() : refName);
+    if (refGenome == NULL) {
+        throw hal_exception("reference genome not found");
+    }
+    size_t startAllocs = numAllocs;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ColumnCounts counts = iterateColumns(refGenome, optionsParser.getOption<hal_size_t>("numColumns"),
+                                         optionsParser.getOption<hal_size_t>("maxRefGap"), optionsParser.getFlag("noDupes"));
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    size_t allocs = numAllocs - startAllocs;
+    cout << setw(10) << "secs" << setw(14) << "columns/sec" << setw(14) << "allocs" << setw(14) << "allocs/col"
+         << setw(12) << "created" << setw(12) << "reused" << setw(16) << "checksum" << endl;
+    cout << setw(10) << fixed << setprecision(3) << secs << setprecision(0) << setw(14) << counts._numColumns / secs
+         << setw(14) << allocs << setw(14) << setprecision(2) << double(allocs) / counts._numColumns << setw(12)
+         << counts._poolStats._created << setw(12) << counts._poolStats._reused << setw(16) << counts._checksum << endl;
+    alignment->close();
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser(CREATE_ACCESS);
+    initParser(optionsParser);
+    try {
+        optionsParser.parseOptions(argc, argv);
+    } catch (hal_exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+    try {
+        string halPath = optionsParser.getOption<string>("halFile");
+        bool randomAlignment = halPath.empty();
+        if (randomAlignment) {
+            halPath = optionsParser.getOption<string>("tmpDir") + "/halColumnIteratorBenchmark.hal";
+            createAlignment(halPath, optionsParser);
+        }
+        runBenchmark(halPath, optionsParser);
+        if (randomAlignment) {
+            ::remove(halPath.c_str());
+        }
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -931,6 +931,159 @@ struct ColumnIteratorMultiGapInvTest : public AlignmentTest {
     }
 };
 
+struct ColumnIteratorBlockTest : public AlignmentTest {
+    void createCallBack(AlignmentPtr alignment) {
+        createRandomAlignment(rng, alignment, 1.5, 0.7, 3, 5, 10, 100, 5, 20);
+    }
+
+    typedef vector<ColumnBlockIterator::Row> Column;
+
+    Column getColumn(const ColumnIterator *colIt) {
+        Column column;
+        for (const auto &seqDna : *colIt->getColumnMap()) {
+            for (const DnaIteratorPtr &dnaIt : *seqDna.second) {
+                column.push_back(ColumnBlockIterator::Row(seqDna.first, dnaIt->getArrayIndex(), dnaIt->getReversed()));
+            }
+        }
+        return column;
+    }
+
+    bool sameColumn(const Column &column, const ColumnBlockIterator::Rows &rows, hal_size_t i) {
+        if (column.size() != rows.size()) {
+            return false;
+        }
+        for (size_t j = 0; j < rows.size(); ++j) {
+            if ((column[j]._sequence != rows[j]._sequence) || (column[j]._reversed != rows[j]._reversed) ||
+                (column[j]._start != rows[j].getPosition(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    vector<Column> getColumns(const Sequence *sequence, bool noDupes, bool reversed) {
+        vector<Column> columns;
+        ColumnIteratorPtr colIt =
+            sequence->getColumnIterator(NULL, 0, 0, sequence->getSequenceLength() - 1, noDupes, false, reversed);
+        while (true) {
+            columns.push_back(getColumn(colIt.get()));
+            if (colIt->lastColumn()) {
+                break;
+            }
+            colIt->toRight();
+        }
+        return columns;
+    }
+
+    /* skipping the gapless runs must land on the same columns */
+    void checkSkip(const Sequence *sequence, bool noDupes, bool reversed) {
+        vector<Column> columns = getColumns(sequence, noDupes, reversed);
+        ColumnIteratorPtr colIt =
+            sequence->getColumnIterator(NULL, 0, 0, sequence->getSequenceLength() - 1, noDupes, false, reversed);
+        size_t i = 0;
+        while (true) {
+            CuAssertTrue(_testCase, sameColumn(columns[i], getColumn(colIt.get()), 0));
+            hal_size_t run = colIt->getGaplessLength();
+            CuAssertTrue(_testCase, run >= 1 && i + run <= columns.size());
+            if (i + run == columns.size()) {
+                break;
+            }
+            colIt->toRight(run);
+            i += run;
+        }
+    }
+
+    /* the blocks must expand to the columns of the column iterator */
+    void checkBlocks(const Sequence *sequence, bool noDupes) {
+        vector<Column> columns = getColumns(sequence, noDupes, false);
+        ColumnBlockIterator blockIt(sequence, NULL, 0, sequence->getSequenceLength() - 1, noDupes);
+        size_t i = 0;
+        while (true) {
+            CuAssertTrue(_testCase, blockIt.getReferenceSequencePosition() == (hal_index_t)i);
+            CuAssertTrue(_testCase, blockIt.getLength() > 0 && i + blockIt.getLength() <= columns.size());
+            for (hal_size_t j = 0; j < blockIt.getLength(); ++j) {
+                CuAssertTrue(_testCase, sameColumn(columns[i + j], blockIt.getRows(), j));
+            }
+            i += blockIt.getLength();
+            if (blockIt.lastBlock()) {
+                break;
+            }
+            blockIt.toRight();
+        }
+        CuAssertTrue(_testCase, i == columns.size());
+        CuAssertTrue(_testCase, blockIt.getNumColumnsComputed() <= columns.size());
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        vector<string> names = alignment->getChildNames(alignment->getRootName());
+        names.push_back(alignment->getRootName());
+        for (const string &name : names) {
+            const Genome *genome = alignment->openGenome(name);
+            for (SequenceIteratorPtr seqIt = genome->getSequenceIterator(); not seqIt->atEnd(); seqIt->toNext()) {
+                const Sequence *sequence = seqIt->getSequence();
+                if (sequence->getSequenceLength() > 0) {
+                    for (bool noDupes : {false, true}) {
+                        checkSkip(sequence, noDupes, false);
+                        checkSkip(sequence, noDupes, true);
+                        checkBlocks(sequence, noDupes);
+                    }
+                }
+            }
+        }
+    }
+};
+
+struct ColumnIteratorRowsTest : public AlignmentTest {
+    void createCallBack(AlignmentPtr alignment) {
+        createRandomAlignment(rng, alignment, 1.5, 0.7, 3, 6, 10, 100, 5, 20);
+    }
+
+    /* rows must be in SequenceLess order, then in the order visited, and
+     * the column map must group them by sequence, with empty entries for
+     * sequences of earlier columns */
+    void checkColumn(const ColumnIterator *colIt) {
+        const ColumnIterator::Rows &rows = colIt->getRows();
+        ColumnIterator::SequenceLess sequenceLess;
+        for (size_t i = 1; i < rows.size(); ++i) {
+            CuAssertTrue(_testCase, not sequenceLess(rows[i]._sequence, rows[i - 1]._sequence));
+            if (rows[i]._sequence == rows[i - 1]._sequence) {
+                CuAssertTrue(_testCase, rows[i]._visit > rows[i - 1]._visit);
+            } else {
+                CuAssertTrue(_testCase, sequenceLess(rows[i - 1]._sequence, rows[i]._sequence));
+            }
+        }
+        const ColumnIterator::ColumnMap *colMap = colIt->getColumnMap();
+        size_t i = 0;
+        for (ColumnIterator::ColumnMap::const_iterator c = colMap->begin(); c != colMap->end(); ++c) {
+            CuAssertTrue(_testCase, colMap->find(c->first) == c);
+            CuAssertTrue(_testCase, c == colMap->begin() || sequenceLess((c - 1)->first, c->first));
+            for (const DnaIteratorPtr &dnaIt : *c->second) {
+                CuAssertTrue(_testCase, i < rows.size() && rows[i]._sequence == c->first && rows[i]._dna == dnaIt);
+                ++i;
+            }
+        }
+        CuAssertTrue(_testCase, i == rows.size());
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        vector<string> names = alignment->getChildNames(alignment->getRootName());
+        names.push_back(alignment->getRootName());
+        for (const string &name : names) {
+            const Genome *genome = alignment->openGenome(name);
+            for (hal_size_t maxInsertLength : {0, 10}) {
+                ColumnIteratorPtr colIt = genome->getColumnIterator(NULL, maxInsertLength);
+                while (true) {
+                    checkColumn(colIt.get());
+                    if (colIt->lastColumn()) {
+                        break;
+                    }
+                    colIt->toRight();
+                }
+            }
+        }
+    }
+};
+
 struct ColumnIteratorPositionCacheTest : public AlignmentTest {
     void createCallBack(AlignmentPtr alignment) {
         alignment->addRootGenome("foobar");
@@ -1000,6 +1153,16 @@ static void halColumnIteratorMultiGapInvTest(CuTest *testCase) {
     tester.check(testCase);
 }
 
+static void halColumnIteratorBlockTest(CuTest *testCase) {
+    ColumnIteratorBlockTest tester;
+    tester.check(testCase);
+}
+
+static void halColumnIteratorRowsTest(CuTest *testCase) {
+    ColumnIteratorRowsTest tester;
+    tester.check(testCase);
+}
+
 static void halColumnIteratorPositionCacheTest(CuTest *testCase) {
     ColumnIteratorPositionCacheTest tester;
     tester.check(testCase);
@@ -1014,6 +1177,8 @@ static CuSuite *halColumnIteratorTestSuite(void) {
     SUITE_ADD_TEST(suite, halColumnIteratorGapTest);
     SUITE_ADD_TEST(suite, halColumnIteratorMultiGapTest);
     SUITE_ADD_TEST(suite, halColumnIteratorMultiGapInvTest);
+    SUITE_ADD_TEST(suite, halColumnIteratorBlockTest);
+    SUITE_ADD_TEST(suite, halColumnIteratorRowsTest);
     SUITE_ADD_TEST(suite, halColumnIteratorPositionCacheTest);
     return suite;
 }
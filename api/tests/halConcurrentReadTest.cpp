@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halApiTestSupport.h"
+#include "hal.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace hal;
+
+static RandNumberGen rng;
+
+static const int NUM_THREADS = 8;
+static const int NUM_QUERIES_PER_GENOME = 200;
+
+/* a query is a genome and position; the result is summarized as a string */
+struct ConcurrentQuery {
+    string _genomeName;
+    hal_index_t _position;
+    string _expect;
+};
+
+/* compute a summary of everything we can look up at a site, each call
+ * opens the genome and creates its own iterators */
+static string querySite(const Alignment *alignment, const ConcurrentQuery &query) {
+    const Genome *genome = alignment->openGenome(query._genomeName);
+    const Genome *root = alignment->openGenome(alignment->getRootName());
+    ostringstream sig;
+
+    const Sequence *sequence = genome->getSequenceBySite(query._position);
+    sig << sequence->getName() << " " << genome->getSequence(sequence->getName())->getStartPosition();
+
+    string dna;
+    hal_size_t dnaLen = min(hal_size_t(16), genome->getSequenceLength() - query._position);
+    DnaIteratorPtr dnaIt = genome->getDnaIterator(query._position);
+    dnaIt->readString(dna, dnaLen);
+    sig << " " << dna;
+
+    if (genome->getNumTopSegments() > 0) {
+        TopSegmentIteratorPtr topIt = genome->getTopSegmentIterator();
+        topIt->toSite(query._position);
+        sig << " t" << topIt->getArrayIndex() << "," << topIt->tseg()->getParentIndex();
+        if (topIt->tseg()->hasParent()) {
+            BottomSegmentIteratorPtr parIt = genome->getParent()->getBottomSegmentIterator();
+            parIt->toParent(topIt);
+            sig << " p" << parIt->getStartPosition() << "," << parIt->getReversed();
+        }
+        MappedSegmentSet mappedSegments;
+        halMapSegmentSP(topIt, mappedSegments, root);
+        for (const MappedSegmentPtr &mappedSeg : mappedSegments) {
+            sig << " m" << mappedSeg->getStartPosition() << "," << mappedSeg->getLength();
+        }
+    }
+    if (genome->getNumBottomSegments() > 0) {
+        BottomSegmentIteratorPtr botIt = genome->getBottomSegmentIterator();
+        botIt->toSite(query._position);
+        sig << " b" << botIt->getArrayIndex();
+        for (hal_size_t i = 0; i < botIt->bseg()->getNumChildren(); i++) {
+            sig << "," << botIt->bseg()->getChildIndex(i);
+        }
+    }
+    return sig.str();
+}
+
+/* run all queries in a thread, counting mismatches and errors */
+static void runQueries(const Alignment *alignment, const vector<ConcurrentQuery> *queries, int threadNum,
+                       atomic<int> *numFailed) {
+    try {
+        // start at a different place in each thread to vary the interleaving
+        size_t start = (threadNum * queries->size()) / NUM_THREADS;
+        for (size_t i = 0; i < queries->size(); i++) {
+            const ConcurrentQuery &query = (*queries)[(start + i) % queries->size()];
+            if (querySite(alignment, query) != query._expect) {
+                (*numFailed)++;
+            }
+        }
+    } catch (const exception &ex) {
+        cerr << "thread " << threadNum << ": " << ex.what() << endl;
+        (*numFailed)++;
+    }
+}
+
+struct ConcurrentReadTest : public AlignmentTest {
+    void createCallBack(AlignmentPtr alignment) {
+        createRandomAlignment(rng, alignment, 1.25, 0.7, 5, 10, 10, 200, 20, 200);
+    }
+
+    /* get all genome names, root first */
+    vector<string> getGenomeNames(AlignmentConstPtr alignment) {
+        vector<string> names;
+        deque<string> queue(1, alignment->getRootName());
+        while (not queue.empty()) {
+            names.push_back(queue.front());
+            queue.pop_front();
+            for (const string &child : alignment->getChildNames(names.back())) {
+                queue.push_back(child);
+            }
+        }
+        return names;
+    }
+
+    vector<ConcurrentQuery> makeQueries(AlignmentConstPtr alignment) {
+        vector<ConcurrentQuery> queries;
+        for (const string &name : getGenomeNames(alignment)) {
+            const Genome *genome = alignment->openGenome(name);
+            if (genome->getSequenceLength() == 0) {
+                continue;
+            }
+            for (int i = 0; i < NUM_QUERIES_PER_GENOME; i++) {
+                ConcurrentQuery query;
+                query._genomeName = name;
+                query._position = rng.getRandInt(0, genome->getSequenceLength() - 1);
+                query._expect = querySite(alignment.get(), query);
+                queries.push_back(query);
+            }
+        }
+        return queries;
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        if (alignment->getStorageFormat() != STORAGE_FORMAT_MMAP) {
+            bool threw = false;
+            try {
+                getTestAlignmentInstances(alignment->getStorageFormat(), _checkPath, READ_ACCESS | CONCURRENT_READ_ACCESS);
+            } catch (const hal_exception &ex) {
+                threw = true;
+            }
+            CuAssertTrue(_testCase, threw);
+            return;
+        }
+
+        // expected results computed from a normal, single-threaded open
+        vector<ConcurrentQuery> queries = makeQueries(alignment);
+        CuAssertTrue(_testCase, queries.size() > 0);
+
+        AlignmentPtr shared = getTestAlignmentInstances(STORAGE_FORMAT_MMAP, _checkPath, READ_ACCESS | CONCURRENT_READ_ACCESS);
+        atomic<int> numFailed(0);
+        vector<thread> threads;
+        for (int i = 0; i < NUM_THREADS; i++) {
+            threads.push_back(thread(runQueries, shared.get(), &queries, i, &numFailed));
+        }
+        for (thread &t : threads) {
+            t.join();
+        }
+        CuAssertTrue(_testCase, numFailed == 0);
+
+        // genomes are unique objects and unknown names are still handled
+        for (const string &name : getGenomeNames(alignment)) {
+            CuAssertTrue(_testCase, shared->openGenome(name) == shared->openGenome(name));
+        }
+        CuAssertTrue(_testCase, shared->openGenome("noSuchGenome") == NULL);
+        shared->close();
+    }
+};
+
+static void halConcurrentReadTest(CuTest *testCase) {
+    ConcurrentReadTest tester;
+    tester.check(testCase);
+}
+
+static CuSuite *halConcurrentReadTestSuite(void) {
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, halConcurrentReadTest);
+    return suite;
+}
+
+int main(int argc, char *argv[]) {
+    return runHalTestSuite(argc, argv, halConcurrentReadTestSuite());
+}
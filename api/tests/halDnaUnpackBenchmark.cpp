@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "hal.h"
+#include "halCLParser.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * Compare decoding nibble-packed DNA one base at a time with dnaUnpack()
+ * against the bulk dnaUnpackString(), forward and reverse complement,
+ * reporting the decode rate in GB/s of output bases.
+ */
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.setDescription("Benchmark bulk DNA decoding");
+    optionsParser.addOption("seed", "random number seed", 0);
+    optionsParser.addOption("numBases", "number of bases to decode per pass", 64 * 1024 * 1024);
+    optionsParser.addOption("numPasses", "number of passes over the bases", 10);
+}
+
+static double elapsedSecs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/* per-base decode, the same as DnaIterator::readString() did */
+static void unpackPerBase(const vector<char> &packed, hal_index_t first, hal_size_t length, bool reverseComplement,
+                          char *out) {
+    if (not reverseComplement) {
+        for (hal_size_t i = 0; i < length; i++) {
+            hal_index_t j = first + i;
+            out[i] = dnaUnpack(j, packed[j / 2]);
+        }
+    } else {
+        for (hal_size_t i = 0; i < length; i++) {
+            hal_index_t j = first + length - 1 - i;
+            out[i] = hal::reverseComplement(dnaUnpack(j, packed[j / 2]));
+        }
+    }
+}
+
+/* run one method, returning GB/s; the checksum keeps the compiler honest and
+ * must match between methods */
+static double runBenchmark(const vector<char> &packed, hal_size_t numBases, hal_size_t numPasses, bool bulk,
+                           bool reverseComplement, hal_size_t &checksum) {
+    vector<char> out(numBases);
+    checksum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (hal_size_t pass = 0; pass < numPasses; pass++) {
+        // vary the start so both odd and even alignments are timed
+        hal_index_t first = pass & 1;
+        hal_size_t length = numBases - first;
+        if (bulk) {
+            dnaUnpackString(packed.data(), first, length, reverseComplement, out.data());
+        } else {
+            unpackPerBase(packed, first, length, reverseComplement, out.data());
+        }
+        checksum += out[0] + out[length / 2] + out[length - 1];
+    }
+    return double(numBases) * numPasses / elapsedSecs(start) / 1.0e9;
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser;
+    initParser(optionsParser);
+    try {
+        optionsParser.parseOptions(argc, argv);
+    } catch (hal_exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+    try {
+        srand(optionsParser.getOption<int>("seed"));
+        hal_size_t numBases = optionsParser.getOption<hal_size_t>("numBases");
+        hal_size_t numPasses = optionsParser.getOption<hal_size_t>("numPasses");
+        if (numBases < 2) {
+            throw hal_exception("--numBases must be at least 2");
+        }
+        const string bases = "ACGTacgtN";
+        vector<char> packed((numBases + 1) / 2);
+        for (hal_size_t i = 0; i < numBases; i++) {
+            packed[i / 2] = dnaPack(bases[rand() % bases.size()], i, packed[i / 2]);
+        }
+
+        cout << setw(10) << "direction" << setw(14) << "perBaseGB/s" << setw(14) << "bulkGB/s" << setw(10) << "speedup"
+             << endl;
+        for (bool reverseComplement : {false, true}) {
+            hal_size_t perBaseChecksum, bulkChecksum;
+            double perBaseRate = runBenchmark(packed, numBases, numPasses, false, reverseComplement, perBaseChecksum);
+            double bulkRate = runBenchmark(packed, numBases, numPasses, true, reverseComplement, bulkChecksum);
+            cout << setw(10) << (reverseComplement ? "revcomp" : "forward") << setw(14) << fixed << setprecision(3)
+                 << perBaseRate << setw(14) << bulkRate << setw(10) << setprecision(1) << bulkRate / perBaseRate << endl;
+            if (perBaseChecksum != bulkChecksum) {
+                throw hal_exception("checksums differ between decoding methods");
+            }
+        }
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -144,6 +144,83 @@ struct GenomeStringTest : public AlignmentTest {
     }
 };
 
+/* long runs of N and lower-case bases, as found in assemblies, which
+ * cross buffer boundaries in storage drivers */
+struct GenomeDnaRunsTest : public AlignmentTest {
+    std::string _string;
+    void createCallBack(AlignmentPtr alignment) {
+        hal_size_t seqLength = 100003;
+        Genome *ancGenome = alignment->addRootGenome("AncGenome", 0);
+        vector<Sequence::Info> seqVec(2);
+        seqVec[0] = Sequence::Info("Sequence1", seqLength / 2, 0, 0);
+        seqVec[1] = Sequence::Info("Sequence2", seqLength - (seqLength / 2), 0, 0);
+        ancGenome->setDimensions(seqVec);
+
+        const string bases = "ACGT";
+        _string.resize(seqLength);
+        for (hal_size_t i = 0; i < seqLength; ++i) {
+            _string[i] = bases[rand() % 4];
+        }
+        for (hal_size_t start = 0; start < seqLength; start += 1 + rand() % 20000) {
+            hal_size_t end = min(seqLength, start + rand() % 10000);
+            bool isN = (rand() % 2) == 0, isLower = (rand() % 2) == 0;
+            for (hal_size_t i = start; i < end; ++i) {
+                if (isN) {
+                    _string[i] = 'N';
+                }
+                if (isLower) {
+                    _string[i] = tolower(_string[i]);
+                }
+            }
+        }
+        _string[0] = 'n';
+        _string[seqLength - 1] = 'N';
+        ancGenome->setString(_string);
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        const Genome *ancGenome = alignment->openGenome("AncGenome");
+        string genomeString;
+        ancGenome->getString(genomeString);
+        CuAssertTrue(_testCase, genomeString == _string);
+
+        string subString;
+        ancGenome->getSubString(subString, 4093, 9000);
+        CuAssertTrue(_testCase, subString == _string.substr(4093, 9000));
+        const Sequence *sequence = ancGenome->getSequence("Sequence2");
+        sequence->getString(subString);
+        CuAssertTrue(_testCase, subString == _string.substr(sequence->getStartPosition()));
+
+        DnaIteratorPtr dnaIt = ancGenome->getDnaIterator();
+        for (int i = 0; i < 1000; ++i) {
+            hal_index_t pos = rand() % _string.size();
+            dnaIt->jumpTo(pos);
+            CuAssertTrue(_testCase, dnaIt->getBase() == _string[pos]);
+        }
+
+        // bulk decode, forward and reverse complement, at random offsets
+        // that cross buffer boundaries
+        vector<char> buffer;
+        for (int i = 0; i < 100; ++i) {
+            hal_size_t start = rand() % _string.size();
+            hal_size_t length = rand() % min(hal_size_t(20000), _string.size() - start + 1);
+            buffer.resize(length);
+            ancGenome->getSubString(buffer.data(), start, length);
+            CuAssertTrue(_testCase, string(buffer.begin(), buffer.end()) == _string.substr(start, length));
+            string revComp = _string.substr(start, length);
+            reverseComplement(revComp);
+            ancGenome->getSubString(buffer.data(), start, length, true);
+            CuAssertTrue(_testCase, string(buffer.begin(), buffer.end()) == revComp);
+        }
+        hal_size_t seqStart = sequence->getStartPosition();
+        buffer.resize(sequence->getSequenceLength());
+        sequence->getSubString(buffer.data(), 0, buffer.size(), true);
+        string revComp = _string.substr(seqStart);
+        reverseComplement(revComp);
+        CuAssertTrue(_testCase, string(buffer.begin(), buffer.end()) == revComp);
+    }
+};
+
 struct GenomeCopyTest : public AlignmentTest {
     std::string _path;
     AlignmentPtr _secondAlignment;
@@ -556,6 +633,11 @@ static void halGenomeStringTest(CuTest *testCase) {
     tester.check(testCase);
 }
 
+static void halGenomeDnaRunsTest(CuTest *testCase) {
+    GenomeDnaRunsTest tester;
+    tester.check(testCase);
+}
+
 static void halGenomeCopyTest(CuTest *testCase) {
     GenomeCopyTest tester;
     tester.check(testCase);
@@ -572,15 +654,42 @@ static void halGenomeDNAPackUnpackTest(CuTest *testCase) {
     }
 }
 
+/* bulk decoding must match the per-base decoding for all alignments of
+ * start and length, which exercise the SIMD and scalar code paths */
+static void halGenomeDNAUnpackStringTest(CuTest *testCase) {
+    const string bases = "ACGTNacgtn";
+    string dna(1000, 'A');
+    for (size_t i = 0; i < dna.size(); i++) {
+        dna[i] = bases[rand() % bases.size()];
+    }
+    vector<char> packed(dna.size() / 2);
+    for (size_t i = 0; i < dna.size(); i++) {
+        packed[i / 2] = dnaPack(dna[i], i, packed[i / 2]);
+    }
+    vector<char> outBuffer(dna.size());
+    for (hal_index_t start = 0; start < 70; start++) {
+        for (hal_size_t length = 0; length + start <= dna.size(); length += 1 + length / 4) {
+            dnaUnpackString(packed.data(), start, length, false, outBuffer.data());
+            CuAssertTrue(testCase, string(outBuffer.data(), length) == dna.substr(start, length));
+            string revComp = dna.substr(start, length);
+            reverseComplement(revComp);
+            dnaUnpackString(packed.data(), start, length, true, outBuffer.data());
+            CuAssertTrue(testCase, string(outBuffer.data(), length) == revComp);
+        }
+    }
+}
+
 static CuSuite *halGenomeTestSuite(void) {
     CuSuite *suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, halGenomeMetaTest);
     SUITE_ADD_TEST(suite, halGenomeCreateTest);
     SUITE_ADD_TEST(suite, halGenomeUpdateTest);
     SUITE_ADD_TEST(suite, halGenomeStringTest);
+    SUITE_ADD_TEST(suite, halGenomeDnaRunsTest);
     SUITE_ADD_TEST(suite, halGenomeCopyTest);
     SUITE_ADD_TEST(suite, halGenomeCopySegmentsWhenSequencesOutOfOrderTest);
     SUITE_ADD_TEST(suite, halGenomeDNAPackUnpackTest);
+    SUITE_ADD_TEST(suite, halGenomeDNAUnpackStringTest);
     return suite;
 }
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halApiTestSupport.h"
+#include "halRandNumberGen.h"
+#include "hdf5ChunkCache.h"
+#include "hdf5ExternalArray.h"
+#include <H5Cpp.h>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+using namespace hal;
+using namespace H5;
+
+static RandNumberGen rng;
+
+static const hsize_t NUM_ARRAYS = 3;
+static const hsize_t ARRAY_SIZE = 1000;
+static const hsize_t CHUNK_SIZE = 16;
+static const size_t CHUNK_BYTES = CHUNK_SIZE * sizeof(hsize_t);
+
+static string arrayName(hsize_t iArray) {
+    return "array" + to_string(iArray);
+}
+
+static hsize_t expectedValue(hsize_t iArray, hsize_t i) {
+    return NUM_ARRAYS * i + iArray;
+}
+
+static void createArrays(const string &path) {
+    H5File file(path, H5F_ACC_TRUNC);
+    DSetCreatPropList cparms;
+    cparms.setDeflate(2);
+    cparms.setChunk(1, &CHUNK_SIZE);
+    for (hsize_t iArray = 0; iArray < NUM_ARRAYS; iArray++) {
+        Hdf5ExternalArray array;
+        array.create(&file, arrayName(iArray), IntType(PredType::NATIVE_HSIZE), ARRAY_SIZE, &cparms);
+        for (hsize_t i = 0; i < ARRAY_SIZE; i++) {
+            array.setValue<hsize_t>(i, 0, expectedValue(iArray, i));
+        }
+        array.write();
+    }
+    file.flush(H5F_SCOPE_LOCAL);
+    file.close();
+}
+
+/* least recently used chunks are evicted, whichever array they belong to */
+static void halHdf5ChunkCacheEvictTest(CuTest *testCase) {
+    Hdf5ChunkCache cache(3 * CHUNK_BYTES);
+    const Hdf5ExternalArray *array1 = reinterpret_cast<const Hdf5ExternalArray *>(1);
+    const Hdf5ExternalArray *array2 = reinterpret_cast<const Hdf5ExternalArray *>(2);
+    vector<char> data(CHUNK_BYTES, 'a'), buf(CHUNK_BYTES);
+    cache.store(array1, 0, data.data(), CHUNK_BYTES);
+    cache.store(array2, 0, data.data(), CHUNK_BYTES);
+    cache.store(array1, CHUNK_SIZE, data.data(), CHUNK_BYTES);
+    CuAssertTrue(testCase, cache.fetch(array1, 0, buf.data(), CHUNK_BYTES));
+    data.assign(CHUNK_BYTES, 'b');
+    cache.store(array2, CHUNK_SIZE, data.data(), CHUNK_BYTES);
+    CuAssertTrue(testCase, cache.getUsedBytes() == 3 * CHUNK_BYTES);
+    CuAssertTrue(testCase, not cache.fetch(array2, 0, buf.data(), CHUNK_BYTES));
+    CuAssertTrue(testCase, cache.fetch(array1, 0, buf.data(), CHUNK_BYTES));
+    CuAssertTrue(testCase, cache.fetch(array2, CHUNK_SIZE, buf.data(), CHUNK_BYTES));
+    CuAssertTrue(testCase, buf == data);
+    CuAssertTrue(testCase, not cache.fetch(array2, CHUNK_SIZE, buf.data(), CHUNK_BYTES - 1));
+
+    cache.dropArray(array1);
+    CuAssertTrue(testCase, cache.getUsedBytes() == CHUNK_BYTES);
+    CuAssertTrue(testCase, not cache.fetch(array1, 0, buf.data(), CHUNK_BYTES));
+    cache.store(array1, 0, data.data(), 4 * CHUNK_BYTES);
+    CuAssertTrue(testCase, cache.getUsedBytes() == CHUNK_BYTES);
+}
+
+/* random access to several arrays sharing a cache smaller than the arrays
+ * always reads the right values, including values updated through the
+ * cache */
+static void halHdf5ChunkCacheArrayTest(CuTest *testCase) {
+    string path = getTempFile();
+    try {
+        createArrays(path);
+        Hdf5ChunkCache cache(20 * CHUNK_BYTES);
+        H5File file(path, H5F_ACC_RDWR);
+        vector<Hdf5ExternalArray> arrays(NUM_ARRAYS);
+        for (hsize_t iArray = 0; iArray < NUM_ARRAYS; iArray++) {
+            arrays[iArray].setCache(&cache, arrayName(iArray));
+            arrays[iArray].load(&file, arrayName(iArray));
+        }
+        vector<vector<hsize_t>> expect(NUM_ARRAYS);
+        for (hsize_t iArray = 0; iArray < NUM_ARRAYS; iArray++) {
+            for (hsize_t i = 0; i < ARRAY_SIZE; i++) {
+                expect[iArray].push_back(expectedValue(iArray, i));
+            }
+        }
+        for (size_t iAccess = 0; iAccess < 20000; iAccess++) {
+            hsize_t iArray = rng.getRandInt(0, NUM_ARRAYS - 1);
+            // mostly in a window that fits in the cache
+            hsize_t i = (iAccess % 10 == 0) ? rng.getRandInt(0, ARRAY_SIZE - 1) : rng.getRandInt(0, 5 * CHUNK_SIZE);
+            if (iAccess % 100 == 0) {
+                expect[iArray][i] += 1;
+                arrays[iArray].setValue<hsize_t>(i, 0, expect[iArray][i]);
+            } else {
+                CuAssertTrue(testCase, arrays[iArray].getValue<hsize_t>(i, 0) == expect[iArray][i]);
+            }
+            CuAssertTrue(testCase, cache.getUsedBytes() <= cache.getMaxBytes());
+        }
+        for (hsize_t iArray = 0; iArray < NUM_ARRAYS; iArray++) {
+            Hdf5ChunkCache::ArrayStats *stats = cache.getArrayStats(arrayName(iArray));
+            CuAssertTrue(testCase, stats->_hits > stats->_misses);
+            arrays[iArray].write();
+        }
+        arrays.clear();
+        CuAssertTrue(testCase, cache.getUsedBytes() == 0);
+        file.close();
+
+        // updates are in the file
+        H5File rereadFile(path, H5F_ACC_RDONLY);
+        for (hsize_t iArray = 0; iArray < NUM_ARRAYS; iArray++) {
+            Hdf5ExternalArray array;
+            array.load(&rereadFile, arrayName(iArray));
+            for (hsize_t i = 0; i < ARRAY_SIZE; i++) {
+                CuAssertTrue(testCase, array.getValue<hsize_t>(i, 0) == expect[iArray][i]);
+            }
+        }
+        rereadFile.close();
+    } catch (const exception &e) {
+        CuFail(testCase, stString_print("Caught exception while testing: %s", e.what()));
+    }
+    ::unlink(path.c_str());
+}
+
+static CuSuite *halHdf5ChunkCacheTestSuite(void) {
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, halHdf5ChunkCacheEvictTest);
+    SUITE_ADD_TEST(suite, halHdf5ChunkCacheArrayTest);
+    return suite;
+}
+
+int main(int argc, char *argv[]) {
+    return runHalTestSuite(argc, argv, halHdf5ChunkCacheTestSuite());
+}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "hal.h"
+#include "halApiTestSupport.h"
+#include "halCLParser.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * Time halMapSegment() on liftover-style input: random intervals of a
+ * source genome are mapped to a target genome one top segment at a time,
+ * as BlockLiftover does for each BED line.  A random alignment is created
+ * unless an existing HAL file is given.  The number of intervals, of
+ * halMapSegment() calls and of mapped segments produced per second are
+ * reported, along with a checksum of the mapped coordinates so that
+ * implementations can be compared.  Segments are mapped into a
+ * MappedSegmentSet, or with --segmentVector, into a MappedSegmentVector that
+ * is then converted to a set.  With --batchSize, intervals are instead
+ * mapped in batches with halMapSegments, as halLiftover does for sorted
+ * input.
+ */
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.setDescription("Benchmark mapping intervals between genomes with halMapSegment");
+    optionsParser.addOption("halFile", "existing HAL file to use rather than a random alignment", "");
+    optionsParser.addOption("srcGenome", "source genome (default: first leaf)", "");
+    optionsParser.addOption("tgtGenome", "target genome (default: last leaf)", "");
+    optionsParser.addOption("seed", "random number seed", 0);
+    optionsParser.addOption("minGenomes", "minimum number of genomes in random alignment", 8);
+    optionsParser.addOption("maxGenomes", "maximum number of genomes in random alignment", 12);
+    optionsParser.addOption("numSegments", "number of segments per sequence in random alignment", 20000);
+    optionsParser.addOption("numIntervals", "number of intervals to map", 5000);
+    optionsParser.addOption("intervalLength", "length of intervals to map", 1000);
+    optionsParser.addOptionFlag("noDupes", "don't follow paralogy edges", false);
+    optionsParser.addOptionFlag("segmentVector", "map into a MappedSegmentVector", false);
+    optionsParser.addOption("batchSize", "map this many intervals at a time with halMapSegments (0 to map each segment)", 0);
+    optionsParser.addOptionFlag("sorted", "sort the intervals by position before mapping", false);
+    optionsParser.addOption("tmpDir", "directory for temporary HAL files", "/tmp");
+}
+
+static void createAlignment(const string &halPath, const CLParser &optionsParser) {
+    RandNumberGen rng(false, optionsParser.getOption<int>("seed"));
+    AlignmentPtr alignment(getTestAlignmentInstances(STORAGE_FORMAT_MMAP, halPath, CREATE_ACCESS));
+    hal_size_t numSegments = optionsParser.getOption<hal_size_t>("numSegments");
+    createRandomAlignment(rng, alignment, 1.5, 0.3, optionsParser.getOption<hal_size_t>("minGenomes"),
+                          optionsParser.getOption<hal_size_t>("maxGenomes"), 10, 200, numSegments, numSegments);
+    alignment->close();
+}
+
+struct MapCounts {
+    MapCounts() : _numCalls(0), _numMapped(0), _checksum(0) {
+    }
+    hal_size_t _numCalls;
+    hal_size_t _numMapped;
+    hal_size_t _checksum;
+};
+
+/* map one interval the way BlockLiftover::liftInterval does */
+static void mapInterval(TopSegmentIteratorPtr &refSeg, hal_index_t globalStart, hal_index_t globalEnd,
+                        const Genome *tgtGenome, const set<const Genome *> &downwardPath, bool doDupes,
+                        const Genome *mrca, bool segmentVector, MapCounts &counts) {
+    MappedSegmentSet mappedSegments;
+    MappedSegmentVector mappedSegmentVector;
+    refSeg->toSite(globalStart, false);
+    hal_offset_t endOffset = 0;
+    if (globalEnd <= refSeg->getEndPosition()) {
+        endOffset = refSeg->getEndPosition() - globalEnd;
+    }
+    refSeg->slice(globalStart - refSeg->getStartPosition(), endOffset);
+    hal_index_t lastIndex = refSeg->getGenome()->getNumTopSegments();
+    while (refSeg->getArrayIndex() < lastIndex && refSeg->getStartPosition() <= globalEnd) {
+        if (segmentVector) {
+            halMapSegment(refSeg.get(), mappedSegmentVector, tgtGenome, &downwardPath, doDupes, 0, mrca, mrca);
+        } else {
+            halMapSegment(refSeg.get(), mappedSegments, tgtGenome, &downwardPath, doDupes, 0, mrca, mrca);
+        }
+        counts._numCalls++;
+        refSeg->toRight(globalEnd);
+    }
+    if (segmentVector) {
+        mappedSegmentVector.resolve();
+        mappedSegmentVector.toSet(mappedSegments);
+    }
+    counts._numMapped += mappedSegments.size();
+    for (const MappedSegmentPtr &mappedSeg : mappedSegments) {
+        counts._checksum += mappedSeg->getStartPosition() + 3 * mappedSeg->getSource()->getStartPosition();
+    }
+}
+
+/* map a batch of intervals the way BlockLiftover::mapBatch does */
+static void mapBatch(const Genome *srcGenome, const vector<SourceInterval> &intervals, const Genome *tgtGenome,
+                     const set<const Genome *> &downwardPath, bool doDupes, const Genome *mrca, MapCounts &counts) {
+    vector<MappedSegmentVector> batchSegments;
+    halMapSegments(srcGenome, intervals, batchSegments, tgtGenome, &downwardPath, doDupes, 0, mrca, mrca);
+    counts._numCalls++;
+    MappedSegmentSet mappedSegments;
+    for (const MappedSegmentVector &segVector : batchSegments) {
+        segVector.toSet(mappedSegments);
+        counts._numMapped += mappedSegments.size();
+        for (const MappedSegmentPtr &mappedSeg : mappedSegments) {
+            counts._checksum += mappedSeg->getStartPosition() + 3 * mappedSeg->getSource()->getStartPosition();
+        }
+    }
+}
+
+static bool intervalLess(const SourceInterval &interval1, const SourceInterval &interval2) {
+    return interval1._start < interval2._start;
+}
+
+static MapCounts runBenchmark(const Genome *srcGenome, const Genome *tgtGenome, bool doDupes, bool segmentVector,
+                              hal_size_t batchSize, bool sorted, RandNumberGen &rng, hal_size_t numIntervals,
+                              hal_size_t intervalLength) {
+    set<const Genome *> inputSet;
+    inputSet.insert(srcGenome);
+    inputSet.insert(tgtGenome);
+    const Genome *mrca = getLowestCommonAncestor(inputSet);
+    inputSet.clear();
+    inputSet.insert(mrca);
+    inputSet.insert(tgtGenome);
+    set<const Genome *> downwardPath;
+    getGenomesInSpanningTree(inputSet, downwardPath);
+
+    MapCounts counts;
+    TopSegmentIteratorPtr refSeg = srcGenome->getTopSegmentIterator();
+    hal_size_t genomeLength = srcGenome->getSequenceLength();
+    intervalLength = min(intervalLength, genomeLength);
+    vector<SourceInterval> intervals;
+    for (hal_size_t i = 0; i < numIntervals; i++) {
+        hal_index_t start = rng.getRandInt(0, genomeLength - intervalLength);
+        intervals.push_back(SourceInterval(start, start + intervalLength - 1));
+    }
+    if (sorted) {
+        sort(intervals.begin(), intervals.end(), intervalLess);
+    }
+    if (batchSize == 0) {
+        for (const SourceInterval &interval : intervals) {
+            mapInterval(refSeg, interval._start, interval._end, tgtGenome, downwardPath, doDupes, mrca, segmentVector,
+                        counts);
+        }
+    } else {
+        for (size_t i = 0; i < intervals.size(); i += batchSize) {
+            vector<SourceInterval> batch(intervals.begin() + i, intervals.begin() + min(i + batchSize, intervals.size()));
+            mapBatch(srcGenome, batch, tgtGenome, downwardPath, doDupes, mrca, counts);
+        }
+    }
+    return counts;
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser(CREATE_ACCESS);
+    initParser(optionsParser);
+    try {
+        optionsParser.parseOptions(argc, argv);
+    } catch (hal_exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+    try {
+        string halPath = optionsParser.getOption<string>("halFile");
+        bool randomAlignment = halPath.empty();
+        if (randomAlignment) {
+            halPath = optionsParser.getOption<string>("tmpDir") + "/halMapSegmentBenchmark.hal";
+            createAlignment(halPath, optionsParser);
+        }
+        AlignmentConstPtr alignment(openHalAlignment(halPath, &optionsParser));
+        vector<string> leaves = alignment->getLeafNamesBelow(alignment->getRootName());
+        string srcName = optionsParser.getOption<string>("srcGenome");
+        string tgtName = optionsParser.getOption<string>("tgtGenome");
+        const Genome *srcGenome = alignment->openGenome(srcName.empty() ? leaves.front() : srcName);
+        const Genome *tgtGenome = alignment->openGenome(tgtName.empty() ? leaves.back() : tgtName);
+        if ((srcGenome == NULL) or (tgtGenome == NULL)) {
+            throw hal_exception("source or target genome not found");
+        }
+        if (srcGenome->getNumTopSegments() == 0) {
+            throw hal_exception("source genome " + srcGenome->getName() + " has no top segments");
+        }
+
+        RandNumberGen rng(false, optionsParser.getOption<int>("seed"));
+        hal_size_t numIntervals = optionsParser.getOption<hal_size_t>("numIntervals");
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        MapCounts counts = runBenchmark(srcGenome, tgtGenome, not optionsParser.getFlag("noDupes"),
+                                        optionsParser.getFlag("segmentVector"),
+                                        optionsParser.getOption<hal_size_t>("batchSize"), optionsParser.getFlag("sorted"),
+                                        rng, numIntervals, optionsParser.getOption<hal_size_t>("intervalLength"));
+        double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        cout << srcGenome->getName() << " -> " << tgtGenome->getName() << ": " << numIntervals << " intervals, "
+             << counts._numCalls << " calls, " << counts._numMapped << " mapped segments, checksum " << counts._checksum
+             << endl;
+        cout << setw(10) << "secs" << setw(16) << "intervals/sec" << setw(14) << "calls/sec" << setw(16) << "mapped/sec"
+             << endl;
+        cout << setw(10) << fixed << setprecision(3) << secs << setprecision(0) << setw(16) << numIntervals / secs
+             << setw(14) << counts._numCalls / secs << setw(16) << counts._numMapped / secs << endl;
+        alignment->close();
+        if (randomAlignment) {
+            ::remove(halPath.c_str());
+        }
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -796,6 +796,124 @@ struct MappedSegmentColCompareTest3 : public MappedSegmentColCompareTest {
     }
 };
 
+/* mapping every segment of a genome into a MappedSegmentVector and resolving
+ * it gives the same segments as inserting them into a MappedSegmentSet */
+struct MappedSegmentVectorTest : public AlignmentTest {
+    void createCallBack(AlignmentPtr alignment) {
+        createRandomAlignment(rng, alignment, 1.5, 0.7, 4, 8, 2, 50, 10, 200);
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        set<const Genome *> genomeSet;
+        hal::getGenomesInSubTree(alignment->openGenome(alignment->getRootName()), genomeSet);
+        for (const Genome *srcGenome : genomeSet) {
+            for (const Genome *tgtGenome : genomeSet) {
+                if (srcGenome->getNumTopSegments() > 0 && tgtGenome->getSequenceLength() > 0) {
+                    checkMapping(srcGenome, tgtGenome);
+                }
+            }
+        }
+    }
+
+    void checkMapping(const Genome *srcGenome, const Genome *tgtGenome) {
+        MappedSegmentSet segSet;
+        MappedSegmentVector segVector;
+        for (TopSegmentIteratorPtr topIt = srcGenome->getTopSegmentIterator(); not topIt->atEnd(); topIt->toRight()) {
+            halMapSegmentSP(topIt, segSet, tgtGenome);
+            halMapSegmentSP(topIt, segVector, tgtGenome);
+        }
+        segVector.resolve();
+        CuAssertTrue(_testCase, segVector.size() == segSet.size());
+        MappedSegmentSet vectorSet;
+        segVector.toSet(vectorSet);
+        CuAssertTrue(_testCase, vectorSet.size() == segSet.size());
+        MappedSegmentSet::const_iterator setIt = segSet.begin();
+        MappedSegmentVector::const_iterator vecIt = segVector.begin();
+        for (const MappedSegmentPtr &mappedSeg : vectorSet) {
+            CuAssertTrue(_testCase, mappedSeg->getStartPosition() == (*setIt)->getStartPosition());
+            CuAssertTrue(_testCase, mappedSeg->getEndPosition() == (*setIt)->getEndPosition());
+            CuAssertTrue(_testCase, mappedSeg->getSource()->getStartPosition() == (*setIt)->getSource()->getStartPosition());
+            CuAssertTrue(_testCase, mappedSeg->getSource()->getEndPosition() == (*setIt)->getSource()->getEndPosition());
+            CuAssertTrue(_testCase, vecIt->_target.getStartPosition() == mappedSeg->getStartPosition());
+            CuAssertTrue(_testCase, vecIt->_source.getEndPosition() == mappedSeg->getSource()->getEndPosition());
+            ++setIt;
+            ++vecIt;
+        }
+    }
+};
+
+/* mapping random, overlapping intervals of a genome in one batch with
+ * halMapSegments gives the same segments for each interval as mapping the
+ * interval's segments one at a time */
+struct MappedSegmentBatchTest : public AlignmentTest {
+    void createCallBack(AlignmentPtr alignment) {
+        createRandomAlignment(rng, alignment, 1.5, 0.7, 4, 8, 2, 50, 10, 200);
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        set<const Genome *> genomeSet;
+        hal::getGenomesInSubTree(alignment->openGenome(alignment->getRootName()), genomeSet);
+        for (const Genome *srcGenome : genomeSet) {
+            for (const Genome *tgtGenome : genomeSet) {
+                if (srcGenome->getSequenceLength() > 0 && tgtGenome->getSequenceLength() > 0) {
+                    checkMapping(srcGenome, tgtGenome);
+                }
+            }
+        }
+    }
+
+    void checkMapping(const Genome *srcGenome, const Genome *tgtGenome) {
+        vector<SourceInterval> intervals;
+        hal_index_t genomeLength = srcGenome->getSequenceLength();
+        for (size_t i = 0; i < 20; ++i) {
+            hal_index_t start = rng.getRandInt(0, genomeLength - 1);
+            hal_index_t end = min(genomeLength - 1, start + (hal_index_t)rng.getRandInt(0, 200));
+            intervals.push_back(SourceInterval(start, end, rng.getRand() < 0.3));
+        }
+        vector<MappedSegmentVector> batchSegments;
+        halMapSegments(srcGenome, intervals, batchSegments, tgtGenome);
+        CuAssertTrue(_testCase, batchSegments.size() == intervals.size());
+
+        SegmentIteratorPtr srcSegIt;
+        hal_index_t lastIndex;
+        if (srcGenome->getNumTopSegments() > 0) {
+            srcSegIt = srcGenome->getTopSegmentIterator();
+            lastIndex = srcGenome->getNumTopSegments();
+        } else {
+            srcSegIt = srcGenome->getBottomSegmentIterator();
+            lastIndex = srcGenome->getNumBottomSegments();
+        }
+        for (size_t i = 0; i < intervals.size(); ++i) {
+            MappedSegmentVector segVector;
+            srcSegIt->toSite(intervals[i]._start, false);
+            hal_offset_t endOffset = 0;
+            if (intervals[i]._end <= srcSegIt->getEndPosition()) {
+                endOffset = srcSegIt->getEndPosition() - intervals[i]._end;
+            }
+            srcSegIt->slice(intervals[i]._start - srcSegIt->getStartPosition(), endOffset);
+            while (srcSegIt->getArrayIndex() < lastIndex && srcSegIt->getStartPosition() <= intervals[i]._end) {
+                if (intervals[i]._reversed) {
+                    srcSegIt->toReverseInPlace();
+                }
+                halMapSegmentSP(srcSegIt, segVector, tgtGenome);
+                if (intervals[i]._reversed) {
+                    srcSegIt->toReverseInPlace();
+                }
+                srcSegIt->toRight(intervals[i]._end);
+            }
+            segVector.resolve();
+            const MappedSegmentVector &batchVector = batchSegments[i];
+            CuAssertTrue(_testCase, batchVector.size() == segVector.size());
+            for (size_t j = 0; j < segVector.size() && j < batchVector.size(); ++j) {
+                CuAssertTrue(_testCase, batchVector[j]._target.getStartPosition() == segVector[j]._target.getStartPosition());
+                CuAssertTrue(_testCase, batchVector[j]._target.getEndPosition() == segVector[j]._target.getEndPosition());
+                CuAssertTrue(_testCase, batchVector[j]._source.getStartPosition() == segVector[j]._source.getStartPosition());
+                CuAssertTrue(_testCase, batchVector[j]._source.getEndPosition() == segVector[j]._source.getEndPosition());
+            }
+        }
+    }
+};
+
 static void halMappedSegmentMapUpTest(CuTest *testCase) {
     MappedSegmentMapUpTest tester;
     tester.check(testCase);
@@ -851,6 +969,16 @@ static void halMappedSegmentColCompareTest3(CuTest *testCase) {
     tester.check(testCase);
 }
 
+static void halMappedSegmentVectorTest(CuTest *testCase) {
+    MappedSegmentVectorTest tester;
+    tester.check(testCase);
+}
+
+static void halMappedSegmentBatchTest(CuTest *testCase) {
+    MappedSegmentBatchTest tester;
+    tester.check(testCase);
+}
+
 static CuSuite *halMappedSegmentTestSuite(void) {
     CuSuite *suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, halMappedSegmentMapExtraParalogsTest);
@@ -862,6 +990,8 @@ static CuSuite *halMappedSegmentTestSuite(void) {
     SUITE_ADD_TEST(suite, halMappedSegmentColCompareTestCheck1);
     SUITE_ADD_TEST(suite, halMappedSegmentColCompareTestCheck2);
     SUITE_ADD_TEST(suite, halMappedSegmentColCompareTest1);
+    SUITE_ADD_TEST(suite, halMappedSegmentVectorTest);
+    SUITE_ADD_TEST(suite, halMappedSegmentBatchTest);
     // FIXME: why are these disabled?
     if (false) {
         SUITE_ADD_TEST(suite, halMappedSegmentColCompareTest2);
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "hal.h"
+#include "halApiTestSupport.h"
+#include "halCLParser.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * Time reading a mmap file from a cold page cache with each of the access
+ * options: a sequential scan of the segments and DNA of all genomes, as
+ * done by hal2maf, and random site lookups, as done by a liftover server.
+ * The file is dropped from the page cache with posix_fadvise() before each
+ * run, the fraction of the file still resident afterwards is reported.
+ * Open time, including any prefetch, is part of the run time.
+ */
+
+struct AccessConfig {
+    string _name;
+    MMapAccessOptions _accessOptions;
+};
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.setDescription("Benchmark mmap access options on a cold page cache");
+    optionsParser.addOption("seed", "random number seed", 0);
+    optionsParser.addOption("minGenomes", "minimum number of genomes", 20);
+    optionsParser.addOption("maxGenomes", "maximum number of genomes", 30);
+    optionsParser.addOption("minSegments", "minimum number of segments per sequence", 20000);
+    optionsParser.addOption("maxSegments", "maximum number of segments per sequence", 50000);
+    optionsParser.addOption("numQueries", "number of random queries per genome", 2000);
+    optionsParser.addOption("tmpDir", "directory for temporary HAL files", "/tmp");
+}
+
+static vector<string> getGenomeNames(const Alignment *alignment) {
+    vector<string> names;
+    deque<string> queue(1, alignment->getRootName());
+    while (not queue.empty()) {
+        names.push_back(queue.front());
+        for (const string &child : alignment->getChildNames(queue.front())) {
+            queue.push_back(child);
+        }
+        queue.pop_front();
+    }
+    return names;
+}
+
+static double elapsedSecs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/* drop the file from the page cache, returning the fraction of pages that
+ * are still resident */
+static double evictFile(const string &halPath) {
+    int fd = ::open(halPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw hal_errno_exception(halPath, "open failed", errno);
+    }
+    struct stat fileStat;
+    ::fstat(fd, &fileStat);
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t numPages = (fileStat.st_size + pageSize - 1) / pageSize;
+    size_t numResident = 0;
+    void *ptr = ::mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr != MAP_FAILED) {
+        vector<unsigned char> residency(numPages);
+        if (::mincore(ptr, fileStat.st_size, residency.data()) == 0) {
+            for (unsigned char page : residency) {
+                numResident += page & 1;
+            }
+        }
+        ::munmap(ptr, fileStat.st_size);
+    }
+    ::close(fd);
+    return double(numResident) / numPages;
+}
+
+static AlignmentPtr openAlignment(const string &halPath, const MMapAccessOptions &accessOptions) {
+    return AlignmentPtr(mmapAlignmentInstance(halPath, READ_ACCESS, MMAP_DEFAULT_FILE_SIZE, MMAP_SEGMENT_LAYOUT_ROWS,
+                                              MMAP_DNA_LAYOUT_NIBBLES, accessOptions));
+}
+
+/* scan all segments and DNA, returning a checksum */
+static hal_size_t scanAlignment(const Alignment *alignment) {
+    hal_size_t checksum = 0;
+    string dna;
+    for (const string &name : getGenomeNames(alignment)) {
+        const Genome *genome = alignment->openGenome(name);
+        if (genome->getNumTopSegments() > 0) {
+            for (TopSegmentIteratorPtr topIt = genome->getTopSegmentIterator(); not topIt->atEnd(); topIt->toRight()) {
+                checksum += topIt->getStartPosition() + topIt->tseg()->getParentIndex();
+            }
+        }
+        if (genome->getNumBottomSegments() > 0) {
+            for (BottomSegmentIteratorPtr botIt = genome->getBottomSegmentIterator(); not botIt->atEnd(); botIt->toRight()) {
+                checksum += botIt->getStartPosition();
+            }
+        }
+        genome->getString(dna);
+        checksum += dna[dna.size() / 2];
+    }
+    return checksum;
+}
+
+/* random site lookups with a little DNA, returning a checksum */
+static hal_size_t queryAlignment(const Alignment *alignment, int seed, hal_size_t numQueries) {
+    RandNumberGen rng(false, seed);
+    hal_size_t checksum = 0;
+    string dna;
+    for (const string &name : getGenomeNames(alignment)) {
+        const Genome *genome = alignment->openGenome(name);
+        if ((genome->getSequenceLength() < 32) or (genome->getNumTopSegments() == 0)) {
+            continue;
+        }
+        TopSegmentIteratorPtr topIt = genome->getTopSegmentIterator();
+        DnaIteratorPtr dnaIt = genome->getDnaIterator();
+        for (hal_size_t i = 0; i < numQueries; i++) {
+            hal_index_t pos = rng.getRandInt(0, genome->getSequenceLength() - 32);
+            topIt->toSite(pos);
+            dnaIt->jumpTo(pos);
+            dnaIt->readString(dna, 32);
+            checksum += topIt->getArrayIndex() + dna[0];
+        }
+    }
+    return checksum;
+}
+
+static void createAlignment(const string &halPath, const CLParser &optionsParser) {
+    RandNumberGen rng(false, optionsParser.getOption<int>("seed"));
+    AlignmentPtr alignment(getTestAlignmentInstances(STORAGE_FORMAT_MMAP, halPath, CREATE_ACCESS));
+    createRandomAlignment(rng, alignment, 2.0, 0.7, optionsParser.getOption<hal_size_t>("minGenomes"),
+                          optionsParser.getOption<hal_size_t>("maxGenomes"), 10, 200,
+                          optionsParser.getOption<hal_size_t>("minSegments"),
+                          optionsParser.getOption<hal_size_t>("maxSegments"));
+    alignment->close();
+}
+
+static vector<AccessConfig> getConfigs(const string &halPath) {
+    vector<AccessConfig> configs(5);
+    configs[0]._name = "normal";
+    configs[1]._name = "sequential";
+    configs[1]._accessOptions._accessPattern = MMAP_ACCESS_SEQUENTIAL;
+    configs[2]._name = "random";
+    configs[2]._accessOptions._accessPattern = MMAP_ACCESS_RANDOM;
+    configs[3]._name = "prefetch";
+    configs[3]._accessOptions._prefetchGenomes = getGenomeNames(openAlignment(halPath, MMapAccessOptions()).get());
+    configs[4]._name = "populate";
+    configs[4]._accessOptions._populate = true;
+    return configs;
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser(CREATE_ACCESS);
+    initParser(optionsParser);
+    try {
+        optionsParser.parseOptions(argc, argv);
+    } catch (hal_exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+    try {
+        const string halPath = optionsParser.getOption<string>("tmpDir") + "/halMmapAccessBenchmark.hal";
+        int seed = optionsParser.getOption<int>("seed");
+        hal_size_t numQueries = optionsParser.getOption<hal_size_t>("numQueries");
+        createAlignment(halPath, optionsParser);
+        struct stat fileStat;
+        ::stat(halPath.c_str(), &fileStat);
+        cout << "file size " << fileStat.st_size << " bytes" << endl;
+
+        cout << setw(12) << "access" << setw(12) << "scanSecs" << setw(14) << "scanResident" << setw(12) << "querySecs"
+             << setw(14) << "queryResident" << endl;
+        hal_size_t scanChecksum = 0, queryChecksum = 0;
+        for (const AccessConfig &config : getConfigs(halPath)) {
+            double scanResident = evictFile(halPath);
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            AlignmentPtr alignment = openAlignment(halPath, config._accessOptions);
+            hal_size_t checksum = scanAlignment(alignment.get());
+            double scanSecs = elapsedSecs(start);
+            alignment->close();
+            if ((scanChecksum != 0) and (checksum != scanChecksum)) {
+                throw hal_exception("scan checksums differ between access options");
+            }
+            scanChecksum = checksum;
+
+            double queryResident = evictFile(halPath);
+            start = chrono::steady_clock::now();
+            alignment = openAlignment(halPath, config._accessOptions);
+            checksum = queryAlignment(alignment.get(), seed, numQueries);
+            double querySecs = elapsedSecs(start);
+            alignment->close();
+            if ((queryChecksum != 0) and (checksum != queryChecksum)) {
+                throw hal_exception("query checksums differ between access options");
+            }
+            queryChecksum = checksum;
+
+            cout << setw(12) << config._name << setw(12) << fixed << setprecision(3) << scanSecs << setw(14)
+                 << setprecision(2) << scanResident << setw(12) << setprecision(3) << querySecs << setw(14)
+                 << setprecision(2) << queryResident << endl;
+        }
+        ::remove(halPath.c_str());
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halApiTestSupport.h"
+#include "hal.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <deque>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace hal;
+
+static RandNumberGen rng;
+
+/* get all genome names, root first */
+static vector<string> getGenomeNames(const Alignment *alignment) {
+    vector<string> names;
+    deque<string> queue(1, alignment->getRootName());
+    while (not queue.empty()) {
+        names.push_back(queue.front());
+        queue.pop_front();
+        for (const string &child : alignment->getChildNames(names.back())) {
+            queue.push_back(child);
+        }
+    }
+    return names;
+}
+
+/* summarize the DNA and segments of all genomes as a string */
+static string alignmentSignature(const Alignment *alignment) {
+    ostringstream sig;
+    for (const string &name : getGenomeNames(alignment)) {
+        const Genome *genome = alignment->openGenome(name);
+        string dna;
+        genome->getString(dna);
+        sig << name << " " << dna;
+        if (genome->getNumTopSegments() > 0) {
+            for (TopSegmentIteratorPtr topIt = genome->getTopSegmentIterator(); not topIt->atEnd(); topIt->toRight()) {
+                sig << " t" << topIt->getStartPosition() << "," << topIt->tseg()->getParentIndex();
+            }
+        }
+        if (genome->getNumBottomSegments() > 0) {
+            for (BottomSegmentIteratorPtr botIt = genome->getBottomSegmentIterator(); not botIt->atEnd(); botIt->toRight()) {
+                sig << " b" << botIt->getStartPosition();
+                for (hal_size_t i = 0; i < botIt->bseg()->getNumChildren(); i++) {
+                    sig << "," << botIt->bseg()->getChildIndex(i);
+                }
+            }
+        }
+        sig << "\n";
+    }
+    return sig.str();
+}
+
+/* access options are only hints, so must not change anything that is read */
+struct MMapAccessTest : public AlignmentTest {
+    void createCallBack(AlignmentPtr alignment) {
+        createRandomAlignment(rng, alignment, 1.25, 0.7, 5, 10, 10, 200, 20, 200);
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        if (alignment->getStorageFormat() != STORAGE_FORMAT_MMAP) {
+            return;
+        }
+        string expect = alignmentSignature(alignment.get());
+        for (int pattern = MMAP_ACCESS_NORMAL; pattern <= MMAP_ACCESS_RANDOM; pattern++) {
+            MMapAccessOptions accessOptions;
+            accessOptions._accessPattern = MMapAccessPattern(pattern);
+            accessOptions._prefetchGenomes = getGenomeNames(alignment.get());
+            accessOptions._populate = (pattern == MMAP_ACCESS_SEQUENTIAL);
+            accessOptions._hugePages = (pattern == MMAP_ACCESS_RANDOM);
+            AlignmentPtr hinted(mmapAlignmentInstance(_checkPath, READ_ACCESS, MMAP_DEFAULT_FILE_SIZE,
+                                                      MMAP_SEGMENT_LAYOUT_ROWS, MMAP_DNA_LAYOUT_NIBBLES, accessOptions));
+            CuAssertTrue(_testCase, alignmentSignature(hinted.get()) == expect);
+            hinted->close();
+        }
+
+        // announce segment ranges, including ones that are out of range
+        for (const string &name : getGenomeNames(alignment.get())) {
+            const Genome *genome = alignment->openGenome(name);
+            for (hal_index_t first : {hal_index_t(-5), hal_index_t(0), hal_index_t(7)}) {
+                genome->prefetchTopSegments(first, first + 10);
+                genome->prefetchBottomSegments(first, genome->getNumBottomSegments() + 3);
+            }
+        }
+        CuAssertTrue(_testCase, alignmentSignature(alignment.get()) == expect);
+
+        MMapAccessOptions badOptions;
+        badOptions._prefetchGenomes.push_back("noSuchGenome");
+        bool threw = false;
+        try {
+            mmapAlignmentInstance(_checkPath, READ_ACCESS, MMAP_DEFAULT_FILE_SIZE, MMAP_SEGMENT_LAYOUT_ROWS,
+                                  MMAP_DNA_LAYOUT_NIBBLES, badOptions);
+        } catch (const hal_exception &ex) {
+            threw = true;
+        }
+        CuAssertTrue(_testCase, threw);
+    }
+};
+
+static void halMmapAccessTest(CuTest *testCase) {
+    MMapAccessTest tester;
+    tester.check(testCase);
+}
+
+static void halMmapAccessPatternNamesTest(CuTest *testCase) {
+    for (int pattern = MMAP_ACCESS_NORMAL; pattern <= MMAP_ACCESS_RANDOM; pattern++) {
+        CuAssertTrue(testCase, mmapAccessPatternFromString(mmapAccessPatternToString(MMapAccessPattern(pattern))) ==
+                                   MMapAccessPattern(pattern));
+    }
+    bool threw = false;
+    try {
+        mmapAccessPatternFromString("sideways");
+    } catch (const hal_exception &ex) {
+        threw = true;
+    }
+    CuAssertTrue(testCase, threw);
+}
+
+static CuSuite *halMmapAccessTestSuite(void) {
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, halMmapAccessTest);
+    SUITE_ADD_TEST(suite, halMmapAccessPatternNamesTest);
+    return suite;
+}
+
+int main(int argc, char *argv[]) {
+    return runHalTestSuite(argc, argv, halMmapAccessTestSuite());
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halApiTestSupport.h"
+#include "halRandNumberGen.h"
+#include "mmapBlockPrefetcher.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hal;
+
+static RandNumberGen rng;
+
+static const size_t BLOCK_SIZE = 64;
+static const size_t MAX_REQUEST_SIZE = 8 * BLOCK_SIZE;
+
+/*
+ * Stand-in for a remote file read through a block cache, such as UDC.  The
+ * remote data is copied into the cache a block at a time, with a delay on
+ * each request to simulate latency.  A gate can be closed to hold requests
+ * in progress.
+ */
+class RemoteStandIn {
+  public:
+    RemoteStandIn(size_t fileSize)
+        : _remote(fileSize), _cache(fileSize), _cached((fileSize + BLOCK_SIZE - 1) / BLOCK_SIZE), _gateOpen(true),
+          _numStarted(0) {
+        for (size_t i = 0; i < fileSize; i++) {
+            _remote[i] = rng.getRandInt(0, 255);
+        }
+    }
+
+    /* fetch missing blocks of a range */
+    void fetch(size_t offset, size_t length) {
+        for (size_t iBlock = offset / BLOCK_SIZE; iBlock * BLOCK_SIZE < offset + length; iBlock++) {
+            if (not _cached[iBlock]) {
+                size_t start = iBlock * BLOCK_SIZE;
+                memcpy(&_cache[start], &_remote[start], min(BLOCK_SIZE, _remote.size() - start));
+                _cached[iBlock] = true;
+            }
+        }
+    }
+
+    /* function run by prefetch workers */
+    void workerFetch(unsigned worker, size_t offset, size_t length) {
+        {
+            unique_lock<mutex> lock(_mutex);
+            _requests.push_back(make_pair(offset, length));
+            _numStarted++;
+            _started.notify_all();
+            _gateChanged.wait(lock, [this]() { return _gateOpen; });
+        }
+        this_thread::sleep_for(chrono::microseconds(200));
+        fetch(offset, length);
+    }
+
+    void setGate(bool open) {
+        lock_guard<mutex> lock(_mutex);
+        _gateOpen = open;
+        _gateChanged.notify_all();
+    }
+
+    void waitForStarted(size_t numStarted) {
+        unique_lock<mutex> lock(_mutex);
+        _started.wait(lock, [this, numStarted]() { return _numStarted >= numStarted; });
+    }
+
+    vector<char> _remote;
+    vector<char> _cache;
+    vector<atomic<bool>> _cached;
+    mutex _mutex;
+    condition_variable _gateChanged;
+    condition_variable _started;
+    bool _gateOpen;
+    size_t _numStarted;
+    vector<pair<size_t, size_t>> _requests;
+};
+
+static MMapBlockPrefetcher::FetchFunc getFetchFunc(RemoteStandIn &standIn) {
+    return [&standIn](unsigned worker, size_t offset, size_t length) { standIn.workerFetch(worker, offset, length); };
+}
+
+/* adjacent ranges queued while the worker is busy are coalesced into
+ * block-aligned requests no larger than the maximum */
+static void halMmapBlockPrefetcherCoalesceTest(CuTest *testCase) {
+    size_t fileSize = 100 * BLOCK_SIZE + 10;
+    RemoteStandIn standIn(fileSize);
+    MMapBlockPrefetcher prefetcher(fileSize, BLOCK_SIZE, 1, MAX_REQUEST_SIZE, getFetchFunc(standIn));
+    standIn.setGate(false);
+    prefetcher.prefetch(3, 5);
+    standIn.waitForStarted(1);
+
+    // the last 20 blocks in small overlapping pieces, out of order, running
+    // off the end of the file
+    size_t spanStart = 80 * BLOCK_SIZE + 1;
+    for (size_t i = 0; i < 50; i++) {
+        prefetcher.prefetch(spanStart + ((i * 7) % 50) * 26, 30);
+    }
+    standIn.setGate(true);
+    prefetcher.waitAll();
+
+    size_t spanRequests = (fileSize - 80 * BLOCK_SIZE + MAX_REQUEST_SIZE - 1) / MAX_REQUEST_SIZE;
+    CuAssertTrue(testCase, prefetcher.getNumRequests() == 1 + spanRequests);
+    CuAssertTrue(testCase, standIn._requests.size() == prefetcher.getNumRequests());
+    CuAssertTrue(testCase, standIn._requests[0] == make_pair(size_t(0), BLOCK_SIZE));
+    size_t nextStart = 80 * BLOCK_SIZE;
+    for (size_t i = 1; i < standIn._requests.size(); i++) {
+        CuAssertTrue(testCase, standIn._requests[i].first == nextStart);
+        CuAssertTrue(testCase, standIn._requests[i].second <= MAX_REQUEST_SIZE);
+        nextStart += standIn._requests[i].second;
+    }
+    CuAssertTrue(testCase, nextStart == fileSize);
+    CuAssertTrue(testCase, memcmp(&standIn._cache[0], &standIn._remote[0], BLOCK_SIZE) == 0);
+    CuAssertTrue(testCase, memcmp(&standIn._cache[80 * BLOCK_SIZE], &standIn._remote[80 * BLOCK_SIZE],
+                                  fileSize - 80 * BLOCK_SIZE) == 0);
+}
+
+/* a range that is about to be read synchronously is dropped from the
+ * queue, and ranges already in progress are not queued again */
+static void halMmapBlockPrefetcherWaitTest(CuTest *testCase) {
+    size_t fileSize = 100 * BLOCK_SIZE;
+    RemoteStandIn standIn(fileSize);
+    MMapBlockPrefetcher prefetcher(fileSize, BLOCK_SIZE, 1, MAX_REQUEST_SIZE, getFetchFunc(standIn));
+    standIn.setGate(false);
+    prefetcher.prefetch(0, 2 * BLOCK_SIZE);
+    standIn.waitForStarted(1);
+    prefetcher.prefetch(BLOCK_SIZE, 10);
+    prefetcher.prefetch(10 * BLOCK_SIZE, 3 * BLOCK_SIZE);
+    prefetcher.waitFor(11 * BLOCK_SIZE, 1);
+    standIn.setGate(true);
+    prefetcher.waitFor(0, 1);
+    CuAssertTrue(testCase, standIn._cached[0] and standIn._cached[1]);
+    prefetcher.waitAll();
+
+    // the middle block is left to the caller
+    CuAssertTrue(testCase, standIn._requests.size() == 3);
+    CuAssertTrue(testCase, standIn._requests[1] == make_pair(10 * BLOCK_SIZE, BLOCK_SIZE));
+    CuAssertTrue(testCase, standIn._requests[2] == make_pair(12 * BLOCK_SIZE, BLOCK_SIZE));
+    CuAssertTrue(testCase, not standIn._cached[11]);
+}
+
+/* random windows are announced and then read in pieces while the workers
+ * fetch them, the data read must always match the remote data */
+static void halMmapBlockPrefetcherReadTest(CuTest *testCase) {
+    size_t fileSize = 5000 * BLOCK_SIZE + 17;
+    RemoteStandIn standIn(fileSize);
+    MMapBlockPrefetcher prefetcher(fileSize, BLOCK_SIZE, 4, MAX_REQUEST_SIZE, getFetchFunc(standIn));
+    for (size_t iWindow = 0; iWindow < 50; iWindow++) {
+        size_t windowStart = rng.getRandInt(0, fileSize - 1);
+        size_t windowLength = rng.getRandInt(1, min(fileSize - windowStart, 100 * BLOCK_SIZE));
+        prefetcher.prefetch(windowStart, windowLength);
+        for (size_t iRead = 0; iRead < 20; iRead++) {
+            size_t offset = windowStart + rng.getRandInt(0, windowLength - 1);
+            size_t length = rng.getRandInt(1, windowStart + windowLength - offset);
+            prefetcher.waitFor(offset, length);
+            standIn.fetch(offset, length);
+            CuAssertTrue(testCase, memcmp(&standIn._cache[offset], &standIn._remote[offset], length) == 0);
+        }
+    }
+    prefetcher.waitAll();
+    for (const pair<size_t, size_t> &request : standIn._requests) {
+        CuAssertTrue(testCase, request.first % BLOCK_SIZE == 0);
+        CuAssertTrue(testCase, (request.second > 0) and (request.second <= MAX_REQUEST_SIZE));
+        CuAssertTrue(testCase, request.first + request.second <= fileSize);
+    }
+}
+
+static CuSuite *halMmapBlockPrefetcherTestSuite(void) {
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, halMmapBlockPrefetcherCoalesceTest);
+    SUITE_ADD_TEST(suite, halMmapBlockPrefetcherWaitTest);
+    SUITE_ADD_TEST(suite, halMmapBlockPrefetcherReadTest);
+    return suite;
+}
+
+int main(int argc, char *argv[]) {
+    return runHalTestSuite(argc, argv, halMmapBlockPrefetcherTestSuite());
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halApiTestSupport.h"
+#include "hal.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+using namespace hal;
+
+/* create a random alignment from a fixed seed */
+static void createAlignment(const string &path, size_t fileSize, MMapSegmentLayout segmentLayout, MMapDnaLayout dnaLayout,
+                            int seed) {
+    RandNumberGen rng(false, seed);
+    AlignmentPtr alignment(mmapAlignmentInstance(path, CREATE_ACCESS, fileSize, segmentLayout, dnaLayout));
+    createRandomAlignment(rng, alignment, 1.25, 0.7, 5, 10, 10, 200, 20, 200);
+    alignment->close();
+}
+
+static string readFile(const string &path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+/* a file started with a tiny size and grown on demand must be identical to
+ * one created with plenty of space, as both are trimmed on close */
+static void halMmapGrowTest(CuTest *testCase) {
+    try {
+        for (int segmentLayout = MMAP_SEGMENT_LAYOUT_ROWS; segmentLayout <= MMAP_SEGMENT_LAYOUT_PACKED; segmentLayout++) {
+            for (int dnaLayout = MMAP_DNA_LAYOUT_NIBBLES; dnaLayout <= MMAP_DNA_LAYOUT_TWO_BIT; dnaLayout++) {
+                int seed = 1000 + 10 * segmentLayout + dnaLayout;
+                string fixedPath = getTempFile();
+                string grownPath = getTempFile();
+                createAlignment(fixedPath, MMAP_DEFAULT_FILE_SIZE, MMapSegmentLayout(segmentLayout),
+                                MMapDnaLayout(dnaLayout), seed);
+                createAlignment(grownPath, 4096, MMapSegmentLayout(segmentLayout), MMapDnaLayout(dnaLayout), seed);
+                string fixedData = readFile(fixedPath);
+                CuAssertTrue(testCase, fixedData.size() > 4096);
+                CuAssertTrue(testCase, readFile(grownPath) == fixedData);
+
+                AlignmentPtr grown(mmapAlignmentInstance(grownPath, READ_ACCESS));
+                validateAlignment(grown.get());
+                grown->close();
+                ::unlink(fixedPath.c_str());
+                ::unlink(grownPath.c_str());
+            }
+        }
+    } catch (const exception &e) {
+        CuFail(testCase, stString_print("Caught exception while testing: %s", e.what()));
+    }
+}
+
+static CuSuite *halMmapGrowTestSuite(void) {
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, halMmapGrowTest);
+    return suite;
+}
+
+int main(int argc, char *argv[]) {
+    return runHalTestSuite(argc, argv, halMmapGrowTestSuite());
+}
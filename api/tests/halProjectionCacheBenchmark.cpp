@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "hal.h"
+#include "halApiTestSupport.h"
+#include "halCLParser.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * Time column iteration as done by hal2maf, without and then with the
+ * projection cache.  Each sequence of the reference genome is walked with a
+ * ColumnIterator, visiting every genome, until the requested number of
+ * columns is reached.  A random alignment is created unless an existing HAL
+ * file is given.  Columns per second, a checksum of the positions in the
+ * columns (which must not differ) and the cache hit rates are reported.
+ */
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.setDescription("Benchmark hal2maf-style column iteration with the projection cache");
+    optionsParser.addOption("halFile", "existing HAL file to use rather than a random alignment", "");
+    optionsParser.addOption("refGenome", "reference genome (default: root)", "");
+    optionsParser.addOption("seed", "random number seed", 0);
+    optionsParser.addOption("minGenomes", "minimum number of genomes in random alignment", 8);
+    optionsParser.addOption("maxGenomes", "maximum number of genomes in random alignment", 12);
+    optionsParser.addOption("numSegments", "number of segments per sequence in random alignment", 5000);
+    optionsParser.addOption("numColumns", "maximum number of columns to visit", 1000000);
+    optionsParser.addOption("projectionCacheBytes", "maximum bytes of each projection cache", 64 * 1024 * 1024);
+    optionsParser.addOptionFlag("noDupes", "don't follow paralogy edges", false);
+    optionsParser.addOption("tmpDir", "directory for temporary HAL files", "/tmp");
+}
+
+static void createAlignment(const string &halPath, const CLParser &optionsParser) {
+    RandNumberGen rng(false, optionsParser.getOption<int>("seed"));
+    AlignmentPtr alignment(getTestAlignmentInstances(STORAGE_FORMAT_MMAP, halPath, CREATE_ACCESS));
+    hal_size_t numSegments = optionsParser.getOption<hal_size_t>("numSegments");
+    createRandomAlignment(rng, alignment, 1.5, 0.3, optionsParser.getOption<hal_size_t>("minGenomes"),
+                          optionsParser.getOption<hal_size_t>("maxGenomes"), 10, 200, numSegments, numSegments);
+    alignment->close();
+}
+
+struct ColumnCounts {
+    ColumnCounts() : _numColumns(0), _numBases(0), _checksum(0) {
+    }
+    hal_size_t _numColumns;
+    hal_size_t _numBases;
+    hal_size_t _checksum;
+};
+
+/* visit the columns of the reference genome the way MafExport does */
+static ColumnCounts iterateColumns(const Genome *refGenome, hal_size_t maxColumns, bool noDupes) {
+    ColumnCounts counts;
+    for (SequenceIteratorPtr seqIt(refGenome->getSequenceIterator()); not seqIt->atEnd() && counts._numColumns < maxColumns;
+         seqIt->toNext()) {
+        const Sequence *sequence = seqIt->getSequence();
+        if (sequence->getSequenceLength() == 0) {
+            continue;
+        }
+        hal_size_t length = min(sequence->getSequenceLength(), maxColumns - counts._numColumns);
+        ColumnIteratorPtr colIt = sequence->getColumnIterator(NULL, 0, 0, length - 1, noDupes);
+        while (true) {
+            for (const auto &seq_dnaSet : *colIt->getColumnMap()) {
+                for (const DnaIteratorPtr &dnaIt : *seq_dnaSet.second) {
+                    counts._numBases++;
+                    counts._checksum += dnaIt->getArrayIndex() + (dnaIt->getReversed() ? 1 : 0);
+                }
+            }
+            counts._numColumns++;
+            if (colIt->lastColumn()) {
+                break;
+            }
+            colIt->toRight();
+        }
+    }
+    return counts;
+}
+
+static ColumnCounts runBenchmark(const string &halPath, const CLParser &optionsParser, size_t cacheBytes) {
+    AlignmentPtr alignment(openHalAlignment(halPath, &optionsParser));
+    alignment->setProjectionCacheBytes(cacheBytes);
+    string refName = optionsParser.getOption<string>("refGenome");
+    const Genome *refGenome = alignment->openGenome(refName.empty() ? alignment->getRootName() : refName);
+    if (refGenome == NULL) {
+        throw hal_exception("reference genome not found");
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    ColumnCounts counts =
+        iterateColumns(refGenome, optionsParser.getOption<hal_size_t>("numColumns"), optionsParser.getFlag("noDupes"));
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << setw(12) << cacheBytes << setw(10) << fixed << setprecision(3) << secs << setprecision(0) << setw(14)
+         << counts._numColumns / secs << setw(14) << counts._numBases / secs << setw(16) << counts._checksum << endl;
+    if (cacheBytes > 0) {
+        alignment->printProjectionCacheStats(cout);
+    }
+    alignment->close();
+    return counts;
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser(CREATE_ACCESS);
+    initParser(optionsParser);
+    try {
+        optionsParser.parseOptions(argc, argv);
+    } catch (hal_exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+    try {
+        string halPath = optionsParser.getOption<string>("halFile");
+        bool randomAlignment = halPath.empty();
+        if (randomAlignment) {
+            halPath = optionsParser.getOption<string>("tmpDir") + "/halProjectionCacheBenchmark.hal";
+            createAlignment(halPath, optionsParser);
+        }
+        cout << setw(12) << "cacheBytes" << setw(10) << "secs" << setw(14) << "columns/sec" << setw(14) << "bases/sec"
+             << setw(16) << "checksum" << endl;
+        ColumnCounts uncached = runBenchmark(halPath, optionsParser, 0);
+        ColumnCounts cached = runBenchmark(halPath, optionsParser, optionsParser.getOption<size_t>("projectionCacheBytes"));
+        if (randomAlignment) {
+            ::remove(halPath.c_str());
+        }
+        if ((cached._numColumns != uncached._numColumns) || (cached._checksum != uncached._checksum)) {
+            throw hal_exception("columns differ with the projection cache");
+        }
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
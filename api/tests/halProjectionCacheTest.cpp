@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halApiTestSupport.h"
+#include "hal.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <deque>
+#include <string>
+
+using namespace std;
+using namespace hal;
+
+static RandNumberGen rng;
+
+/* a single page per genome pair, so that walking a genome evicts pages */
+static const size_t ONE_PAGE_BYTES = ProjectionCache::PAGE_SIZE * sizeof(hal_index_t);
+
+/* is the iterator at the same segment, slice and strand as the other? */
+static bool sameSegment(const SegmentIterator *it1, const SegmentIterator *it2) {
+    return (it1->getArrayIndex() == it2->getArrayIndex()) && (it1->getStartOffset() == it2->getStartOffset()) &&
+           (it1->getEndOffset() == it2->getEndOffset()) && (it1->getReversed() == it2->getReversed());
+}
+
+struct ProjectionCacheTest : public AlignmentTest {
+    void createCallBack(AlignmentPtr alignment) {
+        createRandomAlignment(rng, alignment, 1.5, 0.7, 3, 5, 2, 8, 4500, 5000);
+        // caching requires a read-only alignment
+        bool threw = false;
+        try {
+            alignment->setProjectionCacheBytes(ONE_PAGE_BYTES);
+        } catch (const hal_exception &ex) {
+            threw = true;
+        }
+        CuAssertTrue(_testCase, threw);
+    }
+
+    vector<string> getGenomeNames(AlignmentConstPtr alignment) {
+        vector<string> names;
+        deque<string> queue(1, alignment->getRootName());
+        while (not queue.empty()) {
+            names.push_back(queue.front());
+            queue.pop_front();
+            for (const string &child : alignment->getChildNames(names.back())) {
+                queue.push_back(child);
+            }
+        }
+        return names;
+    }
+
+    /* move each top segment, sliced and reversed, to the parent with and
+     * without the cache */
+    void checkToParent(const Genome *genome, const Genome *cachedGenome) {
+        TopSegmentIteratorPtr topSegIt = genome->getTopSegmentIterator();
+        TopSegmentIteratorPtr cachedTopSegIt = cachedGenome->getTopSegmentIterator();
+        BottomSegmentIteratorPtr botSegIt = genome->getParent()->getBottomSegmentIterator();
+        BottomSegmentIteratorPtr cachedBotSegIt = cachedGenome->getParent()->getBottomSegmentIterator();
+        for (hal_index_t i = 0; i < (hal_index_t)genome->getNumTopSegments(); ++i) {
+            topSegIt->setArrayIndex(const_cast<Genome *>(genome), i);
+            cachedTopSegIt->setArrayIndex(const_cast<Genome *>(cachedGenome), i);
+            if (topSegIt->getLength() > 2 && (i % 2) == 0) {
+                topSegIt->slice(1, 1);
+                cachedTopSegIt->slice(1, 1);
+            }
+            if ((i % 3) == 0) {
+                topSegIt->toReverse();
+                cachedTopSegIt->toReverse();
+            }
+            CuAssertTrue(_testCase, topSegIt->hasParent() == cachedTopSegIt->hasParent());
+            CuAssertTrue(_testCase, topSegIt->tseg()->hasParent() == cachedTopSegIt->hasParent());
+            if (topSegIt->hasParent()) {
+                botSegIt->toParent(topSegIt);
+                cachedBotSegIt->toParent(cachedTopSegIt);
+                CuAssertTrue(_testCase, sameSegment(botSegIt.get(), cachedBotSegIt.get()));
+            }
+        }
+    }
+
+    /* move each bottom segment, in reverse order, to each child with and
+     * without the cache */
+    void checkToChild(const Genome *genome, const Genome *cachedGenome) {
+        BottomSegmentIteratorPtr botSegIt = genome->getBottomSegmentIterator();
+        BottomSegmentIteratorPtr cachedBotSegIt = cachedGenome->getBottomSegmentIterator();
+        for (hal_size_t child = 0; child < genome->getNumChildren(); ++child) {
+            TopSegmentIteratorPtr topSegIt = genome->getChild(child)->getTopSegmentIterator();
+            TopSegmentIteratorPtr cachedTopSegIt = cachedGenome->getChild(child)->getTopSegmentIterator();
+            for (hal_index_t i = (hal_index_t)genome->getNumBottomSegments() - 1; i >= 0; --i) {
+                botSegIt->setArrayIndex(const_cast<Genome *>(genome), i);
+                cachedBotSegIt->setArrayIndex(const_cast<Genome *>(cachedGenome), i);
+                if ((i % 2) == 0) {
+                    botSegIt->toReverse();
+                    cachedBotSegIt->toReverse();
+                }
+                CuAssertTrue(_testCase, botSegIt->bseg()->hasChild(child) == cachedBotSegIt->hasChild(child));
+                if (botSegIt->bseg()->hasChild(child)) {
+                    topSegIt->toChild(botSegIt, child);
+                    cachedTopSegIt->toChild(cachedBotSegIt, child);
+                    CuAssertTrue(_testCase, sameSegment(topSegIt.get(), cachedTopSegIt.get()));
+                }
+            }
+        }
+    }
+
+    /* the same segments are mapped to the root with and without the cache */
+    void checkMapToRoot(const Genome *genome, const Genome *cachedGenome) {
+        vector<SourceInterval> intervals(1, SourceInterval(0, genome->getSequenceLength() - 1));
+        vector<MappedSegmentVector> mappedSegs, cachedMappedSegs;
+        const Alignment *alignment = genome->getAlignment();
+        const Alignment *cachedAlignment = cachedGenome->getAlignment();
+        halMapSegments(genome, intervals, mappedSegs, alignment->openGenome(alignment->getRootName()));
+        halMapSegments(cachedGenome, intervals, cachedMappedSegs, cachedAlignment->openGenome(cachedAlignment->getRootName()));
+        CuAssertIntEquals(_testCase, mappedSegs[0].size(), cachedMappedSegs[0].size());
+        for (size_t i = 0; i < mappedSegs[0].size(); ++i) {
+            const MappedSegmentRecord &mappedSeg = mappedSegs[0][i];
+            const MappedSegmentRecord &cachedMappedSeg = cachedMappedSegs[0][i];
+            CuAssertTrue(_testCase, mappedSeg._source.getStartPosition() == cachedMappedSeg._source.getStartPosition());
+            CuAssertTrue(_testCase, mappedSeg._target.getStartPosition() == cachedMappedSeg._target.getStartPosition());
+            CuAssertTrue(_testCase, mappedSeg._target.getLength() == cachedMappedSeg._target.getLength());
+            CuAssertTrue(_testCase, mappedSeg._target._reversed == cachedMappedSeg._target._reversed);
+        }
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        AlignmentPtr cached = getTestAlignmentInstances(alignment->getStorageFormat(), _checkPath, READ_ACCESS);
+        cached->setProjectionCacheBytes(ONE_PAGE_BYTES);
+        for (const string &name : getGenomeNames(alignment)) {
+            const Genome *genome = alignment->openGenome(name);
+            const Genome *cachedGenome = cached->openGenome(name);
+            if (genome->getParent() != NULL) {
+                checkToParent(genome, cachedGenome);
+                checkMapToRoot(genome, cachedGenome);
+            }
+            checkToChild(genome, cachedGenome);
+            CuAssertTrue(_testCase, (genome->getParent() == NULL) == (cachedGenome->getParentProjectionCache() == NULL));
+        }
+
+        size_t hits = 0, misses = 0, evictions = 0;
+        for (const string &name : getGenomeNames(alignment)) {
+            const Genome *genome = cached->openGenome(name);
+            if (genome->getParent() != NULL) {
+                const ProjectionCacheStats *stats =
+                    cached->getProjectionCacheStats(ProjectionCache::getPairName(genome, NULL_INDEX));
+                hits += stats->_hits;
+                misses += stats->_misses;
+                evictions += stats->_evictions;
+                CuAssertTrue(_testCase, genome->getParentProjectionCache()->getUsedBytes() <= ONE_PAGE_BYTES);
+            }
+        }
+        CuAssertTrue(_testCase, hits > misses);
+        CuAssertTrue(_testCase, evictions > 0);
+        cached->close();
+    }
+};
+
+static void halProjectionCacheTest(CuTest *testCase) {
+    ProjectionCacheTest tester;
+    tester.check(testCase);
+}
+
+static CuSuite *halProjectionCacheTestSuite(void) {
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, halProjectionCacheTest);
+    return suite;
+}
+
+int main(int argc, char *argv[]) {
+    return runHalTestSuite(argc, argv, halProjectionCacheTestSuite());
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "halApiTestSupport.h"
+#include "hal.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include "halSegmentCursor.h"
+#include "mmapGenome.h"
+#include "mmapSegmentAccess.h"
+#include <deque>
+#include <string>
+
+using namespace std;
+using namespace hal;
+
+static RandNumberGen rng;
+
+/* does the cursor have the same position, slice and strand as the iterator? */
+static bool sameSegment(const SlicedSegmentRecord &record, const SegmentIterator *segIt) {
+    SlicedSegmentRecord expect(segIt);
+    return (record._genome == expect._genome) && (record._arrayIndex == expect._arrayIndex) &&
+           (record._segStart == expect._segStart) && (record._segLength == expect._segLength) &&
+           (record._startOffset == expect._startOffset) && (record._endOffset == expect._endOffset) &&
+           (record._isTop == expect._isTop) && (record._reversed == expect._reversed);
+}
+
+struct SegmentCursorTest : public AlignmentTest {
+    void createCallBack(AlignmentPtr alignment) {
+        createRandomAlignment(rng, alignment, 1.5, 0.7, 3, 5, 2, 8, 50, 100);
+    }
+
+    vector<string> getGenomeNames(AlignmentConstPtr alignment) {
+        vector<string> names;
+        deque<string> queue(1, alignment->getRootName());
+        while (not queue.empty()) {
+            names.push_back(queue.front());
+            queue.pop_front();
+            for (const string &child : alignment->getChildNames(names.back())) {
+                queue.push_back(child);
+            }
+        }
+        return names;
+    }
+
+    /* slice every other segment and reverse every third */
+    void varySegment(SegmentIterator *segIt, hal_index_t i) {
+        if (segIt->getLength() > 2 && (i % 2) == 0) {
+            segIt->slice(1, 1);
+        }
+        if ((i % 3) == 0) {
+            segIt->toReverse();
+        }
+    }
+
+    /* follow the edges of each top segment with cursors and iterators */
+    template <class Access> void checkTop(const Genome *genome, SegmentAccessCache<Access> &access) {
+        Genome *mgenome = const_cast<Genome *>(genome);
+        TopSegmentIteratorPtr topSegIt = genome->getTopSegmentIterator();
+        TopSegmentIteratorPtr topSegIt2 = genome->getTopSegmentIterator();
+        BottomSegmentIteratorPtr botSegIt = genome->getBottomSegmentIterator();
+        BottomSegmentIteratorPtr parSegIt = genome->getParent()->getBottomSegmentIterator();
+        for (hal_index_t i = 0; i < (hal_index_t)genome->getNumTopSegments(); ++i) {
+            topSegIt->setArrayIndex(mgenome, i);
+            varySegment(topSegIt.get(), i);
+            TopSegmentCursor<Access> topCursor;
+            topCursor.load(access.getTop(genome), SlicedSegmentRecord(topSegIt.get()));
+            CuAssertTrue(_testCase, topCursor.hasParent() == topSegIt->tseg()->hasParent());
+            CuAssertTrue(_testCase, topCursor.isCanonicalParalog() == topSegIt->tseg()->isCanonicalParalog());
+            CuAssertTrue(_testCase, topCursor.hasNextParalogy() == topSegIt->tseg()->hasNextParalogy());
+            if (topSegIt->tseg()->hasParent()) {
+                BottomSegmentCursor<Access> botCursor;
+                parSegIt->toParent(topSegIt);
+                botCursor.toParent(topCursor, access.getBottom(genome->getParent()));
+                CuAssertTrue(_testCase, sameSegment(botCursor.getRecord(), parSegIt.get()));
+            }
+            if (topSegIt->tseg()->hasParseDown()) {
+                BottomSegmentCursor<Access> botCursor;
+                botSegIt->toParseDown(topSegIt);
+                botCursor.toParseDown(topCursor, access.getBottom(genome));
+                CuAssertTrue(_testCase, sameSegment(botCursor.getRecord(), botSegIt.get()));
+            }
+            if (topSegIt->tseg()->hasNextParalogy()) {
+                topSegIt2->copy(topSegIt);
+                topSegIt2->toNextParalogy();
+                TopSegmentCursor<Access> paraCursor(topCursor);
+                paraCursor.toNextParalogy();
+                CuAssertTrue(_testCase, sameSegment(paraCursor.getRecord(), topSegIt2.get()));
+            }
+            // walk to the end of the genome on the strand, cutting off the
+            // last base
+            hal_index_t cutoff = topSegIt->getReversed() ? 1 : (hal_index_t)genome->getSequenceLength() - 2;
+            bool beforeCutoff =
+                topSegIt->getReversed() ? topSegIt->getEndPosition() > cutoff : topSegIt->getEndPosition() < cutoff;
+            while (beforeCutoff && topSegIt->getEndPosition() != cutoff) {
+                topSegIt->toRight(cutoff);
+                topCursor.toRight(cutoff);
+                CuAssertTrue(_testCase, sameSegment(topCursor.getRecord(), topSegIt.get()));
+            }
+        }
+    }
+
+    /* follow the edges of each bottom segment with cursors and iterators */
+    template <class Access> void checkBottom(const Genome *genome, SegmentAccessCache<Access> &access) {
+        Genome *mgenome = const_cast<Genome *>(genome);
+        BottomSegmentIteratorPtr botSegIt = genome->getBottomSegmentIterator();
+        TopSegmentIteratorPtr topSegIt = genome->getTopSegmentIterator();
+        for (hal_index_t i = (hal_index_t)genome->getNumBottomSegments() - 1; i >= 0; --i) {
+            botSegIt->setArrayIndex(mgenome, i);
+            varySegment(botSegIt.get(), i);
+            BottomSegmentCursor<Access> botCursor;
+            botCursor.load(access.getBottom(genome), SlicedSegmentRecord(botSegIt.get()));
+            for (hal_size_t child = 0; child < genome->getNumChildren(); ++child) {
+                CuAssertTrue(_testCase, botCursor.hasChild(child) == botSegIt->bseg()->hasChild(child));
+                if (botSegIt->bseg()->hasChild(child)) {
+                    TopSegmentIteratorPtr childSegIt = genome->getChild(child)->getTopSegmentIterator();
+                    TopSegmentCursor<Access> topCursor;
+                    childSegIt->toChild(botSegIt, child);
+                    topCursor.toChild(botCursor, child, access.getTop(genome->getChild(child)));
+                    CuAssertTrue(_testCase, sameSegment(topCursor.getRecord(), childSegIt.get()));
+                }
+            }
+            if (genome->getParent() != NULL && botSegIt->bseg()->hasParseUp()) {
+                TopSegmentCursor<Access> topCursor;
+                topSegIt->toParseUp(botSegIt);
+                topCursor.toParseUp(botCursor, access.getTop(genome));
+                CuAssertTrue(_testCase, sameSegment(topCursor.getRecord(), topSegIt.get()));
+            }
+        }
+    }
+
+    template <class Access> void checkAccess(AlignmentConstPtr alignment) {
+        SegmentAccessCache<Access> access;
+        for (const string &name : getGenomeNames(alignment)) {
+            const Genome *genome = alignment->openGenome(name);
+            if (genome->getParent() != NULL) {
+                checkTop(genome, access);
+            }
+            checkBottom(genome, access);
+        }
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        checkAccess<GenericSegmentAccess>(alignment);
+        const MMapGenome *mmapGenome = dynamic_cast<const MMapGenome *>(alignment->openGenome(alignment->getRootName()));
+        if (mmapGenome != NULL) {
+            CuAssertTrue(_testCase, mmapGenome->hasDirectSegmentAccess());
+            checkAccess<MMapSegmentAccess>(alignment);
+        }
+    }
+};
+
+static void halSegmentCursorTest(CuTest *testCase) {
+    SegmentCursorTest tester;
+    tester.check(testCase);
+}
+
+static CuSuite *halSegmentCursorTestSuite(void) {
+    CuSuite *suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, halSegmentCursorTest);
+    return suite;
+}
+
+int main(int argc, char *argv[]) {
+    return runHalTestSuite(argc, argv, halSegmentCursorTestSuite());
+}
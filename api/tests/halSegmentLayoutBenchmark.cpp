@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "hal.h"
+#include "halApiTestSupport.h"
+#include "halCLParser.h"
+#include "halRandNumberGen.h"
+#include "halRandomData.h"
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * Compare the mmap rows, columns and packed segment layouts: generate the
+ * same random alignment in each layout, then time a full scan of the top
+ * and bottom segment arrays and random toSite() searches, and report the
+ * file sizes.
+ */
+
+struct BenchResult {
+    double _scanSecs;
+    double _toSiteSecs;
+    hal_size_t _numSegments;
+    hal_size_t _numQueries;
+    hal_size_t _checksum; // must be the same for all layouts
+    off_t _fileSize;
+};
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.setDescription("Benchmark mmap segment layouts");
+    optionsParser.addOption("seed", "random number seed", 0);
+    optionsParser.addOption("minGenomes", "minimum number of genomes", 20);
+    optionsParser.addOption("maxGenomes", "maximum number of genomes", 30);
+    optionsParser.addOption("minSegments", "minimum number of segments per sequence", 5000);
+    optionsParser.addOption("maxSegments", "maximum number of segments per sequence", 20000);
+    optionsParser.addOption("numQueries", "number of toSite() queries per genome", 100000);
+    optionsParser.addOption("numPasses", "number of scan passes over each genome", 5);
+    optionsParser.addOption("tmpDir", "directory for temporary HAL files", "/tmp");
+}
+
+static vector<const Genome *> getGenomes(const AlignmentConstPtr &alignment) {
+    vector<const Genome *> genomes;
+    deque<string> queue(1, alignment->getRootName());
+    while (not queue.empty()) {
+        genomes.push_back(alignment->openGenome(queue.front()));
+        for (const string &child : alignment->getChildNames(queue.front())) {
+            queue.push_back(child);
+        }
+        queue.pop_front();
+    }
+    return genomes;
+}
+
+static double elapsedSecs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static hal_size_t scanGenome(const Genome *genome, BenchResult &result) {
+    hal_size_t checksum = 0;
+    if (genome->getNumTopSegments() > 0) {
+        TopSegmentIteratorPtr topIt = genome->getTopSegmentIterator();
+        for (; not topIt->atEnd(); topIt->toRight()) {
+            checksum += topIt->getStartPosition() + topIt->tseg()->getParentIndex() + topIt->tseg()->getParentReversed();
+            result._numSegments++;
+        }
+    }
+    if (genome->getNumBottomSegments() > 0) {
+        BottomSegmentIteratorPtr botIt = genome->getBottomSegmentIterator();
+        for (; not botIt->atEnd(); botIt->toRight()) {
+            checksum += botIt->getStartPosition();
+            for (hal_size_t i = 0; i < botIt->bseg()->getNumChildren(); i++) {
+                checksum += botIt->bseg()->getChildIndex(i) + botIt->bseg()->getChildReversed(i);
+            }
+            result._numSegments++;
+        }
+    }
+    return checksum;
+}
+
+static hal_size_t searchGenome(const Genome *genome, RandNumberGen &rng, hal_size_t numQueries, BenchResult &result) {
+    hal_size_t checksum = 0;
+    if (genome->getSequenceLength() == 0) {
+        return 0;
+    }
+    TopSegmentIteratorPtr topIt;
+    if (genome->getNumTopSegments() > 0) {
+        topIt = genome->getTopSegmentIterator();
+    }
+    BottomSegmentIteratorPtr botIt;
+    if (genome->getNumBottomSegments() > 0) {
+        botIt = genome->getBottomSegmentIterator();
+    }
+    result._numQueries += numQueries;
+    for (hal_size_t i = 0; i < numQueries; i++) {
+        hal_index_t pos = rng.getRandInt(0, genome->getSequenceLength() - 1);
+        if (topIt != NULL) {
+            topIt->toSite(pos);
+            checksum += topIt->getArrayIndex();
+        }
+        if (botIt != NULL) {
+            botIt->toSite(pos);
+            checksum += botIt->getArrayIndex();
+        }
+    }
+    return checksum;
+}
+
+static BenchResult runBenchmark(const string &halPath, int seed, hal_size_t numQueries, hal_size_t numPasses) {
+    AlignmentPtr alignment(getTestAlignmentInstances(STORAGE_FORMAT_MMAP, halPath, READ_ACCESS));
+    vector<const Genome *> genomes = getGenomes(alignment);
+    BenchResult result = {0.0, 0.0, 0, 0, 0, 0};
+    struct stat fileStat;
+    if (::stat(halPath.c_str(), &fileStat) == 0) {
+        result._fileSize = fileStat.st_size;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (hal_size_t pass = 0; pass < numPasses; pass++) {
+        for (const Genome *genome : genomes) {
+            result._checksum += scanGenome(genome, result);
+        }
+    }
+    result._scanSecs = elapsedSecs(start);
+
+    RandNumberGen rng(false, seed);
+    start = chrono::steady_clock::now();
+    for (const Genome *genome : genomes) {
+        result._checksum += searchGenome(genome, rng, numQueries, result);
+    }
+    result._toSiteSecs = elapsedSecs(start);
+    alignment->close();
+    return result;
+}
+
+static void createAlignment(const string &storageFormat, const string &halPath, const CLParser &optionsParser) {
+    RandNumberGen rng(false, optionsParser.getOption<int>("seed"));
+    AlignmentPtr alignment(getTestAlignmentInstances(storageFormat, halPath, CREATE_ACCESS));
+    createRandomAlignment(rng, alignment, 2.0, 0.7, optionsParser.getOption<hal_size_t>("minGenomes"),
+                          optionsParser.getOption<hal_size_t>("maxGenomes"), 10, 200,
+                          optionsParser.getOption<hal_size_t>("minSegments"),
+                          optionsParser.getOption<hal_size_t>("maxSegments"));
+    alignment->close();
+}
+
+static void printResult(const string &layout, const BenchResult &result) {
+    cout << setw(8) << layout << setw(14) << fixed << setprecision(3) << result._scanSecs << setw(16) << setprecision(1)
+         << result._numSegments / result._scanSecs / 1.0e6 << setw(14) << setprecision(3) << result._toSiteSecs << setw(16)
+         << setprecision(1) << result._numQueries / result._toSiteSecs / 1.0e6 << setw(14) << result._fileSize << endl;
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser(CREATE_ACCESS);
+    initParser(optionsParser);
+    try {
+        optionsParser.parseOptions(argc, argv);
+    } catch (hal_exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+    try {
+        const string tmpDir = optionsParser.getOption<string>("tmpDir");
+        const string rowsPath = tmpDir + "/halSegmentLayoutBenchmark.rows.hal";
+        const string columnsPath = tmpDir + "/halSegmentLayoutBenchmark.columns.hal";
+        const string packedPath = tmpDir + "/halSegmentLayoutBenchmark.packed.hal";
+        int seed = optionsParser.getOption<int>("seed");
+        hal_size_t numQueries = optionsParser.getOption<hal_size_t>("numQueries");
+        hal_size_t numPasses = optionsParser.getOption<hal_size_t>("numPasses");
+
+        createAlignment(STORAGE_FORMAT_MMAP, rowsPath, optionsParser);
+        createAlignment(TEST_STORAGE_FORMAT_MMAP_COLUMNAR, columnsPath, optionsParser);
+        createAlignment(TEST_STORAGE_FORMAT_MMAP_PACKED, packedPath, optionsParser);
+
+        BenchResult rowsResult = runBenchmark(rowsPath, seed, numQueries, numPasses);
+        BenchResult columnsResult = runBenchmark(columnsPath, seed, numQueries, numPasses);
+        BenchResult packedResult = runBenchmark(packedPath, seed, numQueries, numPasses);
+        ::remove(rowsPath.c_str());
+        ::remove(columnsPath.c_str());
+        ::remove(packedPath.c_str());
+
+        cout << setw(8) << "layout" << setw(14) << "scanSecs" << setw(16) << "Msegs/sec" << setw(14) << "toSiteSecs"
+             << setw(16) << "Mqueries/sec" << setw(14) << "fileBytes" << endl;
+        printResult("rows", rowsResult);
+        printResult("columns", columnsResult);
+        printResult("packed", packedResult);
+        if ((rowsResult._checksum != columnsResult._checksum) or (rowsResult._checksum != packedResult._checksum)) {
+            throw hal_exception("checksums differ between layouts");
+        }
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
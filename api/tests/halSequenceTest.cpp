@@ -5,6 +5,7 @@
  * Released under the MIT license, see LICENSE.txt
  */
 #include "halApiTestSupport.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include "halSequence.h"
@@ -263,6 +264,49 @@ struct SequenceRenameTest : public AlignmentTest {
     }
 };
 
+/* Site lookups, including genomes with empty sequences.  Lookups
+ * alternate between genomes and go both forward and backward, so cached
+ * results are both hit and missed. */
+struct SequenceSiteMapTest : public AlignmentTest {
+    static vector<Sequence::Info> getDimensions(size_t numSequences, size_t emptyInterval) {
+        vector<Sequence::Info> seqVec;
+        for (size_t i = 0; i < numSequences; ++i) {
+            hal_size_t len = (i % emptyInterval == 0) ? 0 : 1 + (i * 7) % 13;
+            seqVec.push_back(Sequence::Info("sequence" + std::to_string(i), len, 0, 0));
+        }
+        return seqVec;
+    }
+
+    void createCallBack(AlignmentPtr alignment) {
+        Genome *ancGenome = alignment->addRootGenome("AncGenome", 0);
+        Genome *leafGenome = alignment->addLeafGenome("LeafGenome", "AncGenome", 0.1);
+        ancGenome->setDimensions(getDimensions(500, 5));
+        leafGenome->setDimensions(getDimensions(301, 3));
+        checkSites(ancGenome, leafGenome);
+    }
+
+    void checkSites(const Genome *genome, hal_index_t position) {
+        const Sequence *seq = genome->getSequenceBySite(position);
+        CuAssertTrue(_testCase, seq != NULL);
+        CuAssertTrue(_testCase, seq->getStartPosition() <= position);
+        CuAssertTrue(_testCase, position < seq->getStartPosition() + hal_index_t(seq->getSequenceLength()));
+    }
+
+    void checkSites(const Genome *ancGenome, const Genome *leafGenome) {
+        hal_index_t ancLength = ancGenome->getSequenceLength();
+        hal_index_t leafLength = leafGenome->getSequenceLength();
+        for (hal_index_t i = 0; i < std::max(ancLength, leafLength); i++) {
+            checkSites(ancGenome, i % ancLength);
+            checkSites(leafGenome, (leafLength - 1) - (i % leafLength));
+            checkSites(ancGenome, (i * 31) % ancLength);
+        }
+    }
+
+    void checkCallBack(AlignmentConstPtr alignment) {
+        checkSites(alignment->openGenome("AncGenome"), alignment->openGenome("LeafGenome"));
+    }
+};
+
 static void halSequenceCreateTest(CuTest *testCase) {
     SequenceCreateTest tester;
     tester.check(testCase);
@@ -283,12 +327,18 @@ static void halSequenceRenameTest(CuTest *testCase) {
     tester.check(testCase);
 }
 
+static void halSequenceSiteMapTest(CuTest *testCase) {
+    SequenceSiteMapTest tester;
+    tester.check(testCase);
+}
+
 static CuSuite *halSequenceTestSuite(void) {
     CuSuite *suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, halSequenceCreateTest);
     SUITE_ADD_TEST(suite, halSequenceIteratorTest);
     SUITE_ADD_TEST(suite, halSequenceUpdateTest);
     SUITE_ADD_TEST(suite, halSequenceRenameTest);
+    SUITE_ADD_TEST(suite, halSequenceSiteMapTest);
     return suite;
 }
 
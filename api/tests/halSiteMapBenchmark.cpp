@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "hal.h"
+#include "halApiTestSupport.h"
+#include "halCLParser.h"
+#include "halRandNumberGen.h"
+#include "mmapGenome.h"
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * Compare mmap genome site map lookups: the red-black tree, the Eytzinger
+ * search array, and getSequenceBySite(), which uses the search array and
+ * the per-thread cache.  A genome with many scaffolds is generated, then
+ * random positions and a sequential walk, as done when mapping segments,
+ * are looked up.
+ */
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.setDescription("Benchmark mmap genome site map lookups");
+    optionsParser.addOption("seed", "random number seed", 0);
+    optionsParser.addOption("numSequences", "number of sequences in the genome", 500000);
+    optionsParser.addOption("maxSequenceLength", "maximum length of a sequence", 5000);
+    optionsParser.addOption("numQueries", "number of queries of each kind", 5000000);
+    optionsParser.addOption("tmpDir", "directory for temporary HAL files", "/tmp");
+}
+
+static void createAlignment(const string &halPath, RandNumberGen &rng, hal_size_t numSequences,
+                            hal_size_t maxSequenceLength) {
+    AlignmentPtr alignment(getTestAlignmentInstances(STORAGE_FORMAT_MMAP, halPath, CREATE_ACCESS));
+    Genome *genome = alignment->addRootGenome("root");
+    vector<Sequence::Info> dimensions;
+    for (hal_size_t i = 0; i < numSequences; i++) {
+        dimensions.push_back(Sequence::Info("scaffold" + to_string(i), rng.getRandInt(1, maxSequenceLength), 0, 0));
+    }
+    genome->setDimensions(dimensions);
+    alignment->close();
+}
+
+enum LookupMethod { TREE_LOOKUP, ARRAY_LOOKUP, CACHED_LOOKUP };
+
+static hal_index_t lookup(const MMapGenomeSiteMap &siteMap, LookupMethod method, size_t position) {
+    MMapGenomeSiteMapHit hit;
+    switch (method) {
+    case TREE_LOOKUP:
+        return siteMap.treeSearch(position, hit) ? hit._sequenceIndex : NULL_INDEX;
+    case ARRAY_LOOKUP:
+        return siteMap.arraySearch(position, hit) ? hit._sequenceIndex : NULL_INDEX;
+    default:
+        return siteMap.getSequenceIndexBySite(position);
+    }
+}
+
+/* time lookups of the positions, returning a checksum of the sequence
+ * indexes found */
+static hal_size_t timeLookups(const MMapGenomeSiteMap &siteMap, LookupMethod method, const vector<size_t> &positions,
+                              double &secs) {
+    hal_size_t checksum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t position : positions) {
+        checksum += lookup(siteMap, method, position);
+    }
+    secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return checksum;
+}
+
+static void runBenchmark(const string &label, const MMapGenomeSiteMap &siteMap, const vector<size_t> &positions) {
+    static const char *methodNames[] = {"tree", "array", "cached"};
+    hal_size_t expectChecksum = 0;
+    for (int method = TREE_LOOKUP; method <= CACHED_LOOKUP; method++) {
+        double secs;
+        hal_size_t checksum = timeLookups(siteMap, LookupMethod(method), positions, secs);
+        if (method == TREE_LOOKUP) {
+            expectChecksum = checksum;
+        } else if (checksum != expectChecksum) {
+            throw hal_exception(string("checksum differs for ") + methodNames[method] + " lookups");
+        }
+        cout << setw(12) << label << setw(10) << methodNames[method] << setw(14) << fixed << setprecision(3) << secs
+             << setw(18) << setprecision(1) << positions.size() / secs / 1.0e6 << endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser(CREATE_ACCESS);
+    initParser(optionsParser);
+    try {
+        optionsParser.parseOptions(argc, argv);
+    } catch (hal_exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+    try {
+        const string halPath = optionsParser.getOption<string>("tmpDir") + "/halSiteMapBenchmark.hal";
+        RandNumberGen rng(false, optionsParser.getOption<int>("seed"));
+        hal_size_t numQueries = optionsParser.getOption<hal_size_t>("numQueries");
+        createAlignment(halPath, rng, optionsParser.getOption<hal_size_t>("numSequences"),
+                        optionsParser.getOption<hal_size_t>("maxSequenceLength"));
+
+        AlignmentPtr alignment(getTestAlignmentInstances(STORAGE_FORMAT_MMAP, halPath, READ_ACCESS));
+        const MMapGenome *genome = dynamic_cast<const MMapGenome *>(alignment->openGenome("root"));
+        const MMapGenomeSiteMap &siteMap = genome->getGenomeSiteMap();
+        if (not siteMap.hasSearchArray()) {
+            throw hal_exception("site map doesn't have a search array");
+        }
+        hal_size_t genomeLength = genome->getSequenceLength();
+        vector<size_t> randomPositions, walkPositions;
+        size_t walkStep = max(genomeLength / numQueries, hal_size_t(1));
+        for (hal_size_t i = 0; i < numQueries; i++) {
+            randomPositions.push_back(rng.getRandInt(0, genomeLength - 1));
+            walkPositions.push_back((i * walkStep) % genomeLength);
+        }
+
+        cout << setw(12) << "queries" << setw(10) << "method" << setw(14) << "secs" << setw(18) << "Mlookups/sec"
+             << endl;
+        runBenchmark("random", siteMap, randomPositions);
+        runBenchmark("sequential", siteMap, walkPositions);
+        alignment->close();
+        ::remove(halPath.c_str());
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -11,6 +11,7 @@
 #include "halBlockMapper.h"
 #include "halLodManager.h"
 #include "halMafExport.h"
+#include "halPairwiseBlockIndex.h"
 #include <algorithm>
 #include <cassert>
 #include <cerrno>
@@ -51,6 +52,10 @@ using namespace hal;
 typedef map<int, pair<string, LodManagerPtr>> HandleMap;
 static HandleMap handleMap;
 
+/* block indexes attached to each handle */
+typedef map<int, vector<PairwiseBlockIndexPtr>> BlockIndexMap;
+static BlockIndexMap blockIndexMap;
+
 static int openLodOrHal(char *inputPath, bool isLod, char **errStr);
 static void checkHandle(int handle);
 static void checkGenomes(int halHandle, AlignmentConstPtr alignment, const string &qSpecies, const string &tSpecies,
@@ -58,11 +63,13 @@ static void checkGenomes(int halHandle, AlignmentConstPtr alignment, const strin
 
 static AlignmentConstPtr getExistingAlignment(int handle, hal_size_t queryLength, bool needSequence);
 static bool isAlignmentLod0(int handle, hal_size_t queryLength);
+static const PairwiseBlockIndex *findBlockIndex(int handle, const Genome *tGenome, const Genome *qGenome);
 static char *copyCString(const string &inString);
 
 static hal_block_results_t *readBlocks(AlignmentConstPtr seqAlignment, const Sequence *tSequence, hal_index_t absStart,
                                        hal_index_t absEnd, bool tReversed, const Genome *qGenome, bool getSequenceString,
-                                       bool doDupes, bool doTargetDupes, bool doAdjes, const char *coalescenceLimitName);
+                                       bool doDupes, bool doTargetDupes, bool doAdjes, const char *coalescenceLimitName,
+                                       const PairwiseBlockIndex *blockIndex);
 
 static void readBlock(AlignmentConstPtr seqAlignment, hal_block_t *cur, vector<MappedSegmentPtr> &fragments,
                       bool getSequenceString, const string &genomeName);
@@ -168,6 +175,7 @@ extern "C" int halClose(int handle, char **errStr) {
             return -1;
         }
         handleMap.erase(mapIt);
+        blockIndexMap.erase(handle);
     } catch (exception &e) {
         halUnlock();
         handleError("halClose error on handle: " + std::to_string(handle) + ": " + e.what(), errStr);
@@ -207,6 +215,24 @@ extern "C" int halCloseGenome(int handle, const char *genomeName, char**errStr)
     return 0;
 }
 
+extern "C" int halAttachBlockIndex(int halHandle, char *indexPath, char **errStr) {
+    halLock();
+    try {
+        checkHandle(halHandle);
+        blockIndexMap[halHandle].push_back(PairwiseBlockIndexPtr(new PairwiseBlockIndex(indexPath)));
+    } catch (exception &e) {
+        halUnlock();
+        handleError("halAttachBlockIndex: " + string(e.what()), errStr);
+        return -1;
+    } catch (...) {
+        halUnlock();
+        handleError("halAttachBlockIndex: unknown exception", errStr);
+        return -1;
+    }
+    halUnlock();
+    return 0;
+}
+
 extern "C" void halFreeBlockResults(struct hal_block_results_t *results) {
     if (results != NULL) {
         halFreeBlocks(results->mappedBlocks);
@@ -300,8 +326,10 @@ extern "C" struct hal_block_results_t *halGetBlocksInTargetRange(int halHandle,
             return NULL;
         }
         // We now know the query length so we can do a proper lod query
+        hal_size_t queryLength = rangeLength;
         if (tEnd == 0) {
-            alignment = getExistingAlignment(halHandle, absEnd - absStart, false);
+            queryLength = absEnd - absStart;
+            alignment = getExistingAlignment(halHandle, queryLength, false);
             checkGenomes(halHandle, alignment, qSpecies, tSpecies, tChrom);
             qGenome = alignment->openGenome(qSpecies);
             tGenome = alignment->openGenome(tSpecies);
@@ -318,10 +346,15 @@ extern "C" struct hal_block_results_t *halGetBlocksInTargetRange(int halHandle,
             seqAlignment = getExistingAlignment(halHandle, absEnd - absStart, true);
         }
 
+        // block indexes are built from the full alignment
+        const PairwiseBlockIndex *blockIndex = NULL;
+        if (isAlignmentLod0(halHandle, queryLength)) {
+            blockIndex = findBlockIndex(halHandle, tGenome, qGenome);
+        }
         results = readBlocks(seqAlignment, tSequence, absStart, absEnd, tReversed != 0, qGenome, getSequenceString,
                              dupMode != HAL_NO_DUPS, dupMode == HAL_QUERY_AND_TARGET_DUPS,
                              mapBackAdjacencies != 0,
-                             coalescenceLimitName);
+                             coalescenceLimitName, blockIndex);
     } catch (exception &e) {
         halUnlock();
         handleError("halGetBlocksInTargetRange error reading blocks: " + string(e.what()), errStr);
@@ -667,9 +700,9 @@ extern "C" char *halGetDna(int halHandle, char *speciesName, char *chromName, ha
             return NULL;
         }
 
-        string buffer;
-        sequence->getSubString(buffer, start, end - start);
-        dna = copyCString(buffer);
+        dna = (char *)malloc(end - start + 1);
+        sequence->getSubString(dna, start, end - start);
+        dna[end - start] = '\0';
     } catch (exception &e) {
         halUnlock();
         handleError("halGetDna: " + string(e.what()), errStr);
@@ -750,6 +783,22 @@ static bool isAlignmentLod0(int handle, hal_size_t queryLength) {
     return mapIt->second.second->isLod0(queryLength);
 }
 
+/* find an index attached to the handle mapping from the reference to the
+ * query genome; BlockMapper checks the rest of the options */
+static const PairwiseBlockIndex *findBlockIndex(int handle, const Genome *tGenome, const Genome *qGenome) {
+    BlockIndexMap::const_iterator mapIt = blockIndexMap.find(handle);
+    if (mapIt == blockIndexMap.end()) {
+        return NULL;
+    }
+    for (const PairwiseBlockIndexPtr &blockIndex : mapIt->second) {
+        if ((blockIndex->getSrcGenomeName() == tGenome->getName()) &&
+            (blockIndex->getTgtGenomeName() == qGenome->getName())) {
+            return blockIndex.get();
+        }
+    }
+    return NULL;
+}
+
 static char *copyCString(const string &inString) {
     char *outString = (char *)malloc(inString.length() + 1);
     strcpy(outString, inString.c_str());
@@ -758,11 +807,13 @@ static char *copyCString(const string &inString) {
 
 static hal_block_results_t *readBlocks(AlignmentConstPtr seqAlignment, const Sequence *tSequence, hal_index_t absStart,
                                        hal_index_t absEnd, bool tReversed, const Genome *qGenome, bool getSequenceString,
-                                       bool doDupes, bool doTargetDupes, bool doAdjes, const char *coalescenceLimitName) {
+                                       bool doDupes, bool doTargetDupes, bool doAdjes, const char *coalescenceLimitName,
+                                       const PairwiseBlockIndex *blockIndex) {
     const Genome *tGenome = tSequence->getGenome();
     string qGenomeName = qGenome->getName();
     hal_block_t *prev = NULL;
     BlockMapper blockMapper;
+    blockMapper.setBlockIndex(blockIndex);
     if (qGenome == tGenome && coalescenceLimitName == NULL) {
         // By default, for self-alignment tracks, walk all the way back to
         // the root finding paralogies.
@@ -842,8 +893,6 @@ static void readBlock(AlignmentConstPtr seqAlignment, hal_block_t *cur, vector<M
     cur->next = NULL;
 
     string seqBuffer = qSequence->getName();
-    string qDnaBuffer;
-    string tDnaBuffer;
     size_t prefix = seqBuffer.find(genomeName + '.') != 0 ? 0 : genomeName.length() + 1;
     cur->qChrom = (char *)malloc(seqBuffer.length() + 1 - prefix);
     strcpy(cur->qChrom, seqBuffer.c_str() + prefix);
@@ -888,15 +937,12 @@ static void readBlock(AlignmentConstPtr seqAlignment, hal_block_t *cur, vector<M
             throw hal_exception("Unable to open sequence " + tSequence->getName() + " for DNA sequence extraction");
         }
 
-        qSeqSequence->getSubString(qDnaBuffer, cur->qStart, cur->size);
-        tSeqSequence->getSubString(tDnaBuffer, cur->tStart, cur->size);
-        if (cur->strand == '-') {
-            reverseComplement(qDnaBuffer);
-        }
-        cur->qSequence = (char *)malloc(qDnaBuffer.length() * sizeof(char) + 1);
-        cur->tSequence = (char *)malloc(tDnaBuffer.length() * sizeof(char) + 1);
-        strcpy(cur->qSequence, qDnaBuffer.c_str());
-        strcpy(cur->tSequence, tDnaBuffer.c_str());
+        cur->qSequence = (char *)malloc(cur->size * sizeof(char) + 1);
+        cur->tSequence = (char *)malloc(cur->size * sizeof(char) + 1);
+        qSeqSequence->getSubString(cur->qSequence, cur->qStart, cur->size, cur->strand == '-');
+        tSeqSequence->getSubString(cur->tSequence, cur->tStart, cur->size);
+        cur->qSequence[cur->size] = '\0';
+        cur->tSequence[cur->size] = '\0';
     }
 }
 
@@ -160,6 +160,21 @@ int halClose(int halHandle, char **errStr);
  * @return 0: success -1: failure
  */
 int halCloseGenome(int halHandle, const char *genomeName, char **errStr);
+
+/** Attach a block index made by halPairwiseIndex to an open alignment.
+ * halGetBlocksInTargetRange then uses the index, rather than following
+ * the alignment, to map ranges of the index's source genome as reference
+ * to its target genome as query.  This is only done when the full
+ * resolution alignment is used and the dupMode (dupes or no dupes) and
+ * coalescence limit are those the index was built with.  Several indexes
+ * can be attached to one handle.
+ * @param halHandle previously obtained from halOpen
+ * @param indexPath path of the block index file
+ * @param errStr pointer to a string that contains an error message on
+ * failure. If NULL, throws an exception on failure instead.
+ * @return 0: success -1: failure
+ */
+int halAttachBlockIndex(int halHandle, char *indexPath, char **errStr);
     
 /** Free block results structure */
 void halFreeBlockResults(struct hal_block_results_t *results);
@@ -36,6 +36,7 @@ struct bv_args_t {
     int doDupes;
     int numThreads;
     char *coalescenceLimit;
+    char *blockIndex;
     int verbose;
     int udcVerbose;
 };
@@ -47,6 +48,7 @@ static void initParser(hal::CLParser &optionsParser) {
     optionsParser.addOptionFlag("doDupes", "get duplicate regions", false);
     optionsParser.addOption("numThreads", "number of threads for thread tests", 10);
     optionsParser.addOption("coalescenceLimit", "coalescence limit specices, default is none", "");
+    optionsParser.addOption("blockIndex", "block index from halPairwiseIndex to attach, default is none", "");
     optionsParser.addArgument("halLodPath", "path to HAL or LOD file");
     optionsParser.addArgument("qSpecies", "query species name");
     optionsParser.addArgument("tSpecies", "target species name");
@@ -91,6 +93,7 @@ static bool parseArgs(int argc, char **argv, bv_args_t *args) {
     args->doDupes = optionsParser.get<bool>("doDupes");
     args->numThreads = optionsParser.get<int>("numThreads");
     args->coalescenceLimit = optionStrOrNull(optionsParser, "coalescenceLimit");
+    args->blockIndex = optionStrOrNull(optionsParser, "blockIndex");
     args->verbose = optionsParser.get<bool>("verbose");
     return true;
 }
@@ -249,6 +252,10 @@ int main(int argc, char **argv) {
         std::cerr << "ERROR: open failed: " << args.path << std::endl;
         return 1;
     }
+    if ((args.blockIndex != NULL) && (halAttachBlockIndex(handle, args.blockIndex, NULL) < 0)) {
+        std::cerr << "ERROR: attaching block index failed: " << args.blockIndex << std::endl;
+        return 1;
+    }
     if (!runTest(&args, handle)) {
         std::cerr << "ERROR: test failed" << std::endl;
         return 1;
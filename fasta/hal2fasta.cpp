@@ -15,14 +15,13 @@
 using namespace std;
 using namespace hal;
 
-static void printSequenceLine(ostream &outStream, const Sequence *sequence, hal_size_t start, hal_size_t length,
-                              string &buffer, bool upper);
 static void printSequence(ostream &outStream, const Sequence *sequence, hal_size_t lineWidth, hal_size_t start,
                           hal_size_t length, bool fullNames, bool upper);
 static void printGenome(ostream &outStream, const Genome *genome, const Sequence *sequence, hal_size_t lineWidth,
                         hal_size_t start, hal_size_t length, bool fullNames, bool upper);
 
-static const hal_size_t StringBufferSize = 1024;
+// DNA is decoded in chunks of about this size, which are then split into lines
+static const hal_size_t StringBufferSize = 1024 * 1024;
 
 static void initParser(CLParser &optionsParser) {
     optionsParser.addArgument("inHalPath", "input hal file");
@@ -148,21 +147,6 @@ int main(int argc, char **argv) {
     return 0;
 }
 
-void printSequenceLine(ostream &outStream, const Sequence *sequence, hal_size_t start, hal_size_t length, string &buffer, bool upper) {
-    hal_size_t last = start + length;
-    hal_size_t readLen;
-    for (hal_size_t i = start; i < last; i += StringBufferSize) {
-        readLen = std::min(StringBufferSize, last - i);
-        sequence->getSubString(buffer, i, readLen);
-        if (upper) {
-            for (int j = 0; j < buffer.size(); ++j) {
-                buffer[j] = std::toupper(buffer[j]);
-            }
-        }
-        outStream << buffer;
-    }
-}
-
 void printSequence(ostream &outStream, const Sequence *sequence, hal_size_t lineWidth, hal_size_t start, hal_size_t length, bool fullNames, bool upper) {
     hal_size_t seqLen = sequence->getSequenceLength();
     if (length == 0) {
@@ -175,12 +159,21 @@ void printSequence(ostream &outStream, const Sequence *sequence, hal_size_t line
                             std::to_string(seqLen));
     }
     outStream << '>' << (fullNames ? sequence->getFullName() : sequence->getName()) << '\n';
-    hal_size_t readLen;
-    string buffer;
-    for (hal_size_t i = start; i < last; i += lineWidth) {
-        readLen = std::min(lineWidth, last - i);
-        printSequenceLine(outStream, sequence, i, readLen, buffer, upper);
-        outStream << '\n';
+    // read a whole number of lines at a time
+    hal_size_t chunkSize = lineWidth * std::max(hal_size_t(1), StringBufferSize / lineWidth);
+    vector<char> buffer(std::min(chunkSize, length));
+    for (hal_size_t i = start; i < last; i += chunkSize) {
+        hal_size_t readLen = std::min(chunkSize, last - i);
+        sequence->getSubString(buffer.data(), i, readLen);
+        if (upper) {
+            for (hal_size_t j = 0; j < readLen; ++j) {
+                buffer[j] = std::toupper(buffer[j]);
+            }
+        }
+        for (hal_size_t j = 0; j < readLen; j += lineWidth) {
+            outStream.write(buffer.data() + j, std::min(lineWidth, readLen - j));
+            outStream << '\n';
+        }
     }
 }
 
@@ -8,27 +8,20 @@
 #include "halBlockLiftover.h"
 #include "halBlockMapper.h"
 #include "halSegmentMapper.h"
+#include <algorithm>
 #include <cassert>
 #include <deque>
 
 using namespace std;
 using namespace hal;
 
-BlockLiftover::BlockLiftover() : Liftover() {
+BlockLiftover::BlockLiftover() : Liftover(), _batchNext(0), _blockIndex(NULL) {
 }
 
 BlockLiftover::~BlockLiftover() {
 }
 
 void BlockLiftover::visitBegin() {
-    if (_srcGenome->getNumTopSegments() > 0) {
-        _refSeg = _srcGenome->getTopSegmentIterator();
-        _lastIndex = (hal_index_t)_srcGenome->getNumTopSegments();
-    } else {
-        _refSeg = _srcGenome->getBottomSegmentIterator();
-        _lastIndex = (hal_index_t)_srcGenome->getNumBottomSegments();
-    }
-
     set<const Genome *> inputSet;
     inputSet.insert(_srcGenome);
     inputSet.insert(_tgtGenome);
@@ -41,35 +34,46 @@ void BlockLiftover::visitBegin() {
     inputSet.insert(_coalescenceLimit);
     inputSet.insert(_tgtGenome);
     getGenomesInSpanningTree(inputSet, _downwardPath);
-}
 
-void BlockLiftover::liftInterval(BedList &mappedBedLines) {
-    _mappedSegments.clear();
-    hal_index_t globalStart = _bedLine._start + _srcSequence->getStartPosition();
-    hal_index_t globalEnd = _bedLine._end - 1 + _srcSequence->getStartPosition();
-    bool flip = _bedLine._strand == '-';
-
-    _refSeg->toSite(globalStart, false);
-    hal_offset_t startOffset = globalStart - _refSeg->getStartPosition();
-    hal_offset_t endOffset = 0;
-    if (globalEnd <= _refSeg->getEndPosition()) {
-        endOffset = _refSeg->getEndPosition() - globalEnd;
+    if ((_blockIndex != NULL) && !_blockIndex->matches(_srcGenome, _tgtGenome, _traverseDupes, _coalescenceLimit)) {
+        throw hal_exception("block index " + _blockIndex->getPath() + " is for " + _blockIndex->getDescription() +
+                            ", not " + _srcGenome->getName() + " to " + _tgtGenome->getName() +
+                            " with coalescence limit " + _coalescenceLimit->getName() +
+                            (_traverseDupes ? "" : " without dupes"));
     }
-    _refSeg->slice(startOffset, endOffset);
-
-    assert(_refSeg->getStartPosition() == globalStart);
-    assert(_refSeg->getEndPosition() <= globalEnd);
+}
 
-    while (_refSeg->getArrayIndex() < _lastIndex && _refSeg->getStartPosition() <= globalEnd) {
-        if (flip == true) {
-            _refSeg->toReverseInPlace();
-        }
-        halMapSegment(_refSeg.get(), _mappedSegments, _tgtGenome, &_downwardPath, _traverseDupes, 0, _coalescenceLimit, _mrca);
-        if (flip == true) {
-            _refSeg->toReverseInPlace();
+void BlockLiftover::mapBatch() {
+    // the intervals liftLine lifts for each line, in order
+    hal_index_t seqStart = _srcSequence->getStartPosition();
+    vector<SourceInterval> intervals;
+    for (const BedLine &bedLine : _batch) {
+        bool flip = bedLine._strand == '-';
+        if (bedLine._bedType <= 9) {
+            intervals.push_back(SourceInterval(bedLine._start + seqStart, bedLine._end - 1 + seqStart, flip));
+        } else {
+            vector<BedBlock> blocks = bedLine._blocks;
+            std::sort(blocks.begin(), blocks.end());
+            for (const BedBlock &block : blocks) {
+                if (block._length > 0) {
+                    hal_index_t start = bedLine._start + block._start + seqStart;
+                    intervals.push_back(SourceInterval(start, start + block._length - 1, flip));
+                }
+            }
         }
-        _refSeg->toRight(globalEnd);
     }
+    if (_blockIndex != NULL) {
+        _blockIndex->mapIntervals(_srcGenome, _tgtGenome, intervals, _batchSegments);
+    } else {
+        halMapSegments(_srcGenome, intervals, _batchSegments, _tgtGenome, &_downwardPath, _traverseDupes, 0,
+                       _coalescenceLimit, _mrca);
+    }
+    _batchNext = 0;
+}
+
+void BlockLiftover::liftInterval(BedList &mappedBedLines) {
+    assert(_batchNext < _batchSegments.size());
+    _batchSegments[_batchNext++].toSet(_mappedSegments);
 
     vector<MappedSegmentPtr> fragments;
     MappedSegmentSet emptySet;
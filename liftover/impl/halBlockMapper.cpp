@@ -19,7 +19,7 @@ using namespace std;
 
 hal_size_t BlockMapper::_maxAdjScan = 1;
 
-BlockMapper::BlockMapper() {
+BlockMapper::BlockMapper() : _blockIndex(NULL) {
 }
 
 BlockMapper::~BlockMapper() {
@@ -75,17 +75,46 @@ void BlockMapper::init(const Genome *refGenome, const Genome *queryGenome, hal_i
 }
 
 void BlockMapper::map() {
+    bool refIsTop = (_mrca != _refGenome) || (_refGenome == _queryGenome);
+    if ((_blockIndex != NULL) && (_minLength == 0) && (_blockIndex->getSrcIsTop() == refIsTop) &&
+        _blockIndex->matches(_refGenome, _queryGenome, _doDupes, _coalescenceLimit)) {
+        vector<SourceInterval> intervals(1, SourceInterval(_absRefFirst, _absRefLast, _targetReversed));
+        vector<MappedSegmentVector> segVectors;
+        _blockIndex->mapIntervals(_refGenome, _queryGenome, intervals, segVectors);
+        segVectors[0].toSet(_segSet);
+    } else {
+        mapFromAlignment(refIsTop);
+    }
+
+    if (_mapAdj) {
+        assert(_targetReversed == false);
+        MappedSegmentSet::const_iterator i;
+        for (i = _segSet.begin(); i != _segSet.end(); ++i) {
+            if (_adjSet.find(*i) == _adjSet.end()) {
+                mapAdjacencies(i);
+            }
+        }
+    }
+}
+
+void BlockMapper::mapFromAlignment(bool refIsTop) {
     SegmentIteratorPtr refSeg;
+    SegmentIteratorPtr refLastSeg;
     hal_index_t lastIndex;
-    if ((_mrca == _refGenome) && (_refGenome != _queryGenome)) {
+    if (!refIsTop) {
         refSeg = _refGenome->getBottomSegmentIterator();
+        refLastSeg = _refGenome->getBottomSegmentIterator();
         lastIndex = _refGenome->getNumBottomSegments();
     } else {
         refSeg = _refGenome->getTopSegmentIterator();
+        refLastSeg = _refGenome->getTopSegmentIterator();
         lastIndex = _refGenome->getNumTopSegments();
     }
 
     refSeg->toSite(_absRefFirst, false);
+    // announce the whole range, so a remote file can fetch it in parallel
+    refLastSeg->toSite(_absRefLast, false);
+    refSeg->prefetchTo(refLastSeg->getArrayIndex());
     hal_offset_t startOffset = _absRefFirst - refSeg->getStartPosition();
     hal_offset_t endOffset = 0;
     if (_absRefLast <= refSeg->getEndPosition()) {
@@ -96,26 +125,20 @@ void BlockMapper::map() {
     assert(refSeg->getStartPosition() == _absRefFirst);
     assert(refSeg->getEndPosition() <= _absRefLast);
 
+    // map into a flat vector and build the set from it in order
+    MappedSegmentVector segVector;
     while (refSeg->getArrayIndex() < lastIndex && refSeg->getStartPosition() <= _absRefLast) {
         if (_targetReversed == true) {
             refSeg->toReverseInPlace();
         }
-        halMapSegment(refSeg.get(), _segSet, _queryGenome, &_downwardPath, _doDupes, _minLength, _coalescenceLimit, _mrca);
+        halMapSegment(refSeg.get(), segVector, _queryGenome, &_downwardPath, _doDupes, _minLength, _coalescenceLimit, _mrca);
         if (_targetReversed == true) {
             refSeg->toReverseInPlace();
         }
         refSeg->toRight(_absRefLast);
     }
-
-    if (_mapAdj) {
-        assert(_targetReversed == false);
-        MappedSegmentSet::const_iterator i;
-        for (i = _segSet.begin(); i != _segSet.end(); ++i) {
-            if (_adjSet.find(*i) == _adjSet.end()) {
-                mapAdjacencies(i);
-            }
-        }
-    }
+    segVector.resolve();
+    segVector.toSet(_segSet);
 }
 
 void BlockMapper::mapAdjacencies(MappedSegmentSet::const_iterator segIt) {
@@ -14,7 +14,7 @@ using namespace hal;
 
 Liftover::Liftover()
     : _outBedStream(NULL), _outPSL(false), _outPSLWithName(false), _srcGenome(NULL),
-      _tgtGenome(NULL) {
+      _tgtGenome(NULL), _batchSequence(NULL) {
 }
 
 Liftover::~Liftover() {
@@ -23,21 +23,51 @@ Liftover::~Liftover() {
 void Liftover::convert(AlignmentConstPtr alignment, const Genome *srcGenome, istream *inBedStream, const Genome *tgtGenome,
                        ostream *outBedStream, int bedType, bool traverseDupes,
                        bool outPSL, bool outPSLWithName, const Genome *coalescenceLimit) {
+    assert(inBedStream && outBedStream);
+    setOptions(alignment, srcGenome, tgtGenome, bedType, traverseDupes, outPSL, outPSLWithName, coalescenceLimit);
+    _outBedStream = outBedStream;
+    scan(inBedStream, bedType);
+}
+
+void Liftover::setup(AlignmentConstPtr alignment, const Genome *srcGenome, const Genome *tgtGenome, int bedType,
+                     bool traverseDupes, bool outPSL, bool outPSLWithName, const Genome *coalescenceLimit) {
+    setOptions(alignment, srcGenome, tgtGenome, bedType, traverseDupes, outPSL, outPSLWithName, coalescenceLimit);
+    visitBegin();
+}
+
+void Liftover::liftLines(const vector<BedLine> &bedLines, hal_size_t firstLineNumber, ostream *outBedStream) {
+    assert(outBedStream != NULL);
+    _outBedStream = outBedStream;
+    _lineNumber = firstLineNumber;
+    try {
+        for (size_t i = 0; i < bedLines.size(); ++i) {
+            _lineNumber = firstLineNumber + i;
+            _bedLine = bedLines[i];
+            visitLine();
+        }
+        visitEOF();
+    } catch (hal_exception &e) {
+        throw hal_exception(string(e.what()) + " in input bed line " + std::to_string(_lineNumber));
+    }
+    _outBedStream = NULL;
+}
+
+void Liftover::setOptions(AlignmentConstPtr alignment, const Genome *srcGenome, const Genome *tgtGenome, int bedType,
+                          bool traverseDupes, bool outPSL, bool outPSLWithName, const Genome *coalescenceLimit) {
+    _alignment = alignment;
     _srcGenome = srcGenome;
     _tgtGenome = tgtGenome;
     _coalescenceLimit = coalescenceLimit;
-    _outBedStream = outBedStream;
     _bedType = bedType;
     _traverseDupes = traverseDupes;
     _outPSL = outPSL;
     _outPSLWithName = outPSLWithName;
     _missedSet.clear();
     _tgtSet.clear();
-    assert(_srcGenome && inBedStream && tgtGenome && outBedStream);
+    _batch.clear();
+    assert(_srcGenome && tgtGenome);
 
     _tgtSet.insert(tgtGenome);
-
-    scan(inBedStream, bedType);
 }
 
 void Liftover::visitBegin() {
@@ -48,7 +78,6 @@ void Liftover::visitLine() {
         // forcing to BED12 makes PSL code simpler
         _bedLine.expandToBed12();
     }
-    _outBedLines.clear();
     _srcSequence = _srcGenome->getSequence(_bedLine._chrName);
     if (_srcSequence == NULL) {
         pair<set<string>::iterator, bool> result = _missedSet.insert(_bedLine._chrName);
@@ -69,6 +98,47 @@ void Liftover::visitLine() {
         return;
     }
 
+    if (!_batch.empty() && (_srcSequence != _batchSequence || _bedLine._start < _batch.back()._start)) {
+        flushBatch();
+    }
+    _batchSequence = _srcSequence;
+    _batch.push_back(_bedLine);
+    if (_batch.size() >= MaxBatchLines) {
+        flushBatch();
+    }
+}
+
+void Liftover::visitEOF() {
+    flushBatch();
+}
+
+/* lift and write all lines in the batch, leaving the current line as it
+ * was */
+void Liftover::flushBatch() {
+    if (_batch.empty()) {
+        return;
+    }
+    BedLine curLine = _bedLine;
+    const Sequence *curSequence = _srcSequence;
+    _srcSequence = _batchSequence;
+    mapBatch();
+    for (const BedLine &bedLine : _batch) {
+        _bedLine = bedLine;
+        liftLine();
+    }
+    _batch.clear();
+    _bedLine = curLine;
+    _srcSequence = curSequence;
+}
+
+/* hook to map the intervals of all lines in the batch at once before
+ * liftInterval() is called for each of them */
+void Liftover::mapBatch() {
+}
+
+/* lift the current line and write the results */
+void Liftover::liftLine() {
+    _outBedLines.clear();
     _mappedBlocks.clear();
     if (_bedLine._bedType <= 9) {
         liftInterval(_mappedBlocks);
@@ -91,9 +161,6 @@ void Liftover::visitLine() {
     writeLineResults();
 }
 
-void Liftover::visitEOF() {
-}
-
 void Liftover::writeLineResults() {
     BedList::iterator i = _outBedLines.begin();
     for (; i != _outBedLines.end(); ++i) {
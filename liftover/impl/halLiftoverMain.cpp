@@ -7,9 +7,11 @@
 
 #include "halBlockLiftover.h"
 #include "halColumnLiftover.h"
+#include "halParallelLiftover.h"
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <memory>
 
 using namespace std;
 using namespace hal;
@@ -39,6 +41,10 @@ static void initParser(CLParser &optionsParser) {
     optionsParser.addOption("bedType", "number of standard columns (3 to 12), columns beyond this are passed "
                             "through.  This only needs to be specified for BEDs with less than 12 columns and "
                             "having non-standard extra columns.", 0);
+    optionsParser.addOption("numThreads", "number of threads to lift lines on.  Output is in the same order as "
+                            "with one thread.  More than one thread requires an mmap HAL file.", 1);
+    optionsParser.addOption("blockIndex", "map intervals with a block index made by halPairwiseIndex for the same "
+                            "genomes and options, rather than by following the alignment", "");
     optionsParser.setDescription("Map BED or PSL genome interval coordinates between "
                                  "two genomes.");
 }
@@ -58,6 +64,8 @@ int main(int argc, char **argv) {
     int bedType;
     bool outPSL;
     bool outPSLWithName;
+    int numThreads;
+    string blockIndexPath;
     try {
         optionsParser.parseOptions(argc, argv);
         halPath = optionsParser.getArgument<string>("halFile");
@@ -78,6 +86,11 @@ int main(int argc, char **argv) {
         }
         outPSL = optionsParser.getFlag("outPSL");
         outPSLWithName = optionsParser.getFlag("outPSLWithName");
+        numThreads = optionsParser.getOption<int>("numThreads");
+        if (numThreads < 1) {
+            throw hal_exception("--numThreads must be at least 1");
+        }
+        blockIndexPath = optionsParser.getOption<string>("blockIndex");
     } catch (exception &e) {
         cerr << e.what() << endl;
         optionsParser.printUsage(cerr);
@@ -88,7 +101,9 @@ int main(int argc, char **argv) {
         if (outPSLWithName == true) {
             outPSL = true;
         }
-        AlignmentConstPtr alignment(openHalAlignment(halPath, &optionsParser));
+        // threads share the alignment
+        unsigned openMode = (numThreads > 1) ? CONCURRENT_READ_ACCESS : READ_ACCESS;
+        AlignmentConstPtr alignment(openHalAlignment(halPath, &optionsParser, openMode));
         if (alignment->getNumGenomes() == 0) {
             throw hal_exception("hal alignment is empty");
         }
@@ -135,11 +150,30 @@ int main(int argc, char **argv) {
             }
         }
 
-        BlockLiftover liftover;
-        liftover.convert(alignment, srcGenome, srcBedPtr, tgtGenome, tgtBedPtr, bedType,
-                         !noDupes, outPSL, outPSLWithName, coalescenceLimit);
-
+        unique_ptr<PairwiseBlockIndex> blockIndex;
+        if (!blockIndexPath.empty()) {
+            blockIndex.reset(new PairwiseBlockIndex(blockIndexPath));
+        }
 
+        if (numThreads == 1) {
+            BlockLiftover liftover;
+            liftover.setBlockIndex(blockIndex.get());
+            liftover.convert(alignment, srcGenome, srcBedPtr, tgtGenome, tgtBedPtr, bedType,
+                             !noDupes, outPSL, outPSLWithName, coalescenceLimit);
+        } else {
+            vector<unique_ptr<Liftover>> liftovers;
+            vector<Liftover *> workerLiftovers;
+            for (int i = 0; i < numThreads; i++) {
+                BlockLiftover *liftover = new BlockLiftover();
+                liftover->setBlockIndex(blockIndex.get());
+                liftovers.push_back(unique_ptr<Liftover>(liftover));
+                liftovers.back()->setup(alignment, srcGenome, tgtGenome, bedType, !noDupes, outPSL, outPSLWithName,
+                                        coalescenceLimit);
+                workerLiftovers.push_back(liftovers.back().get());
+            }
+            ParallelLiftover parallelLiftover(workerLiftovers);
+            parallelLiftover.convert(srcBedPtr, tgtBedPtr, bedType);
+        }
     } catch (hal_exception &e) {
         cerr << "hal exception caught: " << e.what() << endl;
         return 1;
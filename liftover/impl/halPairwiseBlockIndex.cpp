@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#include "halPairwiseBlockIndex.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * File layout: the header, the blocks sorted by lowest source position,
+ * then the running maximum of their highest source positions.  Integers
+ * are in host byte order.
+ */
+static const char FORMAT_NAME[] = "HAL-BLOCK-INDEX";
+static const uint64_t FORMAT_VERSION = 1;
+static const size_t MAX_NAME_SIZE = 256;
+
+/* number of source segments mapped at a time by build() */
+static const size_t BUILD_BATCH_SEGMENTS = 4096;
+
+namespace hal {
+    struct PairwiseBlockIndexHeader {
+        char _format[16];
+        uint64_t _version;
+        uint64_t _numBlocks;
+        uint64_t _doDupes;
+        uint64_t _srcIsTop;
+        // genome sizes when built, to detect a changed alignment
+        uint64_t _srcLength;
+        uint64_t _srcNumSegments;
+        uint64_t _tgtLength;
+        uint64_t _tgtNumSegments;
+        char _srcGenome[MAX_NAME_SIZE];
+        char _tgtGenome[MAX_NAME_SIZE];
+        char _coalescenceLimit[MAX_NAME_SIZE];
+    };
+
+    /* a SlicedSegmentRecord without its genome */
+    struct PairwiseBlockSegment {
+        int64_t _arrayIndex;
+        int64_t _segStart;
+        uint64_t _segLength;
+        uint64_t _startOffset;
+        uint64_t _endOffset;
+        uint8_t _isTop;
+        uint8_t _reversed;
+        uint8_t _unused[6];
+    };
+
+    struct PairwiseBlock {
+        PairwiseBlockSegment _source;
+        PairwiseBlockSegment _target;
+    };
+}
+
+static void toBlockSegment(const SlicedSegmentRecord &record, PairwiseBlockSegment &segment) {
+    memset(&segment, 0, sizeof(segment));
+    segment._arrayIndex = record._arrayIndex;
+    segment._segStart = record._segStart;
+    segment._segLength = record._segLength;
+    segment._startOffset = record._startOffset;
+    segment._endOffset = record._endOffset;
+    segment._isTop = record._isTop;
+    segment._reversed = record._reversed;
+}
+
+static void fromBlockSegment(const PairwiseBlockSegment &segment, const Genome *genome, SlicedSegmentRecord &record) {
+    record._genome = genome;
+    record._arrayIndex = segment._arrayIndex;
+    record._segStart = segment._segStart;
+    record._segLength = segment._segLength;
+    record._startOffset = segment._startOffset;
+    record._endOffset = segment._endOffset;
+    record._isTop = segment._isTop;
+    record._reversed = segment._reversed;
+}
+
+static hal_index_t getLow(const SlicedSegmentRecord &record) {
+    return min(record.getStartPosition(), record.getEndPosition());
+}
+
+static hal_index_t getHigh(const SlicedSegmentRecord &record) {
+    return max(record.getStartPosition(), record.getEndPosition());
+}
+
+/* order by lowest source position, with ties in a fixed order */
+static bool lessSourceLow(const MappedSegmentRecord &ms1, const MappedSegmentRecord &ms2) {
+    hal_index_t low1 = getLow(ms1._source);
+    hal_index_t low2 = getLow(ms2._source);
+    if (low1 != low2) {
+        return low1 < low2;
+    }
+    return ms1.lessThanBySource(ms2);
+}
+
+static hal_size_t getNumSegments(const Genome *genome, bool isTop) {
+    return isTop ? genome->getNumTopSegments() : genome->getNumBottomSegments();
+}
+
+static void copyName(const string &name, char *dest) {
+    if (name.size() >= MAX_NAME_SIZE) {
+        throw hal_exception("genome name too long for block index: " + name);
+    }
+    strncpy(dest, name.c_str(), MAX_NAME_SIZE);
+}
+
+static const Genome *getMrca(const Genome *srcGenome, const Genome *tgtGenome) {
+    set<const Genome *> inputSet;
+    inputSet.insert(srcGenome);
+    inputSet.insert(tgtGenome);
+    return getLowestCommonAncestor(inputSet);
+}
+
+hal_size_t PairwiseBlockIndex::build(const Genome *srcGenome, const Genome *tgtGenome, const string &indexPath,
+                                     bool doDupes, const Genome *coalescenceLimit) {
+    const Genome *mrca = getMrca(srcGenome, tgtGenome);
+    if (coalescenceLimit == NULL) {
+        coalescenceLimit = mrca;
+    }
+    // same path as BlockLiftover and BlockMapper
+    set<const Genome *> inputSet;
+    inputSet.insert(coalescenceLimit);
+    inputSet.insert(tgtGenome);
+    set<const Genome *> downwardPath;
+    getGenomesInSpanningTree(inputSet, downwardPath);
+
+    // map each whole segment, as halMapSegmentRecords cuts intervals into
+    // segments
+    bool srcIsTop = srcGenome->getNumTopSegments() > 0;
+    hal_size_t numSegments = getNumSegments(srcGenome, srcIsTop);
+    SegmentIteratorPtr srcSegIt;
+    if (srcIsTop) {
+        srcSegIt = srcGenome->getTopSegmentIterator();
+    } else {
+        srcSegIt = srcGenome->getBottomSegmentIterator();
+    }
+    vector<MappedSegmentRecord> blocks;
+    vector<MappedSegmentRecord> batchBlocks;
+    vector<SourceInterval> intervals;
+    for (hal_size_t i = 0; i < numSegments; ++i) {
+        intervals.push_back(SourceInterval(srcSegIt->getStartPosition(), srcSegIt->getEndPosition()));
+        srcSegIt->toRight();
+        if ((intervals.size() == BUILD_BATCH_SEGMENTS) || (i == numSegments - 1)) {
+            halMapSegmentRecords(srcGenome, intervals, batchBlocks, tgtGenome, &downwardPath, doDupes, 0,
+                                 coalescenceLimit, mrca);
+            blocks.insert(blocks.end(), batchBlocks.begin(), batchBlocks.end());
+            intervals.clear();
+        }
+    }
+    sort(blocks.begin(), blocks.end(), lessSourceLow);
+
+    PairwiseBlockIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header._format, FORMAT_NAME, sizeof(header._format));
+    header._version = FORMAT_VERSION;
+    header._numBlocks = blocks.size();
+    header._doDupes = doDupes;
+    header._srcIsTop = srcIsTop;
+    header._srcLength = srcGenome->getSequenceLength();
+    header._srcNumSegments = numSegments;
+    header._tgtLength = tgtGenome->getSequenceLength();
+    header._tgtNumSegments = tgtGenome->getNumTopSegments() + tgtGenome->getNumBottomSegments();
+    copyName(srcGenome->getName(), header._srcGenome);
+    copyName(tgtGenome->getName(), header._tgtGenome);
+    copyName(coalescenceLimit->getName(), header._coalescenceLimit);
+
+    ofstream indexFile(indexPath.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!indexFile) {
+        throw hal_errno_exception(indexPath, "open failed", errno);
+    }
+    indexFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (const MappedSegmentRecord &record : blocks) {
+        PairwiseBlock block;
+        toBlockSegment(record._source, block._source);
+        toBlockSegment(record._target, block._target);
+        indexFile.write(reinterpret_cast<const char *>(&block), sizeof(block));
+    }
+    hal_index_t maxSrcHigh = NULL_INDEX;
+    for (const MappedSegmentRecord &record : blocks) {
+        maxSrcHigh = max(maxSrcHigh, getHigh(record._source));
+        indexFile.write(reinterpret_cast<const char *>(&maxSrcHigh), sizeof(maxSrcHigh));
+    }
+    indexFile.close();
+    if (!indexFile) {
+        throw hal_errno_exception(indexPath, "write failed", errno);
+    }
+    return blocks.size();
+}
+
+PairwiseBlockIndex::PairwiseBlockIndex(const string &indexPath)
+    : _indexPath(indexPath), _basePtr(NULL), _fileSize(0), _header(NULL), _blocks(NULL), _maxSrcHigh(NULL) {
+    int fd = open(indexPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw hal_errno_exception(indexPath, "open failed", errno);
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) < 0) {
+        int errnum = errno;
+        close(fd);
+        throw hal_errno_exception(indexPath, "stat failed", errnum);
+    }
+    _fileSize = fileStat.st_size;
+    if (_fileSize < sizeof(PairwiseBlockIndexHeader)) {
+        close(fd);
+        throw hal_exception(indexPath + ": not a HAL block index file");
+    }
+    _basePtr = mmap(NULL, _fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    int errnum = errno;
+    close(fd);
+    if (_basePtr == MAP_FAILED) {
+        _basePtr = NULL;
+        throw hal_errno_exception(indexPath, "mmap failed", errnum);
+    }
+
+    _header = static_cast<const PairwiseBlockIndexHeader *>(_basePtr);
+    const char *dataPtr = static_cast<const char *>(_basePtr) + sizeof(PairwiseBlockIndexHeader);
+    _blocks = reinterpret_cast<const PairwiseBlock *>(dataPtr);
+    _maxSrcHigh = reinterpret_cast<const hal_index_t *>(dataPtr + _header->_numBlocks * sizeof(PairwiseBlock));
+    string error;
+    if (strncmp(_header->_format, FORMAT_NAME, sizeof(_header->_format)) != 0) {
+        error = "not a HAL block index file";
+    } else if (_header->_version != FORMAT_VERSION) {
+        error = "unsupported block index version " + std::to_string(_header->_version) + ", expected " +
+                std::to_string(FORMAT_VERSION);
+    } else if (_fileSize !=
+               sizeof(PairwiseBlockIndexHeader) + _header->_numBlocks * (sizeof(PairwiseBlock) + sizeof(hal_index_t))) {
+        error = "block index file is truncated or corrupt";
+    }
+    if (!error.empty()) {
+        munmap(_basePtr, _fileSize);
+        throw hal_exception(indexPath + ": " + error);
+    }
+}
+
+PairwiseBlockIndex::~PairwiseBlockIndex() {
+    if (_basePtr != NULL) {
+        munmap(_basePtr, _fileSize);
+    }
+}
+
+hal_size_t PairwiseBlockIndex::getNumBlocks() const {
+    return _header->_numBlocks;
+}
+
+string PairwiseBlockIndex::getSrcGenomeName() const {
+    return string(_header->_srcGenome, strnlen(_header->_srcGenome, MAX_NAME_SIZE));
+}
+
+string PairwiseBlockIndex::getTgtGenomeName() const {
+    return string(_header->_tgtGenome, strnlen(_header->_tgtGenome, MAX_NAME_SIZE));
+}
+
+string PairwiseBlockIndex::getCoalescenceLimitName() const {
+    return string(_header->_coalescenceLimit, strnlen(_header->_coalescenceLimit, MAX_NAME_SIZE));
+}
+
+bool PairwiseBlockIndex::getDoDupes() const {
+    return _header->_doDupes != 0;
+}
+
+bool PairwiseBlockIndex::getSrcIsTop() const {
+    return _header->_srcIsTop != 0;
+}
+
+string PairwiseBlockIndex::getDescription() const {
+    return getSrcGenomeName() + " to " + getTgtGenomeName() + " with coalescence limit " + getCoalescenceLimitName() +
+           (getDoDupes() ? "" : " without dupes");
+}
+
+bool PairwiseBlockIndex::matches(const Genome *srcGenome, const Genome *tgtGenome, bool doDupes,
+                                 const Genome *coalescenceLimit) const {
+    if (coalescenceLimit == NULL) {
+        coalescenceLimit = getMrca(srcGenome, tgtGenome);
+    }
+    if ((srcGenome->getName() != getSrcGenomeName()) or (tgtGenome->getName() != getTgtGenomeName()) or
+        (coalescenceLimit->getName() != getCoalescenceLimitName()) or (doDupes != getDoDupes())) {
+        return false;
+    }
+    if ((srcGenome->getSequenceLength() != _header->_srcLength) or
+        (getNumSegments(srcGenome, getSrcIsTop()) != _header->_srcNumSegments)) {
+        throw hal_exception(_indexPath + ": genome " + srcGenome->getName() + " has changed since the index was built");
+    }
+    if ((tgtGenome->getSequenceLength() != _header->_tgtLength) or
+        (tgtGenome->getNumTopSegments() + tgtGenome->getNumBottomSegments() != _header->_tgtNumSegments)) {
+        throw hal_exception(_indexPath + ": genome " + tgtGenome->getName() + " has changed since the index was built");
+    }
+    return true;
+}
+
+/* Slice a block to the part whose source is in an interval.  As source and
+ * target are aligned from their start positions, the same offsets are added
+ * to both. */
+static void clipToInterval(MappedSegmentRecord &record, const SourceInterval &interval) {
+    SlicedSegmentRecord &source = record._source;
+    SlicedSegmentRecord &target = record._target;
+    hal_offset_t lowDelta = max(interval._start - getLow(source), (hal_index_t)0);
+    hal_offset_t highDelta = max(getHigh(source) - interval._end, (hal_index_t)0);
+    hal_offset_t startDelta = source._reversed ? highDelta : lowDelta;
+    hal_offset_t endDelta = source._reversed ? lowDelta : highDelta;
+    source.slice(source._startOffset + startDelta, source._endOffset + endDelta);
+    target.slice(target._startOffset + startDelta, target._endOffset + endDelta);
+}
+
+/* reverse both segments in place, as mapping from the reverse strand does */
+static void reverseRecord(SlicedSegmentRecord &record) {
+    swap(record._startOffset, record._endOffset);
+    record._reversed = !record._reversed;
+}
+
+hal_size_t PairwiseBlockIndex::mapIntervals(const Genome *srcGenome, const Genome *tgtGenome,
+                                            const vector<SourceInterval> &intervals,
+                                            vector<MappedSegmentVector> &outSegments) const {
+    assert((srcGenome->getName() == getSrcGenomeName()) && (tgtGenome->getName() == getTgtGenomeName()));
+    hal_size_t numBlocks = getNumBlocks();
+    hal_size_t numMapped = 0;
+    outSegments.resize(intervals.size());
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        const SourceInterval &interval = intervals[i];
+        MappedSegmentVector &segVector = outSegments[i];
+        segVector.clear();
+        if (interval._end < interval._start) {
+            continue;
+        }
+        // blocks before this one all end before the interval
+        hal_size_t iBlock = lower_bound(_maxSrcHigh, _maxSrcHigh + numBlocks, interval._start) - _maxSrcHigh;
+        for (; iBlock < numBlocks; ++iBlock) {
+            MappedSegmentRecord record;
+            fromBlockSegment(_blocks[iBlock]._source, srcGenome, record._source);
+            if (getLow(record._source) > interval._end) {
+                break;
+            }
+            if (getHigh(record._source) < interval._start) {
+                continue;
+            }
+            fromBlockSegment(_blocks[iBlock]._target, tgtGenome, record._target);
+            record._inputIndex = i;
+            clipToInterval(record, interval);
+            if (interval._reversed) {
+                reverseRecord(record._source);
+                reverseRecord(record._target);
+            }
+            segVector.add(record);
+            ++numMapped;
+        }
+        segVector.resolve();
+    }
+    return numMapped;
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#include "halPairwiseBlockIndex.h"
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+using namespace hal;
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.addArgument("halFile", "input hal file");
+    optionsParser.addArgument("srcGenome", "source genome name");
+    optionsParser.addArgument("tgtGenome", "target genome name");
+    optionsParser.addArgument("indexFile", "path of output block index file");
+    optionsParser.addOptionFlag("noDupes", "do not map between duplications in graph.", false);
+    optionsParser.addOption("coalescenceLimit", "coalescence limit genome: the genome at or above the MRCA of source"
+                                                " and target at which we stop looking for homologies (default: MRCA)",
+                            "");
+    optionsParser.setDescription("Precompute the alignment blocks between two genomes for halLiftover --blockIndex "
+                                 "and halBlockViz.  The options must match those used with the index.");
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser;
+    initParser(optionsParser);
+
+    string halPath;
+    string srcGenomeName;
+    string tgtGenomeName;
+    string indexPath;
+    string coalescenceLimitName;
+    bool noDupes;
+    try {
+        optionsParser.parseOptions(argc, argv);
+        halPath = optionsParser.getArgument<string>("halFile");
+        srcGenomeName = optionsParser.getArgument<string>("srcGenome");
+        tgtGenomeName = optionsParser.getArgument<string>("tgtGenome");
+        indexPath = optionsParser.getArgument<string>("indexFile");
+        coalescenceLimitName = optionsParser.getOption<string>("coalescenceLimit");
+        noDupes = optionsParser.getFlag("noDupes");
+    } catch (exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+
+    try {
+        AlignmentConstPtr alignment(openHalAlignment(halPath, &optionsParser));
+        const Genome *srcGenome = alignment->openGenome(srcGenomeName);
+        if (srcGenome == NULL) {
+            throw hal_exception(string("srcGenome, ") + srcGenomeName + ", not found in alignment");
+        }
+        const Genome *tgtGenome = alignment->openGenome(tgtGenomeName);
+        if (tgtGenome == NULL) {
+            throw hal_exception(string("tgtGenome, ") + tgtGenomeName + ", not found in alignment");
+        }
+        const Genome *coalescenceLimit = NULL;
+        if (coalescenceLimitName != "") {
+            coalescenceLimit = alignment->openGenome(coalescenceLimitName);
+            if (coalescenceLimit == NULL) {
+                throw hal_exception("coalescence limit genome " + coalescenceLimitName + " not found in alignment");
+            }
+        }
+        PairwiseBlockIndex::build(srcGenome, tgtGenome, indexPath, !noDupes, coalescenceLimit);
+    } catch (hal_exception &e) {
+        cerr << "hal exception caught: " << e.what() << endl;
+        return 1;
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
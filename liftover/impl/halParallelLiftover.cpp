@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#include "halParallelLiftover.h"
+#include <cassert>
+#include <sstream>
+
+using namespace std;
+using namespace hal;
+
+ParallelLiftover::ParallelLiftover(const vector<Liftover *> &liftovers, size_t chunkLines)
+    : _liftovers(liftovers), _chunkLines(chunkLines), _outBedStream(NULL), _stopping(false) {
+    assert(!_liftovers.empty() && (_chunkLines > 0));
+}
+
+ParallelLiftover::~ParallelLiftover() {
+    stopWorkers();
+}
+
+void ParallelLiftover::convert(istream *inBedStream, ostream *outBedStream, int bedType) {
+    assert(inBedStream && outBedStream);
+    _outBedStream = outBedStream;
+    _stopping = false;
+    for (Liftover *liftover : _liftovers) {
+        _workers.push_back(thread(&ParallelLiftover::runWorker, this, liftover));
+    }
+    try {
+        scan(inBedStream, bedType);
+        writeChunks(0);
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+    stopWorkers();
+}
+
+/* Read lines into chunks for the workers.  Unlike BedScanner::scan, only
+ * parse errors are given the line number here, as errors from lifting a
+ * chunk already include it. */
+void ParallelLiftover::scan(istream *bedStream, int bedType) {
+    _bedStream = bedStream;
+    if (_bedStream->bad()) {
+        throw hal_exception("Error reading bed input stream");
+    }
+    string lineBuffer;
+    _lineNumber = 0;
+    _chunk.reset(new Chunk());
+    skipWhiteSpaces(_bedStream);
+    while (_bedStream->good()) {
+        ++_lineNumber;
+        try {
+            _bedLine.read(*_bedStream, lineBuffer, bedType);
+        } catch (hal_exception &e) {
+            throw hal_exception(string(e.what()) + " in input bed line " + std::to_string(_lineNumber));
+        }
+        if (_chunk->_lines.empty()) {
+            _chunk->_firstLineNumber = _lineNumber;
+        }
+        _chunk->_lines.push_back(_bedLine);
+        if (_chunk->_lines.size() >= _chunkLines) {
+            submitChunk();
+        }
+        skipWhiteSpaces(_bedStream);
+    }
+    submitChunk();
+    _bedStream = NULL;
+}
+
+/* queue the current chunk for lifting, then write finished chunks, waiting
+ * if too many are in progress */
+void ParallelLiftover::submitChunk() {
+    if (_chunk->_lines.empty()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(_mutex);
+        _toLift.push_back(_chunk.get());
+        _pending.push_back(std::move(_chunk));
+    }
+    _chunkReady.notify_one();
+    _chunk.reset(new Chunk());
+    writeChunks(2 * _liftovers.size());
+}
+
+/* Write finished chunks from the front of the pending queue, until it
+ * has no more than maxPending chunks and the front one isn't done.  An
+ * error in lifting a chunk is rethrown here. */
+void ParallelLiftover::writeChunks(size_t maxPending) {
+    while (true) {
+        unique_ptr<Chunk> chunk;
+        {
+            unique_lock<mutex> lock(_mutex);
+            while (!_pending.empty() && !_pending.front()->_done && (_pending.size() > maxPending)) {
+                _chunkDone.wait(lock);
+            }
+            if (_pending.empty() || !_pending.front()->_done) {
+                return;
+            }
+            chunk = std::move(_pending.front());
+            _pending.pop_front();
+        }
+        if (chunk->_error) {
+            rethrow_exception(chunk->_error);
+        }
+        *_outBedStream << chunk->_output;
+    }
+}
+
+void ParallelLiftover::runWorker(Liftover *liftover) {
+    while (true) {
+        Chunk *chunk;
+        {
+            unique_lock<mutex> lock(_mutex);
+            while (_toLift.empty() && !_stopping) {
+                _chunkReady.wait(lock);
+            }
+            if (_toLift.empty()) {
+                return;
+            }
+            chunk = _toLift.front();
+            _toLift.pop_front();
+        }
+        try {
+            ostringstream outStream;
+            liftover->liftLines(chunk->_lines, chunk->_firstLineNumber, &outStream);
+            chunk->_output = outStream.str();
+        } catch (...) {
+            chunk->_error = current_exception();
+        }
+        chunk->_lines.clear();
+        {
+            lock_guard<mutex> lock(_mutex);
+            chunk->_done = true;
+        }
+        _chunkDone.notify_one();
+    }
+}
+
+/* stop the workers once they have finished any chunk they are lifting,
+ * discarding the rest */
+void ParallelLiftover::stopWorkers() {
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stopping = true;
+        _toLift.clear();
+    }
+    _chunkReady.notify_all();
+    for (thread &worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+    _pending.clear();
+}
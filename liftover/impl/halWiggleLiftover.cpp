@@ -119,11 +119,13 @@ void WiggleLiftover::mapSegment() {
         _segment->slice(_segment->getStartOffset(), eo);
     }
 
-    _mappedSegments.clear();
+    _segmentVector.clear();
     while (_segment->getArrayIndex() < _lastIndex && _segment->getStartPosition() <= (_cvals.back()._last)) {
-        halMapSegment(_segment.get(), _mappedSegments, _tgtGenome, &_tgtSet, _traverseDupes);
+        halMapSegment(_segment.get(), _segmentVector, _tgtGenome, &_tgtSet, _traverseDupes);
         _segment->toRight(_cvals.back()._last);
     }
+    _segmentVector.resolve();
+    _segmentVector.toSet(_mappedSegments);
 
     vector<MappedSegmentPtr> fragments;
     MappedSegmentSet emptySet;
@@ -9,6 +9,7 @@
 #define _HALBLOCKLIFTOVER_H
 
 #include "halLiftover.h"
+#include "halPairwiseBlockIndex.h"
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -21,19 +22,31 @@ namespace hal {
         BlockLiftover();
         virtual ~BlockLiftover();
 
+        /* Map intervals with a precomputed block index rather than by
+         * following the alignment.  It must have been built for the same
+         * genomes and options as the lift, and stays owned by the
+         * caller. */
+        void setBlockIndex(const PairwiseBlockIndex *blockIndex) {
+            _blockIndex = blockIndex;
+        }
+
       protected:
         void liftInterval(BedList &mappedBedLines);
         void visitBegin();
+        void mapBatch();
 
         void cleanTargetParalogies();
         void readPSLInfo(std::vector<MappedSegmentPtr> &fragments, BedLine &outBedLine);
 
       protected:
+        /* mapped segments of each interval in the batch, in the order
+         * liftInterval is called for them */
+        std::vector<MappedSegmentVector> _batchSegments;
+        size_t _batchNext;
         MappedSegmentSet _mappedSegments;
-        SegmentIteratorPtr _refSeg;
-        hal_index_t _lastIndex;
         std::set<const Genome *> _downwardPath;
         const Genome *_mrca;
+        const PairwiseBlockIndex *_blockIndex;
     };
 }
 #endif
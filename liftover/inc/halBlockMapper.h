@@ -10,6 +10,7 @@
 
 #include "hal.h"
 #include "halMappedSegmentContainers.h"
+#include "halPairwiseBlockIndex.h"
 #include <iostream>
 #include <map>
 #include <set>
@@ -32,6 +33,14 @@ namespace hal {
                   const Genome *coalescenceLimit = NULL);
         void map();
 
+        /* Map the reference range with a precomputed block index when it
+         * was built for the same genomes and options, with the segments
+         * this would map from, rather than following the alignment.  The
+         * index stays owned by the caller. */
+        void setBlockIndex(const PairwiseBlockIndex *blockIndex) {
+            _blockIndex = blockIndex;
+        }
+
         const MappedSegmentSet &getMap() const;
         MappedSegmentSet &getMap();
 
@@ -44,6 +53,7 @@ namespace hal {
 
       protected:
         void erase();
+        void mapFromAlignment(bool refIsTop);
         void mapAdjacencies(MappedSegmentSet::const_iterator setIt);
 
         static SegmentIteratorPtr makeIterator(MappedSegmentPtr &mappedSegment, hal_index_t &minIndex, hal_index_t &maxIndex);
@@ -70,6 +80,7 @@ namespace hal {
         bool _targetReversed;
         const Genome *_mrca;
         const Genome *_coalescenceLimit;
+        const PairwiseBlockIndex *_blockIndex;
 
         static hal_size_t _maxAdjScan;
     };
@@ -27,12 +27,29 @@ namespace hal {
                      bool traverseDupes = true, bool outPSL = false, bool outPSLWithName = false,
                      const Genome *coalescenceLimit = NULL);
 
+        /* Prepare to lift lines that have already been read with
+         * liftLines(), taking the same options as convert() */
+        void setup(AlignmentConstPtr alignment, const Genome *srcGenome, const Genome *tgtGenome, int bedType = 0,
+                   bool traverseDupes = true, bool outPSL = false, bool outPSLWithName = false,
+                   const Genome *coalescenceLimit = NULL);
+
+        /* Lift lines as convert() does, writing the results to outputFile.
+         * firstLineNumber is the line number of the first line in the
+         * input, for error messages. */
+        void liftLines(const std::vector<BedLine> &bedLines, hal_size_t firstLineNumber, std::ostream *outputFile);
+
       protected:
+        void setOptions(AlignmentConstPtr alignment, const Genome *srcGenome, const Genome *tgtGenome, int bedType,
+                        bool traverseDupes, bool outPSL, bool outPSLWithName, const Genome *coalescenceLimit);
+
         typedef std::list<BedLine> BedList;
 
         virtual void visitBegin();
         virtual void visitLine();
         virtual void visitEOF();
+        virtual void flushBatch();
+        virtual void mapBatch();
+        virtual void liftLine();
         virtual void writeLineResults();
         virtual void assignBlocksToIntervals();
         virtual bool compatible(const BedLine &tgtBed, const BedLine &newBlock);
@@ -62,6 +79,13 @@ namespace hal {
 
         ColumnIteratorPtr _colIt;
         std::set<std::string> _missedSet;
+
+        /* Lines are lifted in batches of consecutive lines that are sorted
+         * on one sequence, so that their intervals can be mapped together
+         * by mapBatch() */
+        static const size_t MaxBatchLines = 1024;
+        std::vector<BedLine> _batch;
+        const Sequence *_batchSequence;
     };
 }
 #endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#ifndef _HALPAIRWISEBLOCKINDEX_H
+#define _HALPAIRWISEBLOCKINDEX_H
+
+#include "hal.h"
+#include <string>
+#include <vector>
+
+namespace hal {
+    struct PairwiseBlockIndexHeader;
+    struct PairwiseBlock;
+
+    /**
+     * Precomputed alignment blocks between a source and a target genome.
+     * build() maps every segment of the source genome to the target with
+     * halMapSegmentRecords and writes the unresolved blocks, sorted by
+     * source position, to an index file.  Opening the file memory-maps it.
+     * Intervals of the source are then mapped by a binary search of the
+     * blocks instead of following the alignment through the tree, giving
+     * the same segments as halMapSegments.  An open index is read-only and
+     * can be shared by threads.
+     */
+    class PairwiseBlockIndex {
+      public:
+        /* map all of srcGenome to tgtGenome and write the blocks to an
+         * index file, returning the number of blocks.  coalescenceLimit
+         * defaults to the MRCA. */
+        static hal_size_t build(const Genome *srcGenome, const Genome *tgtGenome, const std::string &indexPath,
+                                bool doDupes = true, const Genome *coalescenceLimit = NULL);
+
+        /* open an index file */
+        PairwiseBlockIndex(const std::string &indexPath);
+        ~PairwiseBlockIndex();
+
+        const std::string &getPath() const {
+            return _indexPath;
+        }
+        hal_size_t getNumBlocks() const;
+        std::string getSrcGenomeName() const;
+        std::string getTgtGenomeName() const;
+        std::string getCoalescenceLimitName() const;
+        bool getDoDupes() const;
+
+        /* were the blocks mapped from top segments of the source, rather
+         * than bottom segments? */
+        bool getSrcIsTop() const;
+
+        /* describe the genomes and options the index was built with */
+        std::string getDescription() const;
+
+        /* Check if the index was built for these genomes and options.  The
+         * coalescence limit defaults to the MRCA, as for build().  An
+         * exception is thrown if the genomes match but have changed since
+         * the index was built. */
+        bool matches(const Genome *srcGenome, const Genome *tgtGenome, bool doDupes,
+                     const Genome *coalescenceLimit = NULL) const;
+
+        /* Map source intervals as halMapSegments does, filling outSegments
+         * with a resolved MappedSegmentVector for each interval.  The
+         * genomes must match the index.  Returns the total number of
+         * mapped segments. */
+        hal_size_t mapIntervals(const Genome *srcGenome, const Genome *tgtGenome,
+                                const std::vector<SourceInterval> &intervals,
+                                std::vector<MappedSegmentVector> &outSegments) const;
+
+      private:
+        PairwiseBlockIndex(const PairwiseBlockIndex &) = delete;
+        PairwiseBlockIndex &operator=(const PairwiseBlockIndex &) = delete;
+
+        std::string _indexPath;
+        void *_basePtr;
+        size_t _fileSize;
+        const PairwiseBlockIndexHeader *_header;
+        const PairwiseBlock *_blocks;
+        /* running maximum of the highest source position of the blocks,
+         * to find the first block that can overlap an interval */
+        const hal_index_t *_maxSrcHigh;
+    };
+    typedef std::shared_ptr<PairwiseBlockIndex> PairwiseBlockIndexPtr;
+}
+#endif
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+
+#ifndef _HALPARALLELLIFTOVER_H
+#define _HALPARALLELLIFTOVER_H
+
+#include "halBedScanner.h"
+#include "halLiftover.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hal {
+
+    /**
+     * Lift BED lines on several threads.  Lines are read in chunks, which
+     * are lifted by worker threads, each with its own Liftover object.
+     * The results of each chunk are written in input order, so the output
+     * is the same as lifting with a single Liftover.  The Liftovers must
+     * have been set up with Liftover::setup() on an alignment opened with
+     * CONCURRENT_READ_ACCESS.
+     */
+    class ParallelLiftover : public BedScanner {
+      public:
+        ParallelLiftover(const std::vector<Liftover *> &liftovers, size_t chunkLines = 4096);
+        virtual ~ParallelLiftover();
+
+        void convert(std::istream *inputFile, std::ostream *outputFile, int bedType = 0);
+
+      protected:
+        /* lines read together and their lifted results */
+        struct Chunk {
+            Chunk() : _firstLineNumber(0), _done(false) {
+            }
+            std::vector<BedLine> _lines;
+            hal_size_t _firstLineNumber;
+            std::string _output;
+            std::exception_ptr _error;
+            bool _done;
+        };
+
+        virtual void scan(std::istream *bedStream, int bedType);
+        void submitChunk();
+        void writeChunks(size_t maxPending);
+        void runWorker(Liftover *liftover);
+        void stopWorkers();
+
+      protected:
+        std::vector<Liftover *> _liftovers;
+        size_t _chunkLines;
+        std::ostream *_outBedStream;
+        std::unique_ptr<Chunk> _chunk;
+        std::vector<std::thread> _workers;
+        std::mutex _mutex;
+        std::condition_variable _chunkReady;
+        std::condition_variable _chunkDone;
+        std::deque<std::unique_ptr<Chunk>> _pending; // in input order
+        std::deque<Chunk *> _toLift;
+        bool _stopping;
+    };
+}
+#endif
+// Local Variables:
+// mode: c++
+// End:
@@ -57,6 +57,7 @@ namespace hal {
         const Genome *_tgtGenome;
         const Sequence *_srcSequence;
         std::set<const Genome *> _tgtSet;
+        MappedSegmentVector _segmentVector;
         MappedSegmentSet _mappedSegments;
         hal_index_t _lastIndex;
 
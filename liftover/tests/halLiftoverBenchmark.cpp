@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2012-2019 by UCSC Computational Genomics Lab
+ *
+ * Released under the MIT license, see LICENSE.txt
+ */
+#include "hal.h"
+#include "halBlockLiftover.h"
+#include "halColumnLiftover.h"
+#include "halPairwiseBlockIndex.h"
+#include "halParallelLiftover.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace hal;
+
+/*
+ * Time lifting a synthetic BED file of random intervals of a source genome
+ * to a target genome with one Liftover, then with a ParallelLiftover using
+ * several threads.  The alignment, such as one made by halRandGen, must be
+ * an mmap HAL file.  With --blockIndex, lifting with one thread is also
+ * timed using the index, which the threads then use as well.  The outputs
+ * must be identical; the exit status is non-zero if they are not.
+ */
+
+static void initParser(CLParser &optionsParser) {
+    optionsParser.setDescription("Benchmark lifting BED lines with one and with several threads");
+    optionsParser.addArgument("halFile", "mmap HAL file, such as one created by halRandGen");
+    optionsParser.addOption("srcGenome", "source genome (default: first leaf)", "");
+    optionsParser.addOption("tgtGenome", "target genome (default: last leaf)", "");
+    optionsParser.addOption("seed", "random number seed", 0);
+    optionsParser.addOption("numLines", "number of BED lines to lift", 100000);
+    optionsParser.addOption("maxLength", "maximum length of BED intervals", 1000);
+    optionsParser.addOptionFlag("sorted", "sort the BED lines", false);
+    optionsParser.addOptionFlag("column", "lift with ColumnLiftover rather than BlockLiftover", false);
+    optionsParser.addOption("numThreads", "number of threads", 4);
+    optionsParser.addOption("chunkLines", "number of lines lifted by a thread at a time", 4096);
+    optionsParser.addOption("blockIndex", "block index made by halPairwiseIndex for the genomes", "");
+}
+
+struct BedInterval {
+    const Sequence *_sequence;
+    hal_index_t _start;
+    hal_index_t _end;
+    char _strand;
+    bool operator<(const BedInterval &other) const {
+        return (_sequence->getStartPosition() + _start) < (other._sequence->getStartPosition() + other._start);
+    }
+};
+
+/* make a BED6 file of random intervals, choosing sequences by length */
+static string makeBed(const Genome *genome, hal_size_t numLines, hal_size_t maxLength, bool sorted, int seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<hal_index_t> siteDist(0, genome->getSequenceLength() - 1);
+    uniform_int_distribution<hal_index_t> lengthDist(1, maxLength);
+    vector<BedInterval> intervals;
+    for (hal_size_t i = 0; i < numLines; i++) {
+        BedInterval interval;
+        hal_index_t site = siteDist(rng);
+        interval._sequence = genome->getSequenceBySite(site);
+        interval._start = site - interval._sequence->getStartPosition();
+        interval._end = min(interval._start + lengthDist(rng), (hal_index_t)interval._sequence->getSequenceLength());
+        interval._strand = (rng() & 1) ? '-' : '+';
+        intervals.push_back(interval);
+    }
+    if (sorted) {
+        sort(intervals.begin(), intervals.end());
+    }
+    ostringstream bed;
+    for (size_t i = 0; i < intervals.size(); i++) {
+        bed << intervals[i]._sequence->getName() << '\t' << intervals[i]._start << '\t' << intervals[i]._end << "\tline" << i
+            << "\t0\t" << intervals[i]._strand << '\n';
+    }
+    return bed.str();
+}
+
+static Liftover *newLiftover(bool column, const PairwiseBlockIndex *blockIndex) {
+    if (column) {
+        return new ColumnLiftover();
+    } else {
+        BlockLiftover *liftover = new BlockLiftover();
+        liftover->setBlockIndex(blockIndex);
+        return liftover;
+    }
+}
+
+static double liftSingle(AlignmentConstPtr alignment, const Genome *srcGenome, const Genome *tgtGenome, bool column,
+                         const PairwiseBlockIndex *blockIndex, const string &bed, string &output) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    unique_ptr<Liftover> liftover(newLiftover(column, blockIndex));
+    istringstream inStream(bed);
+    ostringstream outStream;
+    liftover->convert(alignment, srcGenome, &inStream, tgtGenome, &outStream);
+    output = outStream.str();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static double liftParallel(AlignmentConstPtr alignment, const Genome *srcGenome, const Genome *tgtGenome, bool column,
+                           const PairwiseBlockIndex *blockIndex, int numThreads, size_t chunkLines, const string &bed,
+                           string &output) {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<unique_ptr<Liftover>> liftovers;
+    vector<Liftover *> workerLiftovers;
+    for (int i = 0; i < numThreads; i++) {
+        liftovers.push_back(unique_ptr<Liftover>(newLiftover(column, blockIndex)));
+        liftovers.back()->setup(alignment, srcGenome, tgtGenome);
+        workerLiftovers.push_back(liftovers.back().get());
+    }
+    ParallelLiftover parallelLiftover(workerLiftovers, chunkLines);
+    istringstream inStream(bed);
+    ostringstream outStream;
+    parallelLiftover.convert(&inStream, &outStream);
+    output = outStream.str();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    CLParser optionsParser;
+    initParser(optionsParser);
+    try {
+        optionsParser.parseOptions(argc, argv);
+    } catch (hal_exception &e) {
+        cerr << e.what() << endl;
+        optionsParser.printUsage(cerr);
+        exit(1);
+    }
+    try {
+        AlignmentConstPtr alignment(
+            openHalAlignment(optionsParser.getArgument<string>("halFile"), &optionsParser, CONCURRENT_READ_ACCESS));
+        vector<string> leaves = alignment->getLeafNamesBelow(alignment->getRootName());
+        string srcName = optionsParser.getOption<string>("srcGenome");
+        string tgtName = optionsParser.getOption<string>("tgtGenome");
+        const Genome *srcGenome = alignment->openGenome(srcName.empty() ? leaves.front() : srcName);
+        const Genome *tgtGenome = alignment->openGenome(tgtName.empty() ? leaves.back() : tgtName);
+        if ((srcGenome == NULL) or (tgtGenome == NULL)) {
+            throw hal_exception("source or target genome not found");
+        }
+        if (srcGenome->getSequenceLength() == 0) {
+            throw hal_exception("source genome " + srcGenome->getName() + " has no sequence");
+        }
+        bool column = optionsParser.getFlag("column");
+        int numThreads = optionsParser.getOption<int>("numThreads");
+        hal_size_t numLines = optionsParser.getOption<hal_size_t>("numLines");
+        string bed = makeBed(srcGenome, numLines, optionsParser.getOption<hal_size_t>("maxLength"),
+                             optionsParser.getFlag("sorted"), optionsParser.getOption<int>("seed"));
+
+        string blockIndexPath = optionsParser.getOption<string>("blockIndex");
+        unique_ptr<PairwiseBlockIndex> blockIndex;
+        if (!blockIndexPath.empty()) {
+            if (column) {
+                throw hal_exception("--blockIndex can't be used with --column");
+            }
+            blockIndex.reset(new PairwiseBlockIndex(blockIndexPath));
+        }
+
+        string singleOutput;
+        double singleSecs = liftSingle(alignment, srcGenome, tgtGenome, column, NULL, bed, singleOutput);
+        string indexOutput;
+        double indexSecs = 0.0;
+        if (blockIndex) {
+            indexSecs = liftSingle(alignment, srcGenome, tgtGenome, column, blockIndex.get(), bed, indexOutput);
+        }
+        string parallelOutput;
+        double parallelSecs = liftParallel(alignment, srcGenome, tgtGenome, column, blockIndex.get(), numThreads,
+                                           optionsParser.getOption<size_t>("chunkLines"), bed, parallelOutput);
+
+        cout << srcGenome->getName() << " -> " << tgtGenome->getName() << ": " << numLines << " lines, "
+             << count(singleOutput.begin(), singleOutput.end(), '\n') << " output lines" << endl;
+        cout << setw(10) << "threads" << setw(8) << "index" << setw(10) << "secs" << setw(14) << "lines/sec" << endl;
+        cout << setw(10) << 1 << setw(8) << "no" << setw(10) << fixed << setprecision(3) << singleSecs << setw(14)
+             << setprecision(0) << numLines / singleSecs << endl;
+        if (blockIndex) {
+            cout << setw(10) << 1 << setw(8) << "yes" << setw(10) << setprecision(3) << indexSecs << setw(14)
+                 << setprecision(0) << numLines / indexSecs << endl;
+        }
+        cout << setw(10) << numThreads << setw(8) << (blockIndex ? "yes" : "no") << setw(10) << setprecision(3)
+             << parallelSecs << setw(14) << setprecision(0) << numLines / parallelSecs << endl;
+        if (blockIndex && (indexOutput != singleOutput)) {
+            cerr << "output with block index differs from output without it" << endl;
+            return 1;
+        }
+        if (parallelOutput != singleOutput) {
+            cerr << "output with " << numThreads << " threads differs from output with one thread" << endl;
+            return 1;
+        }
+    } catch (exception &e) {
+        cerr << "Exception caught: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
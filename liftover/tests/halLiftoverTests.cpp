@@ -7,7 +7,9 @@
 #include "halApiTestSupport.h"
 #include "halLiftoverTests.h"
 #include "halBlockLiftover.h"
+#include "halPairwiseBlockIndex.h"
 #include <cstdio>
+#include <unistd.h>
 
 using namespace std;
 using namespace hal;
@@ -267,6 +269,22 @@ void BedLiftoverTest::liftAndCheck(AlignmentConstPtr alignment,
         cerr << "Expected: " << endl << expectBed << endl;
     }
     CuAssertTrue(_testCase, outStream.str() == expectBed);
+
+    // the same lift using a precomputed block index
+    string indexPath = getTempFile();
+    PairwiseBlockIndex::build(srcGenome, tgtGenome, indexPath);
+    PairwiseBlockIndex blockIndex(indexPath);
+    BlockLiftover indexLiftover;
+    indexLiftover.setBlockIndex(&blockIndex);
+    stringstream indexBedFile(inBed);
+    stringstream indexOutStream;
+    indexLiftover.convert(alignment, srcGenome, &indexBedFile, tgtGenome, &indexOutStream,
+                          0, true, outPSL, outPSLWithName);
+    ::unlink(indexPath.c_str());
+    if (indexOutStream.str() != expectBed) {
+        cerr << "Got with block index: " << endl << indexOutStream.str() << endl;
+    }
+    CuAssertTrue(_testCase, indexOutStream.str() == expectBed);
 }
 
 void BedLiftoverTest::testOneBranchLifts(AlignmentConstPtr alignment) {
@@ -63,6 +63,10 @@ static void initParser(CLParser &optionsParser) {
                                 false);
     optionsParser.addOptionFlag("keepEmptyRefBlocks", "keep blocks that contain no reference sequence",
                                 false);
+    optionsParser.addOption("projectionCacheBytes", "maximum bytes of each cache of the segments aligned between a "
+                                                    "genome and its parent or a child (0 to not cache)",
+                            0);
+    optionsParser.addOptionFlag("projectionCacheStats", "print projection cache hit rates to stderr", false);
 
     optionsParser.setDescription("Convert hal database to maf.");
 }
@@ -90,6 +94,8 @@ class MafOptions {
     bool onlyOrthologs;
     bool keepEmptyRefBlocks;
     hal_index_t maxBlockLen;
+    size_t projectionCacheBytes;
+    bool projectionCacheStats;
 };
 
 /* This empty string options specified using the old convention of '""' rather than
@@ -242,6 +248,8 @@ int main(int argc, char **argv) {
         opts.maxBlockLen = optionsParser.getOption<hal_index_t>("maxBlockLen");
         opts.onlyOrthologs = optionsParser.getFlag("onlyOrthologs");
         opts.keepEmptyRefBlocks = optionsParser.getFlag("keepEmptyRefBlocks");
+        opts.projectionCacheBytes = optionsParser.getOption<size_t>("projectionCacheBytes");
+        opts.projectionCacheStats = optionsParser.getFlag("projectionCacheStats");
 
         if (((opts.length != 0) || (opts.start != 0)) && (opts.refSequenceName == "")) {
             throw hal_exception("--start and --length require --refSequenceName");
@@ -261,12 +269,16 @@ int main(int argc, char **argv) {
         exit(1);
     }
     try {
-        AlignmentConstPtr alignment(openHalAlignment(opts.halPath, &optionsParser));
+        AlignmentPtr alignment(openHalAlignment(opts.halPath, &optionsParser));
         if (alignment->getNumGenomes() == 0) {
             throw hal_exception("hal alignmenet is empty");
         }
+        alignment->setProjectionCacheBytes(opts.projectionCacheBytes);
 
         hal2maf(alignment, opts);
+        if (opts.projectionCacheStats) {
+            alignment->printProjectionCacheStats(cerr);
+        }
     } catch (hal_exception &e) {
         cerr << "hal exception caught: " << e.what() << endl;
         return 1;
@@ -15,6 +15,9 @@ using namespace hal;
 
 const hal_index_t MafBlock::defaultMaxLength = 1000;
 
+// marks bases in an entry that have not yet been decoded
+static const char DnaPlaceholder = '?';
+
 MafBlock::MafBlock(hal_index_t maxLength) : _maxLength(maxLength), _fullNames(false), _tree(NULL) {
     if (_maxLength <= 0) {
         _maxLength = numeric_limits<hal_index_t>::max();
@@ -86,6 +89,7 @@ void MafBlock::initEntry(MafBlockEntry *entry, const Sequence *sequence, DnaIter
         entry->_genome = sequence->getGenome();
         entry->_srcLength = (hal_index_t)sequence->getSequenceLength();
     }
+    entry->_halSequence = sequence;
     if (dna.get()) {
         // update start position from the iterator
         entry->_start = dna->getArrayIndex() - sequence->getStartPosition();
@@ -125,7 +129,7 @@ inline void MafBlock::updateEntry(MafBlockEntry *entry, const Sequence *sequence
                (hal_index_t)(entry->_srcLength - 1 - (dna->getArrayIndex() - sequence->getStartPosition())) ==
                    (hal_index_t)(entry->_start + entry->_length - 1));
 
-        entry->_sequence->append(dna->getBase());
+        entry->_sequence->append(DnaPlaceholder);
     } else {
         entry->_sequence->append('-');
     }
@@ -238,21 +242,10 @@ void MafBlock::buildTreeR(BottomSegmentIteratorPtr botIt, stTree *tree, bool mod
 
 stTree *MafBlock::buildTree(ColumnIteratorPtr colIt, bool modifyEntries) {
     // Get any base from the column to begin building the tree
-    const ColumnMap *colMap = colIt->getColumnMap();
-    ColumnMap::const_iterator colMapIt = colMap->begin();
-    const Sequence *sequence = NULL;
-    hal_index_t index = NULL_INDEX;
-    while (colMapIt != colMap->end()) {
-        if (!colMapIt->second->empty()) {
-            // Found a non-empty column map entry, just take the index and
-            // sequence of the first base found
-            sequence = colMapIt->first;
-            index = colMapIt->second->at(0)->getArrayIndex();
-            break;
-        }
-        colMapIt++;
-    }
-    assert(sequence != NULL && index != NULL_INDEX);
+    const ColumnIterator::Rows &rows = colIt->getRows();
+    assert(not rows.empty());
+    const Sequence *sequence = rows[0]._sequence;
+    hal_index_t index = rows[0]._dna->getArrayIndex();
     const Genome *genome = sequence->getGenome();
 
     // Get the bottom segment that is the common ancestor of all entries
@@ -298,56 +291,33 @@ void MafBlock::initBlock(ColumnIteratorPtr col, bool fullNames, bool printTree)
     resetEntries();
     _fullNames = fullNames;
     _printTree = printTree;
-    const ColumnMap *colMap = col->getColumnMap();
+    const ColumnIterator::Rows &rows = col->getRows();
     Entries::iterator e = _entries.begin();
-    ColumnMap::const_iterator c = colMap->begin();
-    DNASet::const_iterator d;
-    const Sequence *sequence;
-
-    for (; c != colMap->end(); ++c) {
-        sequence = c->first;
 
-        // No DNA Iterator for this sequence.  We just give it an empty
-        // entry
-        if (c->second->empty()) {
+    for (const ColumnIterator::Row &row : rows) {
+        const Sequence *sequence = row._sequence;
+        // search for the row's sequence in _entries.
+        // we conly call find() once.  afterwards we just move forward
+        // in the map since they are both sorted by the same key.
+        if (e == _entries.begin()) {
             e = _entries.lower_bound(sequence);
             if (e == _entries.end() || e->first != sequence) {
-                MafBlockEntry *entry = new MafBlockEntry(_stringBuffers);
-                initEntry(entry, sequence, DnaIteratorPtr());
-                e = _entries.insert(Entries::value_type(sequence, entry));
-            } else {
-                assert(e->first == sequence);
-                assert(e->second->_name == getName(sequence));
-                initEntry(e->second, sequence, DnaIteratorPtr());
+                e = _entries.end();
             }
-        }
-
-        else {
-            for (d = c->second->begin(); d != c->second->end(); ++d) {
-                // search for c's sequence in _entries.
-                // we conly call find() once.  afterwards we just move forward
-                // in the map since they are both sorted by the same key.
-                if (e == _entries.begin()) {
-                    e = _entries.lower_bound(sequence);
-                    if (e == _entries.end() || e->first != sequence) {
-                        e = _entries.end();
-                    }
-                } else {
-                    while (e->first != c->first && e != _entries.end()) {
-                        ++e;
-                    }
-                }
-                if (e == _entries.end()) {
-                    MafBlockEntry *entry = new MafBlockEntry(_stringBuffers);
-                    initEntry(entry, sequence, *d);
-                    assert(entry->_name == getName(sequence));
-                    e = _entries.insert(Entries::value_type(sequence, entry));
-                } else {
-                    initEntry(e->second, sequence, *d);
-                }
+        } else {
+            while (e != _entries.end() && e->first != sequence) {
                 ++e;
             }
         }
+        if (e == _entries.end()) {
+            MafBlockEntry *entry = new MafBlockEntry(_stringBuffers);
+            initEntry(entry, sequence, row._dna);
+            assert(entry->_name == getName(sequence));
+            e = _entries.insert(Entries::value_type(sequence, entry));
+        } else {
+            initEntry(e->second, sequence, row._dna);
+        }
+        ++e;
     }
 
     if (_reference == NULL) {
@@ -368,25 +338,19 @@ void MafBlock::initBlock(ColumnIteratorPtr col, bool fullNames, bool printTree)
 }
 
 void MafBlock::appendColumn(ColumnIteratorPtr col) {
-    const ColumnMap *colMap = col->getColumnMap();
+    const ColumnIterator::Rows &rows = col->getRows();
     Entries::iterator e = _entries.begin();
-    ColumnMap::const_iterator c = colMap->begin();
-    DNASet::const_iterator d;
-    const Sequence *sequence;
-
-    for (; c != colMap->end(); ++c) {
-        sequence = c->first;
-        for (d = c->second->begin(); d != c->second->end(); ++d) {
-            while (e->first != sequence && e != _entries.end()) {
-                updateEntry(e->second, NULL, DnaIteratorPtr());
-                ++e;
-            }
-            assert(e != _entries.end());
-            assert(e->first == sequence);
-            assert(e->second->_name == getName(sequence));
-            updateEntry(e->second, sequence, *d);
+
+    for (const ColumnIterator::Row &row : rows) {
+        const Sequence *sequence = row._sequence;
+        while (e != _entries.end() && e->first != sequence) {
+            updateEntry(e->second, NULL, DnaIteratorPtr());
             ++e;
         }
+        assert(e != _entries.end());
+        assert(e->second->_name == getName(sequence));
+        updateEntry(e->second, sequence, row._dna);
+        ++e;
     }
 
     for (; e != _entries.end(); ++e) {
@@ -394,52 +358,72 @@ void MafBlock::appendColumn(ColumnIteratorPtr col) {
     }
 }
 
+// Append up to numColumns columns that continue every base and gap of the
+// last column, as in a gapless run of a ColumnIterator.  Stops when an
+// entry with bases reaches the maximum length, where canAppendColumn()
+// would end the block.  Returns the number of columns appended.
+hal_size_t MafBlock::appendGaplessColumns(hal_size_t numColumns) {
+    for (Entries::iterator e = _entries.begin(); e != _entries.end() && numColumns > 0; ++e) {
+        MafBlockEntry *entry = e->second;
+        assert(entry->_sequence->length() > 0);
+        if (entry->_sequence->data()[entry->_sequence->length() - 1] == DnaPlaceholder) {
+            numColumns = min(numColumns, (hal_size_t)max(_maxLength - entry->_length, (hal_index_t)0));
+        }
+    }
+    if (numColumns > 0) {
+        for (Entries::iterator e = _entries.begin(); e != _entries.end(); ++e) {
+            MafBlockEntry *entry = e->second;
+            char last = entry->_sequence->data()[entry->_sequence->length() - 1];
+            entry->_sequence->append(last, numColumns);
+            if (last == DnaPlaceholder) {
+                entry->_length += numColumns;
+            }
+        }
+    }
+    return numColumns;
+}
+
 // Q: When can we append a column?
 // A: When for every sequence already in the column, the new column
 //    has either a gap or a contigugous base.  The new column also has
 //    no new sequences.
 bool MafBlock::canAppendColumn(ColumnIteratorPtr col) {
-    const ColumnMap *colMap = col->getColumnMap();
+    const ColumnIterator::Rows &rows = col->getRows();
     Entries::iterator e = _entries.begin();
-    ColumnMap::const_iterator c;
-    DNASet::const_iterator d;
-    const Sequence *sequence;
+    const Sequence *sequence = NULL;
     MafBlockEntry *entry;
-    hal_index_t sequenceStart;
+    hal_index_t sequenceStart = 0;
     hal_index_t pos;
 
-    for (c = colMap->begin(); c != colMap->end(); ++c) {
-        sequence = c->first;
-        sequenceStart = sequence->getStartPosition();
-
-        for (d = c->second->begin(); d != c->second->end(); ++d) {
-            while (e->first != sequence && e != _entries.end()) {
-                ++e;
+    for (const ColumnIterator::Row &row : rows) {
+        if (row._sequence != sequence) {
+            sequence = row._sequence;
+            sequenceStart = sequence->getStartPosition();
+        }
+        while (e != _entries.end() && e->first != sequence) {
+            ++e;
+        }
+        if (e == _entries.end()) {
+            return false;
+        }
+        entry = e->second;
+        assert(entry->_name == getName(sequence) && entry->_genome == sequence->getGenome());
+        if (entry->_start != NULL_INDEX) {
+            if (entry->_length >= _maxLength || (entry->_length > 0 && (entry->_strand == '-') != row._dna->getReversed())) {
+                return false;
+            }
+            pos = row._dna->getArrayIndex() - sequenceStart;
+            if (row._dna->getReversed() == true) {
+                // position on reverse strand relative to end of sequence
+                pos = entry->_srcLength - 1 - pos;
             }
-            if (e == _entries.end()) {
+            if (pos - entry->_start != entry->_length) {
                 return false;
-            } else {
-                entry = e->second;
-                assert(e->first == sequence);
-                assert(entry->_name == getName(sequence) && entry->_genome == sequence->getGenome());
-                if (entry->_start != NULL_INDEX) {
-                    if (entry->_length >= _maxLength ||
-                        (entry->_length > 0 && (entry->_strand == '-') != (*d)->getReversed())) {
-                        return false;
-                    }
-                    pos = (*d)->getArrayIndex() - sequenceStart;
-                    if ((*d)->getReversed() == true) {
-                        // position on reverse strand relative to end of sequence
-                        pos = entry->_srcLength - 1 - pos;
-                    }
-                    if (pos - entry->_start != entry->_length) {
-                        return false;
-                    }
-                }
-                ++e;
             }
         }
+        ++e;
     }
+
     if (_printTree) {
         stTree *tree = buildTree(col, false);
         bool ret = stTree_equals(tree, _tree);
@@ -481,7 +465,36 @@ static void printTreeEntries(stTree *tree, ostream &os) {
     }
 }
 
+/* decode the bases of an entry in one call and scatter them into the
+ * non-gap positions */
+void MafBlock::fillEntryDna(MafBlockEntry *entry) const {
+    if ((entry->_start == NULL_INDEX) or (entry->_length == 0)) {
+        return;
+    }
+    bool reversed = (entry->_strand == '-');
+    hal_index_t start = reversed ? (entry->_srcLength - entry->_start - entry->_length) : entry->_start;
+    _dnaBuffer.resize(entry->_length);
+    entry->_halSequence->getSubString(_dnaBuffer.data(), start, entry->_length, reversed);
+
+    char *buf = entry->_sequence->data();
+    size_t len = entry->_sequence->length();
+    hal_index_t j = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] == DnaPlaceholder) {
+            buf[i] = _dnaBuffer[j++];
+        }
+    }
+    assert(j == entry->_length);
+}
+
+void MafBlock::fillDna() const {
+    for (Entries::const_iterator e = _entries.begin(); e != _entries.end(); ++e) {
+        fillEntryDna(e->second);
+    }
+}
+
 ostream &MafBlock::printBlockWithTree(ostream &os) const {
+    fillDna();
     // Sort tree so that the reference comes first.
     prioritizeNodeInTree(_reference->_tree);
 
@@ -497,6 +510,7 @@ ostream &MafBlock::printBlockWithTree(ostream &os) const {
 
 // todo: fast way of reference first.
 ostream &MafBlock::printBlock(ostream &os) const {
+    fillDna();
     os << "a\n";
 
     assert(_reference != NULL);
@@ -48,27 +48,27 @@ void MafExport::convertSequence(ostream &mafStream, AlignmentConstPtr alignment,
                                                      _unique,
                                                      _onlyOrthologs);
 
+    // the rest of the gapless run after an appended column is added in
+    // bulk, and the iterator skips over it
     hal_size_t appendCount = 0;
+    hal_size_t numGapless = 0;
     if (_unique == false || colIt->isCanonicalOnRef() == true) {
         _mafBlock.initBlock(colIt, _ucscNames, _printTree);
         assert(_mafBlock.canAppendColumn(colIt) == true);
         _mafBlock.appendColumn(colIt);
         ++appendCount;
+        numGapless = _mafBlock.appendGaplessColumns(colIt->getGaplessLength() - 1);
     }
-    size_t numBlocks = 0;
-    while (colIt->lastColumn() == false) {
-        colIt->toRight();
+    while (colIt->lastColumn() == false &&
+           (numGapless == 0 || colIt->getReferenceSequencePosition() + (hal_index_t)numGapless < lastPosition)) {
+        colIt->toRight(numGapless + 1);
+        numGapless = 0;
         if (_unique == false || colIt->isCanonicalOnRef() == true) {
             if (appendCount == 0) {
                 _mafBlock.initBlock(colIt, _ucscNames, _printTree);
                 assert(_mafBlock.canAppendColumn(colIt) == true);
             }
             if (_mafBlock.canAppendColumn(colIt) == false) {
-                // erase empty entries from the column.  helps when there are
-                // millions of sequences (ie from fastas with lots of scaffolds)
-                if (numBlocks++ % 1000 == 0) {
-                    colIt->defragment();
-                }
                 if ((appendCount > 0) and (_keepEmptyRefBlocks or (not _mafBlock.referenceIsAllGaps()))) {
                     mafStream << _mafBlock << '\n';
                 }
@@ -77,6 +77,7 @@ void MafExport::convertSequence(ostream &mafStream, AlignmentConstPtr alignment,
             }
             _mafBlock.appendColumn(colIt);
             ++appendCount;
+            numGapless = _mafBlock.appendGaplessColumns(colIt->getGaplessLength() - 1);
         }
     }
     // if nothing was ever added (seems to happen in corner case where
@@ -89,7 +90,6 @@ void MafExport::convertSequence(ostream &mafStream, AlignmentConstPtr alignment,
 
 void MafExport::convertEntireAlignment(ostream &mafStream, AlignmentConstPtr alignment) {
     hal_size_t appendCount = 0;
-    size_t numBlocks = 0;
 
     _mafStream = &mafStream;
     _alignment = alignment;
@@ -118,11 +118,6 @@ void MafExport::convertEntireAlignment(ostream &mafStream, AlignmentConstPtr ali
                 assert(_mafBlock.canAppendColumn(colIt) == true);
             }
             if (_mafBlock.canAppendColumn(colIt) == false) {
-                // erase empty entries from the column.  helps when there are
-                // millions of sequences (ie from fastas with lots of scaffolds)
-                if (numBlocks++ % 1000 == 0) {
-                    colIt->defragment();
-                }
                 if (appendCount > 0) {
                     mafStream << _mafBlock << '\n';
                 }
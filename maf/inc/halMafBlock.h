@@ -11,10 +11,12 @@
 #include "hal.h"
 #include "sonLib.h"
 #include <cstdlib>
+#include <cstring>
 #include <deque>
 #include <iostream>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace hal {
 
@@ -41,10 +43,23 @@ namespace hal {
             }
             _buf[_len++] = c;
         }
+        void append(char c, size_t count) {
+            while (_cap < _len + count) {
+                growBuf();
+            }
+            memset(_buf + _len, c, count);
+            _len += count;
+        }
 
         void clear() {
             _len = 0;
         }
+        size_t length() const {
+            return _len;
+        }
+        char *data() {
+            return _buf;
+        }
         const char *str() {
             _buf[_len] = '\0';
             return _buf;
@@ -71,7 +86,7 @@ namespace hal {
         // we hack to keep a global buffer list to reduce
         // allocs and frees as entries get created and destroyed
         inline MafBlockEntry(std::vector<MafBlockString *> &buffers)
-            : _buffers(buffers), _genome(NULL), _lastUsed(0) {
+            : _buffers(buffers), _genome(NULL), _lastUsed(0), _halSequence(NULL) {
             if (_buffers.empty() == false) {
                 _sequence = _buffers.back();
                 _buffers.pop_back();
@@ -110,6 +125,9 @@ namespace hal {
         short _lastUsed;
         hal_index_t _srcLength;
         MafBlockString *_sequence;
+        // bases are appended as placeholders and decoded in bulk from
+        // this sequence when the block is printed
+        const Sequence *_halSequence;
         // The node corresponding to this entry (if we are printing trees)
         stTree *_tree;
     };
@@ -123,6 +141,7 @@ namespace hal {
 
         void initBlock(ColumnIteratorPtr col, bool fullNames, bool printTree);
         void appendColumn(ColumnIteratorPtr col);
+        hal_size_t appendGaplessColumns(hal_size_t numColumns);
         bool canAppendColumn(ColumnIteratorPtr col);
 
         inline std::string getName(const Sequence *sequence) const {
@@ -153,6 +172,8 @@ namespace hal {
         void buildTreeR(BottomSegmentIteratorPtr botIt, stTree *tree, bool modifyEntries);
         stTree *getTreeNode(SegmentIteratorPtr segIt, bool modifyEntries);
 
+        void fillEntryDna(MafBlockEntry *entry) const;
+        void fillDna() const;
         std::ostream &printBlock(std::ostream &os) const;
         std::ostream &printBlockWithTree(std::ostream &os) const;
 
@@ -160,14 +181,13 @@ namespace hal {
         Entries _entries;
         MafBlockEntry *_reference;
         std::vector<MafBlockString *> _stringBuffers;
+        mutable std::vector<char> _dnaBuffer;
         hal_index_t _maxLength;
         hal_index_t _refIndex;
         bool _fullNames;
         bool _printTree;
         stTree *_tree;
 
-        typedef hal::ColumnIterator::ColumnMap ColumnMap;
-        typedef hal::ColumnIterator::DNASet DNASet;
         friend std::ostream &operator<<(std::ostream &os, const hal::MafBlock &mafBlock);
         friend std::istream &operator>>(std::istream &is, hal::MafBlock &mafBlock);
     };
@@ -180,6 +180,17 @@ void PhyloP::processSequence(const Sequence *sequence, hal_index_t start, hal_si
     string sequenceName = sequence->getName();
     string genomeName = genome->getName();
 
+    // note wig coordinates are 1-based for some reason so we shift to right
+    *_outStream << "fixedStep chrom=" << sequenceName << " start=" << start + 1 << " step=" << step << "\n";
+
+    if (step == 1) {
+        /** With a step of one every column is scored, so we fetch the bases
+         * of each gapless block of columns at once rather than iterating
+         * over columns */
+        processBlocks(sequence, start, last - 1);
+        return;
+    }
+
     /** The ColumnIterator is fundamental structure used in this example to
      * traverse the alignment.  It essientially generates the multiple alignment
      * on the fly according to the given reference (in this case the target
@@ -190,9 +201,6 @@ void PhyloP::processSequence(const Sequence *sequence, hal_index_t start, hal_si
     hal_size_t pos = start;
     ColumnIteratorPtr colIt = sequence->getColumnIterator(&_targetSet, 0, pos, last - 1);
 
-    // note wig coordinates are 1-based for some reason so we shift to right
-    *_outStream << "fixedStep chrom=" << sequenceName << " start=" << start + 1 << " step=" << step << "\n";
-
     /** Since the column iterator stores coordinates in Genome coordinates
      * internally, we have to switch back to genome coordinates.  */
     // convert to genome coordinates
@@ -216,31 +224,55 @@ void PhyloP::processSequence(const Sequence *sequence, hal_index_t start, hal_si
         }
 
         pos += step;
-        if (step == 1) {
-            /** Move the iterator one position to the right */
-            colIt->toRight();
-
-            /** This is some tuning code that will probably be hidden from
-             * the interface at some point.  It is a good idea to use for now
-             * though */
-            // erase empty entries from the column.  helps when there are
-            // millions of sequences (ie from fastas with lots of scaffolds)
-            if (pos % 1000 == 0) {
-                colIt->defragment();
+        /** Reset the iterator to a non-contiguous position */
+        colIt->toSite(pos, last - 1);
+    }
+}
+
+/* Print the phyloP score of each column from start to last (inclusive,
+ * sequence-relative), a gapless block of columns at a time.  The bases of
+ * each row of a block are read in one go. */
+void PhyloP::processBlocks(const Sequence *sequence, hal_index_t start, hal_index_t last) {
+    ColumnBlockIterator blockIt(sequence, &_targetSet, start, last);
+    vector<int> specs;
+    vector<string> rowBases;
+    while (true) {
+        const ColumnBlockIterator::Rows &rows = blockIt.getRows();
+        hal_size_t length = blockIt.getLength();
+        specs.resize(rows.size());
+        rowBases.resize(rows.size());
+        for (size_t r = 0; r < rows.size(); ++r) {
+            const ColumnBlockIterator::Row &row = rows[r];
+            specs[r] = hsh_get_int(_seqnameHash, row._sequence->getGenome()->getName().c_str());
+            if (specs[r] >= 0) {
+                // the bases of a reversed row are the reverse complement of
+                // the range ending at its first position
+                hal_index_t first = min(row.getPosition(0), row.getPosition(length - 1));
+                rowBases[r].resize(length);
+                row._sequence->getSubString(&rowBases[r][0], first - row._sequence->getStartPosition(), length, row._reversed);
             }
-        } else {
-            /** Reset the iterator to a non-contiguous position */
-            colIt->toSite(pos, last - 1);
         }
+        for (hal_size_t i = 0; i < length; ++i) {
+            clearColumn();
+            bool masked = false;
+            for (size_t r = 0; r < rows.size() && not masked; ++r) {
+                if (specs[r] >= 0) {
+                    masked = not addBase(specs[r], fastUpper(rowBases[r][i]));
+                }
+            }
+            double pval = masked ? 0.0 : scoreColumn();
+            *_outStream << pval << '\n';
+        }
+        if (blockIt.lastBlock()) {
+            break;
+        }
+        blockIt.toRight();
     }
 }
 
 // compute phyloP score for a particular alignment column, return pval
 double PhyloP::pval(const ColumnIterator::ColumnMap *cmap) {
-    for (int i = 0; i < _msa->nseqs; i++) {
-        _msa->ss->col_tuples[0][i] = '*';
-    }
-
+    clearColumn();
     for (ColumnIterator::ColumnMap::const_iterator it = cmap->begin(); it != cmap->end(); ++it) {
         const Sequence *sequence = it->first;
         const Genome *genome = sequence->getGenome();
@@ -251,27 +283,45 @@ double PhyloP::pval(const ColumnIterator::ColumnMap *cmap) {
         ColumnIterator::DNASet *dnaSet = it->second;
         for (ColumnIterator::DNASet::const_iterator j = dnaSet->begin(); j != dnaSet->end(); ++j) {
             DnaIteratorPtr dna = *j;
-            char base = fastUpper(dna->getBase());
-            if (_msa->ss->col_tuples[0][spec] == '*') {
-                _msa->ss->col_tuples[0][spec] = base;
+            if (not addBase(spec, fastUpper(dna->getBase()))) {
+                return 0.0;
+            }
+        }
+    }
+    return scoreColumn();
+}
+
+void PhyloP::clearColumn() {
+    for (int i = 0; i < _msa->nseqs; i++) {
+        _msa->ss->col_tuples[0][i] = '*';
+    }
+}
+
+// add a base of species spec to the column, masking duplications.  return
+// false if the whole column is masked
+bool PhyloP::addBase(int spec, char base) {
+    if (_msa->ss->col_tuples[0][spec] == '*') {
+        _msa->ss->col_tuples[0][spec] = base;
+    } else {
+        if (_maskAllDups && _softMaskDups == 0) { // hard mask, all dups
+            return false;                         // duplication; mask this base
+        } else if (_maskAllDups) {                // soft mask, all dups
+            _msa->ss->col_tuples[0][spec] = 'N';
+        } else if (_msa->ss->col_tuples[0][spec] != base) {
+            if (_softMaskDups == 0) {
+                return false;
             } else {
-                if (_maskAllDups && _softMaskDups == 0) { // hard mask, all dups
-                    return 0.0;                           // duplication; mask this base
-                } else if (_maskAllDups) {                // soft mask, all dups
-                    _msa->ss->col_tuples[0][spec] = 'N';
-                } else if (_msa->ss->col_tuples[0][spec] != base) {
-                    if (_softMaskDups == 0) {
-                        return 0.0;
-                    } else {
-                        _msa->ss->col_tuples[0][spec] = 'N';
-                    }
-                } else {
-                    _msa->ss->col_tuples[0][spec] = base;
-                }
+                _msa->ss->col_tuples[0][spec] = 'N';
             }
+        } else {
+            _msa->ss->col_tuples[0][spec] = base;
         }
     }
+    return true;
+}
 
+// compute phyloP score for the column built with addBase
+double PhyloP::scoreColumn() {
     for (int i = 0; i < _msa->nseqs; i++) {
         if (_msa->ss->col_tuples[0][i] == '*') {
             _msa->ss->col_tuples[0][i] = 'N';
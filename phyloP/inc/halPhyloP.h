@@ -12,6 +12,7 @@
 #include "hal.h"
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 #undef __cplusplus
 extern "C" {
@@ -52,8 +53,13 @@ namespace hal {
         void processSequence(const Sequence *sequence, hal_index_t start, hal_size_t length, hal_size_t step);
 
       protected:
+        void processBlocks(const Sequence *sequence, hal_index_t start, hal_index_t last);
+
         // return phyloP score
         double pval(const ColumnIterator::ColumnMap *cmap);
+        void clearColumn();
+        bool addBase(int spec, char base);
+        double scoreColumn();
 
         void clear();
 
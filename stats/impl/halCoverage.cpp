@@ -72,8 +72,9 @@ int main(int argc, char **argv) {
         }
         for (size_t j = 0; j < leafGenomes.size(); j++) {
             const Genome *leafGenome = leafGenomes[j];
-            MappedSegmentSet segments;
+            MappedSegmentVector segments;
             halMapSegmentSP(refSeg, segments, leafGenome, NULL, true, 0, NULL, NULL);
+            segments.resolve();
             vector<hal_size_t> &histogram = genome_coverage[leafGenome];
             hal_size_t depth = segments.size();
             if (depth > maxDepth) {
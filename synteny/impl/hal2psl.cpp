@@ -41,6 +41,9 @@ std::vector<PslBlock> Hal2Psl::convert2psl(AlignmentConstPtr alignment, const Ge
             _mappedBlocks.clear();
             _outPSL = true;
             visitBegin();
+            _batch.assign(1, _bedLine);
+            mapBatch();
+            _batch.clear();
             liftInterval(_mappedBlocks);
             if (_mappedBlocks.size()) {
                 assignBlocksToIntervals();